@@ -5,8 +5,7 @@ using Glade2d.Profiling;
 using GladeSampleShared.Screens;
 using Microgpu.Common.Comms;
 
-Console.WriteLine("Connecting to TCP microgpu server on localhost:9123 ...");
-var gpuCommunication = new TcpGpuCommunication("localhost", 9123);
+var gpuCommunication = CreateCommunication();
 
 var layerManager = new LayerManager();
 var profiler = new Profiler();
@@ -18,4 +17,18 @@ var engine = new Game
 
 engine.Initialize(renderer, null, layerManager, profiler); 
 
-await engine.Start(() => new GladeDemoScreen());
\ No newline at end of file
+await engine.Start(() => new GladeDemoScreen());
+
+IGpuCommunication CreateCommunication()
+{
+    var shmIndex = Array.IndexOf(args, "--shm");
+    if (shmIndex >= 0)
+    {
+        var path = shmIndex + 1 < args.Length ? args[shmIndex + 1] : SharedMemoryGpuCommunication.DefaultPath;
+        Console.WriteLine($"Connecting to shared memory microgpu server through {path} ...");
+        return new SharedMemoryGpuCommunication(path);
+    }
+
+    Console.WriteLine("Connecting to TCP microgpu server on localhost:9123 ...");
+    return new TcpGpuCommunication("localhost", 9123);
+}
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace Glade2d.Microgpu;
 
 internal class Layer : ILayer
 {
-    private readonly record struct DrawCommand(string TextureName, Point TopLeftOnLayer);
+    private readonly record struct DrawCommand(TextureManager.SubTextureInfo SubTexture, Point TopLeftOnLayer);
     
     private readonly TextureManager _textureManager;
     private readonly TextureManager.TextureInfo _textureInfo;
@@ -48,8 +48,8 @@ internal class Layer : ILayer
 
     public void DrawTexture(Frame frame, Point topLeftOnLayer)
     {
-        var subTextureName = _textureManager.LoadSubTexture(frame);
-        _pendingDrawCommands.Add(new DrawCommand(subTextureName, topLeftOnLayer));
+        var subTexture = _textureManager.LoadSubTexture(frame);
+        _pendingDrawCommands.Add(new DrawCommand(subTexture, topLeftOnLayer));
     }
 
     public void DrawTexture(BufferRgb565 texture, Point topLeftOnTexture, Point topLeftOnLayer, Dimensions drawSize,
@@ -163,21 +163,10 @@ internal class Layer : ILayer
 
         foreach (var drawCommand in _pendingDrawCommands)
         {
-            var drawingTexture = _textureManager.GetTextureInfo(drawCommand.TextureName);
-            if (drawingTexture == null)
+            var operation = new DrawSubTextureOperation
             {
-                var message = $"Texture {drawCommand.TextureName} not loaded";
-                throw new InvalidOperationException(message);
-            }
-
-            var operation = new DrawTextureOperation
-            {
-                SourceTextureId = drawingTexture.TextureId,
+                SubTextureId = drawCommand.SubTexture.SubTextureId,
                 TargetTextureId = _textureInfo.TextureId,
-                SourceStartX = 0,
-                SourceStartY = 0,
-                SourceWidth = drawingTexture.Width,
-                SourceHeight = drawingTexture.Height,
                 TargetStartX = (short)drawCommand.TopLeftOnLayer.X,
                 TargetStartY = (short)drawCommand.TopLeftOnLayer.Y,
                 IgnoreTransparency = false,
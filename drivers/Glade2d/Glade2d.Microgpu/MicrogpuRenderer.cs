@@ -93,24 +93,20 @@ public class MicrogpuRenderer : IRenderer
         _profiler.StartTiming("Microgpu.Sprites");
         foreach (var sprite in sprites)
         {
-            var textureInfo = _textureManager.GetTextureInfo(sprite.CurrentFrame);
-            if (textureInfo == null)
+            var subTextureInfo = _textureManager.GetSubTextureInfo(sprite.CurrentFrame);
+            if (subTextureInfo == null)
             {
                 var message = $"Texture {sprite.CurrentFrame.TextureName} not loaded";
                 throw new InvalidOperationException(message);
             }
 
-            var operation = new DrawTextureOperation
+            _gpu.EnqueueFireAndForgetAsync(new DrawSubTextureOperation
             {
-                SourceTextureId = textureInfo.TextureId,
+                SubTextureId = subTextureInfo.SubTextureId,
                 TargetTextureId = 0,
-                SourceStartX = 0,
-                SourceStartY = 0,
-                SourceWidth = textureInfo.Width,
-                SourceHeight = textureInfo.Height,
                 TargetStartX = (short)sprite.X,
                 TargetStartY = (short)sprite.Y,
-            };
+            });
         }
 
         await _gpu.SendQueuedOperationsAsync();
@@ -14,15 +14,24 @@ namespace Glade2d.Microgpu;
 internal class TextureManager
 {
     public record TextureInfo(byte TextureId, ushort Width, ushort Height);
-    private record Texture(string Name, BufferRgb565 Buffer);
+    public record SubTextureInfo(ushort SubTextureId, ushort Width, ushort Height);
+    private record Texture(string Name, BufferRgb565 Buffer, bool IsCacheable);
+    private record SubTexture(ushort SubTextureId, byte TextureId, Frame Frame);
+
+    // How many times textures evicted while uploading a frame's textures are uploaded again
+    // before giving up on that frame, in case they don't all fit on the GPU at once.
+    private const int MaxReloadPasses = 3;
    
     private readonly Gpu _gpu;
     private readonly Dictionary<byte, Texture> _textures = new();
-    private readonly Dictionary<string, BufferRgb565> _spriteSheets = new();
     private readonly Dictionary<string, byte> _textureLookup = new();
+    private readonly Dictionary<string, SubTexture> _subTextures = new();
     private readonly string _contentRoot;
     private readonly Queue<byte> _addedTextures = new();
     private readonly Queue<byte> _removedTextures = new();
+    private readonly Queue<SubTexture> _addedSubTextures = new();
+    private readonly HashSet<byte> _evictedTextures = new();
+    private readonly HashSet<byte> _texturesUsedThisFrame = new();
     
     public TextureManager(string contentRoot, Gpu gpu)
     {
@@ -30,39 +39,34 @@ internal class TextureManager
         _gpu = gpu;
     }
     
-    public string LoadSubTexture(Frame frame)
+    /// <summary>
+    /// Registers the frame as a sub-texture of its sprite sheet, which is uploaded to the GPU
+    /// as a single atlas texture the first time any of its frames are used.
+    /// </summary>
+    public SubTextureInfo LoadSubTexture(Frame frame)
     {
         var subTextureName = FormSubTextureName(frame);
-        if (_textureLookup.ContainsKey(subTextureName))
-        {
-            return subTextureName;
-        }
-        
-        if (!_spriteSheets.ContainsKey(frame.TextureName))
-        {
-            LoadSpriteSheet(frame.TextureName);
-        }
-        
-        var buffer = _spriteSheets[frame.TextureName];
-        var subBuffer = new BufferRgb565(frame.Width, frame.Height);
-        for (var y = 0; y < frame.Height; y++)
+        if (!_subTextures.TryGetValue(subTextureName, out var subTexture))
         {
-            for (var x = 0; x < frame.Width; x++)
+            if (_subTextures.Count >= DefineSubTextureOperation.MaxSubTextures)
             {
-                var sourceIndex = (y + frame.Y) * (buffer.Width * 2) + ((x + frame.X) * 2);
-                var destIndex = y * (frame.Width * 2) + (x * 2);
-                subBuffer.Buffer[destIndex] = buffer.Buffer[sourceIndex];
-                subBuffer.Buffer[destIndex + 1] = buffer.Buffer[sourceIndex + 1];
+                throw new InvalidOperationException("All sub-texture ids are in use");
             }
+
+            var textureId = LoadSpriteSheet(frame.TextureName);
+            subTexture = new SubTexture((ushort)_subTextures.Count, textureId, frame);
+            _subTextures.Add(subTextureName, subTexture);
+            _addedSubTextures.Enqueue(subTexture);
         }
-        
-        var texture = new Texture(subTextureName, subBuffer);
-        var textureId = GetNextFreeTextureId();
-        _textures.Add(textureId, texture);
-        _textureLookup.Add(subTextureName, textureId);
-        _addedTextures.Enqueue(textureId);
 
-        return subTextureName;
+        // The GPU treats sprite sheets as a cache, so it may have evicted this one
+        if (_evictedTextures.Remove(subTexture.TextureId))
+        {
+            _addedTextures.Enqueue(subTexture.TextureId);
+        }
+
+        _texturesUsedThisFrame.Add(subTexture.TextureId);
+        return new SubTextureInfo(subTexture.SubTextureId, (ushort)frame.Width, (ushort)frame.Height);
     }
 
     public string CreateLayerTexture(int width, int height)
@@ -73,8 +77,9 @@ internal class TextureManager
             throw new InvalidOperationException($"Unexpected guid collision");
         }
         
+        // Layers are drawn to on the GPU, so their contents would be lost if they were evicted
         var buffer = new BufferRgb565(width, height);
-        var texture = new Texture(textureName, buffer);
+        var texture = new Texture(textureName, buffer, false);
         var textureId = GetNextFreeTextureId();
         _textures.Add(textureId, texture);
         _textureLookup.Add(textureName, textureId);
@@ -88,6 +93,25 @@ internal class TextureManager
     /// </summary>
     public async ValueTask ApplyTextureChanges()
     {
+        for (var pass = 0; ; pass++)
+        {
+            var uploadedTextures = await UploadTextureChanges();
+            if (!uploadedTextures || !await HandleEvictions(pass < MaxReloadPasses))
+            {
+                break;
+            }
+        }
+
+        _texturesUsedThisFrame.Clear();
+    }
+
+    /// <summary>
+    /// Sends queued texture definitions to the GPU. Returns true if any textures were defined,
+    /// which may have caused cacheable textures to be evicted.
+    /// </summary>
+    private async ValueTask<bool> UploadTextureChanges()
+    {
+        var uploadedTextures = false;
         while (_removedTextures.TryDequeue(out var textureId))
         {
             Console.WriteLine($"Removing texture {textureId} from the GPU");
@@ -110,13 +134,18 @@ internal class TextureManager
                 TextureId = textureId,
                 Width = (ushort)texture.Buffer.Width,
                 Height = (ushort)texture.Buffer.Height,
-                TransparentColor = ColorRgb565.FromRgb888(255, 0, 255)
+                TransparentColor = ColorRgb565.FromRgb888(255, 0, 255),
+                IsCacheable = texture.IsCacheable,
             });
 
+            uploadedTextures = true;
+
+            // Each append operation has a 4 byte header, and has to carry whole pixels
+            var maxBytesPerAppend = (_gpu.MaxOperationSize - 4) / 2 * 2;
             var bytesLeft = texture.Buffer.Buffer.Length;
             while (bytesLeft > 0)
             {
-                var bytesToSend = Math.Min(bytesLeft, 512);
+                var bytesToSend = Math.Min(bytesLeft, maxBytesPerAppend);
                 var startIndex = texture.Buffer.Buffer.Length - bytesLeft;
 
                 _gpu.EnqueueFireAndForgetAsync(new AppendTexturePixelsOperation
@@ -130,6 +159,60 @@ internal class TextureManager
 
             await _gpu.SendQueuedOperationsAsync();
         }
+
+        // Sub-textures stay registered on the GPU even if their sprite sheet is evicted, so
+        // they only ever need to be sent once.
+        while (_addedSubTextures.TryDequeue(out var subTexture))
+        {
+            _gpu.EnqueueFireAndForgetAsync(new DefineSubTextureOperation
+            {
+                SubTextureId = subTexture.SubTextureId,
+                TextureId = subTexture.TextureId,
+                X = (ushort)subTexture.Frame.X,
+                Y = (ushort)subTexture.Frame.Y,
+                Width = (ushort)subTexture.Frame.Width,
+                Height = (ushort)subTexture.Frame.Height,
+            });
+        }
+
+        await _gpu.SendQueuedOperationsAsync();
+        return uploadedTextures;
+    }
+
+    /// <summary>
+    /// Asks the GPU which textures it evicted. Evicted textures are uploaded again the next
+    /// time they are used, or queued right away if they're being used this frame and
+    /// `reloadUsedTextures` is set. Returns true if any textures were queued.
+    /// </summary>
+    private async ValueTask<bool> HandleEvictions(bool reloadUsedTextures)
+    {
+        var usage = await _gpu.SendResponsiveOperationAsync(new GetTextureUsageOperation());
+        if (usage == null)
+        {
+            return false;
+        }
+
+        var queuedTextures = false;
+        foreach (var textureId in _textures.Keys)
+        {
+            if (!usage.WasEvicted(textureId))
+            {
+                continue;
+            }
+
+            if (reloadUsedTextures && _texturesUsedThisFrame.Contains(textureId))
+            {
+                Console.WriteLine($"Texture {textureId} was evicted but is still in use, reloading it");
+                _addedTextures.Enqueue(textureId);
+                queuedTextures = true;
+            }
+            else
+            {
+                _evictedTextures.Add(textureId);
+            }
+        }
+
+        return queuedTextures;
     }
     
     public TextureInfo? GetTextureInfo(string textureName)
@@ -144,10 +227,14 @@ internal class TextureManager
         return new TextureInfo(textureId, (ushort) texture.Buffer.Width, (ushort) texture.Buffer.Height);
     }
 
-    public TextureInfo? GetTextureInfo(Frame frame)
+    public SubTextureInfo? GetSubTextureInfo(Frame frame)
     {
-        var textureName = FormSubTextureName(frame);
-        return GetTextureInfo(textureName);
+        if (!_subTextures.TryGetValue(FormSubTextureName(frame), out var subTexture))
+        {
+            return null;
+        }
+
+        return new SubTextureInfo(subTexture.SubTextureId, (ushort)frame.Width, (ushort)frame.Height);
     }
 
     private static string FormSubTextureName(Frame frame)
@@ -169,15 +256,23 @@ internal class TextureManager
         throw new InvalidOperationException("All user defined texture slots are in use");
     }
 
-    private void LoadSpriteSheet(string textureName)
+    private byte LoadSpriteSheet(string textureName)
     {
-        if (_spriteSheets.ContainsKey(textureName))
+        if (_textureLookup.TryGetValue(textureName, out var existingTextureId))
         {
-            return;
+            return existingTextureId;
         }
         
+        // Sprite sheets can always be uploaded again from their bitmap, so the GPU is free to
+        // evict them when it runs low on memory.
         var buffer = LoadBitmapFile(textureName);
-        _spriteSheets.Add(textureName, buffer);
+        var texture = new Texture(textureName, buffer, true);
+        var textureId = GetNextFreeTextureId();
+        _textures.Add(textureId, texture);
+        _textureLookup.Add(textureName, textureId);
+        _addedTextures.Enqueue(textureId);
+
+        return textureId;
     }
     
     private BufferRgb565 LoadBitmapFile(string name)
@@ -0,0 +1,116 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class CompactBatchOperationTests
+{
+    [Fact]
+    public void Repeated_Fields_Are_Left_Out_Of_Rectangles()
+    {
+        var batch = new CompactBatchOperation<ColorRgb565>(250);
+        batch.AddOperation(Rectangle(10, 20, 0x1234)).ShouldBeTrue();
+        batch.AddOperation(Rectangle(14, 18, 0x1234)).ShouldBeTrue();
+
+        var bytes = new byte[batch.GetSize()];
+        batch.Serialize(bytes).ShouldBe(bytes.Length);
+
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            20, 0, 11,
+            0x02, 1, 20, 40, 5, 5, 0x12, 0x34,
+            0x02 | 0x20 | 0x40 | 0x80, 8, 3,
+        });
+    }
+
+    [Fact]
+    public void Operations_Without_Compact_Encoding_Are_Added_Raw()
+    {
+        var batch = new CompactBatchOperation<ColorRgb565>(250);
+        batch.AddOperation(new PresentFramebufferOperation()).ShouldBeTrue();
+
+        var bytes = new byte[batch.GetSize()];
+        batch.Serialize(bytes);
+
+        bytes.ShouldBeEquivalentTo(new byte[] { 20, 0, 3, 0, 1, 6 });
+    }
+
+    [Fact]
+    public void Chars_Encode_Font_And_Text()
+    {
+        var batch = new CompactBatchOperation<ColorRgb565>(250);
+        batch.AddOperation(new DrawCharsOperation<ColorRgb565>
+        {
+            Text = "Hi",
+            Font = Font.Font8X12,
+            TextureId = 0,
+            StartX = 3,
+            StartY = 0,
+            Color = new ColorRgb565(0),
+        }).ShouldBeTrue();
+
+        var bytes = new byte[batch.GetSize()];
+        batch.Serialize(bytes);
+
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            20, 0, 7,
+            12 | 0x20 | 0x40, 5, 6, 0, 2, (byte)'H', (byte)'i',
+        });
+    }
+
+    [Fact]
+    public void Chars_With_Background_Are_Added_Raw()
+    {
+        var batch = new CompactBatchOperation<ColorRgb565>(250);
+        batch.AddOperation(new DrawCharsOperation<ColorRgb565>
+        {
+            Text = "Hi",
+            Font = Font.Font8X12,
+            TextureId = 0,
+            StartX = 3,
+            StartY = 0,
+            Color = new ColorRgb565(0x1234),
+            BackgroundColor = new ColorRgb565(0x5678),
+        }).ShouldBeTrue();
+
+        var bytes = new byte[batch.GetSize()];
+        batch.Serialize(bytes);
+
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            20, 0, 16,
+            0, 14,
+            12, 5, 0, 0x12, 0x34, 0, 3, 0, 0, 2, (byte)'H', (byte)'i', 0x56, 0x78,
+        });
+    }
+
+    [Fact]
+    public void Full_Batch_Rejects_Operation_And_Keeps_State()
+    {
+        var batch = new CompactBatchOperation<ColorRgb565>(3 + 8);
+        batch.AddOperation(Rectangle(10, 20, 0x1234)).ShouldBeTrue();
+        batch.AddOperation(Rectangle(500, 20, 0x4321)).ShouldBeFalse();
+        batch.GetSize().ShouldBe(11);
+
+        batch.Serialize(new byte[batch.GetSize()]);
+        batch.HasAnyOperations().ShouldBeFalse();
+
+        // Serializing starts a new batch, so nothing is relative to the earlier rectangle
+        batch.AddOperation(Rectangle(10, 20, 0x1234)).ShouldBeTrue();
+        batch.GetSize().ShouldBe(11);
+    }
+
+    private static DrawRectangleOperation<ColorRgb565> Rectangle(ushort x, ushort y, ushort color)
+    {
+        return new DrawRectangleOperation<ColorRgb565>
+        {
+            TextureId = 1,
+            StartX = x,
+            StartY = y,
+            Width = 5,
+            Height = 5,
+            Color = new ColorRgb565(color),
+        };
+    }
+}
\ No newline at end of file
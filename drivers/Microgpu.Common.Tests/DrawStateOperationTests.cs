@@ -0,0 +1,47 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class DrawStateOperationTests
+{
+    [Fact]
+    public void Set_Draw_State_Only_Writes_Fields_That_Are_Set()
+    {
+        var operation = new SetDrawStateOperation<ColorRgb565>
+        {
+            Color = new ColorRgb565(0xF800),
+            OriginX = 10,
+            OriginY = 300,
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[] { 21, 0x0A, 0xF8, 0x00, 0, 10, 1, 44 });
+    }
+
+    [Fact]
+    public void Set_Draw_State_Needs_Both_Origin_Values()
+    {
+        var operation = new SetDrawStateOperation<ColorRgb565>
+        {
+            TargetTextureId = 3,
+            Font = Font.Font8X12,
+            OriginX = 10,
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[] { 21, 0x05, 3, 5 });
+    }
+
+    [Fact]
+    public void Draw_State_Chars_Serializes_Text()
+    {
+        var operation = new DrawStateCharsOperation { Text = "Hi", StartX = 2, StartY = 1 };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[] { 24, 0, 2, 0, 1, 2, (byte)'H', (byte)'i' });
+    }
+}
\ No newline at end of file
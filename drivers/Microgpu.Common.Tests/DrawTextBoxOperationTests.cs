@@ -0,0 +1,57 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class DrawTextBoxOperationTests
+{
+    [Fact]
+    public void Text_Box_Packs_Alignment_And_Wrap_Into_Flags()
+    {
+        var operation = new DrawTextBoxOperation<ColorRgb565>
+        {
+            Text = "a\nb",
+            Color = new ColorRgb565(0x1234),
+            Font = Font.Font8X12,
+            TextureId = 0,
+            StartX = 1,
+            StartY = 2,
+            Width = 300,
+            Height = 40,
+            HorizontalAlignment = TextAlignment.Center,
+            VerticalAlignment = TextAlignment.End,
+            Wrap = TextWrap.Characters,
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            28, 5, 0, 0x12, 0x34, 0, 1, 0, 2, 1, 44, 0, 40, 0x29, 0, 3, (byte)'a', (byte)'\n', (byte)'b',
+        });
+    }
+
+    [Fact]
+    public void Text_Box_Background_Follows_Text()
+    {
+        var operation = new DrawTextBoxOperation<ColorRgb565>
+        {
+            Text = "a",
+            Color = new ColorRgb565(0x1234),
+            Font = Font.Font8X12,
+            TextureId = 0,
+            StartX = 0,
+            StartY = 0,
+            Width = 8,
+            Height = 12,
+            BackgroundColor = new ColorRgb565(0x5678),
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            28, 5, 0, 0x12, 0x34, 0, 0, 0, 0, 0, 8, 0, 12, 0x10, 0, 1, (byte)'a', 0x56, 0x78,
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class DrawTextureInstancedOperationTests
+{
+    [Fact]
+    public void Instances_Without_Flips_Are_Only_Positions()
+    {
+        var operation = Operation(new(1, 2), new(-1, 300));
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            25, 4, 0, 0, 8, 0, 0, 0, 16, 0, 16, 0, 0, 2,
+            0, 1, 0, 2,
+            0xFF, 0xFF, 1, 44,
+        });
+    }
+
+    [Fact]
+    public void Instances_Have_Flags_When_Any_Are_Flipped()
+    {
+        var operation = Operation(new(1, 2), new(3, 4, FlipHorizontally: true, FlipVertically: true));
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            25, 4, 0, 0, 8, 0, 0, 0, 16, 0, 16, 8, 0, 2,
+            0, 1, 0, 2, 0,
+            0, 3, 0, 4, 6,
+        });
+    }
+
+    private static DrawTextureInstancedOperation Operation(params DrawTextureInstancedOperation.Instance[] instances)
+    {
+        return new DrawTextureInstancedOperation
+        {
+            SourceTextureId = 4,
+            TargetTextureId = 0,
+            SourceStartX = 8,
+            SourceStartY = 0,
+            SourceWidth = 16,
+            SourceHeight = 16,
+            Instances = instances,
+        };
+    }
+}
\ No newline at end of file
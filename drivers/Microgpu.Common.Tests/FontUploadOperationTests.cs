@@ -0,0 +1,84 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class FontUploadOperationTests
+{
+    [Fact]
+    public void Define_Font_Writes_Each_Glyph()
+    {
+        var operation = new DefineFontOperation
+        {
+            FontId = 16,
+            Height = 4,
+            FirstCharacter = (byte)'A',
+            BitmapSize = 300,
+            Glyphs = new DefineFontOperation.Glyph[] { new(3, 0), new(5, 258) },
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            26, 16, 4, (byte)'A', 2, 1, 44,
+            3, 0, 0,
+            5, 1, 2,
+        });
+    }
+
+    [Fact]
+    public void Append_Font_Bitmap_Writes_Length_And_Bytes()
+    {
+        var operation = new AppendFontBitmapOperation
+        {
+            FontId = 17,
+            Bytes = new byte[] { 0xAA, 0x55, 0x0F },
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[] { 27, 17, 0, 3, 0xAA, 0x55, 0x0F });
+    }
+
+    [Fact]
+    public void Define_Outline_Font_Writes_Each_Glyph()
+    {
+        var operation = new DefineOutlineFontOperation
+        {
+            FontId = 18,
+            UnitsPerEm = 1000,
+            Ascent = 800,
+            Descent = 200,
+            FirstCharacter = (byte)'0',
+            OutlineSize = 300,
+            Glyphs = new DefineOutlineFontOperation.Glyph[] { new(600, 0), new(550, 256) },
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[]
+        {
+            29, 18, 3, 232, 3, 32, 0, 200, (byte)'0', 2, 1, 44,
+            2, 88, 0, 0,
+            2, 38, 1, 0,
+        });
+    }
+
+    [Fact]
+    public void Define_Scaled_Font_Writes_Size_And_Range()
+    {
+        var operation = new DefineScaledFontOperation
+        {
+            FontId = 19,
+            OutlineFontId = 18,
+            PixelSize = 48,
+            FirstCharacter = (byte)'0',
+            CharacterCount = 10,
+        };
+
+        var bytes = new byte[operation.GetSize()];
+        operation.Serialize(bytes).ShouldBe(bytes.Length);
+        bytes.ShouldBeEquivalentTo(new byte[] { 30, 19, 18, 48, (byte)'0', 10 });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+﻿using Microgpu.Common.Comms;
+using Microgpu.Common.Operations;
+using Microgpu.Common.Responses;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class GpuResponseTests
+{
+    [Fact]
+    public void Responsive_Operations_Serialize_Their_Request_Id()
+    {
+        var buffer = new byte[4];
+        var operation = new NegotiateFramingOperation { Version = 3, RequestId = 0x1234 };
+
+        operation.GetSize().ShouldBe(4);
+        operation.Serialize(buffer).ShouldBe(4);
+        buffer.ShouldBeEquivalentTo(new byte[] { 16, 3, 0x12, 0x34 });
+    }
+
+    [Fact]
+    public void Get_Stats_Serializes_Its_Flags_Before_The_Request_Id()
+    {
+        var buffer = new byte[5];
+        var operation = new GetStatsOperation { FirstOperationType = 12, Reset = true, RequestId = 0x1234 };
+
+        operation.GetSize().ShouldBe(5);
+        operation.Serialize(buffer).ShouldBe(5);
+        buffer.ShouldBeEquivalentTo(new byte[] { 31, 12, 1, 0x12, 0x34 });
+    }
+
+    [Fact]
+    public void Stats_Response_Reads_Each_Entry()
+    {
+        var response = new StatsResponse();
+        response.Deserialize(new byte[]
+        {
+            7, 22, 2,
+            2, 0, 0, 0, 4, 0, 0, 0, 21, 0, 0, 0, 7, 0, 0, 0, 160, 0, 0, 0, 48,
+            31, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3,
+        });
+
+        response.NextOperationType.ShouldBe((byte)22);
+        response.Entries.Count.ShouldBe(2);
+        response.Entries[0].ShouldBe(new StatsResponse.Entry(2, 4, 21, 7, 160, 48));
+        response.Entries[1].ShouldBe(new StatsResponse.Entry(31, 1, 256, 0, 0, 3));
+    }
+
+    [Fact]
+    public void Full_Tagged_Stats_Page_Fits_In_V2_Framing()
+    {
+        const int entryCount = StatsResponse.MaxEntriesWithV2Framing;
+        var page = new byte[5 + entryCount * 21];
+        page[0] = 7 | 0x80;
+        page[1] = 0x12;
+        page[2] = 0x34;
+        page[3] = 200;
+        page[4] = entryCount;
+        for (var x = 0; x < entryCount; x++)
+        {
+            page[5 + x * 21] = (byte)(x + 1);
+            page[5 + x * 21 + 4] = 0xFF;
+        }
+
+        var framer = new PacketFramer();
+        var packet = new byte[framer.BufferSizeRequired(new RawOperation(page))];
+        var packetSize = framer.Encode(new RawOperation(page), packet);
+        var decoded = framer.Decode(packet.AsSpan(0, packetSize)).DecodedBytes.ToArray();
+        decoded.ShouldBeEquivalentTo(page);
+
+        var response = new StatsResponse();
+        decoded[2] = 7;
+        response.Deserialize(decoded.AsSpan(2));
+
+        response.NextOperationType.ShouldBe((byte)200);
+        response.Entries.Count.ShouldBe(entryCount);
+        response.Entries[^1].ShouldBe(new StatsResponse.Entry(entryCount, 255, 0, 0, 0, 0));
+
+        var oversizedPage = new byte[page.Length + 21];
+        Should.Throw<InvalidOperationException>(() => framer.Encode(new RawOperation(oversizedPage), new byte[512]));
+    }
+
+    [Fact]
+    public async Task Tagged_Responses_Are_Matched_To_Their_Requests_When_Out_Of_Order()
+    {
+        var communication = new FakeGpuCommunication();
+        var gpu = await Gpu.CreateAsync(communication);
+
+        communication.HoldResponses = true;
+        var status = await gpu.BeginResponsiveOperationAsync(new GetStatusOperation());
+        var framing = await gpu.BeginResponsiveOperationAsync(new NegotiateFramingOperation { Version = 3 });
+        communication.ReleaseHeldResponses(reverseOrder: true);
+
+        var statusResponse = await status.GetResponseAsync();
+        var framingResponse = await framing.GetResponseAsync();
+
+        statusResponse.ShouldNotBeNull();
+        statusResponse.DisplayWidth.ShouldBe((ushort)320);
+        framingResponse.ShouldNotBeNull();
+        framingResponse.Version.ShouldBe((byte)3);
+    }
+
+    [Fact]
+    public async Task Untagged_Responses_Are_Matched_In_Request_Order()
+    {
+        var communication = new FakeGpuCommunication { TagsResponses = false };
+        var gpu = await Gpu.CreateAsync(communication);
+
+        communication.HoldResponses = true;
+        var framing = await gpu.BeginResponsiveOperationAsync(new NegotiateFramingOperation { Version = 3 });
+        var status = await gpu.BeginResponsiveOperationAsync(new GetStatusOperation());
+        communication.ReleaseHeldResponses(reverseOrder: false);
+
+        (await status.GetResponseAsync()).ShouldNotBeNull();
+        (await framing.GetResponseAsync()).ShouldNotBeNull();
+    }
+
+    [Fact]
+    public async Task Operations_Can_Be_Sent_While_A_Response_Is_Pending()
+    {
+        var communication = new FakeGpuCommunication();
+        var gpu = await Gpu.CreateAsync(communication);
+
+        communication.HoldResponses = true;
+        var status = await gpu.BeginResponsiveOperationAsync(new GetStatusOperation());
+        gpu.EnqueueFireAndForgetAsync(new PresentFramebufferOperation());
+        await gpu.SendQueuedOperationsAsync();
+        communication.ReleaseHeldResponses(reverseOrder: false);
+
+        (await status.GetResponseAsync()).ShouldNotBeNull();
+        communication.SentOperations[^1].ShouldBeOfType<PresentFramebufferOperation>();
+    }
+
+    [Fact]
+    public async Task Fence_Queries_Report_The_Last_Inserted_Fence()
+    {
+        var communication = new FakeGpuCommunication();
+        var gpu = await Gpu.CreateAsync(communication);
+
+        gpu.EnqueueFireAndForgetAsync(new InsertFenceOperation { Value = 0x01020304 });
+        await gpu.SendQueuedOperationsAsync();
+        var response = await gpu.SendResponsiveOperationAsync(new QueryFenceOperation());
+
+        response.ShouldNotBeNull();
+        response.LastCompletedValue.ShouldBe(0x01020304u);
+    }
+
+    [Fact]
+    public async Task Returns_Null_When_The_Gpu_Does_Not_Respond()
+    {
+        var communication = new FakeGpuCommunication();
+        var gpu = await Gpu.CreateAsync(communication);
+
+        communication.HoldResponses = true;
+        var status = await gpu.BeginResponsiveOperationAsync(new GetStatusOperation());
+
+        (await status.GetResponseAsync()).ShouldBeNull();
+    }
+
+    private class RawOperation(byte[] bytes) : IOperation
+    {
+        public int Serialize(Span<byte> output)
+        {
+            bytes.CopyTo(output);
+            return bytes.Length;
+        }
+
+        public int GetSize() => bytes.Length;
+    }
+
+    private class FakeGpuCommunication : IGpuCommunication
+    {
+        private readonly Queue<byte[]> _responses = new();
+        private readonly List<byte[]> _heldResponses = new();
+
+        public bool TagsResponses { get; init; } = true;
+        public bool HoldResponses { get; set; }
+        public List<IOperation> SentOperations { get; } = new();
+        public uint LastFenceValue { get; private set; }
+
+        public ValueTask ResetAsync()
+        {
+            return ValueTask.CompletedTask;
+        }
+
+        public void EnqueueOutboundOperation(IFireAndForgetOperation operation)
+        {
+            SentOperations.Add(operation);
+            if (operation is InsertFenceOperation fence)
+            {
+                LastFenceValue = fence.Value;
+            }
+        }
+
+        public ValueTask SendQueuedOutboundOperationsAsync()
+        {
+            return ValueTask.CompletedTask;
+        }
+
+        public ValueTask SendImmediateOperationAsync(IOperation operation)
+        {
+            SentOperations.Add(operation);
+            switch (operation)
+            {
+                case GetStatusOperation status:
+                    Respond(status.RequestId, new byte[] { 1, 0, 0x01, 0x40, 0, 0xF0, 0, 0, 0, 0, 1, 0, 250, 0, 2, 2 });
+                    break;
+
+                case NegotiateFramingOperation framing:
+                    Respond(framing.RequestId, new byte[] { 4, framing.Version, 0x04, 0x00, 0xFF, 0xFF });
+                    break;
+
+                case QueryFenceOperation query:
+                    var value = LastFenceValue;
+                    Respond(query.RequestId, new byte[] { 5, (byte)(value >> 24), (byte)(value >> 16), (byte)(value >> 8), (byte)value });
+                    break;
+            }
+
+            return ValueTask.CompletedTask;
+        }
+
+        public ValueTask<TResponse?> ReadNextResponseAsync<TResponse>() where TResponse : class, IResponse, new()
+        {
+            throw new NotSupportedException();
+        }
+
+        public ValueTask<ReadOnlyMemory<byte>> ReadNextResponseBytesAsync()
+        {
+            var bytes = _responses.TryDequeue(out var response) ? response : ReadOnlyMemory<byte>.Empty;
+            return ValueTask.FromResult(bytes);
+        }
+
+        public void ReleaseHeldResponses(bool reverseOrder)
+        {
+            if (reverseOrder)
+            {
+                _heldResponses.Reverse();
+            }
+
+            _heldResponses.ForEach(_responses.Enqueue);
+            _heldResponses.Clear();
+        }
+
+        private void Respond(ushort requestId, byte[] response)
+        {
+            if (TagsResponses && requestId != 0)
+            {
+                response = new[] { (byte)(response[0] | 0x80), (byte)(requestId >> 8), (byte)(requestId & 0xFF) }
+                    .Concat(response[1..])
+                    .ToArray();
+            }
+
+            if (HoldResponses)
+            {
+                _heldResponses.Add(response);
+            }
+            else
+            {
+                _responses.Enqueue(response);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+public class PacketFramerV3Tests
+{
+    [Theory]
+    [MemberData(nameof(ValidDecodeTestCases))]
+    public void Can_Decode_Valid_Frame(byte[] input, byte[] expected)
+    {
+        var framer = new PacketFramerV3(1024, 65535);
+        var result = framer.Decode(input.AsSpan());
+        result.InputBytesProcessed.ShouldBe(input.Length);
+        result.IsFragment.ShouldBeFalse();
+        result.DecodedBytes.ToArray().ShouldBeEquivalentTo(expected);
+    }
+
+    [Theory]
+    [MemberData(nameof(InvalidDecodeTestCases))]
+    public void Correctly_Fails_To_Decode_Bad_Cases(byte[] input)
+    {
+        var framer = new PacketFramerV3(1024, 65535);
+        var result = framer.Decode(input.AsSpan());
+        result.DecodedBytes.ToArray().ShouldBeEmpty();
+    }
+
+    [Fact]
+    public void Can_Encode_Operations()
+    {
+        var framer = new PacketFramerV3(1024, 65535);
+        var outputBuffer = new byte[255];
+        var result = framer.Encode(new GetStatusOperation(), outputBuffer.AsSpan());
+        outputBuffer[..result].ToArray().ShouldBeEquivalentTo(new byte[] { 0x02, 0x03, 0x04, 0x04, 0xD5, 0x48, 0x00 });
+    }
+
+    [Theory]
+    [InlineData(1, 1024)]
+    [InlineData(253, 1024)]
+    [InlineData(254, 1024)]
+    [InlineData(255, 1024)]
+    [InlineData(1000, 1024)]
+    [InlineData(1000, 64)]
+    [InlineData(65535, 1024)]
+    [InlineData(65535, 65535)]
+    public void Can_Round_Trip_Messages_Split_Into_Frames(int messageSize, int frameSize)
+    {
+        var message = new byte[messageSize];
+        new Random(messageSize).NextBytes(message);
+        message[messageSize / 2] = 0;
+
+        var framer = new PacketFramerV3(frameSize, 65535);
+        var outputBuffer = new byte[messageSize * 2 + 64];
+        var bytesWritten = framer.Encode(message, outputBuffer);
+
+        var offset = 0;
+        var frameCount = 0;
+        PacketDecodeResult result;
+        do
+        {
+            result = framer.Decode(outputBuffer.AsSpan(offset, bytesWritten - offset));
+            result.InputBytesProcessed.ShouldBeGreaterThan(0);
+            result.InputBytesProcessed.ShouldBeLessThanOrEqualTo(frameSize);
+            offset += result.InputBytesProcessed;
+            frameCount++;
+        } while (result.IsFragment);
+
+        offset.ShouldBe(bytesWritten);
+        frameCount.ShouldBe((messageSize + PacketFramerV3.MaxPayloadSize(frameSize) - 1) /
+                            PacketFramerV3.MaxPayloadSize(frameSize));
+        result.DecodedBytes.ToArray().ShouldBeEquivalentTo(message);
+    }
+
+    [Fact]
+    public void Drops_Message_When_A_Fragment_Is_Missing()
+    {
+        var message = new byte[500];
+        new Random(1).NextBytes(message);
+
+        var framer = new PacketFramerV3(64, 65535);
+        var outputBuffer = new byte[2048];
+        var bytesWritten = framer.Encode(message, outputBuffer);
+        var frames = SplitFrames(outputBuffer[..bytesWritten]);
+
+        framer.Decode(frames[0]).IsFragment.ShouldBeTrue();
+        framer.Decode(frames[1]).IsFragment.ShouldBeTrue();
+
+        // Skip the third fragment
+        var result = framer.Decode(frames[3]);
+        result.IsFragment.ShouldBeFalse();
+        result.DecodedBytes.ToArray().ShouldBeEmpty();
+    }
+
+    public static IEnumerable<object[]> ValidDecodeTestCases()
+    {
+        yield return [new byte[] { 0x02, 0x03, 0x01, 0x03, 0x95, 0xCC, 0x00 }, new byte[] { 0x00 }];
+        yield return
+        [
+            new byte[] { 0x02, 0x03, 0x02, 0x11, 0x04, 0x22, 0x8F, 0xAD, 0x00 },
+            new byte[] { 0x11, 0x00, 0x22 }
+        ];
+
+        yield return
+        [
+            new byte[] { 0x02, 0x03, 0x07, 0x01, 0x02, 0x03, 0x04, 0xCD, 0xF3, 0x00 },
+            new byte[] { 0x01, 0x02, 0x03, 0x04 }
+        ];
+    }
+
+    public static IEnumerable<object[]> InvalidDecodeTestCases()
+    {
+        yield return [new byte[] { 0x02, 0x03, 0x07, 0x01, 0x02, 0x03, 0x05, 0xCD, 0xF3, 0x00 }]; // failed crc
+        yield return [new byte[] { 0x02, 0x03, 0x09, 0x01, 0x02, 0x03, 0x04, 0xCD, 0xF3, 0x00 }]; // run past length
+        yield return [new byte[] { 0x02, 0x03, 0x01, 0x00 }]; // too short
+        yield return [new byte[] { 0x09, 0x02, 0x01, 0x01, 0x02, 0x03, 0x04, 0x22, 0x02, 0x00 }]; // not a first fragment
+    }
+
+    private static List<byte[]> SplitFrames(byte[] bytes)
+    {
+        var frames = new List<byte[]>();
+        var start = 0;
+        for (var x = 0; x < bytes.Length; x++)
+        {
+            if (bytes[x] == 0)
+            {
+                frames.Add(bytes[start..(x + 1)]);
+                start = x + 1;
+            }
+        }
+
+        return frames;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+﻿using Microgpu.Common.Operations;
+using Shouldly;
+
+namespace Microgpu.Common.Tests;
+
+/// <summary>
+/// Checks the C# framers against frames produced by the firmware's packet framing. The vectors are
+/// generated with `microgpu_sdl_framing_benchmark --write-vectors`, which also checks the firmware
+/// against the same file.
+/// </summary>
+public class PacketFramingConformanceTests
+{
+    private static readonly string VectorsPath =
+        Path.Combine(AppContext.BaseDirectory, "TestData", "packet_framing_vectors.txt");
+
+    [Theory]
+    [MemberData(nameof(V2Vectors))]
+    public void V2_Encoding_Matches_Firmware(int line, byte[] message, byte[] expected)
+    {
+        var framer = new PacketFramer();
+        var outputBuffer = new byte[expected.Length];
+        var bytesWritten = framer.Encode(new RawOperation(message), outputBuffer);
+
+        bytesWritten.ShouldBe(expected.Length, $"Line {line}");
+        outputBuffer.ShouldBeEquivalentTo(expected);
+    }
+
+    [Theory]
+    [MemberData(nameof(V2Vectors))]
+    public void V2_Decoding_Matches_Firmware(int line, byte[] message, byte[] expected)
+    {
+        var framer = new PacketFramer();
+        var result = framer.Decode(expected);
+
+        result.InputBytesProcessed.ShouldBe(expected.Length, $"Line {line}");
+        result.DecodedBytes.ToArray().ShouldBeEquivalentTo(message);
+    }
+
+    [Theory]
+    [MemberData(nameof(V3Vectors))]
+    public void V3_Encoding_Matches_Firmware(int line, int frameSize, byte[] message, byte[] expected)
+    {
+        // The encoder wants room for the worst case of every fragment, even if it doesn't use it
+        var framer = new PacketFramerV3(frameSize, PacketFramerV3.MaxMessageSizeLimit);
+        var outputBuffer = new byte[expected.Length + frameSize];
+        var bytesWritten = framer.Encode(message, outputBuffer);
+
+        bytesWritten.ShouldBe(expected.Length, $"Line {line}");
+        outputBuffer[..bytesWritten].ShouldBeEquivalentTo(expected);
+    }
+
+    [Theory]
+    [MemberData(nameof(V3Vectors))]
+    public void V3_Decoding_Matches_Firmware(int line, int frameSize, byte[] message, byte[] expected)
+    {
+        var framer = new PacketFramerV3(frameSize, PacketFramerV3.MaxMessageSizeLimit);
+        var offset = 0;
+        PacketDecodeResult result;
+        do
+        {
+            result = framer.Decode(expected.AsSpan(offset));
+            result.InputBytesProcessed.ShouldBeGreaterThan(0, $"Line {line}");
+            offset += result.InputBytesProcessed;
+        } while (result.IsFragment);
+
+        offset.ShouldBe(expected.Length, $"Line {line}");
+        result.DecodedBytes.ToArray().ShouldBeEquivalentTo(message);
+    }
+
+    public static IEnumerable<object[]> V2Vectors()
+    {
+        return ReadVectors("v2")
+            .Select(x => new object[] { x.Line, Convert.FromHexString(x.Fields[0]), Convert.FromHexString(x.Fields[1]) });
+    }
+
+    public static IEnumerable<object[]> V3Vectors()
+    {
+        // Version 3 vectors have the max frame size before the message and frames
+        return ReadVectors("v3")
+            .Select(x => new object[]
+            {
+                x.Line, int.Parse(x.Fields[0]), Convert.FromHexString(x.Fields[1]), Convert.FromHexString(x.Fields[2])
+            });
+    }
+
+    private static IEnumerable<(int Line, string[] Fields)> ReadVectors(string version)
+    {
+        var lines = File.ReadAllLines(VectorsPath);
+        for (var x = 0; x < lines.Length; x++)
+        {
+            var parts = lines[x].Split(' ', StringSplitOptions.RemoveEmptyEntries);
+            if (parts.Length > 0 && parts[0] == version)
+            {
+                yield return (x + 1, parts[1..]);
+            }
+        }
+    }
+
+    private class RawOperation(byte[] bytes) : IOperation
+    {
+        public int Serialize(Span<byte> output)
+        {
+            bytes.CopyTo(output);
+            return bytes.Length;
+        }
+
+        public int GetSize() => bytes.Length;
+    }
+}
\ No newline at end of file
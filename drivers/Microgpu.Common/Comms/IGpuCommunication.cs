@@ -33,4 +33,10 @@ public interface IGpuCommunication
     /// </summary>
     /// <returns></returns>
     ValueTask<TResponse?> ReadNextResponseAsync<TResponse>() where TResponse : class, IResponse, new();
+
+    /// <summary>
+    /// Reads the bytes of the next response from the GPU without deserializing them, or an empty
+    /// buffer if no response is available. The bytes are only valid until the next response is read.
+    /// </summary>
+    ValueTask<ReadOnlyMemory<byte>> ReadNextResponseBytesAsync();
 }
\ No newline at end of file
@@ -9,6 +9,11 @@ namespace Microgpu.Common.Comms;
 
 public class MeadowSpiGpuCommunication : IGpuCommunication
 {
+    /// <summary>
+    /// How many transactions the gpu keeps queued with its SPI driver
+    /// </summary>
+    private const int QueuedGpuTransactions = 3;
+
     private readonly IDigitalOutputPort _chipSelectPin;
     private readonly IDigitalInputPort _handshakePin;
     private readonly IDigitalOutputPort _resetPin;
@@ -81,30 +86,51 @@ public class MeadowSpiGpuCommunication : IGpuCommunication
 
     public async ValueTask<TResponse?> ReadNextResponseAsync<TResponse>() where TResponse : class, IResponse, new()
     {
-        await WaitForHandshakeAsync();
-        
-        // We only expect one single COBS packet, so we are guaranteed to be at most 255 bytes
-        _spiBus.Read(_chipSelectPin, _buffer.AsSpan(0, 255));
-        var result = _packetFramer.Decode(_buffer);
-
-        if (result.InputBytesProcessed == 0)
+        var bytes = await ReadNextResponseBytesAsync();
+        if (bytes.IsEmpty)
         {
-            // Incomplete packet received
             return null;
         }
 
-        if (result.DecodedBytes.Length == 0)
+        var response = new TResponse();
+        response.Deserialize(bytes.Span);
+        return response;
+    }
+
+    public async ValueTask<ReadOnlyMemory<byte>> ReadNextResponseBytesAsync()
+    {
+        // The gpu keeps several transactions queued, and a response goes out with the first one
+        // queued after it was written. So the transactions queued ahead of it have to be clocked
+        // through before the response shows up.
+        for (var attempt = 0; attempt <= QueuedGpuTransactions; attempt++)
         {
-            // Undecodable packet
-            return null;
+            await WaitForHandshakeAsync();
+
+            // We only expect one single COBS packet, so we are guaranteed to be at most 255 bytes
+            _spiBus.Read(_chipSelectPin, _buffer.AsSpan(0, 255));
+            var result = _packetFramer.Decode(_buffer.AsSpan(0, 255));
+
+            if (result.InputBytesProcessed == 0)
+            {
+                // Incomplete packet received
+                return ReadOnlyMemory<byte>.Empty;
+            }
+
+            if (result.InputBytesProcessed > 1)
+            {
+                // Undecodable packets decode to nothing
+                return result.DecodedBytes;
+            }
         }
-        
-        var response = new TResponse();
-        response.Deserialize(result.DecodedBytes.Span);
 
-        return response;
+        return ReadOnlyMemory<byte>.Empty;
     }
 
+    /// <summary>
+    /// Waits for the gpu to have room for another transaction. The handshake line acts as the
+    /// gpu's credit, and is only high while it has at least one more transaction queued beyond
+    /// the one that may have just finished.
+    /// </summary>
     private async Task WaitForHandshakeAsync()
     {
         var startedAt = DateTime.Now;
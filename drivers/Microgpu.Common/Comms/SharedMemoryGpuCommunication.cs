@@ -0,0 +1,354 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+using Microgpu.Common.Operations;
+using Microgpu.Common.Responses;
+
+namespace Microgpu.Common.Comms;
+
+/// <summary>
+/// Talks to a gpu running on the same machine through the file its shared memory databus is
+/// mapped from. Operations are serialized straight into the gpu's operation ring without any
+/// packet framing, and responses are read straight out of its response ring. The layout of the
+/// file is described in the firmware's shm_databus.h.
+/// </summary>
+public class SharedMemoryGpuCommunication : IGpuCommunication, IDisposable
+{
+    public const string DefaultPath = "/dev/shm/microgpu";
+
+    private const uint Magic = 0x4853474D;
+    private const uint LayoutVersion = 1;
+    private const uint WrapMarker = 0xFFFFFFFF;
+    private const int HeaderSize = 4096;
+
+    private const int MagicOffset = 0;
+    private const int LayoutVersionOffset = 4;
+    private const int OperationRingSizeOffset = 8;
+    private const int ResponseRingSizeOffset = 12;
+    private const int ConnectRequestOffset = 64;
+    private const int ConnectAcknowledgementOffset = 128;
+    private const int OperationHeadOffset = 192;
+    private const int OperationTailOffset = 256;
+    private const int ResponseHeadOffset = 320;
+    private const int ResponseTailOffset = 384;
+    private const int GpuSleepingOffset = 448;
+
+    private static readonly TimeSpan ConnectTimeout = TimeSpan.FromSeconds(5);
+    private static readonly TimeSpan ResponseTimeout = TimeSpan.FromSeconds(5);
+
+    private readonly string _path;
+    private readonly Queue<IFireAndForgetOperation> _operations = new();
+    private byte[] _responseBuffer = new byte[1024];
+    private MemoryMappedFile? _file;
+    private MemoryMappedViewAccessor? _view;
+    private unsafe byte* _memory;
+    private uint _operationRingSize, _responseRingSize;
+    private uint _operationHead, _publishedOperationHead;
+    private bool _canWakeGpu = RuntimeInformation.IsOSPlatform(OSPlatform.Linux) && FutexSyscallNumber() > 0;
+
+    public SharedMemoryGpuCommunication(string path = DefaultPath)
+    {
+        _path = path;
+    }
+
+    public unsafe void Dispose()
+    {
+        if (_memory != null)
+        {
+            _view!.SafeMemoryMappedViewHandle.ReleasePointer();
+            _memory = null;
+        }
+
+        _view?.Dispose();
+        _file?.Dispose();
+    }
+
+    public async ValueTask ResetAsync()
+    {
+        await ConnectAsync();
+    }
+
+    public void EnqueueOutboundOperation(IFireAndForgetOperation operation)
+    {
+        _operations.Enqueue(operation);
+    }
+
+    public async ValueTask SendQueuedOutboundOperationsAsync()
+    {
+        // Operations are only published together, so the gpu is woken once for the whole batch
+        while (_operations.TryDequeue(out var operationToSend))
+        {
+            await WriteOperationAsync(operationToSend);
+        }
+
+        PublishOperations();
+    }
+
+    public async ValueTask SendImmediateOperationAsync(IOperation operation)
+    {
+        await WriteOperationAsync(operation);
+        PublishOperations();
+    }
+
+    public async ValueTask<TResponse?> ReadNextResponseAsync<TResponse>() where TResponse : class, IResponse, new()
+    {
+        var bytes = await ReadNextResponseBytesAsync();
+        if (bytes.IsEmpty)
+        {
+            return null;
+        }
+
+        var response = new TResponse();
+        response.Deserialize(bytes.Span);
+        return response;
+    }
+
+    public async ValueTask<ReadOnlyMemory<byte>> ReadNextResponseBytesAsync()
+    {
+        var stopwatch = Stopwatch.StartNew();
+        var attempt = 0;
+        while (true)
+        {
+            var responseSize = TryReadResponse();
+            if (responseSize > 0)
+            {
+                return _responseBuffer.AsMemory(0, responseSize);
+            }
+
+            if (stopwatch.Elapsed > ResponseTimeout)
+            {
+                return ReadOnlyMemory<byte>.Empty;
+            }
+
+            await WaitAsync(attempt++);
+        }
+    }
+
+    private async ValueTask ConnectAsync()
+    {
+        if (IsAttached()) return;
+
+        Attach();
+        var request = RequestConnection();
+
+        // The gpu acknowledges the connection once it has cleared out the rings
+        var stopwatch = Stopwatch.StartNew();
+        var attempt = 0;
+        while (ReadCounter(ConnectAcknowledgementOffset) != request)
+        {
+            if (stopwatch.Elapsed > ConnectTimeout)
+            {
+                throw new TimeoutException($"Gpu did not accept the connection through {_path}");
+            }
+
+            await WaitAsync(attempt++);
+        }
+
+        _operationHead = 0;
+        _publishedOperationHead = 0;
+    }
+
+    private async ValueTask WriteOperationAsync(IOperation operation)
+    {
+        var attempt = 0;
+        while (!TryWriteOperation(operation))
+        {
+            // The ring is full, so let the gpu see everything written so far and wait for it to catch up
+            PublishOperations();
+            await WaitAsync(attempt++);
+        }
+    }
+
+    private static async ValueTask WaitAsync(int attempt)
+    {
+        // The gpu usually gets to things quickly, but don't keep a core busy when it doesn't
+        if (attempt < 100)
+        {
+            Thread.SpinWait(20);
+        }
+        else
+        {
+            await Task.Delay(1);
+        }
+    }
+
+    private unsafe bool IsAttached()
+    {
+        return _memory != null;
+    }
+
+    private unsafe void Attach()
+    {
+        _file = MemoryMappedFile.CreateFromFile(_path, FileMode.Open, null, 0, MemoryMappedFileAccess.ReadWrite);
+        _view = _file.CreateViewAccessor(0, 0, MemoryMappedFileAccess.ReadWrite);
+
+        byte* pointer = null;
+        _view.SafeMemoryMappedViewHandle.AcquirePointer(ref pointer);
+        _memory = pointer + _view.PointerOffset;
+
+        if (ReadCounter(MagicOffset) != Magic || ReadCounter(LayoutVersionOffset) != LayoutVersion)
+        {
+            Dispose();
+            throw new InvalidOperationException($"{_path} is not a microgpu shared memory databus");
+        }
+
+        _operationRingSize = ReadCounter(OperationRingSizeOffset);
+        _responseRingSize = ReadCounter(ResponseRingSizeOffset);
+    }
+
+    private unsafe uint RequestConnection()
+    {
+        return (uint)Interlocked.Increment(ref *(int*)(_memory + ConnectRequestOffset));
+    }
+
+    private unsafe bool TryWriteOperation(IOperation operation)
+    {
+        var size = operation.GetSize();
+        if (size > ushort.MaxValue)
+        {
+            var message = $"Operation of {size} bytes is larger than the {ushort.MaxValue} bytes " +
+                          "the gpu can receive";
+
+            throw new InvalidOperationException(message);
+        }
+
+        var entrySize = EntrySize((uint)size);
+        var offset = _operationHead & (_operationRingSize - 1);
+        var bytesUntilEnd = _operationRingSize - offset;
+        var requiredBytes = entrySize + (bytesUntilEnd < entrySize ? bytesUntilEnd : 0);
+        if (_operationRingSize - (_operationHead - ReadCounter(OperationTailOffset)) < requiredBytes)
+        {
+            return false;
+        }
+
+        var operationRing = _memory + HeaderSize;
+        if (bytesUntilEnd < entrySize)
+        {
+            // Entries never wrap, so start over at the beginning of the ring
+            *(uint*)(operationRing + offset) = WrapMarker;
+            _operationHead += bytesUntilEnd;
+            offset = 0;
+        }
+
+        var bytesWritten = operation.Serialize(new Span<byte>(operationRing + offset + 4, size));
+        *(uint*)(operationRing + offset) = (uint)bytesWritten;
+        _operationHead += EntrySize((uint)bytesWritten);
+
+        return true;
+    }
+
+    private void PublishOperations()
+    {
+        if (_operationHead == _publishedOperationHead) return;
+
+        // A full fence, so the gpu either sees the new head or has already marked itself as sleeping
+        ExchangeCounter(OperationHeadOffset, _operationHead);
+        _publishedOperationHead = _operationHead;
+
+        if (_canWakeGpu && ReadCounter(GpuSleepingOffset) != 0)
+        {
+            WakeGpu(OperationHeadOffset);
+        }
+    }
+
+    /// <summary>
+    /// Copies the next response out of the ring, and returns its size or zero if there wasn't one
+    /// </summary>
+    private unsafe int TryReadResponse()
+    {
+        var responseRing = _memory + HeaderSize + _operationRingSize;
+        while (true)
+        {
+            var head = ReadCounter(ResponseHeadOffset);
+            var tail = ReadCounter(ResponseTailOffset);
+            if (head == tail)
+            {
+                return 0;
+            }
+
+            var offset = tail & (_responseRingSize - 1);
+            var length = *(uint*)(responseRing + offset);
+            if (length == WrapMarker)
+            {
+                ReleaseResponses(tail + _responseRingSize - offset);
+                continue;
+            }
+
+            if (EntrySize(length) > head - tail || EntrySize(length) > _responseRingSize - offset)
+            {
+                // Not a valid entry, so nothing after it can be trusted either
+                ReleaseResponses(head);
+                return 0;
+            }
+
+            if (_responseBuffer.Length < length)
+            {
+                _responseBuffer = new byte[length];
+            }
+
+            new ReadOnlySpan<byte>(responseRing + offset + 4, (int)length).CopyTo(_responseBuffer);
+            ReleaseResponses(tail + EntrySize(length));
+
+            return (int)length;
+        }
+    }
+
+    private void ReleaseResponses(uint newTail)
+    {
+        ExchangeCounter(ResponseTailOffset, newTail);
+
+        // The gpu only waits on the response tail when the ring is full
+        if (_canWakeGpu && ReadCounter(GpuSleepingOffset) != 0)
+        {
+            WakeGpu(ResponseTailOffset);
+        }
+    }
+
+    private static uint EntrySize(uint length)
+    {
+        return 4 + ((length + 3) & ~3u);
+    }
+
+    private unsafe uint ReadCounter(int offset)
+    {
+        return (uint)Volatile.Read(ref *(int*)(_memory + offset));
+    }
+
+    private unsafe void ExchangeCounter(int offset, uint value)
+    {
+        Interlocked.Exchange(ref *(int*)(_memory + offset), (int)value);
+    }
+
+    private unsafe void WakeGpu(int offset)
+    {
+        const int futexWake = 1;
+        try
+        {
+            Syscall(FutexSyscallNumber(), (IntPtr)(_memory + offset), futexWake, int.MaxValue, IntPtr.Zero, IntPtr.Zero, 0);
+        }
+        catch (Exception exception) when (exception is DllNotFoundException or EntryPointNotFoundException)
+        {
+            // The gpu checks for changes on its own every millisecond anyway
+            _canWakeGpu = false;
+        }
+    }
+
+    private static long FutexSyscallNumber()
+    {
+        return RuntimeInformation.ProcessArchitecture switch
+        {
+            Architecture.X64 => 202,
+            Architecture.Arm64 => 98,
+            _ => 0,
+        };
+    }
+
+    [DllImport("libc", EntryPoint = "syscall")]
+    private static extern long Syscall(long number, IntPtr address, int operation, int value, IntPtr timeout,
+        IntPtr address2, int value3);
+}
\ No newline at end of file
@@ -9,13 +9,22 @@ namespace Microgpu.Common.Comms;
 
 public class TcpGpuCommunication : IGpuCommunication, IDisposable
 {
-    private readonly byte[] _buffer = new byte[1026];
+    private byte[] _buffer = new byte[1026];
+    private readonly byte[] _responseBuffer = new byte[2048];
+    private int _responseBytesBuffered;
     private readonly string _host;
     private readonly int _port;
     private readonly TcpClient _tcpClient = new();
     private readonly Queue<IFireAndForgetOperation> _operations = new();
-    private readonly PacketFramer _packetFramer = new();
+    private readonly Queue<byte[]> _heldResponses = new();
+    private IPacketFramer _packetFramer = new PacketFramer();
     private NetworkStream? _networkStream;
+    private bool _isConnectionClosed;
+
+    // Once the gpu sends credits, bytes are only written while they stay within its credit limit
+    private bool _creditsEnabled;
+    private uint _bytesSentSinceCredits;
+    private uint _creditLimit;
 
     public TcpGpuCommunication(string host, int port)
     {
@@ -47,9 +56,24 @@ public class TcpGpuCommunication : IGpuCommunication, IDisposable
 
     public async ValueTask SendQueuedOutboundOperationsAsync()
     {
+        // Operations are written together, so small operations aren't each sent as their own segment
+        var bufferBytesWritten = 0;
         while (_operations.TryDequeue(out var operationToSend))
         {
-            await SendDataAsync(operationToSend);
+            var sizeRequired = _packetFramer.BufferSizeRequired(operationToSend);
+            if (bufferBytesWritten + sizeRequired > _buffer.Length && bufferBytesWritten > 0)
+            {
+                await WriteAsync(_buffer.AsMemory(0, bufferBytesWritten));
+                bufferBytesWritten = 0;
+            }
+
+            EnsureBufferSize(sizeRequired);
+            bufferBytesWritten += _packetFramer.Encode(operationToSend, _buffer.AsSpan(bufferBytesWritten));
+        }
+
+        if (bufferBytesWritten > 0)
+        {
+            await WriteAsync(_buffer.AsMemory(0, bufferBytesWritten));
         }
     }
 
@@ -60,42 +84,175 @@ public class TcpGpuCommunication : IGpuCommunication, IDisposable
 
     public async ValueTask<TResponse?> ReadNextResponseAsync<TResponse>() where TResponse : class, IResponse, new()
     {
-        // We should only have one response at a time, since each response is a 
-        // direct reaction to a non-fire and forget question. So just keep reading
-        // until we get a full packet or read more than 255 bytes.
-        var totalRead = 0;
+        var bytes = await ReadNextResponseBytesAsync();
+        if (bytes.IsEmpty)
+        {
+            return null;
+        }
+
+        var response = new TResponse();
+        response.Deserialize(bytes.Span);
+        return response;
+    }
+
+    public async ValueTask<ReadOnlyMemory<byte>> ReadNextResponseBytesAsync()
+    {
+        if (_heldResponses.TryDequeue(out var heldResponse))
+        {
+            return heldResponse;
+        }
+
+        while (true)
+        {
+            var bytes = await ReadNextFrameAsync();
+            if (!TryTakeCredits(bytes.Span))
+            {
+                return bytes;
+            }
+        }
+    }
+
+    private async ValueTask<ReadOnlyMemory<byte>> ReadNextFrameAsync()
+    {
+        // Several responses can arrive together when requests are pipelined, so anything read
+        // past the end of a response is kept around for the next call.
         while (true)
         {
-            var bytesRead = await _networkStream!.ReadAsync(_buffer.AsMemory(totalRead));
-            totalRead += bytesRead;
-            
             // Did we get a complete packet?
-            var result = _packetFramer.Decode(_buffer[..totalRead]);
+            var result = _packetFramer.Decode(_responseBuffer.AsSpan(0, _responseBytesBuffered));
             if (result.InputBytesProcessed == 0)
             {
+                if (_responseBytesBuffered == _responseBuffer.Length)
+                {
+                    // Filled the buffer without a packet boundary, so the data is corrupted
+                    _responseBytesBuffered = 0;
+                    return ReadOnlyMemory<byte>.Empty;
+                }
+
                 // We didn't have a complete packet so keep reading
+                var bytesRead = await _networkStream!.ReadAsync(_responseBuffer.AsMemory(_responseBytesBuffered));
+                if (bytesRead == 0)
+                {
+                    // Connection was closed
+                    _isConnectionClosed = true;
+                    return ReadOnlyMemory<byte>.Empty;
+                }
+
+                _responseBytesBuffered += bytesRead;
                 continue;
             }
-            
-            // We found a packet boundary
-            if (result.DecodedBytes.Length == 0)
+
+            // Decoded bytes are copied out by the framer, so the consumed frame can be dropped right away
+            _responseBytesBuffered -= result.InputBytesProcessed;
+            Buffer.BlockCopy(_responseBuffer, result.InputBytesProcessed, _responseBuffer, 0, _responseBytesBuffered);
+
+            if (result.IsFragment)
             {
-                // Corrupted packet
-                return null;
+                // Only part of the response, so look for the next frame
+                continue;
             }
 
-            var response = new TResponse();
-            response.Deserialize(result.DecodedBytes.Span);
-            return response;
+            // We found a packet boundary, and corrupted packets decode to nothing
+            return result.DecodedBytes;
         }
     }
 
     private async Task SendDataAsync(IOperation operation)
     {
+        EnsureBufferSize(_packetFramer.BufferSizeRequired(operation));
         var bytesWritten = _packetFramer.Encode(operation, _buffer.AsSpan());
         if (bytesWritten > 0)
         {
-            await _networkStream!.WriteAsync(_buffer.AsMemory(0, bytesWritten));
+            await WriteAsync(_buffer.AsMemory(0, bytesWritten));
+        }
+    }
+
+    private async ValueTask WriteAsync(ReadOnlyMemory<byte> bytes)
+    {
+        // Compared by difference, since both counts wrap around
+        while (_creditsEnabled && (int)(_creditLimit - (_bytesSentSinceCredits + (uint)bytes.Length)) < 0)
+        {
+            var response = await ReadNextFrameAsync();
+            if (_isConnectionClosed)
+            {
+                throw new InvalidOperationException("Connection closed while waiting for credits");
+            }
+
+            // Responses that arrive in the meantime are held for whoever is waiting on them
+            if (!response.IsEmpty && !TryTakeCredits(response.Span))
+            {
+                _heldResponses.Enqueue(response.ToArray());
+            }
+        }
+
+        _bytesSentSinceCredits += (uint)bytes.Length;
+        await _networkStream!.WriteAsync(bytes);
+    }
+
+    private bool TryTakeCredits(ReadOnlySpan<byte> bytes)
+    {
+        if (bytes.IsEmpty || bytes[0] != (byte)ResponseType.Credits)
+        {
+            return false;
+        }
+
+        var credits = new CreditsResponse();
+        credits.Deserialize(bytes);
+        _creditLimit = credits.ByteLimit;
+
+        return true;
+    }
+
+    /// <summary>
+    /// Switches to the newest packet framing both sides support, so operations aren't limited to 250 bytes.
+    /// Every connection starts with the original framing.
+    /// </summary>
+    private async ValueTask NegotiateFramingAsync()
+    {
+        _packetFramer = new PacketFramer();
+
+        // Older gpus don't know the negotiation operation and would never respond, so check for support first
+        await SendDataAsync(new GetStatusOperation());
+        var status = await ReadNextResponseAsync<StatusResponse>();
+        if (status == null || status.MaxFramingVersion < PacketFramerV3.Version)
+        {
+            return;
+        }
+
+        await SendDataAsync(new NegotiateFramingOperation { Version = PacketFramerV3.Version });
+        var framing = await ReadNextResponseAsync<FramingResponse>();
+        if (framing?.Version == PacketFramerV3.Version)
+        {
+            _packetFramer = new PacketFramerV3(framing.MaxFrameSize, framing.MaxMessageSize);
+            EnsureBufferSize(framing.MaxFrameSize);
+        }
+    }
+
+    /// <summary>
+    /// Asks the gpu to send credits, so operations are never written faster than it can buffer them.
+    /// </summary>
+    private async ValueTask EnableCreditsAsync()
+    {
+        _creditsEnabled = false;
+        await SendDataAsync(new EnableCreditsOperation());
+        _bytesSentSinceCredits = 0;
+
+        // The gpu sends its first credits as soon as it receives the request, so they come before
+        // the status. Gpus that don't support credits only send the status.
+        await SendDataAsync(new GetStatusOperation());
+        var response = await ReadNextFrameAsync();
+        if (TryTakeCredits(response.Span))
+        {
+            _creditsEnabled = true;
+            await ReadNextFrameAsync();
+        }
+    }
+
+    private void EnsureBufferSize(int size)
+    {
+        if (_buffer.Length < size)
+        {
+            _buffer = new byte[size];
         }
     }
 
@@ -105,5 +262,8 @@ public class TcpGpuCommunication : IGpuCommunication, IDisposable
 
         await _tcpClient.ConnectAsync(_host, _port);
         _networkStream = _tcpClient.GetStream();
+        _isConnectionClosed = false;
+        await NegotiateFramingAsync();
+        await EnableCreditsAsync();
     }
 }
\ No newline at end of file
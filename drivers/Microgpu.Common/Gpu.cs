@@ -1,4 +1,5 @@
 ﻿using System;
+using System.Collections.Generic;
 using System.Numerics;
 using System.Threading.Tasks;
 using Microgpu.Common.Comms;
@@ -10,10 +11,14 @@ namespace Microgpu.Common;
 public class Gpu
 {
     public const ushort ValidApiVersionId = 2;
+    private const byte TaggedResponseFlag = 0x80;
     
     private readonly IGpuCommunication _communication;
+    private readonly Dictionary<ushort, PendingRequest> _pendingRequests = new();
+    private readonly List<ushort> _unansweredRequestIds = new();
     private byte[] _readBuffer = new byte[1024];
     private byte[] _writeBuffer = new byte[1024];
+    private ushort _lastRequestId;
 
     private Gpu(IGpuCommunication communication)
     {
@@ -40,6 +45,11 @@ public class Gpu
     ///     The resolution of the frame buffer in pixels. This will be null if the GPU is not initialized.
     /// </summary>
     public Vector2? FrameBufferResolution { get; private set; }
+
+    /// <summary>
+    ///     The largest operation, in bytes, the GPU can currently receive
+    /// </summary>
+    public int MaxOperationSize { get; private set; } = 250;
     
     /// <summary>
     ///     Creates a new GPU instance and initializes it
@@ -97,11 +107,108 @@ public class Gpu
     /// </summary>
     public async ValueTask<TResponse?> SendResponsiveOperationAsync<TResponse>(IResponsiveOperation<TResponse> operation)
         where TResponse : class, IResponse, new()
+    {
+        var pendingResponse = await BeginResponsiveOperationAsync(operation);
+        return await pendingResponse.GetResponseAsync();
+    }
+
+    /// <summary>
+    /// Sends an operation to the GPU without waiting for its response, so more operations can be sent while
+    /// the GPU works on it. The operation is tagged with a request id, which lets its response be picked out
+    /// even when responses to other requests arrive first. Every pending response must eventually be awaited,
+    /// since responses are only read from the GPU while one is being waited on.
+    /// </summary>
+    public async ValueTask<PendingResponse<TResponse>> BeginResponsiveOperationAsync<TResponse>(
+        IResponsiveOperation<TResponse> operation)
+        where TResponse : class, IResponse, new()
     {
         operation = operation ?? throw new ArgumentNullException(nameof(operation));
 
+        operation.RequestId = NextRequestId();
+        _pendingRequests.Add(operation.RequestId, new PendingRequest(new TResponse()));
+        _unansweredRequestIds.Add(operation.RequestId);
+
         await _communication.SendImmediateOperationAsync(operation);
-        return await _communication.ReadNextResponseAsync<TResponse>();
+        return new PendingResponse<TResponse>(this, operation.RequestId);
+    }
+
+    internal async ValueTask<TResponse?> WaitForResponseAsync<TResponse>(ushort requestId)
+        where TResponse : class, IResponse, new()
+    {
+        if (!_pendingRequests.TryGetValue(requestId, out var request))
+        {
+            return null;
+        }
+
+        while (!request.HasResponse)
+        {
+            var bytes = await _communication.ReadNextResponseBytesAsync();
+            if (bytes.IsEmpty)
+            {
+                // Nothing came back, so stop waiting on this request
+                _unansweredRequestIds.Remove(requestId);
+                break;
+            }
+
+            HandleResponse(bytes.Span);
+        }
+
+        _pendingRequests.Remove(requestId);
+        return request.HasResponse ? (TResponse)request.Response : null;
+    }
+
+    /// <summary>
+    /// Deserializes a response into the pending request it belongs to, which isn't necessarily the one being
+    /// waited on. Responses to other requests are held until they're asked for.
+    /// </summary>
+    private void HandleResponse(ReadOnlySpan<byte> bytes)
+    {
+        ushort requestId;
+        if ((bytes[0] & TaggedResponseFlag) != 0 && bytes.Length >= 3)
+        {
+            requestId = (ushort)((bytes[1] << 8) | bytes[2]);
+
+            // Responses expect their type byte first, so put it back in front of the rest of the response
+            var untaggedSize = bytes.Length - 2;
+            if (_readBuffer.Length < untaggedSize)
+            {
+                _readBuffer = new byte[untaggedSize];
+            }
+
+            _readBuffer[0] = (byte)(bytes[0] & ~TaggedResponseFlag);
+            bytes[3..].CopyTo(_readBuffer.AsSpan(1));
+            bytes = _readBuffer.AsSpan(0, untaggedSize);
+        }
+        else if (_unansweredRequestIds.Count > 0)
+        {
+            // Gpus that don't know about request ids respond untagged, but always in order
+            requestId = _unansweredRequestIds[0];
+        }
+        else
+        {
+            Console.WriteLine($"Warning: Dropping response of type {bytes[0]} that no request is waiting for");
+            return;
+        }
+
+        if (!_unansweredRequestIds.Remove(requestId))
+        {
+            Console.WriteLine($"Warning: Dropping response to unknown request {requestId}");
+            return;
+        }
+
+        var request = _pendingRequests[requestId];
+        request.Response.Deserialize(bytes);
+        request.HasResponse = true;
+    }
+
+    private ushort NextRequestId()
+    {
+        do
+        {
+            _lastRequestId++;
+        } while (_lastRequestId == 0 || _pendingRequests.ContainsKey(_lastRequestId));
+
+        return _lastRequestId;
     }
 
     private static async Task GetAndApplyStatus(Gpu gpu)
@@ -132,6 +239,7 @@ public class Gpu
         {
             _writeBuffer = new byte[status.MaxBytes];
             _readBuffer = new byte[status.MaxBytes];
+            MaxOperationSize = status.MaxBytes;
         }
         
         if (status.ApiVersionId != ValidApiVersionId)
@@ -142,4 +250,15 @@ public class Gpu
             throw new InvalidOperationException(message);
         }
     }
+
+    private class PendingRequest
+    {
+        public PendingRequest(IResponse response)
+        {
+            Response = response;
+        }
+
+        public IResponse Response { get; }
+        public bool HasResponse { get; set; }
+    }
 }
\ No newline at end of file
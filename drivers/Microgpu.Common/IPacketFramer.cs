@@ -0,0 +1,26 @@
+﻿using System;
+using Microgpu.Common.Operations;
+
+namespace Microgpu.Common;
+
+/// <summary>
+/// Encodes operations into framed packets, and reads framed packets out of a buffer.
+/// </summary>
+public interface IPacketFramer
+{
+    /// <summary>
+    /// Gets the number of bytes required to encode this operation into the buffer
+    /// </summary>
+    int BufferSizeRequired(IOperation operation);
+
+    /// <summary>
+    /// Serialize and encodes the operation into the provided buffer
+    /// </summary>
+    /// <returns>The total number of bytes written to the output buffer</returns>
+    int Encode(IOperation operation, Span<byte> outputBuffer);
+
+    /// <summary>
+    /// Attempts to decode the first packet in the buffer
+    /// </summary>
+    PacketDecodeResult Decode(ReadOnlySpan<byte> buffer);
+}
\ No newline at end of file
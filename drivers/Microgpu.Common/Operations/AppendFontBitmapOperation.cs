@@ -0,0 +1,36 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Appends bytes to the bitmap of a font defined with a DefineFontOperation, or to the outlines
+/// of a font defined with a DefineOutlineFontOperation.
+/// </summary>
+public class AppendFontBitmapOperation : IFireAndForgetOperation
+{
+    public required byte FontId { get; init; }
+    public required Memory<byte> Bytes { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        var size = GetSize();
+        if (bytes.Length < size)
+        {
+            var message = $"AppendFontBitmap requires {size} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        bytes[0] = 27;
+        bytes[1] = FontId;
+        bytes[2] = (byte)(Bytes.Length >> 8);
+        bytes[3] = (byte)(Bytes.Length & 0xFF);
+        Bytes.Span.CopyTo(bytes[4..]);
+
+        return size;
+    }
+
+    public int GetSize()
+    {
+        return 4 + Bytes.Length;
+    }
+}
\ No newline at end of file
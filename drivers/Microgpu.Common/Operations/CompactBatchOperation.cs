@@ -0,0 +1,329 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// A batch of operations where draws are encoded with varints, start positions are relative to
+/// the operation before them, and the target, color and size are left out when they are the same
+/// as the previous operation's. Operations without a compact encoding, including characters drawn
+/// with a background color, are added as is.
+/// </summary>
+public class CompactBatchOperation<TColor> : IFireAndForgetOperation where TColor : struct, IColorType
+{
+    private const byte SameTarget = 0x20;
+    private const byte SameColor = 0x40;
+    private const byte SameSize = 0x80;
+    private const int HeaderSize = 3;
+
+    private readonly byte[] _buffer;
+    private readonly byte[] _scratch = new byte[300];
+    private int _offset;
+    private State _state;
+
+    private struct State
+    {
+        public int X, Y;
+        public byte TargetTextureId;
+        public uint Color;
+        public ushort Width, Height;
+        public ushort SourceX, SourceY, SourceWidth, SourceHeight;
+        public byte FontId;
+    }
+
+    /// <param name="maxSize">
+    /// The most bytes the serialized batch can take up, which should be no more than the gpu's
+    /// max operation size.
+    /// </param>
+    public CompactBatchOperation(int maxSize)
+    {
+        if (maxSize <= HeaderSize)
+        {
+            var message = $"A compact batch needs more than {HeaderSize} bytes, but only {maxSize} were allowed";
+            throw new ArgumentException(message);
+        }
+
+        _buffer = new byte[maxSize - HeaderSize];
+    }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        if (bytes.Length < GetSize())
+        {
+            var message = $"Buffer had a size of {bytes.Length} but {GetSize()} was required.";
+            throw new ArgumentException(message);
+        }
+
+        bytes[0] = 20;
+        bytes[1] = (byte)(_offset >> 8);
+        bytes[2] = (byte)(_offset & 0xFF);
+        _buffer.AsSpan(0, _offset).CopyTo(bytes[HeaderSize..]);
+
+        var totalBytes = _offset + HeaderSize;
+        _offset = 0;
+        _state = new State();
+
+        return totalBytes;
+    }
+
+    public int GetSize()
+    {
+        return _offset + HeaderSize;
+    }
+
+    /// <summary>
+    /// Adds the operation into the batch.
+    /// </summary>
+    /// <returns>True if the operation was added, false if there was not enough space</returns>
+    public bool AddOperation(IFireAndForgetOperation operation)
+    {
+        var state = _state;
+        var scratch = _scratch.AsSpan();
+        var length = operation switch
+        {
+            DrawRectangleOperation<TColor> rectangle => EncodeRectangle(rectangle, ref state, scratch),
+            DrawTriangleOperation<TColor> triangle => EncodeTriangle(triangle, ref state, scratch),
+            DrawTextureOperation texture => EncodeTexture(texture, ref state, scratch),
+            DrawCharsOperation<TColor> { BackgroundColor: null } chars => EncodeChars(chars, ref state, scratch),
+            DrawSubTextureOperation subTexture => EncodeSubTexture(subTexture, ref state, scratch),
+            _ => -1,
+        };
+
+        if (length < 0)
+        {
+            return AddRawOperation(operation);
+        }
+
+        if (_offset + length > _buffer.Length)
+        {
+            return false;
+        }
+
+        scratch[..length].CopyTo(_buffer.AsSpan(_offset));
+        _offset += length;
+        _state = state;
+
+        return true;
+    }
+
+    public bool HasAnyOperations()
+    {
+        return _offset > 0;
+    }
+
+    private bool AddRawOperation(IFireAndForgetOperation operation)
+    {
+        var size = operation.GetSize();
+        var prefixSize = 1 + VarintSize((uint)size);
+        if (_offset + prefixSize + size > _buffer.Length)
+        {
+            return false;
+        }
+
+        var index = _offset;
+        _buffer[index++] = 0;
+        WriteVarint(_buffer, ref index, (uint)size);
+        index += operation.Serialize(_buffer.AsSpan(index));
+        _offset = index;
+
+        return true;
+    }
+
+    private static int EncodeRectangle(DrawRectangleOperation<TColor> rectangle, ref State state, Span<byte> bytes)
+    {
+        var index = 1;
+        byte header = 2;
+        header |= WriteTarget(rectangle.TextureId, ref state, bytes, ref index);
+        WritePosition(rectangle.StartX, rectangle.StartY, ref state, bytes, ref index);
+
+        if (rectangle.Width == state.Width && rectangle.Height == state.Height)
+        {
+            header |= SameSize;
+        }
+        else
+        {
+            state.Width = rectangle.Width;
+            state.Height = rectangle.Height;
+            WriteVarint(bytes, ref index, rectangle.Width);
+            WriteVarint(bytes, ref index, rectangle.Height);
+        }
+
+        header |= WriteColor(rectangle.Color, ref state, bytes, ref index);
+        bytes[0] = header;
+
+        return index;
+    }
+
+    private static int EncodeTriangle(DrawTriangleOperation<TColor> triangle, ref State state, Span<byte> bytes)
+    {
+        var index = 1;
+        byte header = 3;
+        header |= WriteTarget(triangle.TextureId, ref state, bytes, ref index);
+        WritePosition(triangle.X0, triangle.Y0, ref state, bytes, ref index);
+        WriteDelta(bytes, ref index, state.X, triangle.X1);
+        WriteDelta(bytes, ref index, state.Y, triangle.Y1);
+        WriteDelta(bytes, ref index, state.X, triangle.X2);
+        WriteDelta(bytes, ref index, state.Y, triangle.Y2);
+        header |= WriteColor(triangle.Color, ref state, bytes, ref index);
+        bytes[0] = header;
+
+        return index;
+    }
+
+    private static int EncodeTexture(DrawTextureOperation texture, ref State state, Span<byte> bytes)
+    {
+        var index = 1;
+        byte header = 11;
+        bytes[index++] = texture.SourceTextureId;
+        header |= WriteTarget(texture.TargetTextureId, ref state, bytes, ref index);
+
+        if (texture.SourceStartX == state.SourceX &&
+            texture.SourceStartY == state.SourceY &&
+            texture.SourceWidth == state.SourceWidth &&
+            texture.SourceHeight == state.SourceHeight)
+        {
+            header |= SameSize;
+        }
+        else
+        {
+            state.SourceX = texture.SourceStartX;
+            state.SourceY = texture.SourceStartY;
+            state.SourceWidth = texture.SourceWidth;
+            state.SourceHeight = texture.SourceHeight;
+            WriteVarint(bytes, ref index, texture.SourceStartX);
+            WriteVarint(bytes, ref index, texture.SourceStartY);
+            WriteVarint(bytes, ref index, texture.SourceWidth);
+            WriteVarint(bytes, ref index, texture.SourceHeight);
+        }
+
+        WritePosition(texture.TargetStartX, texture.TargetStartY, ref state, bytes, ref index);
+        bytes[index++] = (byte)((texture.IgnoreTransparency ? 1 : 0) |
+                                (texture.FlipHorizontally ? 2 : 0) |
+                                (texture.FlipVertically ? 4 : 0));
+        bytes[0] = header;
+
+        return index;
+    }
+
+    private static int EncodeChars(DrawCharsOperation<TColor> chars, ref State state, Span<byte> bytes)
+    {
+        var text = chars.Text ?? string.Empty;
+        if (text.Length > 255)
+        {
+            var message = $"Attempting to draw {text.Length} chars which exceeds the max of 255";
+            throw new InvalidOperationException(message);
+        }
+
+        var index = 1;
+        byte header = 12;
+        header |= WriteTarget(chars.TextureId, ref state, bytes, ref index);
+
+        if ((byte)chars.Font == state.FontId)
+        {
+            header |= SameSize;
+        }
+        else
+        {
+            state.FontId = (byte)chars.Font;
+            bytes[index++] = state.FontId;
+        }
+
+        WritePosition(chars.StartX, chars.StartY, ref state, bytes, ref index);
+        header |= WriteColor(chars.Color, ref state, bytes, ref index);
+
+        WriteVarint(bytes, ref index, (uint)text.Length);
+        foreach (var character in text)
+        {
+            bytes[index++] = (byte)character;
+        }
+
+        bytes[0] = header;
+
+        return index;
+    }
+
+    private static int EncodeSubTexture(DrawSubTextureOperation subTexture, ref State state, Span<byte> bytes)
+    {
+        var index = 1;
+        byte header = 15;
+        WriteVarint(bytes, ref index, subTexture.SubTextureId);
+        header |= WriteTarget(subTexture.TargetTextureId, ref state, bytes, ref index);
+        WritePosition(subTexture.TargetStartX, subTexture.TargetStartY, ref state, bytes, ref index);
+        bytes[index++] = (byte)(subTexture.IgnoreTransparency ? 1 : 0);
+        bytes[0] = header;
+
+        return index;
+    }
+
+    private static byte WriteTarget(byte targetTextureId, ref State state, Span<byte> bytes, ref int index)
+    {
+        if (targetTextureId == state.TargetTextureId)
+        {
+            return SameTarget;
+        }
+
+        state.TargetTextureId = targetTextureId;
+        bytes[index++] = targetTextureId;
+
+        return 0;
+    }
+
+    private static byte WriteColor(TColor color, ref State state, Span<byte> bytes, ref int index)
+    {
+        Span<byte> colorBytes = stackalloc byte[4];
+        var colorSize = color.WriteBytes(colorBytes);
+
+        uint value = 0;
+        for (var x = 0; x < colorSize; x++)
+        {
+            value = (value << 8) | colorBytes[x];
+        }
+
+        if (value == state.Color)
+        {
+            return SameColor;
+        }
+
+        state.Color = value;
+        colorBytes[..colorSize].CopyTo(bytes[index..]);
+        index += colorSize;
+
+        return 0;
+    }
+
+    private static void WritePosition(int x, int y, ref State state, Span<byte> bytes, ref int index)
+    {
+        WriteDelta(bytes, ref index, state.X, x);
+        WriteDelta(bytes, ref index, state.Y, y);
+        state.X = x;
+        state.Y = y;
+    }
+
+    private static void WriteDelta(Span<byte> bytes, ref int index, int previous, int value)
+    {
+        var delta = value - previous;
+        WriteVarint(bytes, ref index, (uint)((delta << 1) ^ (delta >> 31)));
+    }
+
+    private static void WriteVarint(Span<byte> bytes, ref int index, uint value)
+    {
+        while (value >= 0x80)
+        {
+            bytes[index++] = (byte)(value | 0x80);
+            value >>= 7;
+        }
+
+        bytes[index++] = (byte)value;
+    }
+
+    private static int VarintSize(uint value)
+    {
+        var size = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            size++;
+        }
+
+        return size;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Defines a proportional bitmap font that characters can be drawn with, from the width of each
+/// glyph and which byte of the font's bitmap its rows start at. Rows are one bit per pixel with
+/// the lowest bit being the leftmost pixel, and each row continues straight from the bit the
+/// previous row ended on. The bitmap starts out blank and is filled in with
+/// AppendFontBitmapOperations. Defining a font with no glyphs clears the font id.
+/// </summary>
+public class DefineFontOperation : IFireAndForgetOperation
+{
+    public const byte FirstFontId = 16;
+    public const byte MaxFonts = 16;
+    public const byte MaxGlyphWidth = 24;
+
+    public readonly record struct Glyph(byte Width, ushort Offset);
+
+    public required byte FontId { get; init; }
+    public required byte Height { get; init; }
+    public required byte FirstCharacter { get; init; }
+    public required ushort BitmapSize { get; init; }
+    public required IReadOnlyList<Glyph> Glyphs { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        if (Glyphs.Count > 255)
+        {
+            var message = $"Attempting to define {Glyphs.Count} glyphs which exceeds the max of 255";
+            throw new InvalidOperationException(message);
+        }
+
+        var size = GetSize();
+        if (bytes.Length < size)
+        {
+            var message = $"DefineFont requires {size} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        bytes[0] = 26;
+        bytes[1] = FontId;
+        bytes[2] = Height;
+        bytes[3] = FirstCharacter;
+        bytes[4] = (byte)Glyphs.Count;
+        bytes[5] = (byte)(BitmapSize >> 8);
+        bytes[6] = (byte)(BitmapSize & 0xFF);
+
+        var index = 7;
+        foreach (var glyph in Glyphs)
+        {
+            bytes[index++] = glyph.Width;
+            bytes[index++] = (byte)(glyph.Offset >> 8);
+            bytes[index++] = (byte)(glyph.Offset & 0xFF);
+        }
+
+        return index;
+    }
+
+    public int GetSize()
+    {
+        return 7 + Glyphs.Count * 3;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Defines a font of TrueType style quadratic outlines, from how far each glyph advances and which
+/// byte of the font's outline data its contours start at. The outline data starts out blank and is
+/// filled in with AppendFontBitmapOperations. Outline fonts aren't drawn with directly, but are
+/// rasterized at pixel sizes with DefineScaledFontOperations. Defining a font with no glyphs
+/// clears the font id.
+/// </summary>
+/// <remarks>
+/// Each glyph's outline is a byte of how many contours it has, then each contour as a byte of how
+/// many points it has followed by the points. Points are a flags byte, whose lowest bit is set for
+/// points on the curve, then big endian signed 16 bit X and Y values in font units, with Y going
+/// up from the baseline.
+/// </remarks>
+public class DefineOutlineFontOperation : IFireAndForgetOperation
+{
+    public readonly record struct Glyph(ushort Advance, ushort Offset);
+
+    public required byte FontId { get; init; }
+    public required ushort UnitsPerEm { get; init; }
+    public required ushort Ascent { get; init; }
+    public required ushort Descent { get; init; }
+    public required byte FirstCharacter { get; init; }
+    public required ushort OutlineSize { get; init; }
+    public required IReadOnlyList<Glyph> Glyphs { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        if (Glyphs.Count > 255)
+        {
+            var message = $"Attempting to define {Glyphs.Count} glyphs which exceeds the max of 255";
+            throw new InvalidOperationException(message);
+        }
+
+        var size = GetSize();
+        if (bytes.Length < size)
+        {
+            var message = $"DefineOutlineFont requires {size} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        bytes[0] = 29;
+        bytes[1] = FontId;
+        bytes[2] = (byte)(UnitsPerEm >> 8);
+        bytes[3] = (byte)(UnitsPerEm & 0xFF);
+        bytes[4] = (byte)(Ascent >> 8);
+        bytes[5] = (byte)(Ascent & 0xFF);
+        bytes[6] = (byte)(Descent >> 8);
+        bytes[7] = (byte)(Descent & 0xFF);
+        bytes[8] = FirstCharacter;
+        bytes[9] = (byte)Glyphs.Count;
+        bytes[10] = (byte)(OutlineSize >> 8);
+        bytes[11] = (byte)(OutlineSize & 0xFF);
+
+        var index = 12;
+        foreach (var glyph in Glyphs)
+        {
+            bytes[index++] = (byte)(glyph.Advance >> 8);
+            bytes[index++] = (byte)(glyph.Advance & 0xFF);
+            bytes[index++] = (byte)(glyph.Offset >> 8);
+            bytes[index++] = (byte)(glyph.Offset & 0xFF);
+        }
+
+        return index;
+    }
+
+    public int GetSize()
+    {
+        return 12 + Glyphs.Count * 4;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Rasterizes glyphs of an outline font at a pixel size into a font that characters can be drawn
+/// with, where the edges of glyphs are blended with what they're drawn over. Only the characters
+/// in the range are rasterized, so large sizes can be limited to the characters they're used for.
+/// Defining a font with no characters clears the font id.
+/// </summary>
+public class DefineScaledFontOperation : IFireAndForgetOperation
+{
+    public required byte FontId { get; init; }
+    public required byte OutlineFontId { get; init; }
+
+    /// <summary>
+    /// How many pixels the outline font's em square is scaled to
+    /// </summary>
+    public required byte PixelSize { get; init; }
+
+    public required byte FirstCharacter { get; init; }
+    public required byte CharacterCount { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        if (bytes.Length < GetSize())
+        {
+            var message = $"DefineScaledFont requires {GetSize()} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        bytes[0] = 30;
+        bytes[1] = FontId;
+        bytes[2] = OutlineFontId;
+        bytes[3] = PixelSize;
+        bytes[4] = FirstCharacter;
+        bytes[5] = CharacterCount;
+
+        return GetSize();
+    }
+
+    public int GetSize()
+    {
+        return 6;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+///     Registers a sub-texture id for a rectangle inside of a texture, such as a single sprite
+///     inside of an atlas. A width or height of zero clears the sub-texture id.
+/// </summary>
+public class DefineSubTextureOperation : IFireAndForgetOperation
+{
+    /// <summary>
+    ///     How many sub-texture ids the GPU supports. Ids must be less than this.
+    /// </summary>
+    public const ushort MaxSubTextures = 512;
+
+    public required ushort SubTextureId { get; init; }
+    public required byte TextureId { get; init; }
+    public required ushort X { get; init; }
+    public required ushort Y { get; init; }
+    public required ushort Width { get; init; }
+    public required ushort Height { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 14;
+        bytes[1] = (byte)(SubTextureId >> 8);
+        bytes[2] = (byte)(SubTextureId & 0xFF);
+        bytes[3] = TextureId;
+        bytes[4] = (byte)(X >> 8);
+        bytes[5] = (byte)(X & 0xFF);
+        bytes[6] = (byte)(Y >> 8);
+        bytes[7] = (byte)(Y & 0xFF);
+        bytes[8] = (byte)(Width >> 8);
+        bytes[9] = (byte)(Width & 0xFF);
+        bytes[10] = (byte)(Height >> 8);
+        bytes[11] = (byte)(Height & 0xFF);
+
+        return 12;
+    }
+
+    public int GetSize()
+    {
+        return 12;
+    }
+}
\ No newline at end of file
@@ -10,6 +10,12 @@ public class DefineTextureOperation<TColor> : IFireAndForgetOperation
     public required ushort Height { get; init; }
     public required TColor TransparentColor { get; init; }
 
+    /// <summary>
+    ///     If true, the GPU may evict this texture when it needs memory for other textures.
+    ///     Evicted texture ids are reported by the <see cref="GetTextureUsageOperation"/>.
+    /// </summary>
+    public bool IsCacheable { get; init; }
+
     public int Serialize(Span<byte> bytes)
     {
         bytes[0] = 9;
@@ -19,11 +25,14 @@ public class DefineTextureOperation<TColor> : IFireAndForgetOperation
         bytes[4] = (byte)(Height >> 8);
         bytes[5] = (byte)(Height & 0xFF);
 
-        return 6 + TransparentColor.WriteBytes(bytes[6..]);
+        var colorSize = TransparentColor.WriteBytes(bytes[6..]);
+        bytes[6 + colorSize] = (byte)(IsCacheable ? 0x01 : 0x00);
+
+        return 7 + colorSize;
     }
 
     public int GetSize()
     {
-        return 6 + TransparentColor.GetSize();
+        return 7 + TransparentColor.GetSize();
     }
 }
\ No newline at end of file
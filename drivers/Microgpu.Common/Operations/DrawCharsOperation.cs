@@ -2,7 +2,7 @@
 
 namespace Microgpu.Common.Operations;
 
-public class DrawCharsOperation<TColor> : IFireAndForgetOperation where TColor : IColorType
+public class DrawCharsOperation<TColor> : IFireAndForgetOperation where TColor : struct, IColorType
 {
     public required string Text { get; init; }
     public required TColor Color { get; init; }
@@ -10,6 +10,12 @@ public class DrawCharsOperation<TColor> : IFireAndForgetOperation where TColor :
     public required byte TextureId { get; init; }
     public required ushort StartX { get; init; }
     public required ushort StartY { get; init; }
+
+    /// <summary>
+    /// When set, the pixels of each character's cell that aren't part of its glyph are drawn in
+    /// this color, so the text replaces whatever was under it without clearing it first.
+    /// </summary>
+    public TColor? BackgroundColor { get; init; }
         
     public int Serialize(Span<byte> bytes)
     {
@@ -43,11 +49,16 @@ public class DrawCharsOperation<TColor> : IFireAndForgetOperation where TColor :
             bytes[++byteIndex] = (byte)character;
         }
 
+        if (BackgroundColor != null)
+        {
+            byteIndex += BackgroundColor.Value.WriteBytes(bytes[(byteIndex + 1)..]);
+        }
+
         return byteIndex + 1;
     }
 
     public int GetSize()
     {
-        return 8 + Color.GetSize() + (Text?.Length ?? 0);
+        return 8 + Color.GetSize() + (Text?.Length ?? 0) + (BackgroundColor?.GetSize() ?? 0);
     }
 }
\ No newline at end of file
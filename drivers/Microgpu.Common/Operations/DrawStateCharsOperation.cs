@@ -0,0 +1,50 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Draws text to the draw state's target texture in its color and font, with the start position
+/// relative to its origin.
+/// </summary>
+public class DrawStateCharsOperation : IFireAndForgetOperation
+{
+    public required string Text { get; init; }
+    public required ushort StartX { get; init; }
+    public required ushort StartY { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        if (Text?.Length > 255)
+        {
+            var message = $"Attempting to draw {Text.Length} chars which exceeds the max of 255";
+            throw new InvalidOperationException(message);
+        }
+
+        var size = GetSize();
+        if (bytes.Length < size)
+        {
+            var message = $"DrawStateChars requires {size} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        bytes[0] = 24;
+        bytes[1] = (byte)(StartX >> 8);
+        bytes[2] = (byte)(StartX & 0xFF);
+        bytes[3] = (byte)(StartY >> 8);
+        bytes[4] = (byte)(StartY & 0xFF);
+        bytes[5] = (byte)(Text?.Length ?? 0);
+
+        var byteIndex = 6;
+        foreach (var character in Text ?? string.Empty)
+        {
+            bytes[byteIndex++] = (byte)character;
+        }
+
+        return byteIndex;
+    }
+
+    public int GetSize()
+    {
+        return 6 + (Text?.Length ?? 0);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Draws a triangle to the draw state's target texture in its color, with the points relative
+/// to its origin.
+/// </summary>
+public class DrawStateTriangleOperation : IFireAndForgetOperation
+{
+    public required ushort X0 { get; init; }
+    public required ushort Y0 { get; init; }
+    public required ushort X1 { get; init; }
+    public required ushort Y1 { get; init; }
+    public required ushort X2 { get; init; }
+    public required ushort Y2 { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 23;
+        bytes[1] = (byte)(X0 >> 8);
+        bytes[2] = (byte)(X0 & 0xFF);
+        bytes[3] = (byte)(Y0 >> 8);
+        bytes[4] = (byte)(Y0 & 0xFF);
+        bytes[5] = (byte)(X1 >> 8);
+        bytes[6] = (byte)(X1 & 0xFF);
+        bytes[7] = (byte)(Y1 >> 8);
+        bytes[8] = (byte)(Y1 & 0xFF);
+        bytes[9] = (byte)(X2 >> 8);
+        bytes[10] = (byte)(X2 & 0xFF);
+        bytes[11] = (byte)(Y2 >> 8);
+        bytes[12] = (byte)(Y2 & 0xFF);
+
+        return 13;
+    }
+
+    public int GetSize()
+    {
+        return 13;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+///     Draws a sub-texture registered by a <see cref="DefineSubTextureOperation"/> onto a texture.
+/// </summary>
+public class DrawSubTextureOperation : IFireAndForgetOperation
+{
+    public required ushort SubTextureId { get; init; }
+    public required byte TargetTextureId { get; init; }
+    public required short TargetStartX { get; init; }
+    public required short TargetStartY { get; init; }
+    public bool IgnoreTransparency { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 15;
+        bytes[1] = (byte)(SubTextureId >> 8);
+        bytes[2] = (byte)(SubTextureId & 0xFF);
+        bytes[3] = TargetTextureId;
+        bytes[4] = (byte)(TargetStartX >> 8);
+        bytes[5] = (byte)(TargetStartX & 0xFF);
+        bytes[6] = (byte)(TargetStartY >> 8);
+        bytes[7] = (byte)(TargetStartY & 0xFF);
+
+        bytes[8] = 0;
+        if (IgnoreTransparency)
+        {
+            bytes[8] |= 1;
+        }
+
+        return 9;
+    }
+
+    public int GetSize()
+    {
+        return 9;
+    }
+}
\ No newline at end of file
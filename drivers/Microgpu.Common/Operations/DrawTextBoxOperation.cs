@@ -0,0 +1,78 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Draws text inside a box, with the gpu breaking it into lines and aligning them using the
+/// font's glyph widths. Text is clipped to the box.
+/// </summary>
+public class DrawTextBoxOperation<TColor> : IFireAndForgetOperation where TColor : struct, IColorType
+{
+    public required string Text { get; init; }
+    public required TColor Color { get; init; }
+    public required Font Font { get; init; }
+    public required byte TextureId { get; init; }
+    public required ushort StartX { get; init; }
+    public required ushort StartY { get; init; }
+    public required ushort Width { get; init; }
+    public required ushort Height { get; init; }
+    public TextAlignment HorizontalAlignment { get; init; }
+    public TextAlignment VerticalAlignment { get; init; }
+    public TextWrap Wrap { get; init; } = TextWrap.Words;
+
+    /// <summary>
+    /// When set, the whole box is filled with this color before the text is drawn
+    /// </summary>
+    public TColor? BackgroundColor { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        var text = Text ?? string.Empty;
+        if (text.Length > ushort.MaxValue)
+        {
+            var message = $"Attempting to draw {text.Length} chars which exceeds the max of {ushort.MaxValue}";
+            throw new InvalidOperationException(message);
+        }
+
+        var size = GetSize();
+        if (bytes.Length < size)
+        {
+            var message = $"DrawTextBox requires {size} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        bytes[0] = 28;
+        bytes[1] = (byte)Font;
+        bytes[2] = TextureId;
+
+        var index = 3 + Color.WriteBytes(bytes[3..]);
+        bytes[index++] = (byte)(StartX >> 8);
+        bytes[index++] = (byte)(StartX & 0xFF);
+        bytes[index++] = (byte)(StartY >> 8);
+        bytes[index++] = (byte)(StartY & 0xFF);
+        bytes[index++] = (byte)(Width >> 8);
+        bytes[index++] = (byte)(Width & 0xFF);
+        bytes[index++] = (byte)(Height >> 8);
+        bytes[index++] = (byte)(Height & 0xFF);
+        bytes[index++] = (byte)((int)HorizontalAlignment | ((int)VerticalAlignment << 2) | ((int)Wrap << 4));
+        bytes[index++] = (byte)(text.Length >> 8);
+        bytes[index++] = (byte)(text.Length & 0xFF);
+
+        foreach (var character in text)
+        {
+            bytes[index++] = (byte)character;
+        }
+
+        if (BackgroundColor != null)
+        {
+            index += BackgroundColor.Value.WriteBytes(bytes[index..]);
+        }
+
+        return index;
+    }
+
+    public int GetSize()
+    {
+        return 14 + Color.GetSize() + (Text?.Length ?? 0) + (BackgroundColor?.GetSize() ?? 0);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Draws the same part of a source texture at each of the instances' positions.
+/// </summary>
+public class DrawTextureInstancedOperation : IFireAndForgetOperation
+{
+    public readonly record struct Instance(short TargetStartX, short TargetStartY, bool FlipHorizontally = false, bool FlipVertically = false);
+
+    public required byte SourceTextureId { get; init; }
+    public required byte TargetTextureId { get; init; }
+    public required ushort SourceStartX { get; init; }
+    public required ushort SourceStartY { get; init; }
+    public required ushort SourceWidth { get; init; }
+    public required ushort SourceHeight { get; init; }
+    public bool IgnoreTransparency { get; init; }
+    public required IReadOnlyList<Instance> Instances { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        var size = GetSize();
+        if (bytes.Length < size)
+        {
+            var message = $"DrawTextureInstanced requires {size} bytes, but the buffer only has {bytes.Length}";
+            throw new InvalidOperationException(message);
+        }
+
+        var hasFlips = HasFlips();
+        bytes[0] = 25;
+        bytes[1] = SourceTextureId;
+        bytes[2] = TargetTextureId;
+        bytes[3] = (byte)(SourceStartX >> 8);
+        bytes[4] = (byte)(SourceStartX & 0xFF);
+        bytes[5] = (byte)(SourceStartY >> 8);
+        bytes[6] = (byte)(SourceStartY & 0xFF);
+        bytes[7] = (byte)(SourceWidth >> 8);
+        bytes[8] = (byte)(SourceWidth & 0xFF);
+        bytes[9] = (byte)(SourceHeight >> 8);
+        bytes[10] = (byte)(SourceHeight & 0xFF);
+
+        bytes[11] = 0;
+        if (IgnoreTransparency)
+        {
+            bytes[11] |= 1;
+        }
+
+        if (hasFlips)
+        {
+            // Each instance is followed by its own flags
+            bytes[11] |= 8;
+        }
+
+        bytes[12] = (byte)(Instances.Count >> 8);
+        bytes[13] = (byte)(Instances.Count & 0xFF);
+
+        var index = 14;
+        foreach (var instance in Instances)
+        {
+            bytes[index++] = (byte)(instance.TargetStartX >> 8);
+            bytes[index++] = (byte)(instance.TargetStartX & 0xFF);
+            bytes[index++] = (byte)(instance.TargetStartY >> 8);
+            bytes[index++] = (byte)(instance.TargetStartY & 0xFF);
+
+            if (hasFlips)
+            {
+                bytes[index++] = (byte)((instance.FlipHorizontally ? 2 : 0) | (instance.FlipVertically ? 4 : 0));
+            }
+        }
+
+        return index;
+    }
+
+    public int GetSize()
+    {
+        return 14 + Instances.Count * (HasFlips() ? 5 : 4);
+    }
+
+    private bool HasFlips()
+    {
+        foreach (var instance in Instances)
+        {
+            if (instance.FlipHorizontally || instance.FlipVertically)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
\ No newline at end of file
@@ -13,6 +13,8 @@ public class DrawTextureOperation : IFireAndForgetOperation
     public required short TargetStartX { get; init; }
     public required short TargetStartY { get; init; }
     public bool IgnoreTransparency { get; init; }
+    public bool FlipHorizontally { get; init; }
+    public bool FlipVertically { get; init; }
 
     public int Serialize(Span<byte> bytes)
     {
@@ -38,6 +40,16 @@ public class DrawTextureOperation : IFireAndForgetOperation
             bytes[15] |= 1;
         }
 
+        if (FlipHorizontally)
+        {
+            bytes[15] |= 2;
+        }
+
+        if (FlipVertically)
+        {
+            bytes[15] |= 4;
+        }
+
         return 16;
     }
 
@@ -0,0 +1,24 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+///     Asks the GPU to send credit responses saying how many bytes can be sent before it runs out
+///     of room to buffer them. Bytes are counted from right after this operation, which has to be
+///     sent on its own instead of in a batch. Only databuses without their own flow control (such
+///     as TCP) send credits, so GPUs that never respond to this should be sent to as before.
+/// </summary>
+public class EnableCreditsOperation : IFireAndForgetOperation
+{
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 19;
+
+        return 1;
+    }
+
+    public int GetSize()
+    {
+        return 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+﻿using System;
+using Microgpu.Common.Responses;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+///     Requests the counters the GPU keeps for each type of operation it has executed, such as how
+///     many times it ran and how long it took. Only as many operation types as fit in one message
+///     are reported at once, so when more have run the response says which type to request next.
+/// </summary>
+public class GetStatsOperation : IResponsiveOperation<StatsResponse>
+{
+    public ushort RequestId { get; set; }
+
+    /// <summary>
+    ///     The operation type to start reporting counters from
+    /// </summary>
+    public byte FirstOperationType { get; set; }
+
+    /// <summary>
+    ///     If true, the counters of the operation types in the response are reset to zero
+    /// </summary>
+    public bool Reset { get; set; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 31;
+        bytes[1] = FirstOperationType;
+        bytes[2] = (byte)(Reset ? 1 : 0);
+        if (RequestId == 0)
+        {
+            return 3;
+        }
+
+        bytes[3] = (byte)(RequestId >> 8);
+        bytes[4] = (byte)(RequestId & 0xFF);
+
+        return 5;
+    }
+
+    public int GetSize()
+    {
+        return RequestId == 0 ? 3 : 5;
+    }
+}
\ No newline at end of file
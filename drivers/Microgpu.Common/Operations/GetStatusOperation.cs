@@ -5,15 +5,24 @@ namespace Microgpu.Common.Operations;
 
 public class GetStatusOperation : IResponsiveOperation<StatusResponse>
 {
+    public ushort RequestId { get; set; }
+
     public int Serialize(Span<byte> bytes)
     {
         bytes[0] = 4;
+        if (RequestId == 0)
+        {
+            return 1;
+        }
+
+        bytes[1] = (byte)(RequestId >> 8);
+        bytes[2] = (byte)(RequestId & 0xFF);
 
-        return 1;
+        return 3;
     }
 
     public int GetSize()
     {
-        return 1;
+        return RequestId == 0 ? 1 : 3;
     }
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+﻿using System;
+using Microgpu.Common.Responses;
+
+namespace Microgpu.Common.Operations;
+
+public class GetTextureUsageOperation : IResponsiveOperation<TextureUsageResponse>
+{
+    public ushort RequestId { get; set; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 13;
+        if (RequestId == 0)
+        {
+            return 1;
+        }
+
+        bytes[1] = (byte)(RequestId >> 8);
+        bytes[2] = (byte)(RequestId & 0xFF);
+
+        return 3;
+    }
+
+    public int GetSize()
+    {
+        return RequestId == 0 ? 1 : 3;
+    }
+}
\ No newline at end of file
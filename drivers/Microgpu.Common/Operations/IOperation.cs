@@ -29,6 +29,11 @@ public interface IOperation
 /// </summary>
 public interface IResponsiveOperation<TResponse> : IOperation where TResponse : IResponse
 {
+    /// <summary>
+    ///     Id the gpu tags its response with, so it can be matched up with this operation even if
+    ///     other responses arrive first. Zero leaves the response untagged.
+    /// </summary>
+    ushort RequestId { get; set; }
 }
 
 /// <summary>
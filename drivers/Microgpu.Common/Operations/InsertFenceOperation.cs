@@ -0,0 +1,30 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+///     Inserts a fence that the GPU marks as completed once every operation sent before it has
+///     executed, and any frames presented before it have finished being sent to the display.
+///     Values should increase with each fence, so a completed value also means every earlier
+///     fence has completed.
+/// </summary>
+public class InsertFenceOperation : IFireAndForgetOperation
+{
+    public required uint Value { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 17;
+        bytes[1] = (byte)(Value >> 24);
+        bytes[2] = (byte)((Value >> 16) & 0xFF);
+        bytes[3] = (byte)((Value >> 8) & 0xFF);
+        bytes[4] = (byte)(Value & 0xFF);
+
+        return 5;
+    }
+
+    public int GetSize()
+    {
+        return 5;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+﻿using System;
+using Microgpu.Common.Responses;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Asks the gpu to switch to a newer packet framing. The response is sent with the framing the request was sent
+/// with, and everything after it uses the framing in the response.
+/// </summary>
+public class NegotiateFramingOperation : IResponsiveOperation<FramingResponse>
+{
+    /// <summary>
+    /// The newest framing version the client supports
+    /// </summary>
+    public required byte Version { get; init; }
+
+    public ushort RequestId { get; set; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 16;
+        bytes[1] = Version;
+        if (RequestId == 0)
+        {
+            return 2;
+        }
+
+        bytes[2] = (byte)(RequestId >> 8);
+        bytes[3] = (byte)(RequestId & 0xFF);
+
+        return 4;
+    }
+
+    public int GetSize()
+    {
+        return RequestId == 0 ? 2 : 4;
+    }
+}
\ No newline at end of file
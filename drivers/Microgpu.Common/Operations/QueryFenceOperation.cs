@@ -0,0 +1,33 @@
+﻿using System;
+using Microgpu.Common.Responses;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+///     Requests the value of the most recently completed fence. The GPU answers as soon as it
+///     receives this, without waiting on queued operations or drawing, so this is cheap enough
+///     to poll to see how far behind the GPU is.
+/// </summary>
+public class QueryFenceOperation : IResponsiveOperation<FenceResponse>
+{
+    public ushort RequestId { get; set; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 18;
+        if (RequestId == 0)
+        {
+            return 1;
+        }
+
+        bytes[1] = (byte)(RequestId >> 8);
+        bytes[2] = (byte)(RequestId & 0xFF);
+
+        return 3;
+    }
+
+    public int GetSize()
+    {
+        return RequestId == 0 ? 1 : 3;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+﻿using System;
+
+namespace Microgpu.Common.Operations;
+
+/// <summary>
+/// Sets what DrawState operations draw with. Only the properties that are set are changed, and
+/// the gpu keeps the rest from earlier SetDrawState operations.
+/// </summary>
+public class SetDrawStateOperation<TColor> : IFireAndForgetOperation where TColor : struct, IColorType
+{
+    private const byte TargetFlag = 1 << 0;
+    private const byte ColorFlag = 1 << 1;
+    private const byte FontFlag = 1 << 2;
+    private const byte OriginFlag = 1 << 3;
+
+    public byte? TargetTextureId { get; init; }
+    public TColor? Color { get; init; }
+    public Font? Font { get; init; }
+
+    /// <summary>
+    /// Offset added to the coordinates of every DrawState operation. Both values have to be
+    /// set for the origin to change.
+    /// </summary>
+    public ushort? OriginX { get; init; }
+    public ushort? OriginY { get; init; }
+
+    public int Serialize(Span<byte> bytes)
+    {
+        bytes[0] = 21;
+        bytes[1] = 0;
+
+        var index = 2;
+        if (TargetTextureId != null)
+        {
+            bytes[1] |= TargetFlag;
+            bytes[index++] = TargetTextureId.Value;
+        }
+
+        if (Color != null)
+        {
+            bytes[1] |= ColorFlag;
+            index += Color.Value.WriteBytes(bytes[index..]);
+        }
+
+        if (Font != null)
+        {
+            bytes[1] |= FontFlag;
+            bytes[index++] = (byte)Font.Value;
+        }
+
+        if (OriginX != null && OriginY != null)
+        {
+            bytes[1] |= OriginFlag;
+            bytes[index++] = (byte)(OriginX.Value >> 8);
+            bytes[index++] = (byte)(OriginX.Value & 0xFF);
+            bytes[index++] = (byte)(OriginY.Value >> 8);
+            bytes[index++] = (byte)(OriginY.Value & 0xFF);
+        }
+
+        return index;
+    }
+
+    public int GetSize()
+    {
+        var size = 2;
+        size += TargetTextureId != null ? 1 : 0;
+        size += Color?.GetSize() ?? 0;
+        size += Font != null ? 1 : 0;
+        size += OriginX != null && OriginY != null ? 4 : 0;
+
+        return size;
+    }
+}
\ No newline at end of file
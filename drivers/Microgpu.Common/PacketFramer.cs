@@ -3,13 +3,21 @@ using Microgpu.Common.Operations;
 
 namespace Microgpu.Common;
 
-public readonly record struct PacketDecodeResult(ReadOnlyMemory<byte> DecodedBytes, int InputBytesProcessed);
-   
+/// <param name="DecodedBytes">The decoded message, or empty if no valid message was decoded</param>
+/// <param name="InputBytesProcessed">How many bytes of the input were consumed</param>
+/// <param name="IsFragment">
+/// True if a valid packet was consumed, but it was only part of a message split across multiple packets
+/// </param>
+public readonly record struct PacketDecodeResult(
+    ReadOnlyMemory<byte> DecodedBytes,
+    int InputBytesProcessed,
+    bool IsFragment = false);
+
 /// <summary>
 /// Uses Consistent Overhead Byte Stuffing to serialize an operation into bytes, or to read a packet out of
 /// a buffer.
 /// </summary>
-public class PacketFramer
+public class PacketFramer : IPacketFramer
 {
     private readonly byte[] _decodeBuffer = new byte[255];
     private const int MaxMessageSize = 250;
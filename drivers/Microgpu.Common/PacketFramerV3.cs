@@ -0,0 +1,345 @@
+﻿using System;
+using Microgpu.Common.Operations;
+
+namespace Microgpu.Common;
+
+/// <summary>
+/// Version 3 of the packet framing, which allows messages up to 64KB. Messages larger than the gpu's frame
+/// size are split into fragments. Each fragment has a flags byte and a sequence number, followed by its part of
+/// the message and a CRC16 (CCITT) of all of it, which is then encoded with standard Consistent Overhead Byte
+/// Stuffing and terminated with a zero.
+/// </summary>
+public class PacketFramerV3 : IPacketFramer
+{
+    public const byte Version = 3;
+    public const int MaxMessageSizeLimit = 65535;
+
+    private const byte FirstFragmentFlag = 0x01;
+    private const byte FinalFragmentFlag = 0x02;
+    private const int HeaderSize = 2;
+    private const int CrcSize = 2;
+
+    private static readonly ushort[] CrcTable = CreateCrcTable();
+
+    private readonly int _maxMessageSize;
+    private readonly int _maxPayloadSize;
+    private readonly byte[] _messageBuffer;
+    private readonly byte[] _frameBuffer;
+    private readonly byte[] _reassemblyBuffer;
+    private int _reassembledSize;
+    private byte _nextSequence;
+    private bool _isReassembling;
+
+    /// <param name="maxFrameSize">The largest encoded frame the gpu accepts, including the trailing zero</param>
+    /// <param name="maxMessageSize">The largest message the gpu can reassemble</param>
+    public PacketFramerV3(int maxFrameSize, int maxMessageSize)
+    {
+        _maxPayloadSize = MaxPayloadSize(maxFrameSize);
+        if (_maxPayloadSize == 0)
+        {
+            var message = $"A frame size of {maxFrameSize} bytes is too small to hold any of a message";
+            throw new ArgumentOutOfRangeException(nameof(maxFrameSize), message);
+        }
+
+        _maxMessageSize = Math.Min(maxMessageSize, MaxMessageSizeLimit);
+        _messageBuffer = new byte[_maxMessageSize];
+        _frameBuffer = new byte[maxFrameSize];
+        _reassemblyBuffer = new byte[_maxMessageSize];
+    }
+
+    /// <summary>
+    /// The largest number of bytes a frame carrying the specified amount of a message can be encoded into
+    /// </summary>
+    public static int MaxFrameSize(int payloadSize)
+    {
+        var fragmentSize = HeaderSize + payloadSize + CrcSize;
+
+        // One code byte per 254 bytes, an extra one for the final run, and the zero delimiter
+        return fragmentSize + fragmentSize / 254 + 2;
+    }
+
+    /// <summary>
+    /// How many bytes of a message fit in each frame, if frames can be at most the specified size
+    /// </summary>
+    public static int MaxPayloadSize(int frameSize)
+    {
+        var overhead = MaxFrameSize(0);
+        if (frameSize <= overhead)
+        {
+            return 0;
+        }
+
+        var payload = frameSize - overhead - frameSize / 254;
+        while (payload > 0 && MaxFrameSize(payload) > frameSize)
+        {
+            payload--;
+        }
+
+        return Math.Min(payload, MaxMessageSizeLimit);
+    }
+
+    public int BufferSizeRequired(IOperation operation)
+    {
+        var size = operation.GetSize();
+        var frameCount = (size + _maxPayloadSize - 1) / _maxPayloadSize;
+
+        return size + size / 254 + frameCount * (MaxFrameSize(0) + 1);
+    }
+
+    public int Encode(IOperation operation, Span<byte> outputBuffer)
+    {
+        var size = operation.GetSize();
+        if (size > _maxMessageSize)
+        {
+            var message = $"Operation {operation.GetType().Name} serializes into {size} bytes, which is more " +
+                          $"than the allowed {_maxMessageSize}.";
+            throw new InvalidOperationException(message);
+        }
+
+        var bytesWritten = operation.Serialize(_messageBuffer);
+        return Encode(_messageBuffer.AsSpan(0, bytesWritten), outputBuffer);
+    }
+
+    /// <summary>
+    /// Encodes an already serialized message into one or more frames
+    /// </summary>
+    /// <returns>The total number of bytes written to the output buffer</returns>
+    public int Encode(ReadOnlySpan<byte> message, Span<byte> outputBuffer)
+    {
+        var bytesWritten = 0;
+        var offset = 0;
+        byte sequence = 0;
+        while (offset < message.Length)
+        {
+            var payload = message.Slice(offset, Math.Min(message.Length - offset, _maxPayloadSize));
+            byte flags = 0;
+            if (offset == 0) flags |= FirstFragmentFlag;
+            if (offset + payload.Length == message.Length) flags |= FinalFragmentFlag;
+
+            if (outputBuffer.Length - bytesWritten < MaxFrameSize(payload.Length))
+            {
+                var errorMessage = $"A {message.Length} byte message does not fit in the provided buffer of " +
+                                   $"{outputBuffer.Length} bytes";
+                throw new InvalidOperationException(errorMessage);
+            }
+
+            bytesWritten += EncodeFragment(payload, flags, sequence, outputBuffer[bytesWritten..]);
+            offset += payload.Length;
+            unchecked
+            {
+                sequence++;
+            }
+        }
+
+        return bytesWritten;
+    }
+
+    public PacketDecodeResult Decode(ReadOnlySpan<byte> buffer)
+    {
+        var zeroIndex = buffer.IndexOf((byte)0);
+        if (zeroIndex < 0)
+        {
+            // No zeros were found, not a complete frame (or corrupted).
+            return new PacketDecodeResult(null, 0);
+        }
+
+        var inputBytesProcessed = zeroIndex + 1;
+        var fragmentSize = DecodeFrame(buffer[..zeroIndex]);
+        if (fragmentSize < HeaderSize)
+        {
+            return new PacketDecodeResult(null, inputBytesProcessed);
+        }
+
+        var flags = _frameBuffer[0];
+        var sequence = _frameBuffer[1];
+        var payloadSize = fragmentSize - HeaderSize;
+        if ((flags & FirstFragmentFlag) != 0)
+        {
+            // A new message replaces any partial one, since its remaining fragments were lost
+            ResetReassembly();
+            if ((flags & FinalFragmentFlag) != 0)
+            {
+                return new PacketDecodeResult(_frameBuffer.AsMemory(HeaderSize, payloadSize), inputBytesProcessed);
+            }
+        }
+        else if (!_isReassembling || sequence != _nextSequence)
+        {
+            // A fragment was lost, so the message can't be completed
+            ResetReassembly();
+            return new PacketDecodeResult(null, inputBytesProcessed);
+        }
+
+        if (_reassembledSize + payloadSize > _reassemblyBuffer.Length)
+        {
+            ResetReassembly();
+            return new PacketDecodeResult(null, inputBytesProcessed);
+        }
+
+        _frameBuffer.AsSpan(HeaderSize, payloadSize).CopyTo(_reassemblyBuffer.AsSpan(_reassembledSize));
+        _reassembledSize += payloadSize;
+        _nextSequence = unchecked((byte)(sequence + 1));
+        _isReassembling = true;
+
+        if ((flags & FinalFragmentFlag) == 0)
+        {
+            return new PacketDecodeResult(null, inputBytesProcessed, true);
+        }
+
+        var messageSize = _reassembledSize;
+        ResetReassembly();
+
+        return new PacketDecodeResult(_reassemblyBuffer.AsMemory(0, messageSize), inputBytesProcessed);
+    }
+
+    private static int EncodeFragment(ReadOnlySpan<byte> payload, byte flags, byte sequence, Span<byte> output)
+    {
+        ReadOnlySpan<byte> header = stackalloc byte[] { flags, sequence };
+        var crc = UpdateCrc(0xFFFF, header);
+        crc = UpdateCrc(crc, payload);
+        ReadOnlySpan<byte> crcBytes = stackalloc byte[] { (byte)(crc >> 8), (byte)(crc & 0xFF) };
+
+        var encoder = new CobsEncoder(output);
+        encoder.Add(header);
+        encoder.Add(payload);
+        encoder.Add(crcBytes);
+
+        return encoder.Finish();
+    }
+
+    /// <summary>
+    /// Decodes the COBS encoded frame into the frame buffer and validates its CRC.
+    /// </summary>
+    /// <returns>The number of bytes of the fragment, not including the CRC, or -1 if the frame was invalid</returns>
+    private int DecodeFrame(ReadOnlySpan<byte> encoded)
+    {
+        var inputIndex = 0;
+        var outputIndex = 0;
+        while (inputIndex < encoded.Length)
+        {
+            var code = encoded[inputIndex++];
+            var runLength = code - 1;
+            if (inputIndex + runLength > encoded.Length)
+            {
+                // Went past the frame. The codes are wrong so the frame is corrupted
+                return -1;
+            }
+
+            var addZero = code != 0xFF && inputIndex + runLength < encoded.Length;
+            if (outputIndex + runLength + (addZero ? 1 : 0) > _frameBuffer.Length)
+            {
+                // Larger than any frame the gpu sends, possibly zeros missing due to corruption
+                return -1;
+            }
+
+            encoded.Slice(inputIndex, runLength).CopyTo(_frameBuffer.AsSpan(outputIndex));
+            inputIndex += runLength;
+            outputIndex += runLength;
+            if (addZero)
+            {
+                _frameBuffer[outputIndex++] = 0;
+            }
+        }
+
+        if (outputIndex < HeaderSize + CrcSize)
+        {
+            return -1;
+        }
+
+        var fragmentSize = outputIndex - CrcSize;
+        var expectedCrc = (ushort)((_frameBuffer[fragmentSize] << 8) | _frameBuffer[fragmentSize + 1]);
+        if (UpdateCrc(0xFFFF, _frameBuffer.AsSpan(0, fragmentSize)) != expectedCrc)
+        {
+            // CRC mismatch, so most likely a corrupted frame
+            return -1;
+        }
+
+        return fragmentSize;
+    }
+
+    private void ResetReassembly()
+    {
+        _reassembledSize = 0;
+        _nextSequence = 0;
+        _isReassembling = false;
+    }
+
+    private static ushort UpdateCrc(ushort crc, ReadOnlySpan<byte> bytes)
+    {
+        for (var x = 0; x < bytes.Length; x++)
+        {
+            crc = (ushort)((crc << 8) ^ CrcTable[(byte)(crc >> 8) ^ bytes[x]]);
+        }
+
+        return crc;
+    }
+
+    private static ushort[] CreateCrcTable()
+    {
+        var table = new ushort[256];
+        for (var x = 0; x < table.Length; x++)
+        {
+            var crc = (ushort)(x << 8);
+            for (var bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000) != 0
+                    ? (ushort)((crc << 1) ^ 0x1021)
+                    : (ushort)(crc << 1);
+            }
+
+            table[x] = crc;
+        }
+
+        return table;
+    }
+
+    private ref struct CobsEncoder
+    {
+        private readonly Span<byte> _output;
+        private int _codeIndex;
+        private int _writeIndex;
+        private byte _code;
+
+        public CobsEncoder(Span<byte> output)
+        {
+            _output = output;
+            _codeIndex = 0;
+            _writeIndex = 1;
+            _code = 1;
+        }
+
+        public void Add(scoped ReadOnlySpan<byte> bytes)
+        {
+            foreach (var value in bytes)
+            {
+                if (value == 0)
+                {
+                    StartNextRun();
+                    continue;
+                }
+
+                _output[_writeIndex++] = value;
+                _code++;
+                if (_code == 0xFF)
+                {
+                    // Longest run a code byte can describe, so start a new one without an implied zero
+                    StartNextRun();
+                }
+            }
+        }
+
+        public int Finish()
+        {
+            _output[_codeIndex] = _code;
+            _output[_writeIndex++] = 0;
+
+            return _writeIndex;
+        }
+
+        private void StartNextRun()
+        {
+            _output[_codeIndex] = _code;
+            _codeIndex = _writeIndex++;
+            _code = 1;
+        }
+    }
+}
\ No newline at end of file
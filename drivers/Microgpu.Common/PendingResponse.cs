@@ -0,0 +1,33 @@
+﻿using System.Threading.Tasks;
+using Microgpu.Common.Responses;
+
+namespace Microgpu.Common;
+
+/// <summary>
+/// A response the GPU hasn't necessarily sent yet, for an operation sent with
+/// <see cref="Gpu.BeginResponsiveOperationAsync{TResponse}"/>.
+/// </summary>
+public class PendingResponse<TResponse> where TResponse : class, IResponse, new()
+{
+    private readonly Gpu _gpu;
+
+    internal PendingResponse(Gpu gpu, ushort requestId)
+    {
+        _gpu = gpu;
+        RequestId = requestId;
+    }
+
+    /// <summary>
+    /// The id the operation was tagged with
+    /// </summary>
+    public ushort RequestId { get; }
+
+    /// <summary>
+    /// Waits for the GPU's response, reading and holding on to responses for other requests that arrive first.
+    /// Returns null if the GPU didn't respond, or if the response was already retrieved.
+    /// </summary>
+    public ValueTask<TResponse?> GetResponseAsync()
+    {
+        return _gpu.WaitForResponseAsync<TResponse>(RequestId);
+    }
+}
\ No newline at end of file
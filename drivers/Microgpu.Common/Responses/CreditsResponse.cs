@@ -0,0 +1,26 @@
+﻿using System;
+
+namespace Microgpu.Common.Responses;
+
+/// <summary>
+///     Sent by the GPU on its own once credits are enabled, to say how much can be sent without
+///     overrunning what it can buffer.
+/// </summary>
+public class CreditsResponse : IResponse
+{
+    /// <summary>
+    ///     Total number of bytes that may have been sent since credits were enabled. Wraps around.
+    /// </summary>
+    public uint ByteLimit { get; set; }
+
+    public void Deserialize(ReadOnlySpan<byte> bytes)
+    {
+        if (bytes[0] != (byte)ResponseType.Credits)
+        {
+            var message = $"Expected type byte of 6 (credits response), found {bytes[0]}";
+            throw new InvalidOperationException(message);
+        }
+
+        ByteLimit = (uint)((bytes[1] << 24) | (bytes[2] << 16) | (bytes[3] << 8) | bytes[4]);
+    }
+}
\ No newline at end of file
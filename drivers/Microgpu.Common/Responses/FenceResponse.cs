@@ -0,0 +1,22 @@
+﻿using System;
+
+namespace Microgpu.Common.Responses;
+
+public class FenceResponse : IResponse
+{
+    /// <summary>
+    ///     The value of the most recently completed fence, or zero if no fences have completed yet
+    /// </summary>
+    public uint LastCompletedValue { get; set; }
+
+    public void Deserialize(ReadOnlySpan<byte> bytes)
+    {
+        if (bytes[0] != (byte)ResponseType.Fence)
+        {
+            var message = $"Expected type byte of 5 (fence response), found {bytes[0]}";
+            throw new InvalidOperationException(message);
+        }
+
+        LastCompletedValue = (uint)((bytes[1] << 24) | (bytes[2] << 16) | (bytes[3] << 8) | bytes[4]);
+    }
+}
\ No newline at end of file
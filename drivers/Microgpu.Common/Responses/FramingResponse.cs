@@ -0,0 +1,31 @@
+﻿using System;
+
+namespace Microgpu.Common.Responses;
+
+public class FramingResponse : IResponse
+{
+    public byte Version { get; set; }
+
+    /// <summary>
+    /// The largest encoded frame the gpu accepts, including the trailing zero byte
+    /// </summary>
+    public ushort MaxFrameSize { get; set; }
+
+    /// <summary>
+    /// The largest operation the gpu can reassemble out of multiple frames
+    /// </summary>
+    public ushort MaxMessageSize { get; set; }
+
+    public void Deserialize(ReadOnlySpan<byte> bytes)
+    {
+        if (bytes[0] != (byte)ResponseType.Framing)
+        {
+            var message = $"Expected type byte of 4 (framing response), found {bytes[0]}";
+            throw new InvalidOperationException(message);
+        }
+
+        Version = bytes[1];
+        MaxFrameSize = (ushort)((bytes[2] << 8) | bytes[3]);
+        MaxMessageSize = (ushort)((bytes[4] << 8) | bytes[5]);
+    }
+}
\ No newline at end of file
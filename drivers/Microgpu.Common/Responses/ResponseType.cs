@@ -4,5 +4,10 @@ public enum ResponseType
 {
     Unspecified = 0,
     Status = 1,
-    LastMessage = 2
+    LastMessage = 2,
+    TextureUsage = 3,
+    Framing = 4,
+    Fence = 5,
+    Credits = 6,
+    Stats = 7
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace Microgpu.Common.Responses;
+
+public class StatsResponse : IResponse
+{
+    private const int EntrySize = 21;
+
+    /// <summary>
+    ///     Most entries the GPU sends in one response over version 2 framing, since that limits
+    ///     messages to 250 bytes. Framing that allows larger messages gets up to 16 at once.
+    /// </summary>
+    public const int MaxEntriesWithV2Framing = 11;
+
+    /// <summary>
+    ///     Counters for a single type of operation since they were last reset. Times are only
+    ///     counted if the GPU's firmware has a clock, and all counters wrap around on overflow.
+    /// </summary>
+    public readonly record struct Entry(
+        byte OperationType,
+        uint Executions,
+        uint TotalMicroseconds,
+        uint MaxMicroseconds,
+        uint PixelsTouched,
+        uint BytesDecoded);
+
+    /// <summary>
+    ///     The operation type to request next to get the rest of the counters, or zero if every
+    ///     operation type with counters was included.
+    /// </summary>
+    public byte NextOperationType { get; set; }
+
+    public IReadOnlyList<Entry> Entries { get; set; } = Array.Empty<Entry>();
+
+    public void Deserialize(ReadOnlySpan<byte> bytes)
+    {
+        if (bytes[0] != (byte)ResponseType.Stats)
+        {
+            var message = $"Expected type byte of 7 (stats response), found {bytes[0]}";
+            throw new InvalidOperationException(message);
+        }
+
+        NextOperationType = bytes[1];
+
+        var entries = new Entry[bytes[2]];
+        for (var x = 0; x < entries.Length; x++)
+        {
+            var entryBytes = bytes.Slice(3 + x * EntrySize, EntrySize);
+            entries[x] = new Entry(
+                entryBytes[0],
+                ReadUInt32(entryBytes[1..]),
+                ReadUInt32(entryBytes[5..]),
+                ReadUInt32(entryBytes[9..]),
+                ReadUInt32(entryBytes[13..]),
+                ReadUInt32(entryBytes[17..]));
+        }
+
+        Entries = entries;
+    }
+
+    private static uint ReadUInt32(ReadOnlySpan<byte> bytes)
+    {
+        return (uint)((bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3]);
+    }
+}
\ No newline at end of file
@@ -13,6 +13,11 @@ public class StatusResponse : IResponse
     public ushort MaxBytes { get; set; }
     public ushort ApiVersionId { get; set; }
 
+    /// <summary>
+    /// The newest packet framing the gpu can be negotiated up to
+    /// </summary>
+    public byte MaxFramingVersion { get; set; } = 2;
+
     public void Deserialize(ReadOnlySpan<byte> bytes)
     {
         if (bytes[0] != (byte)ResponseType.Status)
@@ -34,5 +39,10 @@ public class StatusResponse : IResponse
         {
             ApiVersionId = (ushort)((bytes[13] << 8) | bytes[14]);
         }
+
+        if (bytes.Length > 15)
+        {
+            MaxFramingVersion = bytes[15];
+        }
     }
 }
\ No newline at end of file
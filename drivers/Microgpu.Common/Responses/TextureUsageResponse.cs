@@ -0,0 +1,46 @@
+﻿using System;
+
+namespace Microgpu.Common.Responses;
+
+public class TextureUsageResponse : IResponse
+{
+    private readonly byte[] _evictedIds = new byte[32];
+
+    public uint FastBytesUsed { get; set; }
+    public uint FastBudget { get; set; }
+    public uint SlowBytesUsed { get; set; }
+    public uint SlowBudget { get; set; }
+    public byte TextureCount { get; set; }
+    public uint EvictionCount { get; set; }
+
+    /// <summary>
+    ///     Returns true if the texture was evicted since the previous texture usage response, and
+    ///     has not been defined again since.
+    /// </summary>
+    public bool WasEvicted(byte textureId)
+    {
+        return (_evictedIds[textureId / 8] & (1 << (textureId % 8))) != 0;
+    }
+
+    public void Deserialize(ReadOnlySpan<byte> bytes)
+    {
+        if (bytes[0] != (byte)ResponseType.TextureUsage)
+        {
+            var message = $"Expected type byte of 3 (texture usage response), found {bytes[0]}";
+            throw new InvalidOperationException(message);
+        }
+
+        FastBytesUsed = ReadUInt32(bytes[1..]);
+        FastBudget = ReadUInt32(bytes[5..]);
+        SlowBytesUsed = ReadUInt32(bytes[9..]);
+        SlowBudget = ReadUInt32(bytes[13..]);
+        TextureCount = bytes[17];
+        EvictionCount = ReadUInt32(bytes[18..]);
+        bytes[22..54].CopyTo(_evictedIds);
+    }
+
+    private static uint ReadUInt32(ReadOnlySpan<byte> bytes)
+    {
+        return (uint)((bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3]);
+    }
+}
\ No newline at end of file
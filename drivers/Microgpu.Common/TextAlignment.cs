@@ -0,0 +1,11 @@
+﻿namespace Microgpu.Common;
+
+/// <summary>
+/// Where text is placed inside a text box. Text that doesn't fit in the box is placed at its start.
+/// </summary>
+public enum TextAlignment
+{
+    Start = 0,
+    Center = 1,
+    End = 2,
+}
\ No newline at end of file
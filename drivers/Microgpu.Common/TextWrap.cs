@@ -0,0 +1,24 @@
+﻿namespace Microgpu.Common;
+
+/// <summary>
+/// How lines of a text box are broken when they're wider than the box. Lines always break after
+/// a newline character.
+/// </summary>
+public enum TextWrap
+{
+    /// <summary>
+    /// Lines only break at newlines, and anything past the edge of the box is clipped
+    /// </summary>
+    None = 0,
+
+    /// <summary>
+    /// Lines break at the last space that fits, or between characters when a word is wider than
+    /// the box on its own
+    /// </summary>
+    Words = 1,
+
+    /// <summary>
+    /// Lines break after the last character that fits
+    /// </summary>
+    Characters = 2,
+}
\ No newline at end of file
@@ -3,8 +3,7 @@ using Microgpu.Common.Comms;
 using Microgpu.Sample.Common;
 using Microgpu.Sample.Common.Samples;
 
-Console.WriteLine("Connecting to TCP microgpu server on localhost:9123 ...");
-var gpu = await Gpu.CreateAsync(new TcpGpuCommunication("localhost", 9123));
+var gpu = await Gpu.CreateAsync(CreateCommunication());
 await gpu.InitializeAsync(1);
 
 var sampleRunner = new SampleRunner(gpu, TimeSpan.FromMilliseconds(16));
@@ -12,4 +11,18 @@ var octahedron = sampleRunner.Octahedron;
 
 octahedron.RotationDegreesPerSecond = new Octahedron.Vector3(0, 100, 120);
 
-await sampleRunner.Run();
\ No newline at end of file
+await sampleRunner.Run();
+
+IGpuCommunication CreateCommunication()
+{
+    var shmIndex = Array.IndexOf(args, "--shm");
+    if (shmIndex >= 0)
+    {
+        var path = shmIndex + 1 < args.Length ? args[shmIndex + 1] : SharedMemoryGpuCommunication.DefaultPath;
+        Console.WriteLine($"Connecting to shared memory microgpu server through {path} ...");
+        return new SharedMemoryGpuCommunication(path);
+    }
+
+    Console.WriteLine("Connecting to TCP microgpu server on localhost:9123 ...");
+    return new TcpGpuCommunication("localhost", 9123);
+}
\ No newline at end of file
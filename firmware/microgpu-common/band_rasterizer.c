@@ -0,0 +1,198 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "messages.h"
+#include "operations/execution/drawing/draw_operation.h"
+#include "operations/operation_queue.h"
+#include "band_rasterizer.h"
+
+typedef struct {
+    Mgpu_OperationQueue *queue;
+    uint32_t waitAttempts; // Only touched by the worker's thread
+} Worker;
+
+struct Mgpu_BandRasterizer {
+    const Mgpu_Allocator *allocator;
+    void (*waitFn)(uint32_t attempt);
+    atomic_bool isStopped;
+
+    // Set by the executing thread before operations are queued, so workers see it once
+    // they see the operation.
+    Mgpu_TextureManager *textureManager;
+
+    uint8_t workerCount;
+    Worker workers[];
+};
+
+static void wait(Mgpu_BandRasterizer *rasterizer, uint32_t attempt) {
+    if (rasterizer->waitFn != NULL) {
+        rasterizer->waitFn(attempt);
+    }
+}
+
+static void get_band(Mgpu_Texture *frameBuffer, uint8_t workerCount, uint8_t workerIndex, Mgpu_DrawBounds *band) {
+    band->left = 0;
+    band->right = frameBuffer->width;
+    band->top = (uint32_t) frameBuffer->height * workerIndex / workerCount;
+    band->bottom = (uint32_t) frameBuffer->height * (workerIndex + 1) / workerCount;
+}
+
+static void flush(void *context, Mgpu_TextureManager *textureManager) {
+    Mgpu_BandRasterizer *rasterizer = context;
+
+    // Workers only pop an operation once it's been fully rasterized, so empty queues mean
+    // every band is up to date.
+    for (int x = 0; x < rasterizer->workerCount; x++) {
+        uint32_t attempt = 0;
+        while (!mgpu_operation_queue_is_empty(rasterizer->workers[x].queue) &&
+               !atomic_load_explicit(&rasterizer->isStopped, memory_order_relaxed)) {
+            wait(rasterizer, attempt);
+            attempt++;
+        }
+    }
+}
+
+static bool push(Mgpu_BandRasterizer *rasterizer, Worker *worker, Mgpu_Operation *operation) {
+    uint32_t attempt = 0;
+    while (!atomic_load_explicit(&rasterizer->isStopped, memory_order_relaxed)) {
+        switch (mgpu_operation_queue_try_push(worker->queue, operation)) {
+            case Mgpu_OperationQueue_Pushed:
+                return true;
+
+            case Mgpu_OperationQueue_Full:
+                wait(rasterizer, attempt);
+                attempt++;
+                break;
+
+            case Mgpu_OperationQueue_TooLarge:
+                return false;
+        }
+    }
+
+    return false;
+}
+
+static bool submit(void *context, Mgpu_Operation *operation, Mgpu_TextureManager *textureManager) {
+    Mgpu_BandRasterizer *rasterizer = context;
+
+    uint8_t targetTextureId;
+    Mgpu_DrawBounds bounds;
+    if (!mgpu_draw_operation_get_bounds(operation, textureManager, &targetTextureId, &bounds) ||
+        targetTextureId != 0 ||
+        mgpu_draw_operation_reads_texture(operation, 0)) {
+        // Only operations that draw to the framebuffer can be split into bands, and only if
+        // they don't depend on pixels other bands may not have drawn yet.
+        return false;
+    }
+
+    rasterizer->textureManager = textureManager;
+
+    Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
+    bool anyPushed = false;
+    for (int x = 0; x < rasterizer->workerCount; x++) {
+        Mgpu_DrawBounds band;
+        get_band(frameBuffer, rasterizer->workerCount, x, &band);
+        if (!mgpu_draw_bounds_intersect(&bounds, &band)) {
+            continue;
+        }
+
+        if (!push(rasterizer, &rasterizer->workers[x], operation)) {
+            // Every worker's arena is the same size, so an operation that's too large for one
+            // is too large for all of them, and only the first push can fail this way.
+            assert(!anyPushed || atomic_load_explicit(&rasterizer->isStopped, memory_order_relaxed));
+            return anyPushed;
+        }
+
+        anyPushed = true;
+    }
+
+    return true;
+}
+
+Mgpu_BandRasterizer *mgpu_band_rasterizer_new(const Mgpu_Allocator *allocator,
+                                              const Mgpu_BandRasterizerOptions *options) {
+    mgpu_alloc_assert(allocator);
+    assert(options != NULL);
+    assert(options->workerCount > 0);
+
+    size_t size = sizeof(Mgpu_BandRasterizer) + (sizeof(Worker) * options->workerCount);
+    Mgpu_BandRasterizer *rasterizer = allocator->FastMemAllocateFn(size);
+    if (rasterizer == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate band rasterizer", MESSAGE_MAX_LEN);
+
+        return NULL;
+    }
+
+    memset(rasterizer, 0, size);
+    rasterizer->allocator = allocator;
+    rasterizer->waitFn = options->waitFn;
+    rasterizer->workerCount = options->workerCount;
+    atomic_init(&rasterizer->isStopped, false);
+
+    for (int x = 0; x < options->workerCount; x++) {
+        rasterizer->workers[x].queue = mgpu_operation_queue_new(allocator,
+                                                                options->operationCapacity,
+                                                                options->payloadArenaSize);
+
+        if (rasterizer->workers[x].queue == NULL) {
+            mgpu_band_rasterizer_free(rasterizer);
+            return NULL;
+        }
+    }
+
+    return rasterizer;
+}
+
+void mgpu_band_rasterizer_free(Mgpu_BandRasterizer *rasterizer) {
+    if (rasterizer != NULL) {
+        for (int x = 0; x < rasterizer->workerCount; x++) {
+            mgpu_operation_queue_free(rasterizer->workers[x].queue);
+        }
+
+        rasterizer->allocator->FastMemFreeFn(rasterizer);
+    }
+}
+
+void mgpu_band_rasterizer_get_dispatcher(Mgpu_BandRasterizer *rasterizer, Mgpu_DrawDispatcher *dispatcher) {
+    assert(rasterizer != NULL);
+    assert(dispatcher != NULL);
+
+    dispatcher->context = rasterizer;
+    dispatcher->submitFn = submit;
+    dispatcher->flushFn = flush;
+}
+
+bool mgpu_band_rasterizer_work(Mgpu_BandRasterizer *rasterizer, uint8_t workerIndex) {
+    assert(rasterizer != NULL);
+    assert(workerIndex < rasterizer->workerCount);
+
+    Worker *worker = &rasterizer->workers[workerIndex];
+    Mgpu_Operation *operation = mgpu_operation_queue_peek(worker->queue);
+    if (operation == NULL) {
+        wait(rasterizer, worker->waitAttempts);
+        worker->waitAttempts++;
+
+        return false;
+    }
+
+    worker->waitAttempts = 0;
+
+    Mgpu_Texture *frameBuffer = mgpu_texture_get(rasterizer->textureManager, 0);
+    assert(frameBuffer != NULL);
+
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(frameBuffer, &region);
+    get_band(frameBuffer, rasterizer->workerCount, workerIndex, &region.clip);
+
+    mgpu_draw_operation_in_region(operation, rasterizer->textureManager, &region);
+    mgpu_operation_queue_pop(worker->queue);
+
+    return true;
+}
+
+void mgpu_band_rasterizer_stop(Mgpu_BandRasterizer *rasterizer) {
+    assert(rasterizer != NULL);
+    atomic_store_explicit(&rasterizer->isStopped, true, memory_order_relaxed);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "alloc.h"
+#include "operations/operation_execution.h"
+#include "texture_manager.h"
+
+/*
+ * Splits the framebuffer into horizontal bands, with each band rasterized by its own worker.
+ * Drawing operations that target the framebuffer are handed to every worker whose band they
+ * overlap, and each worker only writes the rows in its own band. Since no two workers ever touch
+ * the same pixels, bands can be rasterized in parallel without any locking.
+ *
+ * The rasterizer is hooked into operation execution as a draw dispatcher. Any operation that it
+ * can't split up (drawing to other textures, presenting, defining textures, etc...) first waits
+ * for all workers to finish, so operations always appear to have been executed in order.
+ *
+ * Each worker has its own single producer/single consumer operation queue, so exactly one thread
+ * may execute operations, and each worker index must be run by exactly one thread.
+ */
+typedef struct Mgpu_BandRasterizer Mgpu_BandRasterizer;
+
+typedef struct {
+    /*
+     * How many bands the framebuffer is split into, each with its own worker.
+     */
+    uint8_t workerCount;
+
+    /*
+     * How many operations can be waiting on each worker. Must be a power of two.
+     */
+    uint16_t operationCapacity;
+
+    /*
+     * How many bytes each worker reserves for operation data (characters to draw, etc...). Must
+     * be at least as large as the largest drawing operation the databus can receive, otherwise
+     * larger operations will be rasterized without splitting them up.
+     */
+    size_t payloadArenaSize;
+
+    /*
+     * Called when a worker has nothing to do, or when operation execution is waiting on workers.
+     * The number of consecutive waits is passed in, so implementations can yield at first and
+     * back off to sleeping. If NULL, waiting will busy-wait.
+     */
+    void (*waitFn)(uint32_t attempt);
+} Mgpu_BandRasterizerOptions;
+
+/*
+ * Creates a new band rasterizer
+ */
+Mgpu_BandRasterizer *mgpu_band_rasterizer_new(const Mgpu_Allocator *allocator,
+                                              const Mgpu_BandRasterizerOptions *options);
+
+/*
+ * Frees the rasterizer and all memory it allocated. No workers may be running, and it must no
+ * longer be the active draw dispatcher.
+ */
+void mgpu_band_rasterizer_free(Mgpu_BandRasterizer *rasterizer);
+
+/*
+ * Gets the dispatcher that routes operations through this rasterizer, to be passed to
+ * `mgpu_execute_set_draw_dispatcher()`.
+ */
+void mgpu_band_rasterizer_get_dispatcher(Mgpu_BandRasterizer *rasterizer, Mgpu_DrawDispatcher *dispatcher);
+
+/*
+ * Rasterizes the next operation waiting on the specified worker. If none are waiting then the
+ * rasterizer's wait function is invoked and false is returned. Meant to be called in a loop by the
+ * worker's thread.
+ */
+bool mgpu_band_rasterizer_work(Mgpu_BandRasterizer *rasterizer, uint8_t workerIndex);
+
+/*
+ * Signals that workers are being shut down, so operation execution no longer waits on them.
+ */
+void mgpu_band_rasterizer_stop(Mgpu_BandRasterizer *rasterizer);
@@ -47,6 +47,12 @@ Mgpu_Color mgpu_color_from_rgb888(uint8_t red, uint8_t green, uint8_t blue);
  */
 void mgpu_color_get_rgb888(Mgpu_Color color, uint8_t *red, uint8_t *green, uint8_t *blue);
 
+/*
+ * Mixes the foreground color over the background color, where an alpha of 0 is only the
+ * background and 255 is only the foreground.
+ */
+Mgpu_Color mgpu_color_blend(Mgpu_Color background, Mgpu_Color foreground, uint8_t alpha);
+
 /*
  * Deserializes a single color from an array of bytes. The index of the byte after the last
  * byte read is set in the `nextIndex` pointer
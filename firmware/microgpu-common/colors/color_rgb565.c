@@ -46,6 +46,17 @@ void mgpu_color_get_rgb888(Mgpu_Color color, uint8_t *red, uint8_t *green, uint8
     *blue = tempBlue;
 }
 
+Mgpu_Color mgpu_color_blend(Mgpu_Color background, Mgpu_Color foreground, uint8_t alpha) {
+    // Green is moved to the upper half with a gap before each channel, so all three channels
+    // can be mixed with a single multiply by a 5 bit alpha
+    uint32_t alpha5 = (alpha + 4) >> 3;
+    uint32_t back = (background | ((uint32_t) background << 16)) & 0x07E0F81F;
+    uint32_t fore = (foreground | ((uint32_t) foreground << 16)) & 0x07E0F81F;
+    uint32_t mixed = (back + (((fore - back) * alpha5) >> 5)) & 0x07E0F81F;
+
+    return (Mgpu_Color) (mixed | (mixed >> 16));
+}
+
 Mgpu_Color mgpu_color_deserialize(const uint8_t bytes[], size_t firstColorByteIndex, size_t *nextIndex) {
     uint8_t red = (bytes[firstColorByteIndex] & 0xF8) >> 3;
     uint8_t green = (bytes[firstColorByteIndex] & 0x07) << 3 | (bytes[firstColorByteIndex + 1] & 0xE0) >> 5;
@@ -47,4 +47,18 @@ void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response);
  * received as. A value of zero means the databus has no limit in how large an operation
  * can be.
  */
-uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus);
\ No newline at end of file
+uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus);
+
+/*
+ * Returns the newest packet framing version the databus can be negotiated up to.
+ */
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus);
+
+/*
+ * Switches to the newest packet framing the databus supports that isn't newer than the
+ * requested version, and sends a framing response describing it. The response is still
+ * framed the way the request was, while every operation received after it is expected
+ * in the new framing. Databuses without packet framing respond with version 2. The response
+ * is tagged with the request id, unless it's zero.
+ */
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId);
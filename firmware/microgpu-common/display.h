@@ -15,6 +15,11 @@ typedef struct Mgpu_Display Mgpu_Display;
  */
 typedef struct Mgpu_DisplayOptions Mgpu_DisplayOptions;
 
+/*
+ * A frame kept as a list of drawing operations instead of pixels (see retained_frame.h)
+ */
+typedef struct Mgpu_RetainedFrame Mgpu_RetainedFrame;
+
 /*
  * Creates a new display instance. Display instances will keep a reference
  * to the allocator to ensure it uses the corresponding and correct free
@@ -44,3 +49,24 @@ void mgpu_display_get_dimensions(Mgpu_Display *display, uint16_t *width, uint16_
  * have the same dimensions and scale.
  */
 void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureManager);
+
+/*
+ * Switches the display to rendering frames in strips from the retained frame, instead of from
+ * texture 0's pixels. Texture 0 is expected to be defined with `MGPU_TEXTURE_NO_PIXELS`, and
+ * hardware displays only support a frame buffer scale of 1 in this mode. Strips may be rendered
+ * outside of `mgpu_display_render()` calls, such as while the display is being refreshed, so
+ * the texture manager used to draw them is passed in up front.
+ *
+ * Passing a NULL retained frame switches back to rendering from texture 0's pixels.
+ */
+void mgpu_display_set_retained_frame(Mgpu_Display *display,
+                                     Mgpu_RetainedFrame *retainedFrame,
+                                     Mgpu_TextureManager *textureManager);
+
+/*
+ * Gets how many frames have been passed to `mgpu_display_render()`, and how many of those have
+ * finished being sent to the panel. Displays that keep sending a frame after the render call
+ * returns (such as through DMA) report fewer frames presented than rendered until they're done.
+ * Both counts start at zero when the display is created, and wrap around.
+ */
+void mgpu_display_get_frame_counts(Mgpu_Display *display, uint32_t *framesRendered, uint32_t *framesPresented);
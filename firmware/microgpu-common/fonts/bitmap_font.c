@@ -0,0 +1,213 @@
+#include <assert.h>
+#include "microgpu-common/common.h"
+#include "bitmap_font.h"
+
+// Every bit of a glyph row byte expanded to a whole pixel mask, so a row is drawn without branching
+#define PIXEL_MASK(bits, bit) ((((bits) >> (bit)) & 0x01) ? (Mgpu_Color) ~0 : (Mgpu_Color) 0)
+#define ROW_MASKS(bits) {PIXEL_MASK(bits, 0), PIXEL_MASK(bits, 1), PIXEL_MASK(bits, 2), PIXEL_MASK(bits, 3), \
+                         PIXEL_MASK(bits, 4), PIXEL_MASK(bits, 5), PIXEL_MASK(bits, 6), PIXEL_MASK(bits, 7)}
+#define ROW_MASKS_4(bits) ROW_MASKS(bits), ROW_MASKS((bits) + 1), ROW_MASKS((bits) + 2), ROW_MASKS((bits) + 3)
+#define ROW_MASKS_16(bits) ROW_MASKS_4(bits), ROW_MASKS_4((bits) + 4), ROW_MASKS_4((bits) + 8), ROW_MASKS_4((bits) + 12)
+#define ROW_MASKS_64(bits) ROW_MASKS_16(bits), ROW_MASKS_16((bits) + 16), ROW_MASKS_16((bits) + 32), ROW_MASKS_16((bits) + 48)
+
+static const Mgpu_Color rowMasks[256][8] = {
+        ROW_MASKS_64(0), ROW_MASKS_64(64), ROW_MASKS_64(128), ROW_MASKS_64(192),
+};
+
+static bool has_glyph(const Mgpu_BitmapFont *font, uint8_t character) {
+    return character >= font->firstCharacter && character - font->firstCharacter < font->characterCount;
+}
+
+/*
+ * Gets how wide the character's glyph is and the bit of the data its first row starts at, along
+ * with how many bits apart its rows are.
+ */
+static void get_glyph_layout(const Mgpu_BitmapFont *font,
+                             uint8_t character,
+                             uint8_t *width,
+                             size_t *firstBit,
+                             size_t *rowBits) {
+    size_t glyph = character - font->firstCharacter;
+    if (font->glyphWidths != NULL) {
+        *width = font->glyphWidths[glyph];
+        *firstBit = (size_t) font->glyphOffsets[glyph] * 8;
+        *rowBits = font->hasCoverage ? *width * 8 : *width;
+    } else {
+        *width = font->width;
+        *rowBits = font->rowsArePacked ? font->width : ((font->width + 7) / 8) * 8;
+        *firstBit = glyph * font->height * *rowBits;
+    }
+}
+
+static uint32_t read_row(const Mgpu_BitmapFont *font, size_t firstBit, uint8_t width) {
+    if (width == 0) {
+        return 0;
+    }
+
+    // Only the bytes the row covers are read, as the last row may end on the data's last byte
+    const uint8_t *byte = font->data + (firstBit / 8);
+    uint8_t shift = firstBit % 8;
+    uint32_t bits = byte[0];
+    for (int read = 1; read * 8 < shift + width; read++) {
+        bits |= (uint32_t) byte[read] << (read * 8);
+    }
+
+    return (bits >> shift) & ((1u << width) - 1);
+}
+
+static void write_row(Mgpu_Color *pixel, int count, uint32_t bits, Mgpu_Color color) {
+    // Written 8 pixels at a time, with the table deciding which keep their color
+    for (; count >= 8; count -= 8, bits >>= 8, pixel += 8) {
+        const Mgpu_Color *masks = rowMasks[bits & 0xFF];
+        for (int index = 0; index < 8; index++) {
+            pixel[index] = (pixel[index] & ~masks[index]) | (color & masks[index]);
+        }
+    }
+
+    const Mgpu_Color *masks = rowMasks[bits & 0xFF];
+    for (int index = 0; index < count; index++) {
+        pixel[index] = (pixel[index] & ~masks[index]) | (color & masks[index]);
+    }
+}
+
+static void write_opaque_row(Mgpu_Color *pixel, int count, uint32_t bits, Mgpu_Color color, Mgpu_Color background) {
+    // Every pixel is written, so nothing needs to be read back from the region
+    for (; count >= 8; count -= 8, bits >>= 8, pixel += 8) {
+        const Mgpu_Color *masks = rowMasks[bits & 0xFF];
+        for (int index = 0; index < 8; index++) {
+            pixel[index] = (background & ~masks[index]) | (color & masks[index]);
+        }
+    }
+
+    const Mgpu_Color *masks = rowMasks[bits & 0xFF];
+    for (int index = 0; index < count; index++) {
+        pixel[index] = (background & ~masks[index]) | (color & masks[index]);
+    }
+}
+
+static void write_coverage_row(Mgpu_Color *pixel,
+                               int count,
+                               const uint8_t *coverage,
+                               Mgpu_Color color,
+                               const Mgpu_Color *backgroundColor) {
+    for (int index = 0; index < count; index++) {
+        if (coverage[index] == 0xFF) {
+            pixel[index] = color;
+        } else if (backgroundColor != NULL) {
+            pixel[index] = mgpu_color_blend(*backgroundColor, color, coverage[index]);
+        } else if (coverage[index] != 0) {
+            pixel[index] = mgpu_color_blend(pixel[index], color, coverage[index]);
+        }
+    }
+}
+
+static void write_char(const Mgpu_BitmapFont *font,
+                       const Mgpu_DrawRegion *region,
+                       uint8_t character,
+                       Mgpu_Color color,
+                       const Mgpu_Color *backgroundColor,
+                       int startX,
+                       int startY) {
+    bool glyphExists = has_glyph(font, character);
+    if (!glyphExists && (backgroundColor == NULL || font->glyphWidths != NULL)) {
+        return;
+    }
+
+    uint8_t width = font->width;
+    size_t firstBit = 0, rowBits = 0;
+    if (glyphExists) {
+        get_glyph_layout(font, character, &width, &firstBit, &rowBits);
+    }
+
+    int firstX = max(startX, region->clip.left);
+    int firstY = max(startY, region->clip.top);
+    int endX = min(region->clip.right, startX + width);
+    int endY = min(region->clip.bottom, startY + font->height);
+    if (firstX >= endX || firstY >= endY) {
+        return;
+    }
+
+    uint8_t skippedColumns = firstX - startX;
+    firstBit += (firstY - startY) * rowBits;
+    Mgpu_Color *rowStart = mgpu_draw_region_pixel(region, firstX, firstY);
+
+    if (font->hasCoverage) {
+        // Coverage fonts are always proportional, so only characters with glyphs get this far
+        const uint8_t *coverage = font->data + (firstBit / 8) + skippedColumns;
+        for (int row = firstY; row < endY; row++, rowStart += region->stride, coverage += width) {
+            write_coverage_row(rowStart, endX - firstX, coverage, color, backgroundColor);
+        }
+
+        return;
+    }
+
+    for (int row = firstY; row < endY; row++, rowStart += region->stride, firstBit += rowBits) {
+        // Characters without a glyph still get their cell filled in when drawn with a background
+        uint32_t bits = glyphExists ? read_row(font, firstBit, width) >> skippedColumns : 0;
+        if (backgroundColor != NULL) {
+            write_opaque_row(rowStart, endX - firstX, bits, color, *backgroundColor);
+        } else if (bits != 0) {
+            write_row(rowStart, endX - firstX, bits, color);
+        }
+    }
+}
+
+void mgpu_bitmap_font_write(const Mgpu_BitmapFont *font,
+                            const Mgpu_DrawRegion *region,
+                            const uint8_t *characters,
+                            uint8_t count,
+                            Mgpu_Color color,
+                            const Mgpu_Color *backgroundColor,
+                            uint16_t startX,
+                            uint16_t startY) {
+    assert(font != NULL);
+    assert(region != NULL);
+    assert(characters != NULL);
+
+    int x = startX;
+    for (int index = 0; index < count && x < region->clip.right; index++) {
+        write_char(font, region, characters[index], color, backgroundColor, x, startY);
+        x += mgpu_bitmap_font_get_advance(font, characters[index]);
+    }
+}
+
+uint8_t mgpu_bitmap_font_get_advance(const Mgpu_BitmapFont *font, uint8_t character) {
+    assert(font != NULL);
+
+    if (font->glyphWidths == NULL) {
+        return font->width;
+    }
+
+    return has_glyph(font, character) ? font->glyphWidths[character - font->firstCharacter] : 0;
+}
+
+uint32_t mgpu_bitmap_font_measure(const Mgpu_BitmapFont *font, const uint8_t *characters, uint8_t count) {
+    assert(font != NULL);
+    assert(characters != NULL);
+
+    if (font->glyphWidths == NULL) {
+        return (uint32_t) count * font->width;
+    }
+
+    uint32_t width = 0;
+    for (int index = 0; index < count; index++) {
+        width += mgpu_bitmap_font_get_advance(font, characters[index]);
+    }
+
+    return width;
+}
+
+uint32_t mgpu_bitmap_font_get_row(const Mgpu_BitmapFont *font, uint8_t character, uint8_t row) {
+    assert(font != NULL);
+    assert(!font->hasCoverage);
+    assert(row < font->height);
+
+    if (!has_glyph(font, character)) {
+        return 0;
+    }
+
+    uint8_t width;
+    size_t firstBit, rowBits;
+    get_glyph_layout(font, character, &width, &firstBit, &rowBits);
+    return read_row(font, firstBit + (row * rowBits), width);
+}
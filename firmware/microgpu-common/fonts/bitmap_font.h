@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "microgpu-common/colors/color.h"
+#include "microgpu-common/operations/execution/drawing/draw_region.h"
+
+/*
+ * Widest a glyph can be, so a row and the bits before it in its first byte fit in 32 bits
+ */
+#define MGPU_BITMAP_FONT_MAX_WIDTH 24
+
+/*
+ * A font whose glyphs are one bit per pixel, with the lowest bit of each byte being the leftmost
+ * pixel.
+ */
+typedef struct {
+    /*
+     * For proportional fonts the width is of the widest glyph
+     */
+    uint8_t width, height;
+
+    /*
+     * The character the first glyph in the data is for. Glyphs for every character after it
+     * follow without any gaps.
+     */
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+
+    /*
+     * If true, each row continues straight from the bit the previous row ended on. Otherwise each
+     * row starts on a new byte.
+     */
+    bool rowsArePacked;
+
+    const uint8_t *data;
+
+    /*
+     * For proportional fonts, how wide each glyph is and which byte of the data its rows start
+     * at. Rows of proportional glyphs are always packed, and each character advances by the width
+     * of its glyph. NULL when every glyph is `width` pixels wide and they follow each other.
+     */
+    const uint8_t *glyphWidths;
+    const uint32_t *glyphOffsets;
+
+    /*
+     * If true, every pixel of a proportional glyph is a byte of how much of the pixel the glyph
+     * covers, with partly covered pixels blended with what they're drawn over.
+     */
+    bool hasCoverage;
+} Mgpu_BitmapFont;
+
+/*
+ * Draws the characters, only writing pixels that fall inside the region. Without a background
+ * color, pixels that aren't part of a glyph are left as they are and characters the font doesn't
+ * have a glyph for are skipped over. With one, each character's whole cell is written. Characters
+ * a proportional font has no glyph for take up no space.
+ */
+void mgpu_bitmap_font_write(const Mgpu_BitmapFont *font,
+                            const Mgpu_DrawRegion *region,
+                            const uint8_t *characters,
+                            uint8_t count,
+                            Mgpu_Color color,
+                            const Mgpu_Color *backgroundColor,
+                            uint16_t startX,
+                            uint16_t startY);
+
+/*
+ * Gets how many pixels the start of the next character is after the character
+ */
+uint8_t mgpu_bitmap_font_get_advance(const Mgpu_BitmapFont *font, uint8_t character);
+
+/*
+ * Gets how many pixels wide the characters are when drawn
+ */
+uint32_t mgpu_bitmap_font_measure(const Mgpu_BitmapFont *font, const uint8_t *characters, uint8_t count);
+
+/*
+ * Gets the bits of one row of the character's glyph, with the lowest bit being the leftmost
+ * pixel. Characters without a glyph have no bits set. The font must not have coverage.
+ */
+uint32_t mgpu_bitmap_font_get_row(const Mgpu_BitmapFont *font, uint8_t character, uint8_t row);
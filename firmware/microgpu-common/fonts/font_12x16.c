@@ -1,9 +1,5 @@
-#include "microgpu-common/common.h"
 #include "font_12x16.h"
 
-#define WIDTH 12
-#define HEIGHT 16
-
 // Byte data taken from https://github.com/WildernessLabs/Meadow.Foundation/blob/e7a26cd567/Source/Meadow.Foundation.Libraries_and_Frameworks/Graphics.MicroGraphics/Driver/Fonts/Font12x16.cs
 static const uint8_t data[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -198,46 +194,11 @@ static const uint8_t data[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, //007E(~)
 };
 
-
-static void write_char(Mgpu_Texture *texture, char character, Mgpu_Color color, uint16_t startX, uint16_t startY) {
-    if (startX >= texture->width || startY >= texture->height || character < 0x20 || character > 0x7f) {
-        return;
-    }
-
-    const uint8_t bytesPerChar = WIDTH * HEIGHT / 8;
-    const uint8_t *byte = data + ((character - 0x20) * bytesPerChar);
-    Mgpu_Color *rowStart = texture->pixels + (startY * texture->width + startX);
-
-    int currentBit = 0;
-
-    for (int row = 0; row < HEIGHT; row++) {
-        Mgpu_Color *pixel = rowStart;
-        for (int bitCount = 0; bitCount < WIDTH; bitCount++) {
-            if (currentBit == 8) {
-                byte++;
-                currentBit = 0;
-            }
-
-            const uint8_t mask = 0x01 << currentBit;
-            if ((*byte & mask) == mask) {
-                *pixel = color;
-            }
-
-            pixel++;
-            currentBit++;
-        }
-
-        rowStart += texture->width;
-    }
-}
-
-void mgpu_font_12x16_write(Mgpu_Texture *texture, char *text, Mgpu_Color color, uint16_t startX, uint16_t startY) {
-    assert(texture != NULL);
-    assert(text != NULL);
-
-    while (*text != '\0') {
-        write_char(texture, *text, color, startX, startY);
-        text++;
-        startX += WIDTH;
-    }
-}
+const Mgpu_BitmapFont mgpu_font_12x16 = {
+        .width = 12,
+        .height = 16,
+        .firstCharacter = 0x20,
+        .characterCount = 95,
+        .rowsArePacked = true,
+        .data = data,
+};
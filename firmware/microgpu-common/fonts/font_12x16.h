@@ -1,10 +1,5 @@
 #pragma once
 
-#include "microgpu-common/colors/color.h"
-#include "microgpu-common/texture_manager.h"
+#include "bitmap_font.h"
 
-void mgpu_font_12x16_write(Mgpu_Texture *texture,
-                           char *text,
-                           Mgpu_Color color,
-                           uint16_t startX,
-                           uint16_t startY);
+extern const Mgpu_BitmapFont mgpu_font_12x16;
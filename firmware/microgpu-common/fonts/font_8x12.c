@@ -1,5 +1,3 @@
-#include <assert.h>
-#include "microgpu-common/common.h"
 #include "font_8x12.h"
 
 // Byte data taken from https://github.com/WildernessLabs/Meadow.Foundation/blob/e7a26cd567/Source/Meadow.Foundation.Libraries_and_Frameworks/Graphics.MicroGraphics/Driver/Fonts/Font8x12.cs
@@ -102,39 +100,11 @@ static const uint8_t data[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // U+007F
 };
 
-static void write_char(Mgpu_Texture *texture, char character, Mgpu_Color color, uint16_t startX, uint16_t startY) {
-    if (startX >= texture->width || startY >= texture->height || character < 0x20 || character > 0x7f) {
-        return;
-    }
-
-    uint16_t endX = min(texture->width, startX + 8);
-    uint8_t width = endX - startX;
-    const uint8_t *byte = data + ((character - 0x20) * 12);
-    Mgpu_Color *rowStart = texture->pixels + (startY * texture->width + startX);
-
-    for (int row = 0; row < 12; row++) {
-        Mgpu_Color *pixel = rowStart;
-        for (int shift = 0; shift < width; shift++) {
-            uint8_t mask = 0x01 << shift;
-            if ((*byte & mask) == mask) {
-                *pixel = color;
-            }
-
-            pixel++;
-        }
-
-        rowStart += texture->width;
-        byte++;
-    }
-}
-
-void mgpu_font_8x12_write(Mgpu_Texture *texture, char *text, Mgpu_Color color, uint16_t startX, uint16_t startY) {
-    assert(texture != NULL);
-    assert(text != NULL);
-
-    while (*text != '\0') {
-        write_char(texture, *text, color, startX, startY);
-        text++;
-        startX += 8;
-    }
-}
+const Mgpu_BitmapFont mgpu_font_8x12 = {
+        .width = 8,
+        .height = 12,
+        .firstCharacter = 0x20,
+        .characterCount = 96,
+        .rowsArePacked = false,
+        .data = data,
+};
@@ -2,20 +2,56 @@
 #include <stdio.h>
 #include <assert.h>
 #include "microgpu-common/messages.h"
+#include "microgpu-common/common.h"
 #include "fonts.h"
 #include "font_8x12.h"
 #include "font_12x16.h"
+#include "glyph_cache.h"
+
+static void draw_spans(const Mgpu_DrawRegion *region,
+                       const Mgpu_GlyphSpan *spans,
+                       uint8_t spanCount,
+                       Mgpu_Color color,
+                       uint16_t startX,
+                       uint16_t startY) {
+    for (int index = 0; index < spanCount; index++) {
+        const Mgpu_GlyphSpan *span = &spans[index];
+        int y = startY + span->row;
+        if (y < region->clip.top) {
+            continue;
+        }
+
+        if (y >= region->clip.bottom) {
+            // Spans are in row order, so none of the rest are inside the region either
+            break;
+        }
+
+        int left = max(startX + span->x, region->clip.left);
+        int right = min(startX + span->x + span->length, region->clip.right);
+        if (left >= right) {
+            continue;
+        }
+
+        Mgpu_Color *pixel = mgpu_draw_region_pixel(region, left, y);
+        for (int x = left; x < right; x++) {
+            *pixel = color;
+            pixel++;
+        }
+    }
+}
 
 void mgpu_font_draw(Mgpu_TextureManager *textureManager,
                     Mgpu_FontId fontId,
                     uint8_t destinationTextureId,
-                    char *text,
+                    const uint8_t *characters,
+                    uint8_t count,
                     Mgpu_Color color,
+                    const Mgpu_Color *backgroundColor,
                     uint16_t startX,
                     uint16_t startY) {
     assert(textureManager != NULL);
 
-    if (text == NULL || strlen(text) == 0) {
+    if (characters == NULL || count == 0) {
         return; // nothing to draw
     }
 
@@ -33,21 +69,130 @@ void mgpu_font_draw(Mgpu_TextureManager *textureManager,
         return;
     }
 
+    mgpu_glyph_cache_add(fontId, characters, count);
+
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(texture, &region);
+    if (!mgpu_font_draw_in_region(textureManager,
+                                  fontId,
+                                  &region,
+                                  characters,
+                                  count,
+                                  color,
+                                  backgroundColor,
+                                  startX,
+                                  startY)) {
+        char *message = mgpu_message_get_pointer();
+        assert(message != NULL);
+
+        snprintf(message, MESSAGE_MAX_LEN, "Invalid font id specified of %u", fontId);
+    }
+}
+
+bool mgpu_font_draw_in_region(Mgpu_TextureManager *textureManager,
+                              Mgpu_FontId fontId,
+                              const Mgpu_DrawRegion *region,
+                              const uint8_t *characters,
+                              uint8_t count,
+                              Mgpu_Color color,
+                              const Mgpu_Color *backgroundColor,
+                              uint16_t startX,
+                              uint16_t startY) {
+    assert(textureManager != NULL);
+    assert(region != NULL);
+    assert(characters != NULL);
+
+    Mgpu_BitmapFont uploadedFont;
+    const Mgpu_BitmapFont *font = mgpu_font_get(textureManager, fontId, &uploadedFont);
+    if (font == NULL) {
+        return false;
+    }
+
+    if (backgroundColor != NULL || font == &uploadedFont) {
+        // Every pixel of opaque cells gets written, which the font does in one pass without spans,
+        // and uploaded fonts aren't in the glyph cache
+        mgpu_bitmap_font_write(font, region, characters, count, color, backgroundColor, startX, startY);
+        return true;
+    }
+
+    for (int index = 0; index < count; index++, startX += font->width) {
+        if (startX >= region->clip.right) {
+            break;
+        }
+
+        uint8_t spanCount;
+        const Mgpu_GlyphSpan *spans = mgpu_glyph_cache_get(fontId, characters[index], &spanCount);
+        if (spans != NULL) {
+            draw_spans(region, spans, spanCount, color, startX, startY);
+        } else {
+            mgpu_bitmap_font_write(font, region, &characters[index], 1, color, NULL, startX, startY);
+        }
+    }
+
+    return true;
+}
+
+const Mgpu_BitmapFont *mgpu_font_get_builtin(Mgpu_FontId fontId) {
     switch (fontId) {
         case Mgpu_Font_Font8x12:
-            mgpu_font_8x12_write(texture, text, color, startX, startY);
-            break;
+            return &mgpu_font_8x12;
 
         case Mgpu_Font_Font12x16:
-            mgpu_font_12x16_write(texture, text, color, startX, startY);
-            break;
+            return &mgpu_font_12x16;
 
-        default: {
-            char *message = mgpu_message_get_pointer();
-            assert(message != NULL);
+        default:
+            return NULL;
+    }
+}
 
-            snprintf(message, MESSAGE_MAX_LEN, "Invalid font id specified of %u", fontId);
-            break;
-        }
+const Mgpu_BitmapFont *mgpu_font_get(Mgpu_TextureManager *textureManager,
+                                     Mgpu_FontId fontId,
+                                     Mgpu_BitmapFont *uploadedFont) {
+    assert(textureManager != NULL);
+    assert(uploadedFont != NULL);
+
+    const Mgpu_BitmapFont *builtinFont = mgpu_font_get_builtin(fontId);
+    if (builtinFont != NULL) {
+        return builtinFont;
+    }
+
+    // Outline fonts are only drawn once they're rasterized into a scaled font
+    Mgpu_UploadedFont *font = mgpu_texture_get_font(textureManager, fontId);
+    if (font == NULL || font->type == MGPU_UPLOADED_FONT_OUTLINE) {
+        return NULL;
+    }
+
+    *uploadedFont = (Mgpu_BitmapFont) {
+            .width = font->maxWidth,
+            .height = font->height,
+            .firstCharacter = font->firstCharacter,
+            .characterCount = font->characterCount,
+            .rowsArePacked = true,
+            .data = font->data,
+            .glyphWidths = font->glyphWidths,
+            .glyphOffsets = font->glyphOffsets,
+            .hasCoverage = font->type == MGPU_UPLOADED_FONT_COVERAGE,
+    };
+
+    return uploadedFont;
+}
+
+bool mgpu_font_measure(Mgpu_TextureManager *textureManager,
+                       Mgpu_FontId fontId,
+                       const uint8_t *characters,
+                       uint8_t count,
+                       uint32_t *width,
+                       uint8_t *height) {
+    assert(width != NULL);
+    assert(height != NULL);
+
+    Mgpu_BitmapFont uploadedFont;
+    const Mgpu_BitmapFont *font = mgpu_font_get(textureManager, fontId, &uploadedFont);
+    if (font == NULL) {
+        return false;
     }
+
+    *width = characters != NULL ? mgpu_bitmap_font_measure(font, characters, count) : 0;
+    *height = font->height;
+    return true;
 }
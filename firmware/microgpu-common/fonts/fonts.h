@@ -1,7 +1,10 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "microgpu-common/texture_manager.h"
+#include "microgpu-common/operations/execution/drawing/draw_region.h"
+#include "bitmap_font.h"
 
 typedef enum {
     Mgpu_Font_Unspecified = 0,
@@ -13,15 +16,61 @@ typedef enum {
     // Mgpu_Font_Font8x16 = 6,
     Mgpu_Font_Font12x16 = 7,
     // Mgpu_Font_Font12x20 = 8,
+
+    // Fonts uploaded by the client use ids from MGPU_UPLOADED_FONT_FIRST_ID up
 } Mgpu_FontId;
 
 /*
- * Draws1 the specified text in the specified font
+ * Draws the characters in the specified font. When a background color is given, each character's
+ * whole cell is written, so whatever was drawn under the text is replaced.
  */
 void mgpu_font_draw(Mgpu_TextureManager *textureManager,
                     Mgpu_FontId fontId,
-                     uint8_t destinationTextureId,
-                     char *text,
-                     Mgpu_Color color,
-                     uint16_t startX,
-                     uint16_t startY);
\ No newline at end of file
+                    uint8_t destinationTextureId,
+                    const uint8_t *characters,
+                    uint8_t count,
+                    Mgpu_Color color,
+                    const Mgpu_Color *backgroundColor,
+                    uint16_t startX,
+                    uint16_t startY);
+
+/*
+ * Draws the characters without any validation, only writing pixels that fall inside the region.
+ * Without a background color, glyphs of built-in fonts in the glyph cache are drawn from their
+ * spans. Anything else is drawn from the font a row at a time. Returns false if no font has the
+ * id.
+ */
+bool mgpu_font_draw_in_region(Mgpu_TextureManager *textureManager,
+                              Mgpu_FontId fontId,
+                              const Mgpu_DrawRegion *region,
+                              const uint8_t *characters,
+                              uint8_t count,
+                              Mgpu_Color color,
+                              const Mgpu_Color *backgroundColor,
+                              uint16_t startX,
+                              uint16_t startY);
+
+/*
+ * Gets a font that's compiled into the firmware, or NULL if the id isn't one of them
+ */
+const Mgpu_BitmapFont *mgpu_font_get_builtin(Mgpu_FontId fontId);
+
+/*
+ * Gets a built-in or uploaded font. Uploaded fonts are described in the passed in bitmap font,
+ * which is what's returned for them. Returns NULL if no font has the id, or if it's an outline
+ * font that can only be drawn with once it's scaled.
+ */
+const Mgpu_BitmapFont *mgpu_font_get(Mgpu_TextureManager *textureManager,
+                                     Mgpu_FontId fontId,
+                                     Mgpu_BitmapFont *uploadedFont);
+
+/*
+ * Gets how many pixels wide and tall the characters are when drawn in the font. Returns false if
+ * no font has the id.
+ */
+bool mgpu_font_measure(Mgpu_TextureManager *textureManager,
+                       Mgpu_FontId fontId,
+                       const uint8_t *characters,
+                       uint8_t count,
+                       uint32_t *width,
+                       uint8_t *height);
@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include "glyph_cache.h"
+
+#define FIRST_CHARACTER 0x20
+#define CHARACTER_COUNT 96
+
+typedef enum {
+    GLYPH_NOT_CACHED = 0,
+    GLYPH_CACHED,
+    GLYPH_DID_NOT_FIT,
+} GlyphState;
+
+typedef struct {
+    uint16_t firstSpan;
+    uint8_t spanCount;
+
+    /*
+     * Written after the spans, so another thread that sees the glyph as cached sees all of them
+     */
+    atomic_uchar state;
+} CachedGlyph;
+
+static Mgpu_GlyphSpan spans[MGPU_GLYPH_CACHE_SPANS];
+static uint16_t spansUsed = 0;
+static CachedGlyph glyphs[2][CHARACTER_COUNT];
+
+static CachedGlyph *get_glyph(Mgpu_FontId fontId, uint8_t character) {
+    if (character < FIRST_CHARACTER || character >= FIRST_CHARACTER + CHARACTER_COUNT) {
+        return NULL;
+    }
+
+    switch (fontId) {
+        case Mgpu_Font_Font8x12:
+            return &glyphs[0][character - FIRST_CHARACTER];
+
+        case Mgpu_Font_Font12x16:
+            return &glyphs[1][character - FIRST_CHARACTER];
+
+        default:
+            return NULL;
+    }
+}
+
+static void expand_glyph(Mgpu_FontId fontId, uint8_t character, CachedGlyph *glyph) {
+    const Mgpu_BitmapFont *font = mgpu_font_get_builtin(fontId);
+    if (font == NULL) {
+        return;
+    }
+
+    uint16_t firstSpan = spansUsed;
+    uint16_t spanCount = 0;
+    for (uint8_t row = 0; row < font->height; row++) {
+        uint32_t bits = mgpu_bitmap_font_get_row(font, character, row);
+        uint8_t x = 0;
+        while (x < font->width) {
+            if ((bits & (0x01 << x)) == 0) {
+                x++;
+                continue;
+            }
+
+            uint8_t start = x;
+            while (x < font->width && (bits & (0x01 << x)) != 0) {
+                x++;
+            }
+
+            if (firstSpan + spanCount >= MGPU_GLYPH_CACHE_SPANS) {
+                // Left to be drawn from the font, without keeping any of its spans
+                atomic_store_explicit(&glyph->state, GLYPH_DID_NOT_FIT, memory_order_release);
+                return;
+            }
+
+            spans[firstSpan + spanCount] = (Mgpu_GlyphSpan) {.row = row, .x = start, .length = x - start};
+            spanCount++;
+        }
+    }
+
+    spansUsed = firstSpan + spanCount;
+    glyph->firstSpan = firstSpan;
+    glyph->spanCount = spanCount;
+    atomic_store_explicit(&glyph->state, GLYPH_CACHED, memory_order_release);
+}
+
+void mgpu_glyph_cache_add(Mgpu_FontId fontId, const uint8_t *characters, uint8_t count) {
+    assert(characters != NULL);
+
+    for (int index = 0; index < count; index++) {
+        CachedGlyph *glyph = get_glyph(fontId, characters[index]);
+        if (glyph != NULL &&
+            atomic_load_explicit(&glyph->state, memory_order_relaxed) == GLYPH_NOT_CACHED) {
+            expand_glyph(fontId, characters[index], glyph);
+        }
+    }
+}
+
+const Mgpu_GlyphSpan *mgpu_glyph_cache_get(Mgpu_FontId fontId, uint8_t character, uint8_t *spanCount) {
+    assert(spanCount != NULL);
+
+    CachedGlyph *glyph = get_glyph(fontId, character);
+    if (glyph == NULL) {
+        return NULL;
+    }
+
+    if (atomic_load_explicit(&glyph->state, memory_order_acquire) != GLYPH_CACHED) {
+        return NULL;
+    }
+
+    *spanCount = glyph->spanCount;
+    return &spans[glyph->firstSpan];
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fonts.h"
+
+/*
+ * Most spans the glyph cache holds across every built-in font. They need a little under 2400 of
+ * them for every one of their glyphs. Glyphs that don't fit are drawn from the font instead.
+ */
+#ifndef MGPU_GLYPH_CACHE_SPANS
+#define MGPU_GLYPH_CACHE_SPANS 2400
+#endif
+
+/*
+ * A run of drawn pixels on one row of a glyph
+ */
+typedef struct {
+    uint8_t row;
+    uint8_t x;
+    uint8_t length;
+} Mgpu_GlyphSpan;
+
+/*
+ * Expands the glyphs of the characters into spans, if they haven't been already. Spans don't
+ * depend on the color, so each glyph only ever has to be expanded once, and glyphs are never
+ * evicted. Must only be called from the thread operations are executed on.
+ */
+void mgpu_glyph_cache_add(Mgpu_FontId fontId, const uint8_t *characters, uint8_t count);
+
+/*
+ * Gets the spans of a glyph, or NULL if the glyph hasn't been added to the cache. Safe to call
+ * from any thread.
+ */
+const Mgpu_GlyphSpan *mgpu_glyph_cache_get(Mgpu_FontId fontId, uint8_t character, uint8_t *spanCount);
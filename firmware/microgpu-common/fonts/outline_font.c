@@ -0,0 +1,279 @@
+#include <assert.h>
+#include <string.h>
+#include "microgpu-common/common.h"
+#include "outline_font.h"
+
+typedef struct {
+    float x, y;
+} Point;
+
+/*
+ * Glyphs are rasterized a band of rows at a time, with each band's areas added up in here
+ */
+#ifndef MGPU_OUTLINE_FONT_ACCUMULATION_SIZE
+#define MGPU_OUTLINE_FONT_ACCUMULATION_SIZE 1024
+#endif
+
+// Areas past the end of a row spill over to the start of the next one, including after the last
+static float accumulation[MGPU_OUTLINE_FONT_ACCUMULATION_SIZE + 2];
+
+typedef struct {
+    int width;
+    int top, bottom;
+} Canvas;
+
+static bool has_glyph(const Mgpu_UploadedFont *font, uint8_t character) {
+    return character >= font->firstCharacter && character - font->firstCharacter < font->characterCount;
+}
+
+static float get_scale(const Mgpu_UploadedFont *font, uint8_t pixelSize) {
+    return font->unitsPerEm > 0 ? (float) pixelSize / font->unitsPerEm : 0;
+}
+
+static uint8_t to_pixels(uint32_t fontUnits, float scale) {
+    float pixels = fontUnits * scale + 0.5f;
+    return pixels >= UINT8_MAX ? UINT8_MAX : (uint8_t) pixels;
+}
+
+static float clamp(float value, float low, float high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+/*
+ * Adds how much of each pixel's area is to the left of the line, signed by which direction the
+ * line goes in. After a running sum over the pixels, each pixel has how much of it is inside the
+ * outline.
+ */
+static void draw_line(const Canvas *canvas, Point start, Point end) {
+    if (start.y == end.y) {
+        return;
+    }
+
+    float direction = 1;
+    if (start.y > end.y) {
+        Point swap = start;
+        start = end;
+        end = swap;
+        direction = -1;
+    }
+
+    // Parts of the outline past either side of the glyph are flattened onto that side, so the
+    // areas added to each row still cancel out by the end of it
+    start.x = clamp(start.x, 0, (float) canvas->width);
+    end.x = clamp(end.x, 0, (float) canvas->width);
+
+    float dxdy = (end.x - start.x) / (end.y - start.y);
+    float x = start.x;
+    int firstRow = (int) start.y;
+    if (start.y < canvas->top) {
+        x += (canvas->top - start.y) * dxdy;
+        firstRow = canvas->top;
+    }
+
+    int endRow = min(canvas->bottom, (int) end.y + (end.y > (int) end.y ? 1 : 0));
+    for (int row = firstRow; row < endRow; row++) {
+        float *line = accumulation + ((row - canvas->top) * canvas->width);
+        float dy = min((float) (row + 1), end.y) - max((float) row, start.y);
+        float nextX = x + dxdy * dy;
+        float area = dy * direction;
+        float left = min(x, nextX);
+        float right = max(x, nextX);
+        int leftIndex = (int) left;
+        int rightIndex = (int) right + (right > (int) right ? 1 : 0);
+
+        if (rightIndex <= leftIndex + 1) {
+            float middle = 0.5f * (x + nextX) - leftIndex;
+            line[leftIndex] += area - area * middle;
+            line[leftIndex + 1] += area * middle;
+        } else {
+            float slope = 1 / (right - left);
+            float leftFraction = left - leftIndex;
+            float firstArea = 0.5f * slope * (1 - leftFraction) * (1 - leftFraction);
+            float rightFraction = right - rightIndex + 1;
+            float lastArea = 0.5f * slope * rightFraction * rightFraction;
+
+            line[leftIndex] += area * firstArea;
+            if (rightIndex == leftIndex + 2) {
+                line[leftIndex + 1] += area * (1 - firstArea - lastArea);
+            } else {
+                float secondArea = slope * (1.5f - leftFraction);
+                line[leftIndex + 1] += area * (secondArea - firstArea);
+                for (int column = leftIndex + 2; column < rightIndex - 1; column++) {
+                    line[column] += area * slope;
+                }
+
+                float beforeLastArea = secondArea + (rightIndex - leftIndex - 3) * slope;
+                line[rightIndex - 1] += area * (1 - beforeLastArea - lastArea);
+            }
+
+            line[rightIndex] += area * lastArea;
+        }
+
+        x = nextX;
+    }
+}
+
+static void draw_curve(const Canvas *canvas, Point start, Point control, Point end) {
+    float ddx = start.x - 2 * control.x + end.x;
+    float ddy = start.y - 2 * control.y + end.y;
+    float deviation = 3 * (ddx * ddx + ddy * ddy);
+
+    // Split into enough lines to stay close to the curve, which grows with the fourth root of
+    // how far the curve bends
+    int segments = 1;
+    while (segments < 16 && (float) segments * segments * segments * segments <= deviation) {
+        segments++;
+    }
+
+    Point previous = start;
+    for (int segment = 1; segment <= segments; segment++) {
+        float t = (float) segment / segments;
+        float mt = 1 - t;
+        Point next = {
+                .x = mt * mt * start.x + 2 * mt * t * control.x + t * t * end.x,
+                .y = mt * mt * start.y + 2 * mt * t * control.y + t * t * end.y,
+        };
+
+        draw_line(canvas, previous, next);
+        previous = next;
+    }
+}
+
+static Point read_point(const uint8_t *bytes, float scale, float ascent, bool *onCurve) {
+    int16_t x = (int16_t) (((uint16_t) bytes[1] << 8) | bytes[2]);
+    int16_t y = (int16_t) (((uint16_t) bytes[3] << 8) | bytes[4]);
+    *onCurve = bytes[0] & 0x01;
+
+    return (Point) {.x = x * scale, .y = (ascent - y) * scale};
+}
+
+static Point midpoint(Point first, Point second) {
+    return (Point) {.x = (first.x + second.x) / 2, .y = (first.y + second.y) / 2};
+}
+
+static void draw_contour(const Canvas *canvas, const uint8_t *points, uint8_t pointCount, float scale, float ascent) {
+    bool firstOnCurve, lastOnCurve;
+    Point first = read_point(points, scale, ascent, &firstOnCurve);
+    Point last = read_point(points + (pointCount - 1) * MGPU_OUTLINE_POINT_SIZE, scale, ascent, &lastOnCurve);
+
+    // Contours are walked from a point on the curve, which may be one implied between the ends
+    Point start = first;
+    int index = 1, endIndex = pointCount;
+    if (!firstOnCurve) {
+        start = lastOnCurve ? last : midpoint(last, first);
+        index = 0;
+        endIndex = lastOnCurve ? pointCount - 1 : pointCount;
+    }
+
+    Point current = start, control = {0};
+    bool hasControl = false;
+    for (; index < endIndex; index++) {
+        bool onCurve;
+        Point point = read_point(points + index * MGPU_OUTLINE_POINT_SIZE, scale, ascent, &onCurve);
+        if (onCurve) {
+            if (hasControl) {
+                draw_curve(canvas, current, control, point);
+            } else {
+                draw_line(canvas, current, point);
+            }
+
+            current = point;
+            hasControl = false;
+        } else {
+            if (hasControl) {
+                Point implied = midpoint(control, point);
+                draw_curve(canvas, current, control, implied);
+                current = implied;
+            }
+
+            control = point;
+            hasControl = true;
+        }
+    }
+
+    if (hasControl) {
+        draw_curve(canvas, current, control, start);
+    } else {
+        draw_line(canvas, current, start);
+    }
+}
+
+uint8_t mgpu_outline_font_get_height(const Mgpu_UploadedFont *font, uint8_t pixelSize) {
+    assert(font != NULL);
+
+    return to_pixels(font->ascent + font->descent, get_scale(font, pixelSize));
+}
+
+uint8_t mgpu_outline_font_get_width(const Mgpu_UploadedFont *font, uint8_t character, uint8_t pixelSize) {
+    assert(font != NULL);
+
+    if (!has_glyph(font, character)) {
+        return 0;
+    }
+
+    return to_pixels(font->glyphAdvances[character - font->firstCharacter], get_scale(font, pixelSize));
+}
+
+bool mgpu_outline_font_rasterize(const Mgpu_UploadedFont *font,
+                                 uint8_t character,
+                                 uint8_t pixelSize,
+                                 uint8_t width,
+                                 uint8_t height,
+                                 uint8_t *coverage) {
+    assert(font != NULL);
+    assert(font->type == MGPU_UPLOADED_FONT_OUTLINE);
+    assert(coverage != NULL);
+
+    size_t pixelCount = (size_t) width * height;
+    if (pixelCount == 0 || !has_glyph(font, character)) {
+        return true;
+    }
+
+    // Every contour is checked against the data before anything is drawn
+    uint32_t offset = font->glyphOffsets[character - font->firstCharacter];
+    if (offset >= font->dataSize) {
+        return false;
+    }
+
+    uint8_t contourCount = font->data[offset];
+    uint32_t end = offset + 1;
+    for (int contour = 0; contour < contourCount; contour++) {
+        if (end >= font->dataSize) {
+            return false;
+        }
+
+        end += 1 + (uint32_t) font->data[end] * MGPU_OUTLINE_POINT_SIZE;
+        if (end > font->dataSize) {
+            return false;
+        }
+    }
+
+    float scale = get_scale(font, pixelSize);
+    int bandHeight = MGPU_OUTLINE_FONT_ACCUMULATION_SIZE / width;
+    for (int top = 0; top < height; top += bandHeight) {
+        // Each row's areas add up to zero, so a band starts from nothing no matter what's above it
+        Canvas canvas = {.width = width, .top = top, .bottom = min(top + bandHeight, (int) height)};
+        size_t bandPixels = (size_t) (canvas.bottom - canvas.top) * width;
+        memset(accumulation, 0, sizeof(accumulation));
+
+        const uint8_t *contour = font->data + offset + 1;
+        for (int index = 0; index < contourCount; index++) {
+            uint8_t pointCount = contour[0];
+            if (pointCount > 1) {
+                draw_contour(&canvas, contour + 1, pointCount, scale, font->ascent);
+            }
+
+            contour += 1 + pointCount * MGPU_OUTLINE_POINT_SIZE;
+        }
+
+        float total = 0;
+        uint8_t *bandCoverage = coverage + (size_t) top * width;
+        for (size_t pixel = 0; pixel < bandPixels; pixel++) {
+            total += accumulation[pixel];
+            float covered = total < 0 ? -total : total;
+            bandCoverage[pixel] = covered >= 1 ? 0xFF : (uint8_t) (covered * 255 + 0.5f);
+        }
+    }
+
+    return true;
+}
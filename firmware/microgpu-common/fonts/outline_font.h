@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "microgpu-common/texture_manager.h"
+
+/*
+ * Each glyph's outline starts with a byte of how many contours it has. Each contour is a byte of
+ * how many points it has, followed by its points. Points are a flags byte, where the lowest bit
+ * is set for points on the curve, then big endian signed 16 bit X and Y values in font units.
+ * Like TrueType outlines, Y goes up from the baseline, a point off the curve is the control point
+ * of a quadratic curve between the points either side of it, and a point on the curve is implied
+ * halfway between two points that are both off of it.
+ */
+#define MGPU_OUTLINE_POINT_SIZE 5
+
+/*
+ * Gets how many pixels tall lines of the outline font are when drawn at the pixel size
+ */
+uint8_t mgpu_outline_font_get_height(const Mgpu_UploadedFont *font, uint8_t pixelSize);
+
+/*
+ * Gets how many pixels wide the character's glyph is when drawn at the pixel size, which is zero
+ * for characters the font has no glyph for.
+ */
+uint8_t mgpu_outline_font_get_width(const Mgpu_UploadedFont *font, uint8_t character, uint8_t pixelSize);
+
+/*
+ * Rasterizes the character's outline at the pixel size into a byte per pixel of how much of each
+ * pixel the glyph covers. Parts of the glyph outside its width and height are clipped off. Must
+ * only be called from the thread operations are executed on.
+ *
+ * Returns false if the outline runs past the end of the font's data.
+ */
+bool mgpu_outline_font_rasterize(const Mgpu_UploadedFont *font,
+                                 uint8_t character,
+                                 uint8_t pixelSize,
+                                 uint8_t width,
+                                 uint8_t height,
+                                 uint8_t *coverage);
@@ -0,0 +1,192 @@
+#include <assert.h>
+#include "microgpu-common/common.h"
+#include "microgpu-common/operations/execution/drawing/rectangle.h"
+#include "fonts.h"
+#include "text_box.h"
+
+typedef struct {
+    uint16_t start, count;
+    uint32_t width;
+} Line;
+
+static uint32_t measure(const Mgpu_BitmapFont *font, const uint8_t *characters, uint16_t count) {
+    uint32_t width = 0;
+    for (int index = 0; index < count; index++) {
+        width += mgpu_bitmap_font_get_advance(font, characters[index]);
+    }
+
+    return width;
+}
+
+static uint16_t skip_spaces(const Mgpu_DrawTextBoxOperation *textBox, uint16_t index) {
+    while (index < textBox->numCharacters && textBox->characters[index] == ' ') {
+        index++;
+    }
+
+    return index;
+}
+
+/*
+ * Finds the line that starts at the index, and returns the index the line after it starts at
+ */
+static uint16_t next_line(const Mgpu_BitmapFont *font,
+                          const Mgpu_DrawTextBoxOperation *textBox,
+                          uint16_t start,
+                          Line *line) {
+    const uint8_t *characters = textBox->characters;
+    uint32_t width = 0;
+    int lastSpace = -1;
+
+    for (uint16_t index = start; index < textBox->numCharacters; index++) {
+        uint8_t character = characters[index];
+        if (character == '\n') {
+            *line = (Line) {.start = start, .count = index - start, .width = width};
+            return index + 1;
+        }
+
+        uint8_t advance = mgpu_bitmap_font_get_advance(font, character);
+        if (textBox->wrap != MGPU_TEXT_WRAP_NONE && width + advance > textBox->width && index > start) {
+            // Every line keeps at least one character, so boxes narrower than a glyph still
+            // make progress through the text
+            uint16_t end = index;
+            if (character != ' ' && textBox->wrap == MGPU_TEXT_WRAP_WORDS && lastSpace > start) {
+                end = lastSpace;
+            }
+
+            uint16_t next = skip_spaces(textBox, end);
+            while (end > start && characters[end - 1] == ' ') {
+                end--;
+            }
+
+            *line = (Line) {.start = start, .count = end - start, .width = measure(font, characters + start, end - start)};
+            return next;
+        }
+
+        if (character == ' ') {
+            lastSpace = index;
+        }
+
+        width += advance;
+    }
+
+    *line = (Line) {.start = start, .count = textBox->numCharacters - start, .width = width};
+    return textBox->numCharacters;
+}
+
+static uint32_t count_lines(const Mgpu_BitmapFont *font, const Mgpu_DrawTextBoxOperation *textBox) {
+    uint32_t lineCount = 0;
+    Line line;
+    for (uint16_t index = 0; index < textBox->numCharacters; lineCount++) {
+        index = next_line(font, textBox, index, &line);
+    }
+
+    return lineCount;
+}
+
+static uint32_t get_alignment_offset(Mgpu_TextAlignment alignment, uint32_t boxSize, uint32_t contentSize) {
+    if (contentSize >= boxSize) {
+        return 0;
+    }
+
+    switch (alignment) {
+        case MGPU_TEXT_ALIGN_CENTER:
+            return (boxSize - contentSize) / 2;
+
+        case MGPU_TEXT_ALIGN_END:
+            return boxSize - contentSize;
+
+        default:
+            return 0;
+    }
+}
+
+static void draw_line(Mgpu_TextureManager *textureManager,
+                      const Mgpu_BitmapFont *font,
+                      const Mgpu_DrawTextBoxOperation *textBox,
+                      const Mgpu_DrawRegion *region,
+                      const Line *line,
+                      uint32_t x,
+                      uint16_t y) {
+    const uint8_t *characters = textBox->characters + line->start;
+    uint16_t remaining = line->count;
+
+    // Font draws take at most 255 characters, so longer lines are drawn a piece at a time
+    while (remaining > 0 && x < region->clip.right) {
+        uint8_t count = min(remaining, UINT8_MAX);
+        mgpu_font_draw_in_region(textureManager,
+                                 textBox->fontId,
+                                 region,
+                                 characters,
+                                 count,
+                                 textBox->color,
+                                 NULL,
+                                 x,
+                                 y);
+
+        x += measure(font, characters, count);
+        characters += count;
+        remaining -= count;
+    }
+}
+
+bool mgpu_text_box_draw_in_region(Mgpu_TextureManager *textureManager,
+                                  const Mgpu_DrawTextBoxOperation *textBox,
+                                  const Mgpu_DrawRegion *region) {
+    assert(textureManager != NULL);
+    assert(textBox != NULL);
+    assert(region != NULL);
+
+    Mgpu_BitmapFont uploadedFont;
+    const Mgpu_BitmapFont *font = mgpu_font_get(textureManager, textBox->fontId, &uploadedFont);
+    if (font == NULL) {
+        return false;
+    }
+
+    Mgpu_DrawRegion boxRegion = *region;
+    boxRegion.clip.left = max(region->clip.left, textBox->startX);
+    boxRegion.clip.top = max(region->clip.top, textBox->startY);
+    boxRegion.clip.right = min(region->clip.right, textBox->startX + textBox->width);
+    boxRegion.clip.bottom = min(region->clip.bottom, textBox->startY + textBox->height);
+    if (boxRegion.clip.left >= boxRegion.clip.right || boxRegion.clip.top >= boxRegion.clip.bottom) {
+        return true;
+    }
+
+    if (textBox->hasBackground) {
+        Mgpu_DrawRectangleOperation background = {
+                .textureId = textBox->textureId,
+                .startX = textBox->startX,
+                .startY = textBox->startY,
+                .width = textBox->width,
+                .height = textBox->height,
+                .color = textBox->backgroundColor,
+        };
+
+        mgpu_draw_rectangle_in_region(&background, &boxRegion);
+    }
+
+    if (textBox->characters == NULL || textBox->numCharacters == 0) {
+        return true;
+    }
+
+    uint32_t y = textBox->startY;
+    if (textBox->verticalAlignment != MGPU_TEXT_ALIGN_START) {
+        uint32_t textHeight = count_lines(font, textBox) * font->height;
+        y += get_alignment_offset(textBox->verticalAlignment, textBox->height, textHeight);
+    }
+
+    Line line;
+    uint16_t index = 0;
+    while (index < textBox->numCharacters && y < boxRegion.clip.bottom) {
+        index = next_line(font, textBox, index, &line);
+        if (y + font->height > boxRegion.clip.top) {
+            uint32_t x = textBox->startX +
+                         get_alignment_offset(textBox->horizontalAlignment, textBox->width, line.width);
+
+            draw_line(textureManager, font, textBox, &boxRegion, &line, x, y);
+        }
+
+        y += font->height;
+    }
+
+    return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdbool.h>
+#include "microgpu-common/texture_manager.h"
+#include "microgpu-common/operations/operations.h"
+#include "microgpu-common/operations/execution/drawing/draw_region.h"
+
+/*
+ * Lays the text box's characters out into lines and draws them without any validation, only
+ * writing pixels that fall inside both the box and the region. Returns false if no font has the
+ * box's font id.
+ */
+bool mgpu_text_box_draw_in_region(Mgpu_TextureManager *textureManager,
+                                  const Mgpu_DrawTextBoxOperation *textBox,
+                                  const Mgpu_DrawRegion *region);
@@ -2,8 +2,13 @@
 #include "messages.h"
 
 char *currentMessage = NULL;
+static _Thread_local char *threadMessage = NULL;
 
 char *mgpu_message_get_pointer(void) {
+    if (threadMessage != NULL) {
+        return threadMessage;
+    }
+
     if (currentMessage == NULL) {
         // Eventually this needs to use the mgpu_allocator mechanism for creation, but right now
         // I just want to get it out of the stack.
@@ -12,3 +17,7 @@ char *mgpu_message_get_pointer(void) {
 
     return currentMessage;
 }
+
+void mgpu_message_use_thread_buffer(char *buffer) {
+    threadMessage = buffer;
+}
@@ -12,3 +12,10 @@
  * its own buffer.
  */
 char *mgpu_message_get_pointer(void);
+
+/*
+ * Points `mgpu_message_get_pointer()` at a buffer of at least `MESSAGE_MAX_LEN + 1` bytes, but only
+ * on the calling thread. Lets a thread that isn't executing operations report errors without
+ * touching the message GetLastMessage reports. Passing NULL goes back to the shared buffer.
+ */
+void mgpu_message_use_thread_buffer(char *buffer);
@@ -0,0 +1,249 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "microgpu-common/messages.h"
+#include "compact_batch.h"
+#include "operation_deserializer.h"
+
+typedef struct {
+    const uint8_t *bytes;
+    size_t size;
+    size_t index;
+    bool failed;
+} Reader;
+
+static uint8_t read_byte(Reader *reader) {
+    if (reader->index >= reader->size) {
+        reader->failed = true;
+        return 0;
+    }
+
+    return reader->bytes[reader->index++];
+}
+
+static uint32_t read_varint(Reader *reader) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = read_byte(reader);
+        value |= (uint32_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    // Longer than any 32 bit value can be
+    reader->failed = true;
+    return 0;
+}
+
+static int32_t read_delta(Reader *reader, int32_t previous) {
+    uint32_t zigzag = read_varint(reader);
+    int32_t delta = (int32_t) (zigzag >> 1) ^ -(int32_t) (zigzag & 1);
+    return previous + delta;
+}
+
+static uint16_t read_varint16(Reader *reader) {
+    uint32_t value = read_varint(reader);
+    if (value > UINT16_MAX) {
+        reader->failed = true;
+    }
+
+    return (uint16_t) value;
+}
+
+static Mgpu_Color read_color(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state) {
+    if (header & MGPU_COMPACT_SAME_COLOR) {
+        return state->color;
+    }
+
+    if (reader->size - reader->index < mgpu_color_bytes_per_pixel()) {
+        reader->failed = true;
+        return state->color;
+    }
+
+    size_t nextByteIndex;
+    state->color = mgpu_color_deserialize(reader->bytes, reader->index, &nextByteIndex);
+    reader->index = nextByteIndex;
+
+    return state->color;
+}
+
+static uint8_t read_target(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state) {
+    if ((header & MGPU_COMPACT_SAME_TARGET) == 0) {
+        state->targetTextureId = read_byte(reader);
+    }
+
+    return state->targetTextureId;
+}
+
+static void read_position(Reader *reader, Mgpu_CompactBatchState *state) {
+    state->x = read_delta(reader, state->x);
+    state->y = read_delta(reader, state->y);
+}
+
+static void decode_rectangle(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state, Mgpu_Operation *operation) {
+    Mgpu_DrawRectangleOperation *rectangle = &operation->drawRectangle;
+    rectangle->textureId = read_target(reader, header, state);
+    read_position(reader, state);
+    rectangle->startX = (uint16_t) state->x;
+    rectangle->startY = (uint16_t) state->y;
+
+    if ((header & MGPU_COMPACT_SAME_SIZE) == 0) {
+        state->width = read_varint16(reader);
+        state->height = read_varint16(reader);
+    }
+
+    rectangle->width = state->width;
+    rectangle->height = state->height;
+    rectangle->color = read_color(reader, header, state);
+}
+
+static void decode_triangle(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state, Mgpu_Operation *operation) {
+    Mgpu_DrawTriangleOperation *triangle = &operation->drawTriangle;
+    triangle->textureId = read_target(reader, header, state);
+    read_position(reader, state);
+    triangle->x0 = (uint16_t) state->x;
+    triangle->y0 = (uint16_t) state->y;
+    triangle->x1 = (uint16_t) read_delta(reader, state->x);
+    triangle->y1 = (uint16_t) read_delta(reader, state->y);
+    triangle->x2 = (uint16_t) read_delta(reader, state->x);
+    triangle->y2 = (uint16_t) read_delta(reader, state->y);
+    triangle->color = read_color(reader, header, state);
+}
+
+static void decode_texture(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state, Mgpu_Operation *operation) {
+    Mgpu_DrawTextureOperation *texture = &operation->drawTexture;
+    texture->sourceTextureId = read_byte(reader);
+    texture->targetTextureId = read_target(reader, header, state);
+
+    if ((header & MGPU_COMPACT_SAME_SIZE) == 0) {
+        state->sourceX = read_varint16(reader);
+        state->sourceY = read_varint16(reader);
+        state->sourceWidth = read_varint16(reader);
+        state->sourceHeight = read_varint16(reader);
+    }
+
+    texture->sourceStartX = state->sourceX;
+    texture->sourceStartY = state->sourceY;
+    texture->sourceWidth = state->sourceWidth;
+    texture->sourceHeight = state->sourceHeight;
+
+    read_position(reader, state);
+    texture->targetStartX = (int16_t) state->x;
+    texture->targetStartY = (int16_t) state->y;
+
+    uint8_t flags = read_byte(reader);
+    texture->ignoreTransparency = flags & MGPU_DRAW_TEXTURE_IGNORE_TRANSPARENCY;
+    texture->flipHorizontally = flags & MGPU_DRAW_TEXTURE_FLIP_HORIZONTALLY;
+    texture->flipVertically = flags & MGPU_DRAW_TEXTURE_FLIP_VERTICALLY;
+}
+
+static void decode_chars(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state, Mgpu_Operation *operation) {
+    Mgpu_DrawCharsOperation *chars = &operation->drawChars;
+    chars->textureId = read_target(reader, header, state);
+    if ((header & MGPU_COMPACT_SAME_SIZE) == 0) {
+        state->fontId = read_byte(reader);
+    }
+
+    chars->fontId = state->fontId;
+    read_position(reader, state);
+    chars->startX = (uint16_t) state->x;
+    chars->startY = (uint16_t) state->y;
+    chars->color = read_color(reader, header, state);
+
+    uint32_t count = read_varint(reader);
+    if (count > UINT8_MAX || count > reader->size - reader->index) {
+        reader->failed = true;
+        return;
+    }
+
+    chars->numCharacters = count;
+    chars->characters = reader->bytes + reader->index;
+    chars->hasBackground = false;
+    reader->index += count;
+}
+
+static void decode_sub_texture(Reader *reader, uint8_t header, Mgpu_CompactBatchState *state, Mgpu_Operation *operation) {
+    Mgpu_DrawSubTextureOperation *subTexture = &operation->drawSubTexture;
+    subTexture->subTextureId = read_varint16(reader);
+    subTexture->targetTextureId = read_target(reader, header, state);
+    read_position(reader, state);
+    subTexture->targetStartX = (int16_t) state->x;
+    subTexture->targetStartY = (int16_t) state->y;
+    subTexture->ignoreTransparency = read_byte(reader) & 0x01;
+}
+
+void mgpu_compact_batch_state_reset(Mgpu_CompactBatchState *state) {
+    assert(state != NULL);
+    memset(state, 0, sizeof(Mgpu_CompactBatchState));
+}
+
+size_t mgpu_compact_batch_decode(Mgpu_CompactBatchState *state,
+                                 const uint8_t bytes[],
+                                 size_t size,
+                                 Mgpu_Operation *operation) {
+    assert(state != NULL);
+    assert(bytes != NULL);
+    assert(operation != NULL);
+
+    Reader reader = {.bytes = bytes, .size = size};
+    uint8_t header = read_byte(&reader);
+    uint8_t id = header & MGPU_COMPACT_ID_MASK;
+
+    if (id == 0) {
+        uint32_t length = read_varint(&reader);
+        if (reader.failed || length > reader.size - reader.index) {
+            char *msg = mgpu_message_get_pointer();
+            assert(msg != NULL);
+            snprintf(msg, MESSAGE_MAX_LEN, "Compact batch had a raw operation longer than the batch");
+            return 0;
+        }
+
+        if (!mgpu_operation_deserialize(reader.bytes + reader.index, length, operation)) {
+            return 0;
+        }
+
+        return reader.index + length;
+    }
+
+    operation->type = id;
+    operation->requestId = 0;
+    switch (id) {
+        case Mgpu_Operation_DrawRectangle:
+            decode_rectangle(&reader, header, state, operation);
+            break;
+
+        case Mgpu_Operation_DrawTriangle:
+            decode_triangle(&reader, header, state, operation);
+            break;
+
+        case Mgpu_Operation_DrawTexture:
+            decode_texture(&reader, header, state, operation);
+            break;
+
+        case Mgpu_Operation_DrawChars:
+            decode_chars(&reader, header, state, operation);
+            break;
+
+        case Mgpu_Operation_DrawSubTexture:
+            decode_sub_texture(&reader, header, state, operation);
+            break;
+
+        default: {
+            char *msg = mgpu_message_get_pointer();
+            assert(msg != NULL);
+            snprintf(msg, MESSAGE_MAX_LEN, "Operation id %u has no compact encoding", id);
+            return 0;
+        }
+    }
+
+    if (reader.failed) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        snprintf(msg, MESSAGE_MAX_LEN, "Compact batch ended in the middle of an operation of type %u", id);
+        return 0;
+    }
+
+    operation->serializedSize = reader.index;
+    return reader.index;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "microgpu-common/colors/color.h"
+#include "operations.h"
+
+/*
+ * Operations inside a compact batch start with a header byte. The low 5 bits are the operation
+ * id, and the upper bits mark fields that are left out because they're the same as the previous
+ * operation in the batch. A header with an id of zero is a raw entry instead, which is followed by
+ * a varint length and an operation serialized the normal way, so any operation can be in a compact
+ * batch.
+ *
+ * Numbers are unsigned LEB128 varints, and coordinates are zigzag encoded varints of how far the
+ * operation's start position is from the previous operation's start position. Colors are written
+ * the same as everywhere else. Each operation is laid out as, with optional fields in brackets:
+ *
+ *   DrawRectangle:  [target] dx dy [width height] [color]
+ *   DrawTriangle:   [target] dx0 dy0 dx1 dy1 dx2 dy2 [color]
+ *   DrawTexture:    source [target] [sourceX sourceY sourceWidth sourceHeight] dx dy flags
+ *   DrawChars:      [target] [font] dx dy [color] count characters
+ *   DrawSubTexture: subTextureId [target] dx dy flags
+ *
+ * Triangle points after the first are relative to the first point. The flags byte is the same as
+ * in the normal encoding of the operation, and sub-texture ids are varints. Characters drawn with a
+ * background color have no compact encoding, so they're added as raw entries.
+ *
+ * Every batch starts with a target texture, color, start position, size and font of zero.
+ */
+
+#define MGPU_COMPACT_ID_MASK 0x1F
+
+/*
+ * Set when the operation draws to the same texture as the previous operation
+ */
+#define MGPU_COMPACT_SAME_TARGET 0x20
+
+/*
+ * Set when the operation draws with the same color as the previous operation
+ */
+#define MGPU_COMPACT_SAME_COLOR 0x40
+
+/*
+ * Set when the operation is the same size as the previous one of its type. For rectangles that's
+ * the width and height, for texture draws it's the whole source rectangle, and for characters
+ * it's the font.
+ */
+#define MGPU_COMPACT_SAME_SIZE 0x80
+
+/*
+ * What operations in a compact batch are encoded relative to
+ */
+typedef struct {
+    int32_t x, y;
+    uint8_t targetTextureId;
+    Mgpu_Color color;
+    uint16_t width, height;
+    uint16_t sourceX, sourceY, sourceWidth, sourceHeight;
+    uint8_t fontId;
+} Mgpu_CompactBatchState;
+
+void mgpu_compact_batch_state_reset(Mgpu_CompactBatchState *state);
+
+/*
+ * Decodes the operation at the start of the bytes, and updates the state with it. Returns how
+ * many bytes the operation took up, or zero if it couldn't be decoded. Like other deserialized
+ * operations, the operation may point into the bytes.
+ */
+size_t mgpu_compact_batch_decode(Mgpu_CompactBatchState *state,
+                                 const uint8_t bytes[],
+                                 size_t size,
+                                 Mgpu_Operation *operation);
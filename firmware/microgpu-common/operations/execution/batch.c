@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "microgpu-common/operations/operation_execution.h"
 #include "microgpu-common/operations/operation_deserializer.h"
+#include "microgpu-common/operations/compact_batch.h"
 #include "batch.h"
 #include "microgpu-common/messages.h"
 
@@ -44,3 +45,33 @@ void mgpu_exec_batch(Mgpu_BatchOperation *batchOperation,
         outerBytesLeft -= innerSize + 2;
     }
 }
+
+void mgpu_exec_compact_batch(Mgpu_BatchOperation *batchOperation,
+                             Mgpu_Display *display,
+                             Mgpu_Databus *databus,
+                             bool *resetFlag,
+                             Mgpu_TextureManager *textureManager) {
+    assert(batchOperation != NULL);
+    assert(databus != NULL);
+    assert(textureManager != NULL);
+
+    Mgpu_CompactBatchState state;
+    mgpu_compact_batch_state_reset(&state);
+
+    size_t offset = 0;
+    while (offset < batchOperation->byteLength) {
+        Mgpu_Operation operation;
+        size_t bytesUsed = mgpu_compact_batch_decode(&state,
+                                                     batchOperation->bytes + offset,
+                                                     batchOperation->byteLength - offset,
+                                                     &operation);
+
+        if (bytesUsed == 0) {
+            // Every operation after this one is relative to it, so the rest of the batch can't be trusted
+            return;
+        }
+
+        mgpu_execute_operation(&operation, display, databus, resetFlag, textureManager);
+        offset += bytesUsed;
+    }
+}
@@ -10,3 +10,12 @@ void mgpu_exec_batch(Mgpu_BatchOperation *batchOperation,
                      bool *resetFlag,
                      Mgpu_TextureManager *textureManager);
 
+/*
+ * Executes each operation of a batch whose operations are in the compact encoding
+ */
+void mgpu_exec_compact_batch(Mgpu_BatchOperation *batchOperation,
+                             Mgpu_Display *display,
+                             Mgpu_Databus *databus,
+                             bool *resetFlag,
+                             Mgpu_TextureManager *textureManager);
+
@@ -0,0 +1,82 @@
+#include <assert.h>
+#include "draw_state.h"
+
+static Mgpu_SetDrawStateOperation drawState = {0};
+
+/*
+ * Offsets a coordinate by the origin. Anything past the largest coordinate is off of every
+ * texture anyway, so it's kept there instead of wrapping back around.
+ */
+static uint16_t offset(uint16_t origin, uint16_t value) {
+    uint32_t result = (uint32_t) origin + value;
+    return result > UINT16_MAX ? UINT16_MAX : (uint16_t) result;
+}
+
+void mgpu_exec_draw_state_set(Mgpu_SetDrawStateOperation *operation) {
+    assert(operation != NULL);
+
+    if (operation->fields & MGPU_DRAW_STATE_TARGET) {
+        drawState.targetTextureId = operation->targetTextureId;
+    }
+
+    if (operation->fields & MGPU_DRAW_STATE_COLOR) {
+        drawState.color = operation->color;
+    }
+
+    if (operation->fields & MGPU_DRAW_STATE_FONT) {
+        drawState.fontId = operation->fontId;
+    }
+
+    if (operation->fields & MGPU_DRAW_STATE_ORIGIN) {
+        drawState.originX = operation->originX;
+        drawState.originY = operation->originY;
+    }
+}
+
+void mgpu_exec_draw_state_resolve(Mgpu_Operation *operation) {
+    assert(operation != NULL);
+
+    switch (operation->type) {
+        case Mgpu_Operation_DrawStateRectangle: {
+            Mgpu_DrawRectangleOperation *rectangle = &operation->drawRectangle;
+            operation->type = Mgpu_Operation_DrawRectangle;
+            rectangle->textureId = drawState.targetTextureId;
+            rectangle->color = drawState.color;
+            rectangle->startX = offset(drawState.originX, rectangle->startX);
+            rectangle->startY = offset(drawState.originY, rectangle->startY);
+            break;
+        }
+
+        case Mgpu_Operation_DrawStateTriangle: {
+            Mgpu_DrawTriangleOperation *triangle = &operation->drawTriangle;
+            operation->type = Mgpu_Operation_DrawTriangle;
+            triangle->textureId = drawState.targetTextureId;
+            triangle->color = drawState.color;
+            triangle->x0 = offset(drawState.originX, triangle->x0);
+            triangle->y0 = offset(drawState.originY, triangle->y0);
+            triangle->x1 = offset(drawState.originX, triangle->x1);
+            triangle->y1 = offset(drawState.originY, triangle->y1);
+            triangle->x2 = offset(drawState.originX, triangle->x2);
+            triangle->y2 = offset(drawState.originY, triangle->y2);
+            break;
+        }
+
+        case Mgpu_Operation_DrawStateChars: {
+            Mgpu_DrawCharsOperation *chars = &operation->drawChars;
+            operation->type = Mgpu_Operation_DrawChars;
+            chars->textureId = drawState.targetTextureId;
+            chars->color = drawState.color;
+            chars->fontId = drawState.fontId;
+            chars->startX = offset(drawState.originX, chars->startX);
+            chars->startY = offset(drawState.originY, chars->startY);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void mgpu_exec_draw_state_reset(void) {
+    drawState = (Mgpu_SetDrawStateOperation) {0};
+}
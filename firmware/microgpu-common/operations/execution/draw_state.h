@@ -0,0 +1,21 @@
+#pragma once
+
+#include "microgpu-common/operations/operations.h"
+
+/*
+ * DrawState operations are deserialized into the same fields as the draws they're short for, with
+ * the coordinates relative to the origin and everything that comes from the draw state left unset.
+ */
+
+void mgpu_exec_draw_state_set(Mgpu_SetDrawStateOperation *operation);
+
+/*
+ * Turns a DrawState operation into the full draw operation it's short for, using the current draw
+ * state, so it can be executed or deferred like any other draw. Other operations are left as is.
+ */
+void mgpu_exec_draw_state_resolve(Mgpu_Operation *operation);
+
+/*
+ * Puts the draw state back to how it starts, drawing to the frame buffer with everything else zero
+ */
+void mgpu_exec_draw_state_reset(void);
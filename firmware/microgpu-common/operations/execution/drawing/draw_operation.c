@@ -0,0 +1,252 @@
+#include <assert.h>
+#include "microgpu-common/common.h"
+#include "microgpu-common/fonts/fonts.h"
+#include "microgpu-common/fonts/text_box.h"
+#include "microgpu-common/operations/execution/textures.h"
+#include "draw_operation.h"
+#include "rectangle.h"
+#include "triangle.h"
+
+static void set_bounds(Mgpu_DrawBounds *bounds, Mgpu_Texture *texture, int left, int top, int right, int bottom) {
+    left = max(left, 0);
+    top = max(top, 0);
+    right = min(right, (int) texture->width);
+    bottom = min(bottom, (int) texture->height);
+
+    if (left >= right || top >= bottom) {
+        bounds->left = bounds->top = bounds->right = bounds->bottom = 0;
+        return;
+    }
+
+    bounds->left = left;
+    bounds->top = top;
+    bounds->right = right;
+    bounds->bottom = bottom;
+}
+
+static bool get_rectangle_bounds(Mgpu_DrawRectangleOperation *operation,
+                                 Mgpu_TextureManager *textureManager,
+                                 Mgpu_DrawBounds *bounds) {
+    Mgpu_Texture *texture = mgpu_texture_get(textureManager, operation->textureId);
+    if (texture == NULL) {
+        return false;
+    }
+
+    set_bounds(bounds,
+               texture,
+               operation->startX,
+               operation->startY,
+               operation->startX + operation->width,
+               operation->startY + operation->height);
+
+    return true;
+}
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_TRIANGLE
+static bool get_triangle_bounds(Mgpu_DrawTriangleOperation *operation,
+                                Mgpu_TextureManager *textureManager,
+                                Mgpu_DrawBounds *bounds) {
+    Mgpu_Texture *texture = mgpu_texture_get(textureManager, operation->textureId);
+    if (texture == NULL) {
+        return false;
+    }
+
+    // Edges are walked with floating point slopes, so rows can land a column past the points
+    int left = min(min(operation->x0, operation->x1), operation->x2) - 1;
+    int right = max(max(operation->x0, operation->x1), operation->x2) + 2;
+    int top = min(min(operation->y0, operation->y1), operation->y2);
+    int bottom = max(max(operation->y0, operation->y1), operation->y2) + 1;
+
+    if (right > INT16_MAX) {
+        // Columns are tracked as signed values while rasterizing, so points this far out can
+        // end up wrapping around to the left side.
+        left = 0;
+        right = texture->width;
+    }
+
+    set_bounds(bounds, texture, left, top, right, bottom);
+
+    return true;
+}
+#endif
+
+static bool get_texture_bounds(Mgpu_DrawTextureOperation *operation,
+                               Mgpu_TextureManager *textureManager,
+                               Mgpu_DrawBounds *bounds) {
+    Mgpu_Texture *target = mgpu_texture_get(textureManager, operation->targetTextureId);
+    if (target == NULL) {
+        return false;
+    }
+
+    if (operation->sourceWidth == 0 || operation->sourceHeight == 0) {
+        set_bounds(bounds, target, 0, 0, 0, 0);
+        return true;
+    }
+
+    Mgpu_Texture *source = mgpu_texture_get(textureManager, operation->sourceTextureId);
+    if (source == NULL ||
+        operation->sourceWidth + operation->sourceStartX > source->width ||
+        operation->sourceHeight + operation->sourceStartY > source->height) {
+        return false;
+    }
+
+    // Texture draws never touch the last row or column of the target
+    set_bounds(bounds,
+               target,
+               operation->targetStartX,
+               operation->targetStartY,
+               min(operation->targetStartX + operation->sourceWidth, target->width - 1),
+               min(operation->targetStartY + operation->sourceHeight, target->height - 1));
+
+    return true;
+}
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+static bool get_chars_bounds(Mgpu_DrawCharsOperation *operation,
+                             Mgpu_TextureManager *textureManager,
+                             Mgpu_DrawBounds *bounds) {
+    uint32_t width;
+    uint8_t height;
+    Mgpu_Texture *texture = mgpu_texture_get(textureManager, operation->textureId);
+    if (texture == NULL ||
+        !mgpu_font_measure(textureManager,
+                           operation->fontId,
+                           operation->characters,
+                           operation->numCharacters,
+                           &width,
+                           &height)) {
+        return false;
+    }
+
+    set_bounds(bounds,
+               texture,
+               operation->startX,
+               operation->startY,
+               operation->startX + width,
+               operation->startY + height);
+
+    return true;
+}
+
+static bool get_text_box_bounds(Mgpu_DrawTextBoxOperation *operation,
+                                Mgpu_TextureManager *textureManager,
+                                Mgpu_DrawBounds *bounds) {
+    Mgpu_BitmapFont uploadedFont;
+    Mgpu_Texture *texture = mgpu_texture_get(textureManager, operation->textureId);
+    if (texture == NULL || mgpu_font_get(textureManager, operation->fontId, &uploadedFont) == NULL) {
+        return false;
+    }
+
+    // Text is clipped to the box, so however it's laid out it stays inside of it
+    set_bounds(bounds,
+               texture,
+               operation->startX,
+               operation->startY,
+               operation->startX + operation->width,
+               operation->startY + operation->height);
+
+    return true;
+}
+#endif
+
+bool mgpu_draw_operation_get_bounds(Mgpu_Operation *operation,
+                                    Mgpu_TextureManager *textureManager,
+                                    uint8_t *targetTextureId,
+                                    Mgpu_DrawBounds *bounds) {
+    assert(operation != NULL);
+    assert(textureManager != NULL);
+    assert(targetTextureId != NULL);
+    assert(bounds != NULL);
+
+    switch (operation->type) {
+        case Mgpu_Operation_DrawRectangle:
+            *targetTextureId = operation->drawRectangle.textureId;
+            return get_rectangle_bounds(&operation->drawRectangle, textureManager, bounds);
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_TRIANGLE
+        case Mgpu_Operation_DrawTriangle:
+            *targetTextureId = operation->drawTriangle.textureId;
+            return get_triangle_bounds(&operation->drawTriangle, textureManager, bounds);
+#endif
+
+        case Mgpu_Operation_DrawTexture:
+            *targetTextureId = operation->drawTexture.targetTextureId;
+            return get_texture_bounds(&operation->drawTexture, textureManager, bounds);
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+        case Mgpu_Operation_DrawChars:
+            *targetTextureId = operation->drawChars.textureId;
+            return get_chars_bounds(&operation->drawChars, textureManager, bounds);
+
+        case Mgpu_Operation_DrawTextBox:
+            *targetTextureId = operation->drawTextBox.textureId;
+            return get_text_box_bounds(&operation->drawTextBox, textureManager, bounds);
+#endif
+
+        default:
+            return false;
+    }
+}
+
+bool mgpu_draw_operation_reads_texture(Mgpu_Operation *operation, uint8_t textureId) {
+    assert(operation != NULL);
+
+    return operation->type == Mgpu_Operation_DrawTexture &&
+           operation->drawTexture.sourceTextureId == textureId;
+}
+
+void mgpu_draw_operation_in_region(Mgpu_Operation *operation,
+                                   Mgpu_TextureManager *textureManager,
+                                   const Mgpu_DrawRegion *region) {
+    assert(operation != NULL);
+    assert(textureManager != NULL);
+    assert(region != NULL);
+
+    switch (operation->type) {
+        case Mgpu_Operation_DrawRectangle:
+            mgpu_draw_rectangle_in_region(&operation->drawRectangle, region);
+            break;
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_TRIANGLE
+        case Mgpu_Operation_DrawTriangle:
+            mgpu_draw_triangle_in_region(&operation->drawTriangle, region);
+            break;
+#endif
+
+        case Mgpu_Operation_DrawTexture: {
+            Mgpu_DrawTextureOperation *drawTexture = &operation->drawTexture;
+            if (drawTexture->sourceWidth > 0 && drawTexture->sourceHeight > 0) {
+                mgpu_exec_texture_draw_in_region(drawTexture,
+                                                 mgpu_texture_get(textureManager, drawTexture->sourceTextureId),
+                                                 mgpu_texture_get(textureManager, drawTexture->targetTextureId),
+                                                 region);
+            }
+
+            break;
+        }
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+        case Mgpu_Operation_DrawChars: {
+            Mgpu_DrawCharsOperation *drawChars = &operation->drawChars;
+            mgpu_font_draw_in_region(textureManager,
+                                     drawChars->fontId,
+                                     region,
+                                     drawChars->characters,
+                                     drawChars->numCharacters,
+                                     drawChars->color,
+                                     drawChars->hasBackground ? &drawChars->backgroundColor : NULL,
+                                     drawChars->startX,
+                                     drawChars->startY);
+
+            break;
+        }
+
+        case Mgpu_Operation_DrawTextBox:
+            mgpu_text_box_draw_in_region(textureManager, &operation->drawTextBox, region);
+            break;
+#endif
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "microgpu-common/operations/operations.h"
+#include "microgpu-common/texture_manager.h"
+#include "draw_region.h"
+
+/*
+ * Helpers for treating drawing operations generically, so they can be split up and rasterized
+ * somewhere other than the thread that received them.
+ */
+
+/*
+ * Gets the texture a drawing operation writes to, and the area of that texture its pixels may
+ * land in. The bounds may be empty if the operation won't draw anything.
+ *
+ * Returns false if the operation isn't a drawing operation, or if it is not valid against the
+ * current textures. Invalid operations should be executed normally so their error message is
+ * raised.
+ */
+bool mgpu_draw_operation_get_bounds(Mgpu_Operation *operation,
+                                    Mgpu_TextureManager *textureManager,
+                                    uint8_t *targetTextureId,
+                                    Mgpu_DrawBounds *bounds);
+
+/*
+ * Returns true if executing the operation requires reading pixels from the specified texture.
+ */
+bool mgpu_draw_operation_reads_texture(Mgpu_Operation *operation, uint8_t textureId);
+
+/*
+ * Rasterizes the part of a drawing operation that falls within the region. The operation must
+ * have been accepted by `mgpu_draw_operation_get_bounds()`, as no validation is performed and
+ * no messages are raised. Safe to call from multiple threads at once, as long as the regions
+ * don't overlap.
+ */
+void mgpu_draw_operation_in_region(Mgpu_Operation *operation,
+                                   Mgpu_TextureManager *textureManager,
+                                   const Mgpu_DrawRegion *region);
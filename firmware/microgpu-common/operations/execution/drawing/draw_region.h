@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include "microgpu-common/texture_manager.h"
+
+/*
+ * A rectangular area of a texture. The right and bottom edges are exclusive.
+ */
+typedef struct {
+    uint16_t left, top, right, bottom;
+} Mgpu_DrawBounds;
+
+/*
+ * Describes where a draw operation's pixels should be written. Drawing still computes coordinates
+ * in terms of the full target texture, but only pixels inside the clip bounds are written, and they
+ * are written relative to `pixels`.
+ *
+ * This allows a single draw operation to be rasterized in pieces, such as one horizontal band at a
+ * time, or into a small buffer that only covers part of the target texture.
+ */
+typedef struct {
+    /*
+     * Pixel storage, where `pixels[0]` holds the target texture's pixel at (originX, originY)
+     */
+    Mgpu_Color *pixels;
+
+    /*
+     * Number of pixels between the start of each row in `pixels`
+     */
+    uint16_t stride;
+
+    uint16_t originX, originY;
+
+    /*
+     * Only pixels inside of these bounds are written. Must fit within the target texture, and
+     * must be covered by `pixels`.
+     */
+    Mgpu_DrawBounds clip;
+} Mgpu_DrawRegion;
+
+/*
+ * Sets up a region that draws directly to the whole texture.
+ */
+static inline void mgpu_draw_region_for_texture(Mgpu_Texture *texture, Mgpu_DrawRegion *region) {
+    region->pixels = texture->pixels;
+    region->stride = texture->width;
+    region->originX = 0;
+    region->originY = 0;
+    region->clip.left = 0;
+    region->clip.top = 0;
+    region->clip.right = texture->width;
+    region->clip.bottom = texture->height;
+}
+
+/*
+ * Gets the address of a texture pixel inside the region's storage. The pixel must be within the
+ * region's clip bounds.
+ */
+static inline Mgpu_Color *mgpu_draw_region_pixel(const Mgpu_DrawRegion *region, uint16_t x, uint16_t y) {
+    return region->pixels + ((y - region->originY) * region->stride) + (x - region->originX);
+}
+
+/*
+ * Returns true if the two bounds share any pixels
+ */
+static inline bool mgpu_draw_bounds_intersect(const Mgpu_DrawBounds *first, const Mgpu_DrawBounds *second) {
+    return first->left < second->right &&
+           second->left < first->right &&
+           first->top < second->bottom &&
+           second->top < first->bottom;
+}
@@ -18,23 +18,34 @@ void mgpu_draw_rectangle(Mgpu_DrawRectangleOperation *drawRectangle, Mgpu_Textur
         return;
     }
 
-    if (drawRectangle->startX >= texture->width || drawRectangle->startY >= texture->height) {
-        // It starts out of bounds, so nothing to draw.
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(texture, &region);
+    mgpu_draw_rectangle_in_region(drawRectangle, &region);
+}
+
+void mgpu_draw_rectangle_in_region(Mgpu_DrawRectangleOperation *drawRectangle, const Mgpu_DrawRegion *region) {
+    assert(drawRectangle != NULL);
+    assert(region != NULL);
+
+    uint16_t startX = max(drawRectangle->startX, region->clip.left);
+    uint16_t startY = max(drawRectangle->startY, region->clip.top);
+    uint16_t endX = min(drawRectangle->startX + drawRectangle->width, region->clip.right);
+    uint16_t endY = min(drawRectangle->startY + drawRectangle->height, region->clip.bottom);
+    if (startX >= endX || startY >= endY) {
+        // Nothing inside the region to draw
         return;
     }
 
-    uint16_t endX = min(drawRectangle->startX + drawRectangle->width, texture->width);
-    uint16_t endY = min(drawRectangle->startY + drawRectangle->height, texture->height);
-    uint16_t adjustedWidth = endX - drawRectangle->startX;
-    uint16_t adjustedHeight = endY - drawRectangle->startY;
+    uint16_t adjustedWidth = endX - startX;
+    uint16_t adjustedHeight = endY - startY;
 
-    Mgpu_Color *pixel = texture->pixels + ((drawRectangle->startY * texture->width) + drawRectangle->startX);
+    Mgpu_Color *pixel = mgpu_draw_region_pixel(region, startX, startY);
     for (uint16_t row = 0; row < adjustedHeight; row++) {
         for (uint16_t col = 0; col < adjustedWidth; col++) {
             *pixel = drawRectangle->color;
             pixel++;
         }
 
-        pixel += texture->width - adjustedWidth;
+        pixel += region->stride - adjustedWidth;
     }
 }
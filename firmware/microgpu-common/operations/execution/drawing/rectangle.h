@@ -1,5 +1,11 @@
 #pragma once
 
 #include "microgpu-common/operations/operations.h"
+#include "draw_region.h"
 
 void mgpu_draw_rectangle(Mgpu_DrawRectangleOperation *drawRectangle, Mgpu_TextureManager *textureManager);
+
+/*
+ * Draws the rectangle without any validation, only writing pixels that fall inside the region.
+ */
+void mgpu_draw_rectangle_in_region(Mgpu_DrawRectangleOperation *drawRectangle, const Mgpu_DrawRegion *region);
@@ -52,8 +52,8 @@ void make_point_pair(PointPair *pair, Point p0, Point p1) {
     pair->slope = (float) pair->deltaX / (float) pair->deltaY;
 }
 
-void draw_triangle(Point top, Point mid, Point bottom, Mgpu_Texture *texture, Mgpu_Color color) {
-    assert(texture != NULL);
+void draw_triangle(Point top, Point mid, Point bottom, const Mgpu_DrawRegion *region, Mgpu_Color color) {
+    assert(region != NULL);
 
     // Iterate through the triangle from top to bottom one y value at a time.
     // TODO: Swap out for bresenham at some point.
@@ -68,8 +68,10 @@ void draw_triangle(Point top, Point mid, Point bottom, Mgpu_Texture *texture, Mg
     float shortX = top.x;
     float longX = top.x;
 
+    // Rows above the region still need to be walked, so the x positions are accumulated exactly
+    // the same way no matter how the triangle is split up.
     for (uint16_t y = top.y; y <= bottom.y; y++) {
-        if (y >= texture->height) {
+        if (y >= region->clip.bottom) {
             break;
         }
 
@@ -81,15 +83,17 @@ void draw_triangle(Point top, Point mid, Point bottom, Mgpu_Texture *texture, Mg
 
         // Draw the row
         int16_t startCol = min(shortX, longX);
-        if (startCol < texture->width) {
+        if (y >= region->clip.top && startCol < region->clip.right) {
             uint16_t diff = longX > shortX ? (int32_t) (longX - shortX) : (int32_t) (shortX - longX);
-            int16_t endCol = min(startCol + diff, texture->width - 1);
-            diff = endCol - startCol;
-
-            Mgpu_Color *pixel = texture->pixels + (y * texture->width) + startCol;
-            for (int x = 0; x <= diff; x++) {
-                *pixel = color;
-                pixel++;
+            int16_t endCol = min(startCol + diff, region->clip.right - 1);
+            startCol = max(startCol, (int16_t) region->clip.left);
+
+            if (startCol <= endCol) {
+                Mgpu_Color *pixel = mgpu_draw_region_pixel(region, startCol, y);
+                for (int x = startCol; x <= endCol; x++) {
+                    *pixel = color;
+                    pixel++;
+                }
             }
         }
 
@@ -112,6 +116,14 @@ void mgpu_draw_triangle(Mgpu_DrawTriangleOperation *operation, Mgpu_TextureManag
         return;
     }
 
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(texture, &region);
+    mgpu_draw_triangle_in_region(operation, &region);
+}
+
+void mgpu_draw_triangle_in_region(Mgpu_DrawTriangleOperation *operation, const Mgpu_DrawRegion *region) {
+    assert(operation != NULL);
+
     Triangle triangle = get_sorted_points(operation);
-    draw_triangle(triangle.p0, triangle.p1, triangle.p2, texture, operation->color);
+    draw_triangle(triangle.p0, triangle.p1, triangle.p2, region, operation->color);
 }
@@ -1,5 +1,11 @@
 #pragma once
 
 #include "microgpu-common/operations/operations.h"
+#include "draw_region.h"
 
 void mgpu_draw_triangle(Mgpu_DrawTriangleOperation *operation, Mgpu_TextureManager *textureManager);
+
+/*
+ * Draws the triangle without any validation, only writing pixels that fall inside the region.
+ */
+void mgpu_draw_triangle_in_region(Mgpu_DrawTriangleOperation *operation, const Mgpu_DrawRegion *region);
@@ -0,0 +1,106 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include "fences.h"
+
+// How many fences can be waiting on the display at once. More than that get merged together.
+#define MAX_PENDING_FENCES 16
+
+typedef struct {
+    uint32_t value;
+
+    /*
+     * How many frames the display has to have presented for the fence to be complete
+     */
+    uint32_t framesRendered;
+} PendingFence;
+
+static PendingFence pendingFences[MAX_PENDING_FENCES];
+static uint8_t pendingStart = 0, pendingCount = 0;
+
+// Published so the receive stage can answer fence queries without waiting on execution
+static atomic_uint_fast32_t lastCompletedValue = 0;
+
+/*
+ * Completes every pending fence whose frames the display has finished with
+ */
+static void complete_presented_fences(Mgpu_Display *display) {
+    if (pendingCount == 0) {
+        return;
+    }
+
+    uint32_t framesRendered, framesPresented;
+    mgpu_display_get_frame_counts(display, &framesRendered, &framesPresented);
+
+    while (pendingCount > 0) {
+        PendingFence *fence = &pendingFences[pendingStart];
+
+        // Compared by difference so frame counts wrapping around doesn't matter
+        if ((int32_t) (framesPresented - fence->framesRendered) < 0) {
+            break;
+        }
+
+        atomic_store_explicit(&lastCompletedValue, fence->value, memory_order_release);
+        pendingStart = (pendingStart + 1) % MAX_PENDING_FENCES;
+        pendingCount--;
+    }
+}
+
+void mgpu_exec_fence_insert(Mgpu_Display *display, uint32_t value) {
+    assert(display != NULL);
+
+    complete_presented_fences(display);
+
+    uint32_t framesRendered, framesPresented;
+    mgpu_display_get_frame_counts(display, &framesRendered, &framesPresented);
+    if (pendingCount == 0 && framesPresented == framesRendered) {
+        // Nothing is still being sent to the display
+        atomic_store_explicit(&lastCompletedValue, value, memory_order_release);
+        return;
+    }
+
+    if (pendingCount == MAX_PENDING_FENCES) {
+        // The newest fence waits on at least as many frames as the one before it, so folding it
+        // into that one only delays when the earlier value gets reported.
+        uint8_t newestIndex = (pendingStart + pendingCount - 1) % MAX_PENDING_FENCES;
+        pendingFences[newestIndex].value = value;
+        pendingFences[newestIndex].framesRendered = framesRendered;
+        return;
+    }
+
+    uint8_t index = (pendingStart + pendingCount) % MAX_PENDING_FENCES;
+    pendingFences[index].value = value;
+    pendingFences[index].framesRendered = framesRendered;
+    pendingCount++;
+}
+
+void mgpu_exec_fences_update(Mgpu_Display *display) {
+    assert(display != NULL);
+
+    complete_presented_fences(display);
+}
+
+void mgpu_exec_fence_respond(Mgpu_Databus *databus, uint16_t requestId) {
+    assert(databus != NULL);
+
+    Mgpu_Response response = {
+            .type = Mgpu_Response_Fence,
+            .requestId = requestId,
+            .fence = {.lastCompletedValue = atomic_load_explicit(&lastCompletedValue, memory_order_acquire)},
+    };
+
+    mgpu_databus_send_response(databus, &response);
+}
+
+void mgpu_exec_fence_query(Mgpu_Display *display, Mgpu_Databus *databus, uint16_t requestId) {
+    assert(display != NULL);
+    assert(databus != NULL);
+
+    complete_presented_fences(display);
+    mgpu_exec_fence_respond(databus, requestId);
+}
+
+void mgpu_exec_fences_reset(void) {
+    pendingStart = 0;
+    pendingCount = 0;
+    atomic_store_explicit(&lastCompletedValue, 0, memory_order_release);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "microgpu-common/databus.h"
+#include "microgpu-common/display.h"
+
+/*
+ * Inserts a fence after every operation executed so far. Drawing has to be flushed before this
+ * is called, so the only thing the fence may still have to wait on is the display finishing
+ * frames it's already been given.
+ */
+void mgpu_exec_fence_insert(Mgpu_Display *display, uint32_t value);
+
+/*
+ * Completes every fence whose frames the display has finished sending. Must be called from the
+ * thread executing operations.
+ */
+void mgpu_exec_fences_update(Mgpu_Display *display);
+
+/*
+ * Responds with the value of the most recently completed fence, as of the last time fences were
+ * updated. Safe to call from a thread other than the one executing operations, so queries can be
+ * answered as soon as they're received instead of waiting behind every queued operation.
+ */
+void mgpu_exec_fence_respond(Mgpu_Databus *databus, uint16_t requestId);
+
+/*
+ * Completes fences the display has finished with, then responds with the value of the most
+ * recently completed fence.
+ */
+void mgpu_exec_fence_query(Mgpu_Display *display, Mgpu_Databus *databus, uint16_t requestId);
+
+/*
+ * Forgets every fence, so the next client starts from a completed value of zero.
+ */
+void mgpu_exec_fences_reset(void);
@@ -1,30 +1,264 @@
+#include <stdio.h>
+#include <string.h>
 #include "microgpu-common/common.h"
+#include "microgpu-common/messages.h"
 #include "microgpu-common/fonts/fonts.h"
+#include "microgpu-common/fonts/outline_font.h"
+#include "microgpu-common/fonts/text_box.h"
 #include "microgpu-common/operations/execution/fonts.h"
 
-char string[256] = {0};
-
 void mgpu_exec_font_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawCharsOperation *operation) {
-    // We can't guarantee the consumer sent us a null terminated string, so move it into the
-    // string to be sure of it.
-
-    int count = min(sizeof(string), operation->numCharacters);
-    int index;
-    for (index = 0; index < count; index++) {
-        string[index] = operation->characters[index];
-    }
-
-    if (index >= 255) {
-        string[255] = '\0';
-    } else {
-        string[index] = '\0';
-    }
-
     mgpu_font_draw(textureManager,
                    operation->fontId,
                    operation->textureId,
-                   string,
+                   operation->characters,
+                   operation->numCharacters,
                    operation->color,
+                   operation->hasBackground ? &operation->backgroundColor : NULL,
                    operation->startX,
                    operation->startY);
 }
+
+void mgpu_exec_font_draw_text_box(Mgpu_TextureManager *textureManager, Mgpu_DrawTextBoxOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    Mgpu_Texture *texture = mgpu_texture_get(textureManager, operation->textureId);
+    if (texture == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Text box draw failed: destination texture id %u does not exist",
+                 operation->textureId);
+        return;
+    }
+
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(texture, &region);
+    if (!mgpu_text_box_draw_in_region(textureManager, operation, &region)) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Invalid font id specified of %u", operation->fontId);
+    }
+}
+
+void mgpu_exec_font_define(Mgpu_TextureManager *textureManager, Mgpu_DefineFontOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    if (operation->characterCount > 0 && operation->height == 0) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Defining font id %u failed: font has a height of zero", operation->fontId);
+        return;
+    }
+
+    if (operation->firstCharacter + operation->characterCount > 256) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining font id %u failed: %u characters starting at %u goes past the last character",
+                 operation->fontId,
+                 operation->characterCount,
+                 operation->firstCharacter);
+
+        return;
+    }
+
+    // Glyphs are checked up front, so drawing never has to check what it reads from the bitmap
+    for (int x = 0; x < operation->characterCount; x++) {
+        const uint8_t *glyph = operation->glyphs + (x * 3);
+        uint8_t width = glyph[0];
+        uint16_t offset = ((uint16_t) glyph[1] << 8) | glyph[2];
+        size_t glyphBytes = ((width * operation->height) + 7) / 8;
+
+        if (width > MGPU_BITMAP_FONT_MAX_WIDTH || offset + glyphBytes > operation->bitmapSize) {
+            char *msg = mgpu_message_get_pointer();
+            assert(msg != NULL);
+
+            snprintf(msg,
+                     MESSAGE_MAX_LEN,
+                     "Defining font id %u failed: glyph for character %u is wider than %u or outside the bitmap",
+                     operation->fontId,
+                     operation->firstCharacter + x,
+                     MGPU_BITMAP_FONT_MAX_WIDTH);
+
+            return;
+        }
+    }
+
+    Mgpu_FontDefinition info = {
+            .id = operation->fontId,
+            .height = operation->height,
+            .firstCharacter = operation->firstCharacter,
+            .characterCount = operation->characterCount,
+            .bitmapSize = operation->bitmapSize,
+            .glyphs = operation->glyphs,
+    };
+
+    mgpu_texture_define_font(textureManager, &info);
+}
+
+void mgpu_exec_font_append(Mgpu_TextureManager *textureManager, Mgpu_AppendFontBitmapOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+    assert(operation->bytes != NULL);
+
+    Mgpu_UploadedFont *font = mgpu_texture_get_font(textureManager, operation->fontId);
+    if (font == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Append to font %u failed: font not defined", operation->fontId);
+        return;
+    }
+
+    if (font->type == MGPU_UPLOADED_FONT_COVERAGE) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Append to font %u failed: scaled fonts are rasterized", operation->fontId);
+        return;
+    }
+
+    size_t bytesToWrite = min(font->dataSize - font->dataBytesWritten, operation->byteCount);
+    memcpy(font->data + font->dataBytesWritten, operation->bytes, bytesToWrite);
+    font->dataBytesWritten += bytesToWrite;
+}
+
+void mgpu_exec_font_define_outline(Mgpu_TextureManager *textureManager, Mgpu_DefineOutlineFontOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    if (operation->characterCount > 0 && operation->unitsPerEm == 0) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Defining font id %u failed: font has zero units per em", operation->fontId);
+        return;
+    }
+
+    if (operation->firstCharacter + operation->characterCount > 256) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining font id %u failed: %u characters starting at %u goes past the last character",
+                 operation->fontId,
+                 operation->characterCount,
+                 operation->firstCharacter);
+
+        return;
+    }
+
+    // Contours past the start of each glyph are checked when the glyph is rasterized
+    for (int x = 0; x < operation->characterCount; x++) {
+        const uint8_t *glyph = operation->glyphs + (x * 4);
+        uint16_t offset = ((uint16_t) glyph[2] << 8) | glyph[3];
+        if (offset >= operation->outlineSize) {
+            char *msg = mgpu_message_get_pointer();
+            assert(msg != NULL);
+
+            snprintf(msg,
+                     MESSAGE_MAX_LEN,
+                     "Defining font id %u failed: glyph for character %u starts outside the outlines",
+                     operation->fontId,
+                     operation->firstCharacter + x);
+
+            return;
+        }
+    }
+
+    Mgpu_OutlineFontDefinition info = {
+            .id = operation->fontId,
+            .unitsPerEm = operation->unitsPerEm,
+            .ascent = operation->ascent,
+            .descent = operation->descent,
+            .firstCharacter = operation->firstCharacter,
+            .characterCount = operation->characterCount,
+            .outlineSize = operation->outlineSize,
+            .glyphs = operation->glyphs,
+    };
+
+    mgpu_texture_define_outline_font(textureManager, &info);
+}
+
+void mgpu_exec_font_define_scaled(Mgpu_TextureManager *textureManager, Mgpu_DefineScaledFontOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    Mgpu_CoverageFontDefinition info = {
+            .id = operation->fontId,
+            .firstCharacter = operation->firstCharacter,
+            .characterCount = operation->characterCount,
+    };
+
+    if (operation->characterCount == 0) {
+        mgpu_texture_define_coverage_font(textureManager, &info);
+        return;
+    }
+
+    // Defining the scaled font would free an outline font with the same id before it's rasterized
+    Mgpu_UploadedFont *outline = mgpu_texture_get_font(textureManager, operation->outlineFontId);
+    if (outline == NULL || outline->type != MGPU_UPLOADED_FONT_OUTLINE || operation->outlineFontId == operation->fontId) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining font id %u failed: font id %u is not a different outline font",
+                 operation->fontId,
+                 operation->outlineFontId);
+
+        return;
+    }
+
+    if (operation->pixelSize == 0 || operation->firstCharacter + operation->characterCount > 256) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining font id %u failed: pixel size is zero or characters go past the last character",
+                 operation->fontId);
+
+        return;
+    }
+
+    uint8_t glyphWidths[256];
+    for (int x = 0; x < operation->characterCount; x++) {
+        glyphWidths[x] = mgpu_outline_font_get_width(outline, operation->firstCharacter + x, operation->pixelSize);
+    }
+
+    info.height = mgpu_outline_font_get_height(outline, operation->pixelSize);
+    info.glyphWidths = glyphWidths;
+
+    Mgpu_UploadedFont *font = mgpu_texture_define_coverage_font(textureManager, &info);
+    if (font == NULL) {
+        return;
+    }
+
+    for (int x = 0; x < operation->characterCount; x++) {
+        uint8_t character = operation->firstCharacter + x;
+        if (!mgpu_outline_font_rasterize(outline,
+                                         character,
+                                         operation->pixelSize,
+                                         font->glyphWidths[x],
+                                         font->height,
+                                         font->data + font->glyphOffsets[x])) {
+            char *msg = mgpu_message_get_pointer();
+            assert(msg != NULL);
+
+            snprintf(msg,
+                     MESSAGE_MAX_LEN,
+                     "Outline for character %u of font id %u runs past the end of its data",
+                     character,
+                     operation->outlineFontId);
+        }
+    }
+}
@@ -4,4 +4,8 @@
 #include "microgpu-common/texture_manager.h"
 
 void mgpu_exec_font_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawCharsOperation *operation);
-
+void mgpu_exec_font_draw_text_box(Mgpu_TextureManager *textureManager, Mgpu_DrawTextBoxOperation *operation);
+void mgpu_exec_font_define(Mgpu_TextureManager *textureManager, Mgpu_DefineFontOperation *operation);
+void mgpu_exec_font_append(Mgpu_TextureManager *textureManager, Mgpu_AppendFontBitmapOperation *operation);
+void mgpu_exec_font_define_outline(Mgpu_TextureManager *textureManager, Mgpu_DefineOutlineFontOperation *operation);
+void mgpu_exec_font_define_scaled(Mgpu_TextureManager *textureManager, Mgpu_DefineScaledFontOperation *operation);
@@ -1,8 +1,8 @@
 #include "get_last_message.h"
 #include "microgpu-common/messages.h"
 
-void mgpu_exec_get_last_message(Mgpu_Databus *databus) {
-    Mgpu_Response response = {.type = Mgpu_Response_LastMessage};
+void mgpu_exec_get_last_message(Mgpu_Databus *databus, uint16_t requestId) {
+    Mgpu_Response response = {.type = Mgpu_Response_LastMessage, .requestId = requestId};
     response.lastMessage.message = mgpu_message_get_pointer();
 
     mgpu_databus_send_response(databus, &response);
@@ -3,4 +3,4 @@
 #include "microgpu-common/databus.h"
 #include "microgpu-common/operations/operations.h"
 
-void mgpu_exec_get_last_message(Mgpu_Databus *databus);
+void mgpu_exec_get_last_message(Mgpu_Databus *databus, uint16_t requestId);
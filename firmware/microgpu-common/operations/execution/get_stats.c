@@ -0,0 +1,66 @@
+#include <assert.h>
+#include "microgpu-common/operations/operation_stats.h"
+#include "get_stats.h"
+
+#ifndef MGPU_OMIT_OPERATION_STATS
+
+/*
+ * How many entries fit in a response the databus can send. Responses are framed the same way as
+ * operations, so they're held to the same size limit.
+ */
+static uint8_t get_max_entries(Mgpu_Databus *databus, uint16_t requestId) {
+    uint16_t maxSize = mgpu_databus_get_max_size(databus);
+    if (maxSize == 0) {
+        return MGPU_STATS_RESPONSE_MAX_ENTRIES;
+    }
+
+    // Tagged responses have the request id after the type byte
+    size_t headerSize = MGPU_STATS_RESPONSE_HEADER_SIZE + (requestId != 0 ? 2 : 0);
+    assert(maxSize >= headerSize + MGPU_STATS_RESPONSE_ENTRY_SIZE);
+
+    size_t entries = (maxSize - headerSize) / MGPU_STATS_RESPONSE_ENTRY_SIZE;
+    return entries < MGPU_STATS_RESPONSE_MAX_ENTRIES ? entries : MGPU_STATS_RESPONSE_MAX_ENTRIES;
+}
+
+void mgpu_exec_get_stats(Mgpu_GetStatsOperation *getStats, Mgpu_Databus *databus, uint16_t requestId) {
+    assert(getStats != NULL);
+    assert(databus != NULL);
+
+    Mgpu_StatsEntry entries[MGPU_STATS_RESPONSE_MAX_ENTRIES];
+    uint8_t maxEntries = get_max_entries(databus, requestId);
+    Mgpu_Response response = {
+            .type = Mgpu_Response_Stats,
+            .requestId = requestId,
+            .stats = {.entries = entries},
+    };
+
+    for (uint32_t type = getStats->firstType; type <= UINT8_MAX; type++) {
+        const Mgpu_OperationStats *stats = mgpu_operation_stats_get(type);
+        if (stats->executions == 0) {
+            continue;
+        }
+
+        if (response.stats.entryCount == maxEntries) {
+            response.stats.nextType = type;
+            break;
+        }
+
+        entries[response.stats.entryCount++] = (Mgpu_StatsEntry) {
+                .operationType = type,
+                .executions = stats->executions,
+                .totalMicroseconds = stats->totalMicroseconds,
+                .maxMicroseconds = stats->maxMicroseconds,
+                .pixelsTouched = stats->pixelsTouched,
+                .bytesDecoded = stats->bytesDecoded,
+        };
+
+        // Only types that are sent back are reset, so paging through them doesn't lose any
+        if (getStats->reset) {
+            mgpu_operation_stats_reset(type);
+        }
+    }
+
+    mgpu_databus_send_response(databus, &response);
+}
+
+#endif
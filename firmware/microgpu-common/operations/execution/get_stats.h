@@ -0,0 +1,6 @@
+#pragma once
+
+#include "microgpu-common/databus.h"
+#include "microgpu-common/operations/operations.h"
+
+void mgpu_exec_get_stats(Mgpu_GetStatsOperation *getStats, Mgpu_Databus *databus, uint16_t requestId);
@@ -0,0 +1,26 @@
+#include <microgpu-common/common.h>
+#include "get_texture_usage.h"
+
+void mgpu_exec_get_texture_usage(Mgpu_TextureManager *textureManager, Mgpu_Databus *databus, uint16_t requestId) {
+    assert(textureManager != NULL);
+    assert(databus != NULL);
+
+    Mgpu_TextureUsage usage;
+    mgpu_texture_manager_get_usage(textureManager, &usage);
+
+    Mgpu_Response response = {
+            .type = Mgpu_Response_TextureUsage,
+            .requestId = requestId,
+            .textureUsage = {
+                    .fastBytesUsed = usage.fastBytesUsed,
+                    .fastBudget = usage.fastBudget,
+                    .slowBytesUsed = usage.slowBytesUsed,
+                    .slowBudget = usage.slowBudget,
+                    .textureCount = usage.textureCount,
+                    .evictionCount = usage.evictionCount,
+            },
+    };
+
+    mgpu_texture_manager_take_evicted_ids(textureManager, response.textureUsage.evictedIds);
+    mgpu_databus_send_response(databus, &response);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "microgpu-common/databus.h"
+#include "microgpu-common/texture_manager.h"
+
+void mgpu_exec_get_texture_usage(Mgpu_TextureManager *textureManager, Mgpu_Databus *databus, uint16_t requestId);
@@ -18,6 +18,10 @@ void mgpu_exec_present_framebuffer(Mgpu_Display *display, Mgpu_TextureManager *t
     // drawing to a cached texture is preferred.
     Mgpu_Texture *texture = mgpu_texture_get(textureManager, 0);
     assert(texture != NULL); // We should never not have an active frame buffer
+    if (!texture->hasPixels) {
+        // Frames are being rendered in strips, so there's nothing to clear
+        return;
+    }
 
     Mgpu_Color color = mgpu_color_from_rgb888(0, 0, 0);
     memset(texture->pixels, color, sizeof(Mgpu_Color) * texture->width * texture->height);
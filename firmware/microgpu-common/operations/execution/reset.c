@@ -1,4 +1,6 @@
 #include "reset.h"
+#include "draw_state.h"
+#include "fences.h"
 
 void mgpu_exec_reset(bool *resetFlag) {
     // We can't do anything from here, as a full reset depends
@@ -6,4 +8,10 @@ void mgpu_exec_reset(bool *resetFlag) {
     // reset flag to true, and let the firmware specific reset
     // functionality run.
     *resetFlag = true;
+
+    // Fences are tracked against the display's frame counts, which start over with a new display
+    mgpu_exec_fences_reset();
+
+    // The next client shouldn't inherit the draw state the last one left behind
+    mgpu_exec_draw_state_reset();
 }
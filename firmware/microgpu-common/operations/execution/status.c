@@ -1,7 +1,7 @@
 #include <microgpu-common/common.h>
 #include "status.h"
 
-void mgpu_exec_status_op(Mgpu_Display *display, Mgpu_TextureManager *textureManager, Mgpu_Databus *databus) {
+void mgpu_exec_status_op(Mgpu_Display *display, Mgpu_TextureManager *textureManager, Mgpu_Databus *databus, uint16_t requestId) {
     assert(display != NULL);
     assert(databus != NULL);
     assert(textureManager != NULL);
@@ -15,6 +15,7 @@ void mgpu_exec_status_op(Mgpu_Display *display, Mgpu_TextureManager *textureMana
             .displayWidth = width,
             .opByteLimit = mgpu_databus_get_max_size(databus),
             .apiVersionId = MGPU_API_VERSION,
+            .maxFramingVersion = mgpu_databus_get_max_framing_version(databus),
     };
 
     // We know we aren't initialized if we don't have a frame buffer yet
@@ -31,6 +32,7 @@ void mgpu_exec_status_op(Mgpu_Display *display, Mgpu_TextureManager *textureMana
 
     Mgpu_Response response = {
             .type = Mgpu_Response_Status,
+            .requestId = requestId,
             .status = status,
     };
 
@@ -3,4 +3,4 @@
 #include "microgpu-common/databus.h"
 #include "microgpu-common/operations/operations.h"
 
-void mgpu_exec_status_op(Mgpu_Display *display, Mgpu_TextureManager *textureManager, Mgpu_Databus *databus);
+void mgpu_exec_status_op(Mgpu_Display *display, Mgpu_TextureManager *textureManager, Mgpu_Databus *databus, uint16_t requestId);
@@ -25,9 +25,13 @@ void mgpu_exec_texture_define(Mgpu_TextureManager *textureManager, Mgpu_DefineTe
             .width = operation->width,
             .height = operation->height,
             .transparentColor = operation->transparentColor,
-            .flags = MGPU_TEXTURE_USE_SLOW_RAM,
+            .flags = MGPU_TEXTURE_USE_SLOW_RAM | MGPU_TEXTURE_RELOCATABLE,
     };
 
+    if (operation->isCacheable) {
+        info.flags |= MGPU_TEXTURE_CACHEABLE;
+    }
+
     mgpu_texture_define(textureManager, &info, 1);
 }
 
@@ -49,6 +53,18 @@ void mgpu_exec_texture_append(Mgpu_TextureManager *textureManager, Mgpu_AppendTe
         return;
     }
 
+    if (!texture->hasPixels) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Append to texture %u failed: texture has no pixels to write to",
+                 operation->textureId);
+
+        return;
+    }
+
     size_t pixelsLeft = (texture->width * texture->height) - texture->pixelsWritten;
     size_t pixelsToWrite = min(pixelsLeft, operation->pixelCount);
 
@@ -66,17 +82,16 @@ void mgpu_exec_texture_append(Mgpu_TextureManager *textureManager, Mgpu_AppendTe
     texture->pixelsWritten += pixelsToWrite;
 }
 
-void mgpu_exec_texture_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawTextureOperation *operation) {
-    assert(textureManager != NULL);
-    assert(operation != NULL);
-
-    if (operation->sourceWidth == 0 || operation->sourceHeight == 0) {
-        // nothing to draw
-        return;
-    }
-
-    Mgpu_Texture *sourceTexture = mgpu_texture_get(textureManager, operation->sourceTextureId);
-    if (sourceTexture == NULL) {
+/*
+ * Gets the source and target textures of a draw, raising a message if either isn't defined or the
+ * source rectangle doesn't fit in the source texture.
+ */
+static bool get_draw_textures(Mgpu_TextureManager *textureManager,
+                              Mgpu_DrawTextureOperation *operation,
+                              Mgpu_Texture **sourceTexture,
+                              Mgpu_Texture **targetTexture) {
+    *sourceTexture = mgpu_texture_get(textureManager, operation->sourceTextureId);
+    if (*sourceTexture == NULL) {
         char *msg = mgpu_message_get_pointer();
         assert(msg != NULL);
 
@@ -85,11 +100,11 @@ void mgpu_exec_texture_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawTextur
                  "Attempted to draw from source texture id %u, but that texture is not defined",
                  operation->sourceTextureId);
 
-        return;
+        return false;
     }
 
-    Mgpu_Texture *targetTexture = mgpu_texture_get(textureManager, operation->targetTextureId);
-    if (targetTexture == NULL) {
+    *targetTexture = mgpu_texture_get(textureManager, operation->targetTextureId);
+    if (*targetTexture == NULL) {
         char *msg = mgpu_message_get_pointer();
         assert(msg != NULL);
 
@@ -98,67 +113,235 @@ void mgpu_exec_texture_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawTextur
                  "Texture draw error: Attempted to draw to target texture id %u, but that texture is not defined",
                  operation->targetTextureId);
 
-        return;
+        return false;
     }
 
-    if (operation->sourceWidth + operation->sourceStartX > sourceTexture->width) {
+    if (operation->sourceWidth + operation->sourceStartX > (*sourceTexture)->width) {
         char *msg = mgpu_message_get_pointer();
         assert(msg != NULL);
 
         strncpy(msg, "Texture draw error: Drawing more horizontal pixels than source texture contains",
                 MESSAGE_MAX_LEN);
-        return;
+        return false;
     }
 
-    if (operation->sourceHeight + operation->sourceStartY > sourceTexture->height) {
+    if (operation->sourceHeight + operation->sourceStartY > (*sourceTexture)->height) {
         char *msg = mgpu_message_get_pointer();
         assert(msg != NULL);
 
         strncpy(msg, "Texture draw error: Drawing more horizontal pixels than source texture contains",
                 MESSAGE_MAX_LEN);
+        return false;
+    }
+
+    return true;
+}
+
+void mgpu_exec_texture_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawTextureOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    if (operation->sourceWidth == 0 || operation->sourceHeight == 0) {
+        // nothing to draw
+        return;
+    }
+
+    Mgpu_Texture *sourceTexture, *targetTexture;
+    if (!get_draw_textures(textureManager, operation, &sourceTexture, &targetTexture)) {
         return;
     }
 
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(targetTexture, &region);
+    mgpu_exec_texture_draw_in_region(operation, sourceTexture, targetTexture, &region);
+}
+
+void mgpu_exec_texture_get_instance(Mgpu_DrawTextureInstancedOperation *operation,
+                                    uint16_t index,
+                                    Mgpu_DrawTextureOperation *instance) {
+    assert(operation != NULL);
+    assert(instance != NULL);
+    assert(index < operation->instanceCount);
+
+    bool hasInstanceFlags = operation->flags & MGPU_DRAW_TEXTURE_INSTANCE_FLAGS;
+    const uint8_t *bytes = operation->instances + index * (hasInstanceFlags ? 5 : 4);
+    uint8_t flags = hasInstanceFlags ? bytes[4] : operation->flags;
+
+    *instance = (Mgpu_DrawTextureOperation) {
+            .sourceTextureId = operation->sourceTextureId,
+            .targetTextureId = operation->targetTextureId,
+            .ignoreTransparency = operation->flags & MGPU_DRAW_TEXTURE_IGNORE_TRANSPARENCY,
+            .sourceStartX = operation->sourceStartX,
+            .sourceStartY = operation->sourceStartY,
+            .sourceWidth = operation->sourceWidth,
+            .sourceHeight = operation->sourceHeight,
+            .targetStartX = (int16_t) (((int16_t) bytes[0] << 8) | bytes[1]),
+            .targetStartY = (int16_t) (((int16_t) bytes[2] << 8) | bytes[3]),
+            .flipHorizontally = flags & MGPU_DRAW_TEXTURE_FLIP_HORIZONTALLY,
+            .flipVertically = flags & MGPU_DRAW_TEXTURE_FLIP_VERTICALLY,
+    };
+}
+
+void mgpu_exec_texture_draw_instanced(Mgpu_TextureManager *textureManager,
+                                      Mgpu_DrawTextureInstancedOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    if (operation->instanceCount == 0 || operation->sourceWidth == 0 || operation->sourceHeight == 0) {
+        return;
+    }
+
+    // Every instance has the same textures and source rectangle, so they only need to be checked once
+    Mgpu_DrawTextureOperation instance;
+    mgpu_exec_texture_get_instance(operation, 0, &instance);
+
+    Mgpu_Texture *sourceTexture, *targetTexture;
+    if (!get_draw_textures(textureManager, &instance, &sourceTexture, &targetTexture)) {
+        return;
+    }
+
+    mgpu_texture_mark_used(textureManager, operation->sourceTextureId);
+
+    Mgpu_DrawRegion region;
+    mgpu_draw_region_for_texture(targetTexture, &region);
+    for (uint16_t index = 0; index < operation->instanceCount; index++) {
+        mgpu_exec_texture_get_instance(operation, index, &instance);
+        mgpu_exec_texture_draw_in_region(&instance, sourceTexture, targetTexture, &region);
+    }
+}
+
+void mgpu_exec_sub_texture_define(Mgpu_TextureManager *textureManager, Mgpu_DefineSubTextureOperation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+
+    if (operation->textureId == 0 || operation->textureId > 200) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Cannot define sub-texture %u inside texture id %u, as its reserved for internal usage",
+                 operation->subTextureId,
+                 operation->textureId);
+
+        return;
+    }
+
+    Mgpu_SubTexture info = {
+            .textureId = operation->textureId,
+            .x = operation->x,
+            .y = operation->y,
+            .width = operation->width,
+            .height = operation->height,
+    };
+
+    mgpu_texture_define_sub(textureManager, operation->subTextureId, &info);
+}
+
+bool mgpu_exec_sub_texture_resolve(Mgpu_TextureManager *textureManager, Mgpu_Operation *operation) {
+    assert(textureManager != NULL);
+    assert(operation != NULL);
+    assert(operation->type == Mgpu_Operation_DrawSubTexture);
+
+    Mgpu_DrawSubTextureOperation drawSubTexture = operation->drawSubTexture;
+    const Mgpu_SubTexture *subTexture = mgpu_texture_get_sub(textureManager, drawSubTexture.subTextureId);
+    if (subTexture == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Attempted to draw sub-texture id %u, but that sub-texture is not defined",
+                 drawSubTexture.subTextureId);
+
+        return false;
+    }
+
+    operation->type = Mgpu_Operation_DrawTexture;
+    operation->drawTexture = (Mgpu_DrawTextureOperation) {
+            .sourceTextureId = subTexture->textureId,
+            .targetTextureId = drawSubTexture.targetTextureId,
+            .ignoreTransparency = drawSubTexture.ignoreTransparency,
+            .sourceStartX = subTexture->x,
+            .sourceStartY = subTexture->y,
+            .sourceWidth = subTexture->width,
+            .sourceHeight = subTexture->height,
+            .targetStartX = drawSubTexture.targetStartX,
+            .targetStartY = drawSubTexture.targetStartY,
+    };
+
+    return true;
+}
+
+void mgpu_exec_texture_draw_in_region(Mgpu_DrawTextureOperation *operation,
+                                      Mgpu_Texture *sourceTexture,
+                                      Mgpu_Texture *targetTexture,
+                                      const Mgpu_DrawRegion *region) {
+    assert(operation != NULL);
+    assert(sourceTexture != NULL);
+    assert(targetTexture != NULL);
+    assert(region != NULL);
+
     int startX = max(operation->targetStartX, 0);
     int startY = max(operation->targetStartY, 0);
     int lastX = min(operation->targetStartX + operation->sourceWidth, targetTexture->width - 1);
     int lastY = min(operation->targetStartY + operation->sourceHeight, targetTexture->height - 1);
+
+    // Only draw the part that's inside the region
+    startX = max(startX, (int) region->clip.left);
+    startY = max(startY, (int) region->clip.top);
+    lastX = min(lastX, (int) region->clip.right);
+    lastY = min(lastY, (int) region->clip.bottom);
+
     int width = lastX - startX;
     int height = lastY - startY;
 
     if (startX >= targetTexture->width ||
         startY >= targetTexture->height ||
-        width == 0 ||
-        height == 0) {
+        width <= 0 ||
+        height <= 0) {
         return;
     }
 
-    size_t sourceOffset = ((startY - operation->targetStartY + operation->sourceStartY) * sourceTexture->width) +
-                          (startX - operation->targetStartX + operation->sourceStartX);
+    // Flipped draws walk the source rectangle backwards from its opposite edge
+    int sourceX = startX - operation->targetStartX;
+    int sourceY = startY - operation->targetStartY;
+    int columnStep = 1;
+    int rowStep = sourceTexture->width;
+    if (operation->flipHorizontally) {
+        sourceX = operation->sourceWidth - 1 - sourceX;
+        columnStep = -1;
+    }
+
+    if (operation->flipVertically) {
+        sourceY = operation->sourceHeight - 1 - sourceY;
+        rowStep = -rowStep;
+    }
 
-    size_t targetOffset = (startY * targetTexture->width) + startX;
+    size_t sourceOffset = ((sourceY + operation->sourceStartY) * sourceTexture->width) +
+                          (sourceX + operation->sourceStartX);
 
     Mgpu_Color *sourceRowStart = sourceTexture->pixels + sourceOffset;
-    Mgpu_Color *targetRowStart = targetTexture->pixels + targetOffset;
+    Mgpu_Color *targetRowStart = mgpu_draw_region_pixel(region, startX, startY);
 
     for (int row = 0; row < height; row++) {
         Mgpu_Color *source = sourceRowStart;
         Mgpu_Color *target = targetRowStart;
 
-        if (operation->ignoreTransparency) {
+        if (operation->ignoreTransparency && !operation->flipHorizontally) {
             memcpy(target, source, width * sizeof(Mgpu_Color));
         } else {
             for (int col = 0; col < width; col++) {
-                if (*source != sourceTexture->transparencyColor) {
+                if (operation->ignoreTransparency || *source != sourceTexture->transparencyColor) {
                     *target = *source;
                 }
 
                 target++;
-                source++;
+                source += columnStep;
             }
         }
 
-        sourceRowStart += sourceTexture->width;
-        targetRowStart += targetTexture->width;
+        sourceRowStart += rowStep;
+        targetRowStart += region->stride;
     }
 }
@@ -2,9 +2,41 @@
 
 #include "microgpu-common/operations/operations.h"
 #include "microgpu-common/texture_manager.h"
+#include "microgpu-common/operations/execution/drawing/draw_region.h"
 
 void mgpu_exec_texture_define(Mgpu_TextureManager *textureManager, Mgpu_DefineTextureOperation *operation);
 
 void mgpu_exec_texture_append(Mgpu_TextureManager *textureManager, Mgpu_AppendTexturePixelOperation *operation);
 
-void mgpu_exec_texture_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawTextureOperation *operation);
\ No newline at end of file
+void mgpu_exec_texture_draw(Mgpu_TextureManager *textureManager, Mgpu_DrawTextureOperation *operation);
+
+/*
+ * Draws every instance of an instanced texture draw. The textures and source rectangle are only
+ * looked up and checked once for all of the instances.
+ */
+void mgpu_exec_texture_draw_instanced(Mgpu_TextureManager *textureManager,
+                                      Mgpu_DrawTextureInstancedOperation *operation);
+
+/*
+ * Gets one instance of an instanced texture draw as its own texture draw operation
+ */
+void mgpu_exec_texture_get_instance(Mgpu_DrawTextureInstancedOperation *operation,
+                                    uint16_t index,
+                                    Mgpu_DrawTextureOperation *instance);
+
+void mgpu_exec_sub_texture_define(Mgpu_TextureManager *textureManager, Mgpu_DefineSubTextureOperation *operation);
+
+/*
+ * Turns a draw sub-texture operation into the equivalent draw texture operation, so it can be
+ * executed or deferred like any other texture draw. Returns false if the sub-texture isn't defined.
+ */
+bool mgpu_exec_sub_texture_resolve(Mgpu_TextureManager *textureManager, Mgpu_Operation *operation);
+
+/*
+ * Draws from the source texture without any validation, only writing pixels that fall inside the
+ * region. The source texture must be able to provide every pixel the operation asks for.
+ */
+void mgpu_exec_texture_draw_in_region(Mgpu_DrawTextureOperation *operation,
+                                      Mgpu_Texture *sourceTexture,
+                                      Mgpu_Texture *targetTexture,
+                                      const Mgpu_DrawRegion *region);
@@ -3,34 +3,39 @@
 #include "microgpu-common/messages.h"
 #include "microgpu-common/colors/color.h"
 #include "operation_deserializer.h"
+#include "operation_registry.h"
+
+/*
+ * Reads the optional request id that can follow the bytes of operations that send a response
+ */
+static uint16_t deserialize_request_id(const uint8_t bytes[], size_t size, size_t index) {
+    if (size < index + 2) {
+        return 0;
+    }
 
-bool deserialize_status_op(Mgpu_Operation *operation) {
-    operation->type = Mgpu_Operation_GetStatus;
-    return true;
+    return ((uint16_t) bytes[index] << 8) | bytes[index + 1];
 }
 
-bool deserialize_last_message_op(Mgpu_Operation *operation) {
-    operation->type = Mgpu_Operation_GetLastMessage;
+bool mgpu_deserialize_get_status(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->requestId = deserialize_request_id(bytes, size, 1);
     return true;
 }
 
-bool deserialize_initialize_op(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
-    if (size < 2) {
-        return false;
-    }
+bool mgpu_deserialize_get_last_message(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->requestId = deserialize_request_id(bytes, size, 1);
+    return true;
+}
 
-    operation->type = Mgpu_Operation_Initialize;
+bool mgpu_deserialize_initialize(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     operation->initialize.frameBufferScale = bytes[1];
-
     return true;
 }
 
-bool deserialize_draw_rectangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+bool mgpu_deserialize_draw_rectangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     if (size < 10 + mgpu_color_bytes_per_pixel()) {
         return false;
     }
 
-    operation->type = Mgpu_Operation_DrawRectangle;
     operation->drawRectangle.textureId = bytes[1];
     operation->drawRectangle.startX = ((uint16_t) bytes[2] << 8) | bytes[3];
     operation->drawRectangle.startY = ((uint16_t) bytes[4] << 8) | bytes[5];
@@ -43,12 +48,11 @@ bool deserialize_draw_rectangle(const uint8_t bytes[], size_t size, Mgpu_Operati
     return true;
 }
 
-bool deserialize_draw_triangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+bool mgpu_deserialize_draw_triangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     if (size < 14 + mgpu_color_bytes_per_pixel()) {
         return false;
     }
 
-    operation->type = Mgpu_Operation_DrawTriangle;
     operation->drawTriangle.textureId = bytes[1];
     operation->drawTriangle.x0 = ((uint16_t) bytes[2] << 8) | bytes[3];
     operation->drawTriangle.y0 = ((uint16_t) bytes[4] << 8) | bytes[5];
@@ -63,31 +67,22 @@ bool deserialize_draw_triangle(const uint8_t bytes[], size_t size, Mgpu_Operatio
     return true;
 }
 
-bool deserialize_present_framebuffer(Mgpu_Operation *operation) {
-    operation->type = Mgpu_Operation_PresentFramebuffer;
+bool mgpu_deserialize_get_texture_usage(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->requestId = deserialize_request_id(bytes, size, 1);
     return true;
 }
 
-bool deserialize_reset(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
-    // Require magic bytes just to ensure the reset request was valid and wasn't caused
-    // by an incorrect read.
-    if (size < 4 || bytes[1] != 0x09 || bytes[2] != 0x13 || bytes[3] != 0xac) {
-        return false;
-    }
-
-    operation->type = Mgpu_Operation_Reset;
+bool mgpu_deserialize_present_framebuffer(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     return true;
 }
 
-bool deserialize_batch(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
-    if (size < 3) {
-        char *msg = mgpu_message_get_pointer();
-        assert(msg != NULL);
-
-        snprintf(msg, MESSAGE_MAX_LEN, "Batch message had too few characters (size %zu)", size);
-        return false;
-    }
+bool mgpu_deserialize_reset(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    // Require magic bytes just to ensure the reset request was valid and wasn't caused
+    // by an incorrect read.
+    return bytes[1] == 0x09 && bytes[2] == 0x13 && bytes[3] == 0xac;
+}
 
+bool mgpu_deserialize_batch(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     uint16_t innerSize = (bytes[1] << 8) | bytes[2];
     if (innerSize > size - 3) {
         char *msg = mgpu_message_get_pointer();
@@ -97,7 +92,6 @@ bool deserialize_batch(const uint8_t bytes[], size_t size, Mgpu_Operation *opera
         return false;
     }
 
-    operation->type = Mgpu_Operation_Batch;
     operation->batchOperation.byteLength = innerSize;
 
     // This should be ok as the operation should not be used by the time
@@ -107,12 +101,11 @@ bool deserialize_batch(const uint8_t bytes[], size_t size, Mgpu_Operation *opera
     return true;
 }
 
-bool deserialize_define_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+bool mgpu_deserialize_define_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     if (size < 6 + mgpu_color_bytes_per_pixel()) {
         return false;
     }
 
-    operation->type = Mgpu_Operation_DefineTexture;
     operation->defineTexture.textureId = bytes[1];
     operation->defineTexture.width = ((uint16_t) bytes[2] << 8) | bytes[3];
     operation->defineTexture.height = ((uint16_t) bytes[4] << 8) | bytes[5];
@@ -120,15 +113,14 @@ bool deserialize_define_texture(const uint8_t bytes[], size_t size, Mgpu_Operati
     size_t nextByteIndex;
     operation->defineTexture.transparentColor = mgpu_color_deserialize(bytes, 6, &nextByteIndex);
 
+    // Flags are optional, as older clients don't send them
+    uint8_t flags = nextByteIndex < size ? bytes[nextByteIndex] : 0;
+    operation->defineTexture.isCacheable = flags & 0x01;
+
     return true;
 }
 
-bool deserialize_append_pixels(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
-    if (size < 4) {
-        return false;
-    }
-
-    operation->type = Mgpu_Operation_AppendTexturePixels;
+bool mgpu_deserialize_append_pixels(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     operation->appendTexturePixels.textureId = bytes[1];
     operation->appendTexturePixels.pixelCount = ((uint16_t) bytes[2] << 8) | bytes[3];
 
@@ -154,12 +146,7 @@ bool deserialize_append_pixels(const uint8_t bytes[], size_t size, Mgpu_Operatio
     return true;
 }
 
-bool deserialize_draw_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
-    if (size < 16) {
-        return false;
-    }
-
-    operation->type = Mgpu_Operation_DrawTexture;
+bool mgpu_deserialize_draw_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     operation->drawTexture.sourceTextureId = bytes[1];
     operation->drawTexture.targetTextureId = bytes[2];
     operation->drawTexture.sourceStartX = ((uint16_t) bytes[3] << 8) | bytes[4];
@@ -173,17 +160,95 @@ bool deserialize_draw_texture(const uint8_t bytes[], size_t size, Mgpu_Operation
     operation->drawTexture.targetStartY = (int16_t) (((int16_t) bytes[13] << 8) | bytes[14]);
 
     // Flags
-    operation->drawTexture.ignoreTransparency = bytes[15] & 0x01;
+    operation->drawTexture.ignoreTransparency = bytes[15] & MGPU_DRAW_TEXTURE_IGNORE_TRANSPARENCY;
+    operation->drawTexture.flipHorizontally = bytes[15] & MGPU_DRAW_TEXTURE_FLIP_HORIZONTALLY;
+    operation->drawTexture.flipVertically = bytes[15] & MGPU_DRAW_TEXTURE_FLIP_VERTICALLY;
 
     return true;
 }
 
-bool deserialize_draw_chars(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+bool mgpu_deserialize_draw_texture_instanced(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    Mgpu_DrawTextureInstancedOperation *instanced = &operation->drawTextureInstanced;
+    instanced->sourceTextureId = bytes[1];
+    instanced->targetTextureId = bytes[2];
+    instanced->sourceStartX = ((uint16_t) bytes[3] << 8) | bytes[4];
+    instanced->sourceStartY = ((uint16_t) bytes[5] << 8) | bytes[6];
+    instanced->sourceWidth = ((uint16_t) bytes[7] << 8) | bytes[8];
+    instanced->sourceHeight = ((uint16_t) bytes[9] << 8) | bytes[10];
+    instanced->flags = bytes[11];
+    instanced->instanceCount = ((uint16_t) bytes[12] << 8) | bytes[13];
+    instanced->instances = bytes + 14;
+
+    size_t instanceSize = instanced->flags & MGPU_DRAW_TEXTURE_INSTANCE_FLAGS ? 5 : 4;
+    if (14 + instanced->instanceCount * instanceSize > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Instanced texture draw had %u instances, but only %zu bytes were provided for them",
+                 instanced->instanceCount,
+                 size - 14);
+
+        return false;
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_define_sub_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->defineSubTexture.subTextureId = ((uint16_t) bytes[1] << 8) | bytes[2];
+    operation->defineSubTexture.textureId = bytes[3];
+    operation->defineSubTexture.x = ((uint16_t) bytes[4] << 8) | bytes[5];
+    operation->defineSubTexture.y = ((uint16_t) bytes[6] << 8) | bytes[7];
+    operation->defineSubTexture.width = ((uint16_t) bytes[8] << 8) | bytes[9];
+    operation->defineSubTexture.height = ((uint16_t) bytes[10] << 8) | bytes[11];
+
+    return true;
+}
+
+bool mgpu_deserialize_draw_sub_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->drawSubTexture.subTextureId = ((uint16_t) bytes[1] << 8) | bytes[2];
+    operation->drawSubTexture.targetTextureId = bytes[3];
+    operation->drawSubTexture.targetStartX = (int16_t) (((int16_t) bytes[4] << 8) | bytes[5]);
+    operation->drawSubTexture.targetStartY = (int16_t) (((int16_t) bytes[6] << 8) | bytes[7]);
+
+    // Flags
+    operation->drawSubTexture.ignoreTransparency = bytes[8] & 0x01;
+
+    return true;
+}
+
+bool mgpu_deserialize_negotiate_framing(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->negotiateFraming.version = bytes[1];
+    operation->requestId = deserialize_request_id(bytes, size, 2);
+
+    return true;
+}
+
+bool mgpu_deserialize_insert_fence(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->insertFence.value = ((uint32_t) bytes[1] << 24) |
+                                   ((uint32_t) bytes[2] << 16) |
+                                   ((uint32_t) bytes[3] << 8) |
+                                   bytes[4];
+
+    return true;
+}
+
+bool mgpu_deserialize_query_fence(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->requestId = deserialize_request_id(bytes, size, 1);
+    return true;
+}
+
+bool mgpu_deserialize_enable_credits(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    return true;
+}
+
+bool mgpu_deserialize_draw_chars(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
     if (size < 6 + mgpu_color_bytes_per_pixel()) {
         return false;
     }
 
-    operation->type = Mgpu_Operation_DrawChars;
     operation->drawChars.fontId = bytes[1];
     operation->drawChars.textureId = bytes[2];
 
@@ -194,6 +259,259 @@ bool deserialize_draw_chars(const uint8_t bytes[], size_t size, Mgpu_Operation *
     operation->drawChars.numCharacters = bytes[nextByteIndex + 4];
     operation->drawChars.characters = bytes + nextByteIndex + 5;
 
+    if (nextByteIndex + 5 + operation->drawChars.numCharacters > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Draw chars op had %u characters, but only %u bytes were provided",
+                 operation->drawChars.numCharacters,
+                 (int) (size - nextByteIndex - 5));
+
+        return false;
+    }
+
+    // The background color is optional, and only there when it follows the characters
+    size_t backgroundIndex = nextByteIndex + 5 + operation->drawChars.numCharacters;
+    operation->drawChars.hasBackground = size >= backgroundIndex + mgpu_color_bytes_per_pixel();
+    if (operation->drawChars.hasBackground) {
+        operation->drawChars.backgroundColor = mgpu_color_deserialize(bytes, backgroundIndex, &nextByteIndex);
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_set_draw_state(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    Mgpu_SetDrawStateOperation *setDrawState = &operation->setDrawState;
+    setDrawState->fields = bytes[1];
+
+    size_t index = 2;
+    if (setDrawState->fields & MGPU_DRAW_STATE_TARGET) {
+        if (size < index + 1) {
+            return false;
+        }
+
+        setDrawState->targetTextureId = bytes[index++];
+    }
+
+    if (setDrawState->fields & MGPU_DRAW_STATE_COLOR) {
+        if (size < index + mgpu_color_bytes_per_pixel()) {
+            return false;
+        }
+
+        setDrawState->color = mgpu_color_deserialize(bytes, index, &index);
+    }
+
+    if (setDrawState->fields & MGPU_DRAW_STATE_FONT) {
+        if (size < index + 1) {
+            return false;
+        }
+
+        setDrawState->fontId = bytes[index++];
+    }
+
+    if (setDrawState->fields & MGPU_DRAW_STATE_ORIGIN) {
+        if (size < index + 4) {
+            return false;
+        }
+
+        setDrawState->originX = ((uint16_t) bytes[index] << 8) | bytes[index + 1];
+        setDrawState->originY = ((uint16_t) bytes[index + 2] << 8) | bytes[index + 3];
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_draw_state_rectangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->drawRectangle.startX = ((uint16_t) bytes[1] << 8) | bytes[2];
+    operation->drawRectangle.startY = ((uint16_t) bytes[3] << 8) | bytes[4];
+    operation->drawRectangle.width = ((uint16_t) bytes[5] << 8) | bytes[6];
+    operation->drawRectangle.height = ((uint16_t) bytes[7] << 8) | bytes[8];
+
+    return true;
+}
+
+bool mgpu_deserialize_draw_state_triangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->drawTriangle.x0 = ((uint16_t) bytes[1] << 8) | bytes[2];
+    operation->drawTriangle.y0 = ((uint16_t) bytes[3] << 8) | bytes[4];
+    operation->drawTriangle.x1 = ((uint16_t) bytes[5] << 8) | bytes[6];
+    operation->drawTriangle.y1 = ((uint16_t) bytes[7] << 8) | bytes[8];
+    operation->drawTriangle.x2 = ((uint16_t) bytes[9] << 8) | bytes[10];
+    operation->drawTriangle.y2 = ((uint16_t) bytes[11] << 8) | bytes[12];
+
+    return true;
+}
+
+bool mgpu_deserialize_draw_state_chars(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->drawChars.startX = ((uint16_t) bytes[1] << 8) | bytes[2];
+    operation->drawChars.startY = ((uint16_t) bytes[3] << 8) | bytes[4];
+    operation->drawChars.numCharacters = bytes[5];
+    operation->drawChars.characters = bytes + 6;
+    operation->drawChars.hasBackground = false;
+
+    if (6 + operation->drawChars.numCharacters > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Draw chars op had %u characters, but only %u bytes were provided",
+                 operation->drawChars.numCharacters,
+                 (int) (size - 6));
+
+        return false;
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_define_font(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    Mgpu_DefineFontOperation *defineFont = &operation->defineFont;
+    defineFont->fontId = bytes[1];
+    defineFont->height = bytes[2];
+    defineFont->firstCharacter = bytes[3];
+    defineFont->characterCount = bytes[4];
+    defineFont->bitmapSize = ((uint16_t) bytes[5] << 8) | bytes[6];
+    defineFont->glyphs = bytes + 7;
+
+    if (7 + (defineFont->characterCount * 3) > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Define font op had %u glyphs, but only %u bytes were provided",
+                 defineFont->characterCount,
+                 (int) (size - 7));
+
+        return false;
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_append_font_bitmap(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    Mgpu_AppendFontBitmapOperation *append = &operation->appendFontBitmap;
+    append->fontId = bytes[1];
+    append->byteCount = ((uint16_t) bytes[2] << 8) | bytes[3];
+    append->bytes = bytes + 4;
+
+    if (4 + append->byteCount > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Append to font op had %u bytes, but only %u bytes were provided",
+                 append->byteCount,
+                 (int) (size - 4));
+
+        return false;
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_define_outline_font(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    Mgpu_DefineOutlineFontOperation *defineFont = &operation->defineOutlineFont;
+    defineFont->fontId = bytes[1];
+    defineFont->unitsPerEm = ((uint16_t) bytes[2] << 8) | bytes[3];
+    defineFont->ascent = ((uint16_t) bytes[4] << 8) | bytes[5];
+    defineFont->descent = ((uint16_t) bytes[6] << 8) | bytes[7];
+    defineFont->firstCharacter = bytes[8];
+    defineFont->characterCount = bytes[9];
+    defineFont->outlineSize = ((uint16_t) bytes[10] << 8) | bytes[11];
+    defineFont->glyphs = bytes + 12;
+
+    if (12 + (defineFont->characterCount * 4) > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Define outline font op had %u glyphs, but only %u bytes were provided",
+                 defineFont->characterCount,
+                 (int) (size - 12));
+
+        return false;
+    }
+
+    return true;
+}
+
+bool mgpu_deserialize_define_scaled_font(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    Mgpu_DefineScaledFontOperation *defineFont = &operation->defineScaledFont;
+    defineFont->fontId = bytes[1];
+    defineFont->outlineFontId = bytes[2];
+    defineFont->pixelSize = bytes[3];
+    defineFont->firstCharacter = bytes[4];
+    defineFont->characterCount = bytes[5];
+
+    return true;
+}
+
+bool mgpu_deserialize_get_stats(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    operation->getStats.firstType = bytes[1];
+    operation->getStats.reset = bytes[2] & MGPU_GET_STATS_RESET;
+    operation->requestId = deserialize_request_id(bytes, size, 3);
+
+    return true;
+}
+
+bool mgpu_deserialize_draw_text_box(const uint8_t bytes[], size_t size, Mgpu_Operation *operation) {
+    if (size < 14 + mgpu_color_bytes_per_pixel()) {
+        return false;
+    }
+
+    Mgpu_DrawTextBoxOperation *textBox = &operation->drawTextBox;
+    textBox->fontId = bytes[1];
+    textBox->textureId = bytes[2];
+
+    size_t nextByteIndex;
+    textBox->color = mgpu_color_deserialize(bytes, 3, &nextByteIndex);
+    const uint8_t *fields = bytes + nextByteIndex;
+    textBox->startX = ((uint16_t) fields[0] << 8) | fields[1];
+    textBox->startY = ((uint16_t) fields[2] << 8) | fields[3];
+    textBox->width = ((uint16_t) fields[4] << 8) | fields[5];
+    textBox->height = ((uint16_t) fields[6] << 8) | fields[7];
+    textBox->horizontalAlignment = fields[8] & 0x03;
+    textBox->verticalAlignment = (fields[8] >> 2) & 0x03;
+    textBox->wrap = (fields[8] >> 4) & 0x03;
+    textBox->numCharacters = ((uint16_t) fields[9] << 8) | fields[10];
+    textBox->characters = fields + 11;
+
+    if (textBox->horizontalAlignment > MGPU_TEXT_ALIGN_END ||
+        textBox->verticalAlignment > MGPU_TEXT_ALIGN_END ||
+        textBox->wrap > MGPU_TEXT_WRAP_CHARACTERS) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Draw text box op had an invalid flags byte of 0x%02x", fields[8]);
+        return false;
+    }
+
+    size_t charactersIndex = nextByteIndex + 11;
+    if (charactersIndex + textBox->numCharacters > size) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Draw text box op had %u characters, but only %u bytes were provided",
+                 textBox->numCharacters,
+                 (int) (size - charactersIndex));
+
+        return false;
+    }
+
+    // Like with DrawChars, the background color is optional and follows the characters
+    size_t backgroundIndex = charactersIndex + textBox->numCharacters;
+    textBox->hasBackground = size >= backgroundIndex + mgpu_color_bytes_per_pixel();
+    if (textBox->hasBackground) {
+        textBox->backgroundColor = mgpu_color_deserialize(bytes, backgroundIndex, &nextByteIndex);
+    }
+
     return true;
 }
 
@@ -206,49 +524,92 @@ bool mgpu_operation_deserialize(const uint8_t bytes[], size_t size, Mgpu_Operati
         return false;
     }
 
-    switch (bytes[0]) {
-        case Mgpu_Operation_Initialize:
-            return deserialize_initialize_op(bytes, size, operation);
+    const Mgpu_OperationDescriptor *descriptor = mgpu_operation_get_descriptor(bytes[0]);
+    if (descriptor == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
 
-        case Mgpu_Operation_GetStatus:
-            return deserialize_status_op(operation);
+        snprintf(msg, MESSAGE_MAX_LEN, "Operation id %u is not a known operation id", bytes[0]);
+        return false;
+    }
+
+    if (size < descriptor->minimumSize) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Operation id %u needs at least %u bytes, but only %zu were provided",
+                 bytes[0],
+                 descriptor->minimumSize,
+                 size);
 
-        case Mgpu_Operation_GetLastMessage:
-            return deserialize_last_message_op(operation);
+        return false;
+    }
 
-        case Mgpu_Operation_DrawRectangle:
-            return deserialize_draw_rectangle(bytes, size, operation);
+    operation->type = bytes[0];
+    operation->requestId = 0;
+    operation->serializedSize = size > UINT16_MAX ? UINT16_MAX : size;
+    if (bytes[0] >= MGPU_CUSTOM_OPERATION_FIRST_ID) {
+        // This should be ok as the operation should not be used by the time
+        // the next databus operation occurs.
+        operation->custom.bytes = bytes + 1;
+        operation->custom.size = size - 1;
+    }
 
-        case Mgpu_Operation_DrawTriangle:
-            return deserialize_draw_triangle(bytes, size, operation);
+    return descriptor->deserializeFn == NULL || descriptor->deserializeFn(bytes, size, operation);
+}
 
-        case Mgpu_Operation_PresentFramebuffer:
-            return deserialize_present_framebuffer(operation);
+size_t mgpu_operation_get_payload(Mgpu_Operation *operation, const uint8_t ***payloadField) {
+    assert(operation != NULL);
+    assert(payloadField != NULL);
 
+    switch (operation->type) {
         case Mgpu_Operation_Batch:
-            return deserialize_batch(bytes, size, operation);
+        case Mgpu_Operation_CompactBatch:
+            *payloadField = &operation->batchOperation.bytes;
+            return operation->batchOperation.byteLength;
 
-        case Mgpu_Operation_Reset:
-            return deserialize_reset(bytes, size, operation);
+        case Mgpu_Operation_AppendTexturePixels:
+            *payloadField = &operation->appendTexturePixels.pixelBytes;
+            return operation->appendTexturePixels.pixelCount * mgpu_color_bytes_per_pixel();
 
-        case Mgpu_Operation_DefineTexture:
-            return deserialize_define_texture(bytes, size, operation);
+        case Mgpu_Operation_DrawTextureInstanced: {
+            Mgpu_DrawTextureInstancedOperation *instanced = &operation->drawTextureInstanced;
+            *payloadField = &instanced->instances;
+            return instanced->instanceCount * (instanced->flags & MGPU_DRAW_TEXTURE_INSTANCE_FLAGS ? 5 : 4);
+        }
 
-        case Mgpu_Operation_AppendTexturePixels:
-            return deserialize_append_pixels(bytes, size, operation);
+        case Mgpu_Operation_DefineFont:
+            *payloadField = &operation->defineFont.glyphs;
+            return operation->defineFont.characterCount * 3;
 
-        case Mgpu_Operation_DrawTexture:
-            return deserialize_draw_texture(bytes, size, operation);
+        case Mgpu_Operation_AppendFontBitmap:
+            *payloadField = &operation->appendFontBitmap.bytes;
+            return operation->appendFontBitmap.byteCount;
 
-        case Mgpu_Operation_DrawChars:
-            return deserialize_draw_chars(bytes, size, operation);
+        case Mgpu_Operation_DefineOutlineFont:
+            *payloadField = &operation->defineOutlineFont.glyphs;
+            return operation->defineOutlineFont.characterCount * 4;
 
-        default: {
-            char *msg = mgpu_message_get_pointer();
-            assert(msg != NULL);
+        case Mgpu_Operation_DrawTextBox:
+            *payloadField = &operation->drawTextBox.characters;
+            return operation->drawTextBox.numCharacters;
 
-            snprintf(msg, MESSAGE_MAX_LEN, "Operation id %u is not a known operation id", bytes[0]);
-            return false;
-        }
+        case Mgpu_Operation_DrawChars:
+        case Mgpu_Operation_DrawStateChars:
+            *payloadField = &operation->drawChars.characters;
+            return operation->drawChars.numCharacters;
+
+        default:
+            // Unknown ids fall through to here too, and their union holds whatever was left in it
+            if (operation->type >= MGPU_CUSTOM_OPERATION_FIRST_ID &&
+                mgpu_operation_get_descriptor(operation->type) != NULL) {
+                *payloadField = &operation->custom.bytes;
+                return operation->custom.size;
+            }
+
+            *payloadField = NULL;
+            return 0;
     }
 }
@@ -9,3 +9,49 @@
  * true if the deserialization was successful, or false if deserialization fails.
  */
 bool mgpu_operation_deserialize(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+
+/*
+ * Some operations reference variable length data (e.g. batch contents or texture pixels) by pointing
+ * directly into the bytes the operation was deserialized from. Returns how many bytes of such data the
+ * operation references, and sets `payloadField` to the operation's field holding that pointer. This
+ * allows callers that need the operation to outlive its source bytes to copy the data elsewhere and
+ * re-point the operation at the copy.
+ *
+ * Returns zero, and sets `payloadField` to NULL, for operations that don't reference any such data.
+ */
+size_t mgpu_operation_get_payload(Mgpu_Operation *operation, const uint8_t ***payloadField);
+
+/*
+ * Deserializers for the built-in operations, used by their operation descriptors. Each one is
+ * only called with at least as many bytes as its descriptor's minimum size.
+ */
+bool mgpu_deserialize_initialize(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_rectangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_triangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_get_status(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_get_last_message(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_present_framebuffer(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_batch(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_define_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_append_pixels(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_chars(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_get_texture_usage(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_define_sub_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_sub_texture(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_negotiate_framing(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_insert_fence(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_query_fence(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_enable_credits(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_set_draw_state(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_state_rectangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_state_triangle(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_state_chars(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_texture_instanced(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_define_font(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_append_font_bitmap(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_draw_text_box(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_define_outline_font(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_define_scaled_font(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_get_stats(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+bool mgpu_deserialize_reset(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
@@ -1,26 +1,47 @@
 #include <stdio.h>
+#include "microgpu-common/common.h"
 #include "microgpu-common/messages.h"
+#include "microgpu-common/fonts/glyph_cache.h"
 #include "operations.h"
-#include "microgpu-common/operations/execution/batch.h"
-#include "microgpu-common/operations/execution/drawing/rectangle.h"
-#include "microgpu-common/operations/execution/drawing/triangle.h"
-#include "microgpu-common/operations/execution/fonts.h"
-#include "microgpu-common/operations/execution/get_last_message.h"
-#include "microgpu-common/operations/execution/present_framebuffer.h"
-#include "microgpu-common/operations/execution/reset.h"
-#include "microgpu-common/operations/execution//status.h"
+#include "operation_execution.h"
+#include "operation_registry.h"
+#include "operation_stats.h"
+#include "microgpu-common/operations/execution/drawing/draw_operation.h"
+#include "microgpu-common/operations/execution/draw_state.h"
 #include "microgpu-common/operations/execution/textures.h"
 
-void mgpu_execute_operation(Mgpu_Operation *operation,
-                            Mgpu_Display *display,
-                            Mgpu_Databus *databus,
-                            bool *resetFlag,
-                            Mgpu_TextureManager *textureManager) {
-    assert(operation != NULL);
-    assert(display != NULL);
-    assert(databus != NULL);
-    assert(textureManager != NULL);
+static Mgpu_DrawDispatcher drawDispatcher = {0};
+
+void mgpu_execute_set_draw_dispatcher(const Mgpu_DrawDispatcher *dispatcher) {
+    if (dispatcher != NULL) {
+        assert(dispatcher->submitFn != NULL);
+        assert(dispatcher->flushFn != NULL);
+        drawDispatcher = *dispatcher;
+    } else {
+        drawDispatcher = (Mgpu_DrawDispatcher) {0};
+    }
+}
 
+#ifndef MGPU_OMIT_OPERATION_STATS
+static uint32_t get_pixels_touched(Mgpu_Operation *operation, Mgpu_TextureManager *textureManager) {
+    uint8_t targetTextureId;
+    Mgpu_DrawBounds bounds;
+    if (!mgpu_draw_operation_get_bounds(operation, textureManager, &targetTextureId, &bounds) ||
+        bounds.right <= bounds.left ||
+        bounds.bottom <= bounds.top) {
+        return 0;
+    }
+
+    return (uint32_t) (bounds.right - bounds.left) * (bounds.bottom - bounds.top);
+}
+#endif
+
+static void execute(Mgpu_Operation *operation,
+                    Mgpu_Display *display,
+                    Mgpu_Databus *databus,
+                    bool *resetFlag,
+                    Mgpu_TextureManager *textureManager,
+                    uint32_t *pixelsTouched) {
     // Don't clear the last operation's message if the next operation
     // being requested is to get the latest message
     if (operation->type != Mgpu_Operation_GetLastMessage) {
@@ -29,61 +50,93 @@ void mgpu_execute_operation(Mgpu_Operation *operation,
         message[0] = '\0';
     }
 
-    switch (operation->type) {
-        case Mgpu_Operation_DrawRectangle:
-            mgpu_draw_rectangle(&operation->drawRectangle, textureManager);
-            break;
-
-        case Mgpu_Operation_DrawTriangle:
-            mgpu_draw_triangle(&operation->drawTriangle, textureManager);
-            break;
-
-        case Mgpu_Operation_GetStatus:
-            mgpu_exec_status_op(display, textureManager, databus);
-            break;
-
-        case Mgpu_Operation_GetLastMessage:
-            mgpu_exec_get_last_message(databus);
-            break;
-
-        case Mgpu_Operation_PresentFramebuffer:
-            mgpu_exec_present_framebuffer(display, textureManager);
-            break;
-
-        case Mgpu_Operation_Batch:
-            mgpu_exec_batch(&operation->batchOperation,
-                            display,
-                            databus,
-                            resetFlag,
-                            textureManager);
-            break;
-
-        case Mgpu_Operation_Reset:
-            mgpu_exec_reset(resetFlag);
-            break;
-
-        case Mgpu_Operation_DefineTexture:
-            mgpu_exec_texture_define(textureManager, &operation->defineTexture);
-            break;
-
-        case Mgpu_Operation_AppendTexturePixels:
-            mgpu_exec_texture_append(textureManager, &operation->appendTexturePixels);
-            break;
-
-        case Mgpu_Operation_DrawTexture:
-            mgpu_exec_texture_draw(textureManager, &operation->drawTexture);
-            break;
-
-        case Mgpu_Operation_DrawChars:
-            mgpu_exec_font_draw(textureManager, &operation->drawChars);
-            break;
-
-        default: {
-            char *message = mgpu_message_get_pointer();
-            assert(message != NULL);
-            snprintf(message, MESSAGE_MAX_LEN, "Cannot execute operation of type %u", operation->type);
-
-            break;
+#ifndef MGPU_OMIT_OPERATION_SUB_TEXTURES
+    if (operation->type == Mgpu_Operation_DrawSubTexture &&
+        !mgpu_exec_sub_texture_resolve(textureManager, operation)) {
+        return;
+    }
+#endif
+
+    mgpu_exec_draw_state_resolve(operation);
+
+    const Mgpu_OperationDescriptor *descriptor = mgpu_operation_get_descriptor(operation->type);
+    if (descriptor == NULL || descriptor->executeFn == NULL) {
+        char *message = mgpu_message_get_pointer();
+        assert(message != NULL);
+        snprintf(message, MESSAGE_MAX_LEN, "Cannot execute operation of type %u", operation->type);
+
+        return;
+    }
+
+    // Marked before drawing is dispatched, since deferred drawing may not happen until after
+    // later operations have already picked textures to evict
+    if (operation->type == Mgpu_Operation_DrawTexture) {
+        mgpu_texture_mark_used(textureManager, operation->drawTexture.sourceTextureId);
+    }
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+    // Glyphs are only added to the cache from this thread, since deferred text may be drawn on others
+    if (operation->type == Mgpu_Operation_DrawChars) {
+        mgpu_glyph_cache_add(operation->drawChars.fontId,
+                             operation->drawChars.characters,
+                             operation->drawChars.numCharacters);
+    }
+
+    if (operation->type == Mgpu_Operation_DrawTextBox) {
+        const Mgpu_DrawTextBoxOperation *textBox = &operation->drawTextBox;
+        for (uint16_t index = 0; index < textBox->numCharacters; index += UINT8_MAX) {
+            uint8_t count = min(textBox->numCharacters - index, UINT8_MAX);
+            mgpu_glyph_cache_add(textBox->fontId, textBox->characters + index, count);
+        }
+    }
+#endif
+
+#ifndef MGPU_OMIT_OPERATION_STATS
+    *pixelsTouched = get_pixels_touched(operation, textureManager);
+#endif
+
+    if (drawDispatcher.submitFn != NULL && !descriptor->skipsDrawFlush) {
+        if (drawDispatcher.submitFn(drawDispatcher.context, operation, textureManager)) {
+            return;
         }
+
+        // Anything submitted before this operation has to be visible to it, such as the
+        // framebuffer being complete before it's presented.
+        drawDispatcher.flushFn(drawDispatcher.context, textureManager);
     }
+
+    Mgpu_ExecutionContext context = {
+            .display = display,
+            .databus = databus,
+            .textureManager = textureManager,
+            .resetFlag = resetFlag,
+            .drawsAreDispatched = drawDispatcher.submitFn != NULL,
+    };
+
+    descriptor->executeFn(operation, &context);
+}
+
+void mgpu_execute_operation(Mgpu_Operation *operation,
+                            Mgpu_Display *display,
+                            Mgpu_Databus *databus,
+                            bool *resetFlag,
+                            Mgpu_TextureManager *textureManager) {
+    assert(operation != NULL);
+    assert(display != NULL);
+    assert(databus != NULL);
+    assert(textureManager != NULL);
+
+    uint32_t pixelsTouched = 0;
+
+#ifndef MGPU_OMIT_OPERATION_STATS
+    // Captured first, since resolving draw state and sub-textures changes the operation's type
+    uint8_t type = operation->type;
+    uint16_t bytesDecoded = operation->serializedSize;
+    uint32_t startedAt = mgpu_operation_stats_now();
+
+    execute(operation, display, databus, resetFlag, textureManager, &pixelsTouched);
+    mgpu_operation_stats_record(type, startedAt, pixelsTouched, bytesDecoded);
+#else
+    execute(operation, display, databus, resetFlag, textureManager, &pixelsTouched);
+#endif
 }
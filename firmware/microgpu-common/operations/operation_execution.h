@@ -14,3 +14,30 @@ void mgpu_execute_operation(Mgpu_Operation *operation,
                             Mgpu_Databus *databus,
                             bool *resetFlag,
                             Mgpu_TextureManager *textureManager);
+
+/*
+ * Allows drawing operations to be handed off and rasterized somewhere other than the thread
+ * executing operations.
+ */
+typedef struct {
+    void *context;
+
+    /*
+     * Called for every operation that might read or write texture pixels. Returns true if the
+     * dispatcher took responsibility for the operation. If false is returned, then `flushFn` is
+     * called and the operation is executed normally.
+     */
+    bool (*submitFn)(void *context, Mgpu_Operation *operation, Mgpu_TextureManager *textureManager);
+
+    /*
+     * Must block until every previously submitted operation has been fully rasterized.
+     */
+    void (*flushFn)(void *context, Mgpu_TextureManager *textureManager);
+} Mgpu_DrawDispatcher;
+
+/*
+ * Sets the dispatcher all later operations will be submitted to. Passing NULL removes the
+ * current dispatcher, so all operations are executed directly. Any operations previously
+ * submitted to the current dispatcher must be flushed before it's replaced.
+ */
+void mgpu_execute_set_draw_dispatcher(const Mgpu_DrawDispatcher *dispatcher);
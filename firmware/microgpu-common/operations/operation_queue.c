@@ -0,0 +1,172 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "microgpu-common/messages.h"
+#include "operation_deserializer.h"
+#include "operation_queue.h"
+
+typedef struct {
+    Mgpu_Operation operation;
+
+    /*
+     * The arena position the consumer can release up to once this operation is popped
+     */
+    size_t payloadEnd;
+} Slot;
+
+struct Mgpu_OperationQueue {
+    const Mgpu_Allocator *allocator;
+    Slot *slots;
+    uint32_t slotMask;
+    uint8_t *payloadArena;
+    size_t payloadArenaSize;
+
+    /*
+     * Arena positions are ever-increasing byte counters, and are only wrapped to the arena's
+     * size when indexing into it. This keeps used space as `head - tail` without ambiguity
+     * between a full and empty arena.
+     */
+    size_t payloadHead; // Only touched by the producer
+    atomic_size_t payloadTail;
+
+    atomic_uint_fast32_t writeIndex;
+    atomic_uint_fast32_t readIndex;
+};
+
+Mgpu_OperationQueue *mgpu_operation_queue_new(const Mgpu_Allocator *allocator,
+                                              uint16_t operationCapacity,
+                                              size_t payloadArenaSize) {
+    mgpu_alloc_assert(allocator);
+    assert(operationCapacity > 0);
+    assert((operationCapacity & (operationCapacity - 1)) == 0); // must be a power of two
+    assert(payloadArenaSize > 0);
+
+    Mgpu_OperationQueue *queue = allocator->FastMemAllocateFn(sizeof(Mgpu_OperationQueue));
+    if (queue == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate operation queue", MESSAGE_MAX_LEN);
+
+        return NULL;
+    }
+
+    memset(queue, 0, sizeof(Mgpu_OperationQueue));
+    queue->allocator = allocator;
+    queue->slotMask = operationCapacity - 1;
+    queue->payloadArenaSize = payloadArenaSize;
+    atomic_init(&queue->payloadTail, 0);
+    atomic_init(&queue->writeIndex, 0);
+    atomic_init(&queue->readIndex, 0);
+
+    queue->slots = allocator->FastMemAllocateFn(sizeof(Slot) * operationCapacity);
+    queue->payloadArena = allocator->FastMemAllocateFn(payloadArenaSize);
+    if (queue->slots == NULL || queue->payloadArena == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Failed to allocate operation queue with %u slots and a %zu byte arena",
+                 operationCapacity,
+                 payloadArenaSize);
+
+        mgpu_operation_queue_free(queue);
+        return NULL;
+    }
+
+    return queue;
+}
+
+void mgpu_operation_queue_free(Mgpu_OperationQueue *queue) {
+    if (queue != NULL) {
+        if (queue->slots != NULL) {
+            queue->allocator->FastMemFreeFn(queue->slots);
+        }
+
+        if (queue->payloadArena != NULL) {
+            queue->allocator->FastMemFreeFn(queue->payloadArena);
+        }
+
+        queue->allocator->FastMemFreeFn(queue);
+    }
+}
+
+Mgpu_OperationQueuePushResult mgpu_operation_queue_try_push(Mgpu_OperationQueue *queue,
+                                                            const Mgpu_Operation *operation) {
+    assert(queue != NULL);
+    assert(operation != NULL);
+
+    uint32_t writeIndex = atomic_load_explicit(&queue->writeIndex, memory_order_relaxed);
+    uint32_t readIndex = atomic_load_explicit(&queue->readIndex, memory_order_acquire);
+    if (writeIndex - readIndex > queue->slotMask) {
+        return Mgpu_OperationQueue_Full;
+    }
+
+    Slot *slot = &queue->slots[writeIndex & queue->slotMask];
+    slot->operation = *operation;
+
+    const uint8_t **payloadField;
+    size_t payloadSize = mgpu_operation_get_payload(&slot->operation, &payloadField);
+    size_t head = queue->payloadHead;
+    if (payloadSize > 0) {
+        if (payloadSize > queue->payloadArenaSize) {
+            return Mgpu_OperationQueue_TooLarge;
+        }
+
+        // Payloads are kept contiguous, so if it won't fit before the end of the arena then
+        // skip the remaining space and start from the beginning.
+        size_t offset = head % queue->payloadArenaSize;
+        if (offset + payloadSize > queue->payloadArenaSize) {
+            head += queue->payloadArenaSize - offset;
+            offset = 0;
+        }
+
+        size_t tail = atomic_load_explicit(&queue->payloadTail, memory_order_acquire);
+        bool arenaIsEmpty = tail == queue->payloadHead;
+        if (!arenaIsEmpty && head + payloadSize - tail > queue->payloadArenaSize) {
+            return Mgpu_OperationQueue_Full;
+        }
+
+        memcpy(queue->payloadArena + offset, *payloadField, payloadSize);
+        *payloadField = queue->payloadArena + offset;
+        head += payloadSize;
+    }
+
+    slot->payloadEnd = head;
+    queue->payloadHead = head;
+    atomic_store_explicit(&queue->writeIndex, writeIndex + 1, memory_order_release);
+
+    return Mgpu_OperationQueue_Pushed;
+}
+
+Mgpu_Operation *mgpu_operation_queue_peek(Mgpu_OperationQueue *queue) {
+    assert(queue != NULL);
+
+    uint32_t readIndex = atomic_load_explicit(&queue->readIndex, memory_order_relaxed);
+    uint32_t writeIndex = atomic_load_explicit(&queue->writeIndex, memory_order_acquire);
+    if (readIndex == writeIndex) {
+        return NULL;
+    }
+
+    return &queue->slots[readIndex & queue->slotMask].operation;
+}
+
+void mgpu_operation_queue_pop(Mgpu_OperationQueue *queue) {
+    assert(queue != NULL);
+
+    uint32_t readIndex = atomic_load_explicit(&queue->readIndex, memory_order_relaxed);
+    assert(readIndex != atomic_load_explicit(&queue->writeIndex, memory_order_acquire));
+
+    Slot *slot = &queue->slots[readIndex & queue->slotMask];
+    atomic_store_explicit(&queue->payloadTail, slot->payloadEnd, memory_order_release);
+    atomic_store_explicit(&queue->readIndex, readIndex + 1, memory_order_release);
+}
+
+bool mgpu_operation_queue_is_empty(Mgpu_OperationQueue *queue) {
+    assert(queue != NULL);
+
+    uint32_t readIndex = atomic_load_explicit(&queue->readIndex, memory_order_acquire);
+    uint32_t writeIndex = atomic_load_explicit(&queue->writeIndex, memory_order_acquire);
+
+    return readIndex == writeIndex;
+}
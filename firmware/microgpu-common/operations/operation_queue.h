@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "microgpu-common/alloc.h"
+#include "operations.h"
+
+/*
+ * A lock-free ring of decoded operations, meant to be pushed to by exactly one thread and
+ * consumed by exactly one (possibly different) thread.
+ *
+ * Any variable length data an operation points to (batch contents, texture pixels, characters)
+ * is copied into a ring-backed arena owned by the queue when the operation is pushed. This means
+ * the source bytes the operation was deserialized from can be re-used as soon as the push returns,
+ * and the operation's pointers stay valid until the consumer pops it.
+ */
+typedef struct Mgpu_OperationQueue Mgpu_OperationQueue;
+
+typedef enum {
+    /*
+     * The operation (and its data) was copied into the queue.
+     */
+    Mgpu_OperationQueue_Pushed,
+
+    /*
+     * There is currently no room for the operation. Pushing it again can succeed once the
+     * consumer has popped some operations.
+     */
+    Mgpu_OperationQueue_Full,
+
+    /*
+     * The operation's data is larger than the queue's whole arena, so it can never be pushed.
+     */
+    Mgpu_OperationQueue_TooLarge,
+} Mgpu_OperationQueuePushResult;
+
+/*
+ * Creates a new operation queue. The number of operations it can hold must be a power of two,
+ * and the arena should be at least as large as the biggest operation the databus can receive.
+ */
+Mgpu_OperationQueue *mgpu_operation_queue_new(const Mgpu_Allocator *allocator,
+                                              uint16_t operationCapacity,
+                                              size_t payloadArenaSize);
+
+/*
+ * Frees the queue and all memory it allocated.
+ */
+void mgpu_operation_queue_free(Mgpu_OperationQueue *queue);
+
+/*
+ * Attempts to copy the operation, and any data it points to, to the end of the queue. Must
+ * only be called from the producing thread.
+ */
+Mgpu_OperationQueuePushResult mgpu_operation_queue_try_push(Mgpu_OperationQueue *queue,
+                                                            const Mgpu_Operation *operation);
+
+/*
+ * Returns the oldest operation in the queue, or NULL if the queue is empty. The operation stays
+ * in the queue, and all of its pointers remain valid, until `mgpu_operation_queue_pop()` is called.
+ * Must only be called from the consuming thread.
+ */
+Mgpu_Operation *mgpu_operation_queue_peek(Mgpu_OperationQueue *queue);
+
+/*
+ * Removes the oldest operation from the queue, releasing its slot and arena space back to the
+ * producer. Must only be called from the consuming thread, and only when the queue isn't empty.
+ */
+void mgpu_operation_queue_pop(Mgpu_OperationQueue *queue);
+
+/*
+ * Returns true if there are no operations waiting to be consumed. Safe to call from either thread.
+ */
+bool mgpu_operation_queue_is_empty(Mgpu_OperationQueue *queue);
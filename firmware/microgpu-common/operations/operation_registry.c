@@ -0,0 +1,415 @@
+#include <assert.h>
+#include <stdio.h>
+#include "microgpu-common/messages.h"
+#include "microgpu-common/operations/execution/batch.h"
+#include "microgpu-common/operations/execution/draw_state.h"
+#include "microgpu-common/operations/execution/fences.h"
+#include "microgpu-common/operations/execution/drawing/rectangle.h"
+#include "microgpu-common/operations/execution/drawing/triangle.h"
+#include "microgpu-common/operations/execution/fonts.h"
+#include "microgpu-common/operations/execution/get_last_message.h"
+#include "microgpu-common/operations/execution/get_stats.h"
+#include "microgpu-common/operations/execution/get_texture_usage.h"
+#include "microgpu-common/operations/execution/present_framebuffer.h"
+#include "microgpu-common/operations/execution/reset.h"
+#include "microgpu-common/operations/execution/status.h"
+#include "microgpu-common/operations/execution/textures.h"
+#include "operation_deserializer.h"
+#include "operation_execution.h"
+#include "operation_registry.h"
+
+#define CUSTOM_OPERATION_COUNT (256 - MGPU_CUSTOM_OPERATION_FIRST_ID)
+
+static void execute_draw_rectangle(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_draw_rectangle(&operation->drawRectangle, context->textureManager);
+}
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_TRIANGLE
+static void execute_draw_triangle(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_draw_triangle(&operation->drawTriangle, context->textureManager);
+}
+#endif
+
+static void execute_get_status(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_status_op(context->display, context->textureManager, context->databus, operation->requestId);
+}
+
+static void execute_get_last_message(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_get_last_message(context->databus, operation->requestId);
+}
+
+static void execute_present_framebuffer(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_present_framebuffer(context->display, context->textureManager);
+}
+
+static void execute_batch(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_batch(&operation->batchOperation,
+                    context->display,
+                    context->databus,
+                    context->resetFlag,
+                    context->textureManager);
+}
+
+static void execute_compact_batch(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_compact_batch(&operation->batchOperation,
+                            context->display,
+                            context->databus,
+                            context->resetFlag,
+                            context->textureManager);
+}
+
+static void execute_define_texture(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_texture_define(context->textureManager, &operation->defineTexture);
+}
+
+static void execute_append_pixels(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_texture_append(context->textureManager, &operation->appendTexturePixels);
+}
+
+static void execute_draw_texture(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_texture_draw(context->textureManager, &operation->drawTexture);
+}
+
+static void execute_draw_texture_instanced(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    Mgpu_DrawTextureInstancedOperation *instanced = &operation->drawTextureInstanced;
+    if (!context->drawsAreDispatched) {
+        mgpu_exec_texture_draw_instanced(context->textureManager, instanced);
+        return;
+    }
+
+    for (uint16_t index = 0; index < instanced->instanceCount; index++) {
+        Mgpu_Operation instance = {.type = Mgpu_Operation_DrawTexture};
+        mgpu_exec_texture_get_instance(instanced, index, &instance.drawTexture);
+        mgpu_execute_operation(&instance,
+                               context->display,
+                               context->databus,
+                               context->resetFlag,
+                               context->textureManager);
+    }
+}
+
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+static void execute_draw_chars(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_font_draw(context->textureManager, &operation->drawChars);
+}
+
+static void execute_define_font(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_font_define(context->textureManager, &operation->defineFont);
+}
+
+static void execute_append_font_bitmap(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_font_append(context->textureManager, &operation->appendFontBitmap);
+}
+
+static void execute_draw_text_box(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_font_draw_text_box(context->textureManager, &operation->drawTextBox);
+}
+
+static void execute_define_outline_font(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_font_define_outline(context->textureManager, &operation->defineOutlineFont);
+}
+
+static void execute_define_scaled_font(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_font_define_scaled(context->textureManager, &operation->defineScaledFont);
+}
+#endif
+
+static void execute_get_texture_usage(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_get_texture_usage(context->textureManager, context->databus, operation->requestId);
+}
+
+#ifndef MGPU_OMIT_OPERATION_STATS
+static void execute_get_stats(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_get_stats(&operation->getStats, context->databus, operation->requestId);
+}
+#endif
+
+#ifndef MGPU_OMIT_OPERATION_SUB_TEXTURES
+static void execute_define_sub_texture(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_sub_texture_define(context->textureManager, &operation->defineSubTexture);
+}
+#endif
+
+static void execute_negotiate_framing(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_databus_negotiate_framing(context->databus, operation->negotiateFraming.version, operation->requestId);
+}
+
+static void execute_insert_fence(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_fence_insert(context->display, operation->insertFence.value);
+}
+
+static void execute_query_fence(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_fence_query(context->display, context->databus, operation->requestId);
+}
+
+static void execute_enable_credits(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    // Databuses that advertise credits start as soon as this is received, since they need
+    // to know where in the stream of received bytes it was.
+}
+
+static void execute_set_draw_state(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_draw_state_set(&operation->setDrawState);
+}
+
+static void execute_reset(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context) {
+    mgpu_exec_reset(context->resetFlag);
+}
+
+/*
+ * Indexed by operation id, so looking up an operation is a single array access. Ids without an
+ * operation have no deserialize function.
+ */
+static const Mgpu_OperationDescriptor builtinOperations[MGPU_CUSTOM_OPERATION_FIRST_ID] = {
+        [Mgpu_Operation_Initialize] = {
+                .id = Mgpu_Operation_Initialize,
+                .minimumSize = 2,
+                .deserializeFn = mgpu_deserialize_initialize,
+        },
+        [Mgpu_Operation_DrawRectangle] = {
+                .id = Mgpu_Operation_DrawRectangle,
+                .minimumSize = 10,
+                .deserializeFn = mgpu_deserialize_draw_rectangle,
+                .executeFn = execute_draw_rectangle,
+        },
+#ifndef MGPU_OMIT_OPERATION_DRAW_TRIANGLE
+        [Mgpu_Operation_DrawTriangle] = {
+                .id = Mgpu_Operation_DrawTriangle,
+                .minimumSize = 14,
+                .deserializeFn = mgpu_deserialize_draw_triangle,
+                .executeFn = execute_draw_triangle,
+        },
+#endif
+        [Mgpu_Operation_GetStatus] = {
+                .id = Mgpu_Operation_GetStatus,
+                .minimumSize = 1,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_get_status,
+                .executeFn = execute_get_status,
+        },
+        [Mgpu_Operation_GetLastMessage] = {
+                .id = Mgpu_Operation_GetLastMessage,
+                .minimumSize = 1,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_get_last_message,
+                .executeFn = execute_get_last_message,
+        },
+        [Mgpu_Operation_PresentFramebuffer] = {
+                .id = Mgpu_Operation_PresentFramebuffer,
+                .minimumSize = 1,
+                .deserializeFn = mgpu_deserialize_present_framebuffer,
+                .executeFn = execute_present_framebuffer,
+        },
+        [Mgpu_Operation_Batch] = {
+                .id = Mgpu_Operation_Batch,
+                .minimumSize = 3,
+                .skipsDrawFlush = true, // Each inner operation is checked individually
+                .deserializeFn = mgpu_deserialize_batch,
+                .executeFn = execute_batch,
+        },
+        [Mgpu_Operation_DefineTexture] = {
+                .id = Mgpu_Operation_DefineTexture,
+                .minimumSize = 6,
+                .deserializeFn = mgpu_deserialize_define_texture,
+                .executeFn = execute_define_texture,
+        },
+        [Mgpu_Operation_AppendTexturePixels] = {
+                .id = Mgpu_Operation_AppendTexturePixels,
+                .minimumSize = 4,
+                .deserializeFn = mgpu_deserialize_append_pixels,
+                .executeFn = execute_append_pixels,
+        },
+        [Mgpu_Operation_DrawTexture] = {
+                .id = Mgpu_Operation_DrawTexture,
+                .minimumSize = 16,
+                .deserializeFn = mgpu_deserialize_draw_texture,
+                .executeFn = execute_draw_texture,
+        },
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+        [Mgpu_Operation_DrawChars] = {
+                .id = Mgpu_Operation_DrawChars,
+                .minimumSize = 6,
+                .deserializeFn = mgpu_deserialize_draw_chars,
+                .executeFn = execute_draw_chars,
+        },
+#endif
+        [Mgpu_Operation_GetTextureUsage] = {
+                .id = Mgpu_Operation_GetTextureUsage,
+                .minimumSize = 1,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_get_texture_usage,
+                .executeFn = execute_get_texture_usage,
+        },
+#ifndef MGPU_OMIT_OPERATION_SUB_TEXTURES
+        [Mgpu_Operation_DefineSubTexture] = {
+                .id = Mgpu_Operation_DefineSubTexture,
+                .minimumSize = 12,
+                .skipsDrawFlush = true, // Draws resolve sub-textures before they're submitted
+                .deserializeFn = mgpu_deserialize_define_sub_texture,
+                .executeFn = execute_define_sub_texture,
+        },
+        [Mgpu_Operation_DrawSubTexture] = {
+                // Resolved into a DrawTexture operation before it's executed
+                .id = Mgpu_Operation_DrawSubTexture,
+                .minimumSize = 9,
+                .deserializeFn = mgpu_deserialize_draw_sub_texture,
+        },
+#endif
+        [Mgpu_Operation_NegotiateFraming] = {
+                .id = Mgpu_Operation_NegotiateFraming,
+                .minimumSize = 2,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_negotiate_framing,
+                .executeFn = execute_negotiate_framing,
+        },
+        [Mgpu_Operation_InsertFence] = {
+                .id = Mgpu_Operation_InsertFence,
+                .minimumSize = 5,
+                .deserializeFn = mgpu_deserialize_insert_fence,
+                .executeFn = execute_insert_fence,
+        },
+        [Mgpu_Operation_QueryFence] = {
+                .id = Mgpu_Operation_QueryFence,
+                .minimumSize = 1,
+                .skipsDrawFlush = true, // Reports what already completed, without waiting on drawing
+                .deserializeFn = mgpu_deserialize_query_fence,
+                .executeFn = execute_query_fence,
+        },
+        [Mgpu_Operation_EnableCredits] = {
+                .id = Mgpu_Operation_EnableCredits,
+                .minimumSize = 1,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_enable_credits,
+                .executeFn = execute_enable_credits,
+        },
+        [Mgpu_Operation_CompactBatch] = {
+                .id = Mgpu_Operation_CompactBatch,
+                .minimumSize = 3,
+                .skipsDrawFlush = true, // Each inner operation is checked individually
+                .deserializeFn = mgpu_deserialize_batch,
+                .executeFn = execute_compact_batch,
+        },
+        [Mgpu_Operation_SetDrawState] = {
+                .id = Mgpu_Operation_SetDrawState,
+                .minimumSize = 2,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_set_draw_state,
+                .executeFn = execute_set_draw_state,
+        },
+
+        // DrawState operations are executed as the full draws they resolve to
+        [Mgpu_Operation_DrawStateRectangle] = {
+                .id = Mgpu_Operation_DrawStateRectangle,
+                .minimumSize = 9,
+                .deserializeFn = mgpu_deserialize_draw_state_rectangle,
+        },
+#ifndef MGPU_OMIT_OPERATION_DRAW_TRIANGLE
+        [Mgpu_Operation_DrawStateTriangle] = {
+                .id = Mgpu_Operation_DrawStateTriangle,
+                .minimumSize = 13,
+                .deserializeFn = mgpu_deserialize_draw_state_triangle,
+        },
+#endif
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+        [Mgpu_Operation_DrawStateChars] = {
+                .id = Mgpu_Operation_DrawStateChars,
+                .minimumSize = 6,
+                .deserializeFn = mgpu_deserialize_draw_state_chars,
+        },
+#endif
+        [Mgpu_Operation_DrawTextureInstanced] = {
+                .id = Mgpu_Operation_DrawTextureInstanced,
+                .minimumSize = 14,
+                .skipsDrawFlush = true, // Dispatched one instance at a time when drawing is dispatched
+                .deserializeFn = mgpu_deserialize_draw_texture_instanced,
+                .executeFn = execute_draw_texture_instanced,
+        },
+#ifndef MGPU_OMIT_OPERATION_DRAW_CHARS
+        [Mgpu_Operation_DefineFont] = {
+                .id = Mgpu_Operation_DefineFont,
+                .minimumSize = 7,
+                .deserializeFn = mgpu_deserialize_define_font,
+                .executeFn = execute_define_font,
+        },
+        [Mgpu_Operation_AppendFontBitmap] = {
+                .id = Mgpu_Operation_AppendFontBitmap,
+                .minimumSize = 4,
+                .deserializeFn = mgpu_deserialize_append_font_bitmap,
+                .executeFn = execute_append_font_bitmap,
+        },
+        [Mgpu_Operation_DrawTextBox] = {
+                .id = Mgpu_Operation_DrawTextBox,
+                .minimumSize = 14,
+                .deserializeFn = mgpu_deserialize_draw_text_box,
+                .executeFn = execute_draw_text_box,
+        },
+        [Mgpu_Operation_DefineOutlineFont] = {
+                .id = Mgpu_Operation_DefineOutlineFont,
+                .minimumSize = 12,
+                .deserializeFn = mgpu_deserialize_define_outline_font,
+                .executeFn = execute_define_outline_font,
+        },
+        [Mgpu_Operation_DefineScaledFont] = {
+                .id = Mgpu_Operation_DefineScaledFont,
+                .minimumSize = 6,
+                .deserializeFn = mgpu_deserialize_define_scaled_font,
+                .executeFn = execute_define_scaled_font,
+        },
+#endif
+#ifndef MGPU_OMIT_OPERATION_STATS
+        [Mgpu_Operation_GetStats] = {
+                .id = Mgpu_Operation_GetStats,
+                .minimumSize = 3,
+                .skipsDrawFlush = true,
+                .deserializeFn = mgpu_deserialize_get_stats,
+                .executeFn = execute_get_stats,
+        },
+#endif
+        [Mgpu_Operation_Reset] = {
+                .id = Mgpu_Operation_Reset,
+                .minimumSize = 4,
+                .deserializeFn = mgpu_deserialize_reset,
+                .executeFn = execute_reset,
+        },
+};
+
+static const Mgpu_OperationDescriptor *customOperations[CUSTOM_OPERATION_COUNT];
+
+bool mgpu_operation_register(const Mgpu_OperationDescriptor *descriptor) {
+    assert(descriptor != NULL);
+    assert(descriptor->minimumSize >= 1);
+
+    if (descriptor->id < MGPU_CUSTOM_OPERATION_FIRST_ID) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Custom operations must use ids of %u and up, not %u",
+                 MGPU_CUSTOM_OPERATION_FIRST_ID,
+                 descriptor->id);
+
+        return false;
+    }
+
+    // Registering the same descriptor again is allowed, so firmwares can register their
+    // operations as part of initialization that's repeated after a reset.
+    const Mgpu_OperationDescriptor **slot = &customOperations[descriptor->id - MGPU_CUSTOM_OPERATION_FIRST_ID];
+    if (*slot != NULL && *slot != descriptor) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg, MESSAGE_MAX_LEN, "Operation id %u is already registered", descriptor->id);
+        return false;
+    }
+
+    *slot = descriptor;
+    return true;
+}
+
+const Mgpu_OperationDescriptor *mgpu_operation_get_descriptor(uint32_t id) {
+    if (id >= MGPU_CUSTOM_OPERATION_FIRST_ID) {
+        return id < 256 ? customOperations[id - MGPU_CUSTOM_OPERATION_FIRST_ID] : NULL;
+    }
+
+    return builtinOperations[id].deserializeFn != NULL ? &builtinOperations[id] : NULL;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "microgpu-common/databus.h"
+#include "microgpu-common/display.h"
+#include "microgpu-common/texture_manager.h"
+#include "operations.h"
+
+/*
+ * Built-in operations can be left out of a firmware to save flash by defining these. Omitted
+ * operations are rejected as unknown operation ids.
+ *
+ *   MGPU_OMIT_OPERATION_DRAW_TRIANGLE - DrawTriangle
+ *   MGPU_OMIT_OPERATION_DRAW_CHARS    - DrawChars and DrawTextBox, along with the fonts they
+ *                                       draw with and the operations that upload fonts
+ *   MGPU_OMIT_OPERATION_SUB_TEXTURES  - DefineSubTexture and DrawSubTexture
+ *   MGPU_OMIT_OPERATION_STATS         - GetStats, along with the counters kept for it while
+ *                                       executing operations
+ */
+
+/*
+ * Everything an operation may need while it's being executed
+ */
+typedef struct {
+    Mgpu_Display *display;
+    Mgpu_Databus *databus;
+    Mgpu_TextureManager *textureManager;
+    bool *resetFlag;
+
+    /*
+     * True if drawing is being handed to a draw dispatcher. Operations that draw several things
+     * at once have to execute each of them through `mgpu_execute_operation()` so they're
+     * dispatched, instead of writing pixels themselves.
+     */
+    bool drawsAreDispatched;
+} Mgpu_ExecutionContext;
+
+/*
+ * Describes how to deserialize and execute a single type of operation
+ */
+typedef struct {
+    uint8_t id;
+
+    /*
+     * Fewest bytes the serialized operation can have, including its id. Anything shorter is
+     * rejected before the deserialize function is called.
+     */
+    uint8_t minimumSize;
+
+    /*
+     * True if the operation never reads or writes texture pixels, so it doesn't have to wait for
+     * drawing that's been handed to a draw dispatcher.
+     */
+    bool skipsDrawFlush;
+
+    /*
+     * Fills in the operation's fields from its bytes. The operation's type has already been set,
+     * and for custom operations so have its bytes. Returns false if the bytes aren't valid. Only
+     * custom operations may leave this NULL, in which case their bytes are taken as is.
+     */
+    bool (*deserializeFn)(const uint8_t bytes[], size_t size, Mgpu_Operation *operation);
+
+    /*
+     * Executes the operation. NULL for operations that aren't executed, such as initialization.
+     */
+    void (*executeFn)(Mgpu_Operation *operation, const Mgpu_ExecutionContext *context);
+} Mgpu_OperationDescriptor;
+
+/*
+ * Adds a firmware specific operation, so it's deserialized and executed like any built-in one.
+ * The id must be at least MGPU_CUSTOM_OPERATION_FIRST_ID and the descriptor must outlive every
+ * operation executed afterward. Returns false if the id is out of range or another descriptor
+ * was already registered with it.
+ */
+bool mgpu_operation_register(const Mgpu_OperationDescriptor *descriptor);
+
+/*
+ * Gets the descriptor for the operation id, or NULL if no operation has that id.
+ */
+const Mgpu_OperationDescriptor *mgpu_operation_get_descriptor(uint32_t id);
@@ -0,0 +1,40 @@
+#include <stddef.h>
+#include <string.h>
+#include "operation_stats.h"
+
+#ifndef MGPU_OMIT_OPERATION_STATS
+
+static Mgpu_OperationStats stats[UINT8_MAX + 1];
+static uint32_t (*clockFn)(void) = NULL;
+
+void mgpu_operation_stats_set_clock(uint32_t (*microsecondsFn)(void)) {
+    clockFn = microsecondsFn;
+}
+
+uint32_t mgpu_operation_stats_now(void) {
+    return clockFn != NULL ? clockFn() : 0;
+}
+
+void mgpu_operation_stats_record(uint8_t type, uint32_t startedAt, uint32_t pixelsTouched, uint16_t bytesDecoded) {
+    // Unsigned subtraction keeps the duration right when the clock wraps during the operation
+    uint32_t microseconds = mgpu_operation_stats_now() - startedAt;
+
+    Mgpu_OperationStats *typeStats = &stats[type];
+    typeStats->executions++;
+    typeStats->totalMicroseconds += microseconds;
+    typeStats->pixelsTouched += pixelsTouched;
+    typeStats->bytesDecoded += bytesDecoded;
+    if (microseconds > typeStats->maxMicroseconds) {
+        typeStats->maxMicroseconds = microseconds;
+    }
+}
+
+const Mgpu_OperationStats *mgpu_operation_stats_get(uint8_t type) {
+    return &stats[type];
+}
+
+void mgpu_operation_stats_reset(uint8_t type) {
+    memset(&stats[type], 0, sizeof(Mgpu_OperationStats));
+}
+
+#endif
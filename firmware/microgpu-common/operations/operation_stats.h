@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Counters kept for each type of operation as it's executed, so clients can find out which
+ * operations are using up their frame time under real traffic. Operations are counted as the type
+ * they were received as, before draw state and sub-textures are resolved. Operations inside of a
+ * batch are counted on their own, as well as being part of the batch's time and bytes.
+ *
+ * Drawing that's handed to a draw dispatcher is only timed while it's being submitted, so the time
+ * spent rasterizing it is counted against whichever operation flushes it, such as presenting the
+ * frame buffer.
+ *
+ * Counters are only updated from the thread executing operations, and wrap around once they
+ * overflow, so they should be reset often enough that they don't.
+ */
+typedef struct {
+    uint32_t executions;
+    uint32_t totalMicroseconds;
+    uint32_t maxMicroseconds;
+
+    /*
+     * Area of the target textures that drawing operations covered with their bounding rectangles
+     */
+    uint32_t pixelsTouched;
+
+    /*
+     * Bytes the operations were decoded from, not counting any packet framing
+     */
+    uint32_t bytesDecoded;
+} Mgpu_OperationStats;
+
+/*
+ * Sets the function operations are timed with, which returns a microsecond count that's allowed to
+ * wrap around. Until a clock is set, operations are counted without being timed.
+ */
+void mgpu_operation_stats_set_clock(uint32_t (*microsecondsFn)(void));
+
+/*
+ * Gets the current time from the clock, or zero if no clock has been set
+ */
+uint32_t mgpu_operation_stats_now(void);
+
+/*
+ * Adds a single execution of an operation type to its counters
+ */
+void mgpu_operation_stats_record(uint8_t type, uint32_t startedAt, uint32_t pixelsTouched, uint16_t bytesDecoded);
+
+const Mgpu_OperationStats *mgpu_operation_stats_get(uint8_t type);
+
+void mgpu_operation_stats_reset(uint8_t type);
@@ -56,6 +56,9 @@ typedef enum {
      * the previous texture is cleared and a new one is started. If the new
      * width and height are zeros, then the texture is considered undefined.
      *
+     * Textures defined as cacheable may be evicted when space is needed for another
+     * texture, and must be defined again before they can be drawn from.
+     *
      * Only texture ids 1-230 are allowed to be defined externally, the rest of them
      * are reserved for internal usage. Texture id 0 is always the currently active
      * frame buffer.
@@ -78,12 +81,140 @@ typedef enum {
      */
     Mgpu_Operation_DrawChars = 12,
 
+    /*
+     * Requests how much texture memory is in use, and which textures have been evicted
+     * since the last time usage was requested.
+     */
+    Mgpu_Operation_GetTextureUsage = 13,
+
+    /*
+     * Registers a sub-texture id for a rectangle inside of a texture, such as a single
+     * sprite inside an atlas. A width or height of zero clears the sub-texture id.
+     */
+    Mgpu_Operation_DefineSubTexture = 14,
+
+    /*
+     * Draws a registered sub-texture onto a texture. Equivalent to a DrawTexture operation
+     * with the sub-texture's source rectangle, but without sending the rectangle each time.
+     */
+    Mgpu_Operation_DrawSubTexture = 15,
+
+    /*
+     * Requests the databus switch to a newer packet framing, such as one that allows
+     * operations larger than 250 bytes. The gpu responds with the framing it switched to.
+     */
+    Mgpu_Operation_NegotiateFraming = 16,
+
+    /*
+     * Inserts a fence with a 32 bit value into the stream of operations. The fence is completed
+     * once every operation before it has executed, including any frames presented before it having
+     * finished being sent to the display.
+     */
+    Mgpu_Operation_InsertFence = 17,
+
+    /*
+     * Requests the value of the most recently completed fence. When operations are pipelined it's
+     * answered as soon as it's received, instead of waiting behind queued operations or drawing,
+     * so it's cheap enough for a client to poll to see how far behind the gpu is.
+     */
+    Mgpu_Operation_QueryFence = 18,
+
+    /*
+     * Asks the databus to advertise how many more bytes the client can send before the gpu runs
+     * out of room to buffer them, such as with credit responses on TCP. Databuses act on this as
+     * they receive it, so it has to be sent on its own rather than inside of a batch. Databuses
+     * that already limit what the client can send, like SPI's handshake line, ignore it.
+     */
+    Mgpu_Operation_EnableCredits = 19,
+
+    /*
+     * A batch whose operations are encoded with varints, and with coordinates relative to the
+     * operation before them. Fields that are the same as the previous operation's can be left out
+     * entirely. See compact_batch.h for the encoding.
+     */
+    Mgpu_Operation_CompactBatch = 20,
+
+    /*
+     * Sets part of the draw state, which is the target texture, color, font and origin that
+     * DrawState operations draw with. The draw state starts out drawing to the frame buffer with
+     * a color, font id and origin of zero, and is kept until it's set again or the gpu is reset.
+     */
+    Mgpu_Operation_SetDrawState = 21,
+
+    /*
+     * Draws a filled in rectangle to the draw state's target, in its color and offset by its
+     * origin.
+     */
+    Mgpu_Operation_DrawStateRectangle = 22,
+
+    /*
+     * Draws a filled in triangle to the draw state's target, in its color and offset by its
+     * origin.
+     */
+    Mgpu_Operation_DrawStateTriangle = 23,
+
+    /*
+     * Draws ascii text to the draw state's target, in its color and font and offset by its
+     * origin.
+     */
+    Mgpu_Operation_DrawStateChars = 24,
+
+    /*
+     * Draws the same part of a texture at many positions on another texture, such as for
+     * particles or repeated icons, without sending the source rectangle for each of them.
+     */
+    Mgpu_Operation_DrawTextureInstanced = 25,
+
+    /*
+     * Defines a proportional bitmap font that DrawChars can draw with, from the width of each
+     * glyph and where its rows start in the font's bitmap. The bitmap starts out blank, and is
+     * filled in by AppendFontBitmap operations. A character count of zero clears the font id.
+     */
+    Mgpu_Operation_DefineFont = 26,
+
+    /*
+     * Appends bytes to the bitmap or outlines of a defined font
+     */
+    Mgpu_Operation_AppendFontBitmap = 27,
+
+    /*
+     * Draws text laid out inside a box, wrapping and aligning its lines with the font's widths so
+     * the client doesn't have to measure and split it into one DrawChars per line.
+     */
+    Mgpu_Operation_DrawTextBox = 28,
+
+    /*
+     * Defines a font of quadratic outlines, from the advance of each glyph and where its contours
+     * start in the font's outline data, which is filled in by AppendFontBitmap operations. Outline
+     * fonts aren't drawn with directly, but are rasterized into scaled fonts.
+     */
+    Mgpu_Operation_DefineOutlineFont = 29,
+
+    /*
+     * Rasterizes some of an outline font's glyphs at a pixel size into a font that text can be
+     * drawn with, where edges of the glyphs are blended with what they're drawn over. The outline
+     * font's data should be fully appended first.
+     */
+    Mgpu_Operation_DefineScaledFont = 30,
+
+    /*
+     * Requests the counters kept for each type of operation that's been executed, such as how many
+     * times it ran and how long it took, optionally resetting them once they're read.
+     */
+    Mgpu_Operation_GetStats = 31,
+
     /*
      * Requests the microgpu to initialize itself and fully reset itself.
      */
     Mgpu_Operation_Reset = 189, // Higher value that's hard to see accidentally
 } Mgpu_OperationType;
 
+/*
+ * Operation ids from this one up are never used by built-in operations, and are left for
+ * firmwares to register their own operations with.
+ */
+#define MGPU_CUSTOM_OPERATION_FIRST_ID 224
+
 typedef struct {
     /*
      * How much to scale the frame buffer down from the display resolution.
@@ -117,6 +248,12 @@ typedef struct {
     uint8_t textureId;
     uint16_t width, height;
     Mgpu_Color transparentColor;
+
+    /*
+     * If true, the gpu may evict the texture when it needs memory for another one. The
+     * least recently drawn cacheable textures are evicted first.
+     */
+    bool isCacheable;
 } Mgpu_DefineTextureOperation;
 
 typedef struct {
@@ -173,8 +310,134 @@ typedef struct {
      * The Y position on the target texture to start drawing
      */
     int16_t targetStartY;
+
+    /*
+     * If true, the source pixels are mirrored left to right and/or top to bottom as they're drawn
+     */
+    bool flipHorizontally, flipVertically;
 } Mgpu_DrawTextureOperation;
 
+/*
+ * Flags byte of texture draws. Instanced draws can be followed by a flags byte per instance,
+ * whose flip flags are used for that instance in place of the operation's.
+ */
+typedef enum {
+    MGPU_DRAW_TEXTURE_IGNORE_TRANSPARENCY = 1 << 0,
+    MGPU_DRAW_TEXTURE_FLIP_HORIZONTALLY = 1 << 1,
+    MGPU_DRAW_TEXTURE_FLIP_VERTICALLY = 1 << 2,
+    MGPU_DRAW_TEXTURE_INSTANCE_FLAGS = 1 << 3,
+} Mgpu_DrawTextureFlags;
+
+typedef struct {
+    uint8_t sourceTextureId;
+    uint8_t targetTextureId;
+    uint16_t sourceStartX, sourceStartY, sourceWidth, sourceHeight;
+    Mgpu_DrawTextureFlags flags;
+    uint16_t instanceCount;
+
+    /*
+     * Each instance's target X and Y as big endian signed 16 bit values, followed by its flags
+     * byte if the operation has MGPU_DRAW_TEXTURE_INSTANCE_FLAGS set.
+     */
+    const uint8_t *instances;
+} Mgpu_DrawTextureInstancedOperation;
+
+typedef struct {
+    uint8_t fontId;
+    uint8_t height;
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+    uint16_t bitmapSize;
+
+    /*
+     * Three bytes for each character: its glyph's width, then the big endian offset of the bitmap
+     * byte the glyph's rows start at. Each glyph's rows are packed one after another.
+     */
+    const uint8_t *glyphs;
+} Mgpu_DefineFontOperation;
+
+typedef struct {
+    uint8_t fontId;
+    uint16_t byteCount;
+    const uint8_t *bytes;
+} Mgpu_AppendFontBitmapOperation;
+
+typedef struct {
+    uint8_t fontId;
+    uint16_t unitsPerEm;
+    uint16_t ascent, descent;
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+    uint16_t outlineSize;
+
+    /*
+     * Four bytes per character, of its big endian advance in font units and then the big endian
+     * offset of the outline byte its contours start at
+     */
+    const uint8_t *glyphs;
+} Mgpu_DefineOutlineFontOperation;
+
+typedef struct {
+    uint8_t fontId;
+    uint8_t outlineFontId;
+
+    /*
+     * How many pixels the outline font's em square is scaled to
+     */
+    uint8_t pixelSize;
+
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+} Mgpu_DefineScaledFontOperation;
+
+typedef struct {
+    uint16_t subTextureId;
+    uint8_t textureId;
+    uint16_t x, y, width, height;
+} Mgpu_DefineSubTextureOperation;
+
+typedef struct {
+    uint16_t subTextureId;
+
+    /*
+     * The texture to draw pixels to. Specifying texture id 0 means to draw to
+     * the active frame buffer.
+     */
+    uint8_t targetTextureId;
+    int16_t targetStartX, targetStartY;
+    bool ignoreTransparency;
+} Mgpu_DrawSubTextureOperation;
+
+typedef struct {
+    /*
+     * The newest framing version the client supports
+     */
+    uint8_t version;
+} Mgpu_NegotiateFramingOperation;
+
+typedef struct {
+    /*
+     * Value reported by fence queries once the fence completes. Clients are expected to use
+     * increasing values, so a completed value also means every fence before it completed.
+     */
+    uint32_t value;
+} Mgpu_InsertFenceOperation;
+
+/*
+ * Set on the flags of a GetStats operation to reset the counters that are sent back
+ */
+#define MGPU_GET_STATS_RESET 0x01
+
+typedef struct {
+    /*
+     * Operation type to start reporting counters from, so clients can page through them when
+     * more types have run than fit in one response.
+     */
+    uint8_t firstType;
+
+    bool reset;
+} Mgpu_GetStatsOperation;
+
 typedef struct {
     uint8_t fontId;
     uint8_t textureId;
@@ -182,14 +445,118 @@ typedef struct {
     uint16_t startX, startY;
     uint8_t numCharacters;
     const uint8_t *characters;
+
+    /*
+     * When set, every pixel of each character's cell that isn't part of its glyph is written with
+     * the background color, so text can replace older text without clearing it first.
+     */
+    bool hasBackground;
+    Mgpu_Color backgroundColor;
 } Mgpu_DrawCharsOperation;
 
+/*
+ * Where lines of a text box are placed horizontally, or where the block of lines is placed
+ * vertically. Text that doesn't fit in the box is placed at its start.
+ */
+typedef enum {
+    MGPU_TEXT_ALIGN_START = 0,
+    MGPU_TEXT_ALIGN_CENTER = 1,
+    MGPU_TEXT_ALIGN_END = 2,
+} Mgpu_TextAlignment;
+
+/*
+ * How lines of a text box are broken when they're wider than the box. Lines always break after
+ * a newline character.
+ */
+typedef enum {
+    /*
+     * Lines only break at newlines, and anything past the box's edge is clipped
+     */
+    MGPU_TEXT_WRAP_NONE = 0,
+
+    /*
+     * Lines break at the last space that fits, or between characters when a word is wider than
+     * the box on its own
+     */
+    MGPU_TEXT_WRAP_WORDS = 1,
+
+    /*
+     * Lines break after the last character that fits
+     */
+    MGPU_TEXT_WRAP_CHARACTERS = 2,
+} Mgpu_TextWrap;
+
+/*
+ * The flags byte of a text box has the horizontal alignment in its lowest two bits, the vertical
+ * alignment in the two bits above it, and the wrap mode in the two bits above those.
+ */
+typedef struct {
+    uint8_t fontId;
+    uint8_t textureId;
+    Mgpu_Color color;
+    uint16_t startX, startY, width, height;
+    Mgpu_TextAlignment horizontalAlignment, verticalAlignment;
+    Mgpu_TextWrap wrap;
+    uint16_t numCharacters;
+    const uint8_t *characters;
+
+    /*
+     * When set, the whole box is filled with the background color before the text is drawn
+     */
+    bool hasBackground;
+    Mgpu_Color backgroundColor;
+} Mgpu_DrawTextBoxOperation;
+
+/*
+ * Which parts of the draw state a SetDrawState operation sets
+ */
+typedef enum {
+    MGPU_DRAW_STATE_TARGET = 1 << 0,
+    MGPU_DRAW_STATE_COLOR = 1 << 1,
+    MGPU_DRAW_STATE_FONT = 1 << 2,
+    MGPU_DRAW_STATE_ORIGIN = 1 << 3,
+} Mgpu_DrawStateFields;
+
+typedef struct {
+    Mgpu_DrawStateFields fields;
+    uint8_t targetTextureId;
+    Mgpu_Color color;
+    uint8_t fontId;
+    uint16_t originX, originY;
+} Mgpu_SetDrawStateOperation;
+
+/*
+ * A firmware's own operation. Custom operations are kept in their serialized form, and their
+ * execute function is expected to read their fields from the bytes.
+ */
+typedef struct {
+    /*
+     * Bytes following the operation id
+     */
+    const uint8_t *bytes;
+    uint16_t size;
+} Mgpu_CustomOperation;
+
 /*
  * Single type that can represent any type of operation that
  * the microgpu framework can support.
  */
 typedef struct {
     Mgpu_OperationType type;
+
+    /*
+     * The id to tag the response to this operation with, or zero if the response should be
+     * sent untagged. GetStatus, GetLastMessage, GetTextureUsage, NegotiateFraming, QueryFence
+     * and GetStats operations can end with this as an optional 16 bit value, so a client can
+     * have several requests in flight and match up the responses as they arrive.
+     */
+    uint16_t requestId;
+
+    /*
+     * How many bytes the operation was decoded from, or zero if it was created by the gpu itself
+     */
+    uint16_t serializedSize;
+
     union {
         Mgpu_InitializeOperation initialize;
         Mgpu_DrawRectangleOperation drawRectangle;
@@ -199,5 +566,18 @@ typedef struct {
         Mgpu_AppendTexturePixelOperation appendTexturePixels;
         Mgpu_DrawTextureOperation drawTexture;
         Mgpu_DrawCharsOperation drawChars;
+        Mgpu_DefineSubTextureOperation defineSubTexture;
+        Mgpu_DrawSubTextureOperation drawSubTexture;
+        Mgpu_NegotiateFramingOperation negotiateFraming;
+        Mgpu_InsertFenceOperation insertFence;
+        Mgpu_SetDrawStateOperation setDrawState;
+        Mgpu_DrawTextureInstancedOperation drawTextureInstanced;
+        Mgpu_DefineFontOperation defineFont;
+        Mgpu_AppendFontBitmapOperation appendFontBitmap;
+        Mgpu_DrawTextBoxOperation drawTextBox;
+        Mgpu_DefineOutlineFontOperation defineOutlineFont;
+        Mgpu_DefineScaledFontOperation defineScaledFont;
+        Mgpu_GetStatsOperation getStats;
+        Mgpu_CustomOperation custom;
     };
 } Mgpu_Operation;
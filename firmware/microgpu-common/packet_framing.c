@@ -1,9 +1,81 @@
 #include <assert.h>
 #include <memory.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include "packet_framing.h"
 #include "messages.h"
 
+// Bytes are scanned for zeros a machine word at a time, since the vast majority of bytes in a
+// packet aren't zero. These are the SWAR (SIMD within a register) masks for that.
+typedef size_t Word;
+#define WORD_ONES (~(Word) 0 / 0xFF)
+#define WORD_HIGH_BITS (WORD_ONES * 0x80)
+#define WORD_LOW_BYTES_OF_PAIRS (~(Word) 0 / 0xFFFF * 0xFF)
+#define WORD_PAIR_ONES (~(Word) 0 / 0xFFFF)
+
+static inline bool word_has_zero_byte(Word word) {
+    return ((word - WORD_ONES) & ~word & WORD_HIGH_BITS) != 0;
+}
+
+static inline uint16_t word_byte_sum(Word word) {
+    // Add neighboring bytes into 16 bit lanes, then multiply to gather every lane into the top one
+    Word pairs = (word & WORD_LOW_BYTES_OF_PAIRS) + ((word >> 8) & WORD_LOW_BYTES_OF_PAIRS);
+    return (uint16_t) ((pairs * WORD_PAIR_ONES) >> (sizeof(Word) * 8 - 16));
+}
+
+/*
+ * Copies bytes from the source until a zero byte is found, or `size` bytes have been copied.
+ * The bytes copied are added to the checksum if one is passed in. Returns the number of bytes
+ * copied, which is the index of the zero byte if one was found.
+ *
+ * The target may overlap the source as long as it doesn't start after it, since every word is
+ * read before it's written.
+ */
+static inline size_t copy_until_zero(const uint8_t *source, size_t size, uint8_t *target, uint16_t *checksum) {
+    if (size == 0 || source[0] == 0) {
+        return 0; // Back to back zeros are common in pixel data
+    }
+
+    size_t index = 0;
+    uint16_t sum = 0;
+
+    // Go byte by byte until the source is word aligned, so word loads stay cheap on MCUs
+    while (index < size && ((uintptr_t) (source + index) % sizeof(Word)) != 0) {
+        if (source[index] == 0) {
+            size = index; // Nothing left to copy
+            break;
+        }
+
+        target[index] = source[index];
+        sum += source[index];
+        index++;
+    }
+
+    while (size - index >= sizeof(Word)) {
+        Word word;
+        memcpy(&word, source + index, sizeof(Word));
+        if (word_has_zero_byte(word)) {
+            break;
+        }
+
+        memcpy(target + index, &word, sizeof(Word));
+        sum += word_byte_sum(word);
+        index += sizeof(Word);
+    }
+
+    while (index < size && source[index] != 0) {
+        target[index] = source[index];
+        sum += source[index];
+        index++;
+    }
+
+    if (checksum != NULL) {
+        *checksum += sum;
+    }
+
+    return index;
+}
+
 int mgpu_packet_framing_encode(const uint8_t *msg_buffer,
                                size_t msg_size,
                                uint8_t *target_buffer,
@@ -28,51 +100,47 @@ int mgpu_packet_framing_encode(const uint8_t *msg_buffer,
     }
 
     // Encode the message with Consistent Overhead Byte Stuffing encoding, but with
-    // checksum as part of the message. This entails changing all
-    // zero byte values to be a value of how many bytes to the next zero byte value.
+    // checksum as part of the message. This entails changing all zero byte values to
+    // be a value of how many bytes to the next zero byte value. Runs of non-zero bytes
+    // are copied straight into place while being summed, and each zero found closes off
+    // the run before it.
     uint16_t checksum = 0;
+    size_t index_of_last_zero_byte = 0; // First byte is the COBS zero byte offset value
+    size_t write_index = 1;
+    size_t read_index = 0;
+    while (true) {
+        size_t run = copy_until_zero(msg_buffer + read_index,
+                                     msg_size - read_index,
+                                     target_buffer + write_index,
+                                     &checksum);
 
-    // First byte is the COBS zero byte offset value
-    memcpy(target_buffer + 1, msg_buffer, msg_size);
-    target_buffer[final_size - 1] = 0;
-
-    uint8_t index_of_last_zero_byte = 0;
-    uint8_t offset;
-    for (size_t x = 0; x < msg_size; x++) {
-        size_t index = x + 1; // Message starts at index 1 for initial zero offset byte
-        checksum += target_buffer[index];
-
-        if (target_buffer[index] != 0) {
-            continue; // leave non-zero bytes alone
+        read_index += run;
+        write_index += run;
+        if (read_index == msg_size) {
+            break;
         }
 
-        offset = index - index_of_last_zero_byte;
-        target_buffer[index_of_last_zero_byte] = offset;
-        index_of_last_zero_byte = index;
+        target_buffer[index_of_last_zero_byte] = (uint8_t) (write_index - index_of_last_zero_byte);
+        index_of_last_zero_byte = write_index++;
+        read_index++;
     }
 
     // Add the checksum to the target buffer
-    uint8_t checksumByte0 = (uint8_t)(checksum >> 8);
-    if (checksumByte0 != 0) {
-        target_buffer[final_size - 3] = checksumByte0;
-    } else {
-        offset = msg_size + 1 - index_of_last_zero_byte;
-        target_buffer[index_of_last_zero_byte] = offset;
-        index_of_last_zero_byte = final_size - 3;
-    }
+    uint8_t checksumBytes[] = {(uint8_t) (checksum >> 8), (uint8_t) checksum};
+    for (int x = 0; x < sizeof(checksumBytes); x++) {
+        if (checksumBytes[x] != 0) {
+            target_buffer[write_index] = checksumBytes[x];
+        } else {
+            target_buffer[index_of_last_zero_byte] = (uint8_t) (write_index - index_of_last_zero_byte);
+            index_of_last_zero_byte = write_index;
+        }
 
-    uint8_t checksumByte1 = (uint8_t)(checksum);
-    if (checksumByte1 != 0) {
-        target_buffer[final_size - 2] = checksumByte1;
-    } else {
-        offset = msg_size + 2 - index_of_last_zero_byte;
-        target_buffer[index_of_last_zero_byte] = offset;
-        index_of_last_zero_byte = final_size - 2;
+        write_index++;
     }
 
     // Add the final zero byte offset
-    offset = final_size - 1 - index_of_last_zero_byte;
-    target_buffer[index_of_last_zero_byte] = offset;
+    target_buffer[index_of_last_zero_byte] = (uint8_t) (write_index - index_of_last_zero_byte);
+    target_buffer[write_index] = 0;
 
     return (int) final_size;
 }
@@ -89,16 +157,57 @@ void mgpu_packet_framing_decode(const uint8_t *input_buffer,
     assert(input_bytes_processed != NULL);
 
     *decoded_byte_count = 0;
-    int index_of_zero = -1;
-    for (int index = 0; index < input_buffer_size; index++) {
-        if (input_buffer[index] == 0) {
+    *input_bytes_processed = 0;
+    if (input_buffer_size == 0) {
+        return;
+    }
+
+    // Follow the zero offsets through the packet, un-stuffing and summing each run of non-zero
+    // bytes as it's copied into the decode buffer. Every byte between the initial offset byte
+    // and the delimiter lands in the decode buffer, with the checksum bytes at the end. Once
+    // the decode buffer is full, the rest of the packet is only scanned for its delimiter.
+    uint16_t calculatedChecksum = 0;
+    size_t index_of_zero = 0;
+    size_t next_zero_index = input_buffer[0];
+    size_t index = 1;
+    bool offsetsMatch = true;
+    size_t writable_end = decode_buffer_size + 1; // Input bytes before this have room to be decoded
+    while (next_zero_index != 0) {
+        size_t runEnd = next_zero_index < input_buffer_size ? next_zero_index : input_buffer_size;
+        size_t run;
+        if (runEnd <= writable_end) {
+            run = copy_until_zero(input_buffer + index,
+                                  runEnd - index,
+                                  decode_buffer + index - 1,
+                                  &calculatedChecksum);
+        } else {
+            const uint8_t *zero = memchr(input_buffer + index, 0, runEnd - index);
+            run = zero != NULL ? (size_t) (zero - (input_buffer + index)) : runEnd - index;
+        }
+
+        index += run;
+        if (index == input_buffer_size) {
+            return; // No delimiter yet, so not a complete packet
+        }
+
+        if (index < next_zero_index || input_buffer[index] == 0) {
+            // Hit the delimiter, which should be exactly where the last offset pointed to
+            offsetsMatch = index == next_zero_index;
             index_of_zero = index;
             break;
         }
+
+        // The byte at the offset is the offset to the next zero, and was a zero before encoding
+        if (index < writable_end) {
+            decode_buffer[index - 1] = 0;
+        }
+
+        next_zero_index = index + input_buffer[index];
+        index++;
     }
 
     *input_bytes_processed = index_of_zero + 1;
-    if (index_of_zero <= 0) {
+    if (index_of_zero == 0) {
         return;
     }
 
@@ -110,7 +219,7 @@ void mgpu_packet_framing_decode(const uint8_t *input_buffer,
         return;
     }
 
-    // Move everything up to the zero delimiter and the initial offset byte to the decode buffer
+    // Everything between the initial offset byte and the zero delimiter is decoded
     size_t decode_size_required = index_of_zero - 1;
     size_t packet_size = decode_size_required - 2;
     if (decode_buffer_size < decode_size_required) {
@@ -126,55 +235,436 @@ void mgpu_packet_framing_decode(const uint8_t *input_buffer,
         return;
     }
 
-    memcpy(decode_buffer, input_buffer + 1, decode_size_required); // skip the initial offset byte
+    if (!offsetsMatch) {
+        char *message = mgpu_message_get_pointer();
+        assert(message != NULL);
+        snprintf(message,
+                 MESSAGE_MAX_LEN,
+                 "Expected zero offset to match the end of the packet, instead had an offset of %zu",
+                 next_zero_index - index_of_zero + 1);
 
-    // iterate through the bytes, correcting any zeros and calculating the checksum
-    uint16_t calculatedChecksum = 0;
-    uint8_t offsetToNextZero = input_buffer[0];
-    for (int x = 0; x < packet_size; x++) {
-        offsetToNextZero--;
-        if (offsetToNextZero == 0) {
-            offsetToNextZero = decode_buffer[x];
-            decode_buffer[x] = 0;
-        } else {
-            calculatedChecksum += decode_buffer[x];
+        return;
+    }
+
+    // The checksum bytes were summed along with the rest of the packet
+    uint8_t checksumBytes[] = {decode_buffer[packet_size], decode_buffer[packet_size + 1]};
+    calculatedChecksum -= checksumBytes[0] + checksumBytes[1];
+
+    uint16_t expectedChecksum = (((uint16_t) checksumBytes[0]) << 8) | ((uint16_t) checksumBytes[1]);
+    if (calculatedChecksum != expectedChecksum) {
+        char *message = mgpu_message_get_pointer();
+        assert(message != NULL);
+        snprintf(message, MESSAGE_MAX_LEN, "Received packet with incorrect checksum value");
+
+        return;
+    }
+
+    // Decode was successful
+    *decoded_byte_count = packet_size;
+}
+
+// Flags and sequence bytes before each fragment's payload, and the CRC after it
+#define V3_HEADER_SIZE 2
+#define V3_CRC_SIZE 2
+
+struct Mgpu_FrameReassembler {
+    const Mgpu_Allocator *allocator;
+    uint8_t *buffer;
+    size_t capacity, size;
+    uint8_t nextSequence;
+    bool inMessage;
+};
+
+// CRC16-CCITT (polynomial 0x1021), one table lookup per byte
+static const uint16_t crc16Table[256] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+        0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+        0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+        0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+        0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+        0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+        0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+        0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+        0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+        0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+        0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+        0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+        0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+        0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+        0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+        0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+        0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+        0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+        0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+        0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+        0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+        0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+        0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+        0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+        0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+        0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+        0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+        0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+        0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+        0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+        0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+
+static uint16_t crc16_update(uint16_t crc, const uint8_t *bytes, size_t size) {
+    for (size_t x = 0; x < size; x++) {
+        crc = (uint16_t) (crc << 8) ^ crc16Table[(uint8_t) (crc >> 8) ^ bytes[x]];
+    }
+
+    return crc;
+}
+
+/*
+ * Byte stuffs a fragment that may be spread across multiple buffers. The target is assumed
+ * to already be known to be large enough.
+ */
+typedef struct {
+    uint8_t *target;
+    size_t codeIndex, writeIndex;
+    uint8_t code;
+} CobsEncoder;
+
+static void cobs_start(CobsEncoder *encoder, uint8_t *target) {
+    encoder->target = target;
+    encoder->codeIndex = 0;
+    encoder->writeIndex = 1;
+    encoder->code = 1;
+}
+
+static void cobs_add(CobsEncoder *encoder, const uint8_t *bytes, size_t size) {
+    size_t index = 0;
+    while (index < size) {
+        // Copy as much of the run as the current code byte can still describe
+        size_t room = 0xFF - encoder->code;
+        size_t available = size - index < room ? size - index : room;
+        size_t run = copy_until_zero(bytes + index, available, encoder->target + encoder->writeIndex, NULL);
+        index += run;
+        encoder->writeIndex += run;
+        encoder->code += run;
+
+        if (encoder->code == 0xFF) {
+            // Longest run a code byte can describe, so start a new one without an implied zero
+            encoder->target[encoder->codeIndex] = encoder->code;
+            encoder->codeIndex = encoder->writeIndex++;
+            encoder->code = 1;
+        } else if (run < available) {
+            encoder->target[encoder->codeIndex] = encoder->code;
+            encoder->codeIndex = encoder->writeIndex++;
+            encoder->code = 1;
+            index++; // Skip over the zero
         }
     }
+}
 
-    // Get the expected checksum, and zero out the bytes if required
-    uint8_t checksumBytes[] = {
-            decode_buffer[decode_size_required - 2],
-            decode_buffer[decode_size_required - 1],
-    };
+static size_t cobs_finish(CobsEncoder *encoder) {
+    encoder->target[encoder->codeIndex] = encoder->code;
+    encoder->target[encoder->writeIndex++] = 0;
 
-    for (int x = 0; x < sizeof(checksumBytes); x++) {
-        offsetToNextZero--;
-        if (offsetToNextZero == 0) {
-            offsetToNextZero = checksumBytes[x];
-            checksumBytes[x] = 0;
+    return encoder->writeIndex;
+}
+
+size_t mgpu_packet_framing_v3_max_frame_size(size_t payload_size) {
+    size_t fragmentSize = V3_HEADER_SIZE + payload_size + V3_CRC_SIZE;
+
+    // One code byte per 254 bytes, an extra one for the final run, and the zero delimiter
+    return fragmentSize + fragmentSize / 254 + 2;
+}
+
+size_t mgpu_packet_framing_v3_max_payload(size_t frame_size) {
+    size_t overhead = mgpu_packet_framing_v3_max_frame_size(0);
+    if (frame_size <= overhead) {
+        return 0;
+    }
+
+    size_t payload = frame_size - overhead - frame_size / 254;
+    while (payload > 0 && mgpu_packet_framing_v3_max_frame_size(payload) > frame_size) {
+        payload--;
+    }
+
+    if (payload > MGPU_FRAMING_V3_MAX_MSG_SIZE) {
+        payload = MGPU_FRAMING_V3_MAX_MSG_SIZE;
+    }
+
+    return payload;
+}
+
+int mgpu_packet_framing_v3_encode_fragment(const uint8_t *payload,
+                                           size_t payload_size,
+                                           uint8_t flags,
+                                           uint8_t sequence,
+                                           uint8_t *target_buffer,
+                                           size_t buffer_size) {
+    assert(payload != NULL || payload_size == 0);
+    assert(target_buffer != NULL);
+
+    if (mgpu_packet_framing_v3_max_frame_size(payload_size) > buffer_size) {
+        return MGPU_FRAMING_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    uint8_t header[V3_HEADER_SIZE] = {flags, sequence};
+    uint16_t crc = crc16_update(0xFFFF, header, sizeof(header));
+    crc = crc16_update(crc, payload, payload_size);
+    uint8_t crcBytes[V3_CRC_SIZE] = {crc >> 8, crc & 0xFF};
+
+    CobsEncoder encoder;
+    cobs_start(&encoder, target_buffer);
+    cobs_add(&encoder, header, sizeof(header));
+    cobs_add(&encoder, payload, payload_size);
+    cobs_add(&encoder, crcBytes, sizeof(crcBytes));
+
+    return (int) cobs_finish(&encoder);
+}
+
+int mgpu_packet_framing_v3_encode(const uint8_t *msg_buffer,
+                                  size_t msg_size,
+                                  size_t frame_size,
+                                  uint8_t *target_buffer,
+                                  size_t buffer_size) {
+    assert(msg_buffer != NULL);
+    assert(target_buffer != NULL);
+
+    if (msg_size == 0) {
+        return 0; // Nothing to write
+    }
+
+    if (msg_size > MGPU_FRAMING_V3_MAX_MSG_SIZE) {
+        return MGPU_FRAMING_ERROR_MSG_TOO_LARGE;
+    }
+
+    size_t maxPayload = mgpu_packet_framing_v3_max_payload(frame_size);
+    if (maxPayload == 0) {
+        return MGPU_FRAMING_ERROR_FRAME_TOO_SMALL;
+    }
+
+    size_t bytesWritten = 0;
+    size_t offset = 0;
+    uint8_t sequence = 0;
+    while (offset < msg_size) {
+        size_t payloadSize = msg_size - offset < maxPayload ? msg_size - offset : maxPayload;
+        uint8_t flags = 0;
+        if (offset == 0) {
+            flags |= MGPU_FRAMING_V3_FLAG_FIRST;
+        }
+
+        if (offset + payloadSize == msg_size) {
+            flags |= MGPU_FRAMING_V3_FLAG_FINAL;
+        }
+
+        int frameSize = mgpu_packet_framing_v3_encode_fragment(msg_buffer + offset,
+                                                               payloadSize,
+                                                               flags,
+                                                               sequence,
+                                                               target_buffer + bytesWritten,
+                                                               buffer_size - bytesWritten);
+
+        if (frameSize < 0) {
+            return frameSize;
+        }
+
+        bytesWritten += frameSize;
+        offset += payloadSize;
+        sequence++;
+    }
+
+    return (int) bytesWritten;
+}
+
+void mgpu_packet_framing_v3_decode(const uint8_t *input_buffer,
+                                   size_t input_buffer_size,
+                                   uint8_t *decode_buffer,
+                                   size_t decode_buffer_size,
+                                   size_t *decoded_byte_count,
+                                   size_t *input_bytes_processed) {
+    assert(input_buffer != NULL);
+    assert(decode_buffer != NULL);
+    assert(decoded_byte_count != NULL);
+    assert(input_bytes_processed != NULL);
+
+    *decoded_byte_count = 0;
+    const uint8_t *zero = memchr(input_buffer, 0, input_buffer_size);
+    if (zero == NULL) {
+        *input_bytes_processed = 0;
+        return;
+    }
+
+    size_t encodedSize = zero - input_buffer;
+    *input_bytes_processed = encodedSize + 1;
+    if (encodedSize == 0) {
+        return; // Empty frame, usually padding between transactions
+    }
+
+    // Each code byte is followed by that many bytes minus one, and then an implied zero unless
+    // it was a maximum length run or the end of the frame. The CRC is calculated over each run
+    // right after it's copied, while it's still in cache, and includes the CRC bytes at the end
+    // of the fragment. A CRC over data followed by its own CRC always comes out to zero.
+    uint16_t crc = 0xFFFF;
+    size_t inputIndex = 0, outputIndex = 0;
+    while (inputIndex < encodedSize) {
+        uint8_t code = input_buffer[inputIndex++];
+        size_t runLength = code - 1;
+        if (inputIndex + runLength > encodedSize) {
+            char *message = mgpu_message_get_pointer();
+            assert(message != NULL);
+            snprintf(message, MESSAGE_MAX_LEN, "Frame had a COBS run that went past the end of the frame");
+
+            return;
+        }
+
+        bool addZero = code != 0xFF && inputIndex + runLength < encodedSize;
+        if (outputIndex + runLength + (addZero ? 1 : 0) > decode_buffer_size) {
+            char *message = mgpu_message_get_pointer();
+            assert(message != NULL);
+            snprintf(message,
+                     MESSAGE_MAX_LEN,
+                     "Received frame of at least %zu bytes, but decode buffer only has %zu capacity",
+                     outputIndex + runLength,
+                     decode_buffer_size);
+
+            return;
+        }
+
+        // Output never runs ahead of input, but they overlap when decoding in place
+        memmove(decode_buffer + outputIndex, input_buffer + inputIndex, runLength);
+        crc = crc16_update(crc, decode_buffer + outputIndex, runLength);
+        inputIndex += runLength;
+        outputIndex += runLength;
+        if (addZero) {
+            decode_buffer[outputIndex++] = 0;
+            crc = crc16_update(crc, decode_buffer + outputIndex - 1, 1);
         }
     }
 
-    if (offsetToNextZero != 1) {
+    if (outputIndex < V3_HEADER_SIZE + V3_CRC_SIZE) {
         char *message = mgpu_message_get_pointer();
         assert(message != NULL);
-        snprintf(message,
-                 MESSAGE_MAX_LEN,
-                 "Expected zero offset to match the end of the packet, instead had an offset of %u",
-                 offsetToNextZero);
+        snprintf(message, MESSAGE_MAX_LEN, "Received %zu byte frame, which is too few", outputIndex);
 
         return;
     }
 
-    uint16_t expectedChecksum = (((uint16_t) checksumBytes[0]) << 8) | ((uint16_t) checksumBytes[1]);
-    if (calculatedChecksum != expectedChecksum) {
+    if (crc != 0) {
         char *message = mgpu_message_get_pointer();
         assert(message != NULL);
-        snprintf(message, MESSAGE_MAX_LEN, "Received packet with incorrect checksum value");
+        snprintf(message, MESSAGE_MAX_LEN, "Received frame with incorrect CRC value");
 
         return;
     }
 
-    // Decode was successful
-    *decoded_byte_count = packet_size;
+    *decoded_byte_count = outputIndex - V3_CRC_SIZE;
+}
+
+Mgpu_FrameReassembler *mgpu_frame_reassembler_new(const Mgpu_Allocator *allocator, size_t max_message_size) {
+    mgpu_alloc_assert(allocator);
+    assert(max_message_size > 0);
+
+    Mgpu_FrameReassembler *reassembler = allocator->FastMemAllocateFn(sizeof(Mgpu_FrameReassembler));
+    if (reassembler == NULL) {
+        return NULL;
+    }
+
+    reassembler->allocator = allocator;
+    reassembler->capacity = max_message_size;
+    reassembler->buffer = allocator->SlowMemAllocateFn(max_message_size);
+    if (reassembler->buffer == NULL) {
+        char *message = mgpu_message_get_pointer();
+        assert(message != NULL);
+        snprintf(message, MESSAGE_MAX_LEN, "Failed to allocate %zu byte reassembly buffer", max_message_size);
+
+        allocator->FastMemFreeFn(reassembler);
+        return NULL;
+    }
+
+    mgpu_frame_reassembler_reset(reassembler);
+
+    return reassembler;
+}
+
+void mgpu_frame_reassembler_free(Mgpu_FrameReassembler *reassembler) {
+    if (reassembler != NULL) {
+        reassembler->allocator->SlowMemFreeFn(reassembler->buffer);
+        reassembler->allocator->FastMemFreeFn(reassembler);
+    }
+}
+
+void mgpu_frame_reassembler_reset(Mgpu_FrameReassembler *reassembler) {
+    assert(reassembler != NULL);
+
+    reassembler->size = 0;
+    reassembler->nextSequence = 0;
+    reassembler->inMessage = false;
+}
+
+bool mgpu_frame_reassembler_add(Mgpu_FrameReassembler *reassembler,
+                                const uint8_t *fragment,
+                                size_t fragment_size,
+                                const uint8_t **message,
+                                size_t *message_size) {
+    assert(reassembler != NULL);
+    assert(fragment != NULL);
+    assert(message != NULL);
+    assert(message_size != NULL);
+
+    if (fragment_size < V3_HEADER_SIZE) {
+        return false;
+    }
+
+    uint8_t flags = fragment[0];
+    uint8_t sequence = fragment[1];
+    const uint8_t *payload = fragment + V3_HEADER_SIZE;
+    size_t payloadSize = fragment_size - V3_HEADER_SIZE;
+
+    if (flags & MGPU_FRAMING_V3_FLAG_FIRST) {
+        // A new message replaces any partial one, since its remaining fragments were lost
+        mgpu_frame_reassembler_reset(reassembler);
+
+        if (flags & MGPU_FRAMING_V3_FLAG_FINAL) {
+            *message = payload;
+            *message_size = payloadSize;
+            return true;
+        }
+    } else if (!reassembler->inMessage || sequence != reassembler->nextSequence) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Received fragment %u but expected fragment %u, dropping the message",
+                 sequence,
+                 reassembler->inMessage ? reassembler->nextSequence : 0);
+
+        mgpu_frame_reassembler_reset(reassembler);
+        return false;
+    }
+
+    if (reassembler->size + payloadSize > reassembler->capacity) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Fragmented message is larger than the %zu bytes that can be reassembled",
+                 reassembler->capacity);
+
+        mgpu_frame_reassembler_reset(reassembler);
+        return false;
+    }
+
+    memcpy(reassembler->buffer + reassembler->size, payload, payloadSize);
+    reassembler->size += payloadSize;
+    reassembler->nextSequence = sequence + 1;
+    reassembler->inMessage = true;
+
+    if ((flags & MGPU_FRAMING_V3_FLAG_FINAL) == 0) {
+        return false;
+    }
+
+    *message = reassembler->buffer;
+    *message_size = reassembler->size;
+    reassembler->inMessage = false;
+    reassembler->size = 0;
+
+    return true;
 }
@@ -1,12 +1,38 @@
 #pragma once
 
 // Handles logic for encoding bytes into framed packets, and unpacking framed packets
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include "alloc.h"
 
 #define MGPU_FRAMING_MAX_MSG_SIZE 250
 #define MGPU_FRAMING_ERROR_MSG_TOO_LARGE (-1)
 #define MGPU_FRAMING_ERROR_BUFFER_TOO_SMALL (-2)
+#define MGPU_FRAMING_ERROR_FRAME_TOO_SMALL (-3)
+
+/*
+ * The original framing, limited to 250 byte messages. Every databus starts out with this
+ * framing, and clients may negotiate for a newer version afterward.
+ */
+#define MGPU_FRAMING_VERSION_2 2
+
+/*
+ * Framing that supports messages up to 64KB. Messages larger than the databus' frame size are
+ * split into multiple fragments, each of which is its own frame:
+ *
+ * - 1 byte of flags (first and/or final fragment of the message)
+ * - 1 byte sequence number, starting at zero for the first fragment and wrapping at 255
+ * - The fragment's part of the message
+ * - 2 byte CRC16 (CCITT, big endian) of everything before it
+ *
+ * The whole fragment is then byte stuffed with standard COBS (runs of up to 254 non-zero
+ * bytes) and terminated with a zero byte.
+ */
+#define MGPU_FRAMING_VERSION_3 3
+#define MGPU_FRAMING_V3_MAX_MSG_SIZE 65535
+#define MGPU_FRAMING_V3_FLAG_FIRST 0x01
+#define MGPU_FRAMING_V3_FLAG_FINAL 0x02
 
 /* Takes the message buffer container containing the bytes of the message to
  * encode into a packet. Each message should not be larger than the max packet
@@ -24,6 +50,9 @@ int mgpu_packet_framing_encode(const uint8_t *msg_buffer,
  * packet it finds ending with a zero byte value. If the packet is a
  * valid MGPU packet, it's placed in the decode buffer with the number
  * of bytes in the decoded packet in `decoded_byte_count`.
+ *
+ * The decode buffer may be the input buffer itself to decode in place, as
+ * long as the whole packet including its zero byte is in the input buffer.
  */
 void mgpu_packet_framing_decode(const uint8_t *input_buffer,
                                 size_t input_buffer_size,
@@ -31,3 +60,94 @@ void mgpu_packet_framing_decode(const uint8_t *input_buffer,
                                 size_t decode_buffer_size,
                                 size_t *decoded_byte_count,
                                 size_t *input_bytes_processed);
+
+/*
+ * Gets the largest number of bytes a v3 frame carrying `payload_size` bytes of a message can
+ * be encoded into, including the trailing zero byte.
+ */
+size_t mgpu_packet_framing_v3_max_frame_size(size_t payload_size);
+
+/*
+ * Gets how many bytes of a message can be carried in each v3 frame, if frames can't be
+ * larger than `frame_size` bytes once encoded. Returns zero if no payload fits.
+ */
+size_t mgpu_packet_framing_v3_max_payload(size_t frame_size);
+
+/*
+ * Encodes a message into one or more v3 frames, none of which are larger than `frame_size`
+ * bytes. All frames are written back to back into the target buffer.
+ *
+ * Returns the number of bytes written to the target buffer, or a negative value if an
+ * error occurs.
+ */
+int mgpu_packet_framing_v3_encode(const uint8_t *msg_buffer,
+                                  size_t msg_size,
+                                  size_t frame_size,
+                                  uint8_t *target_buffer,
+                                  size_t buffer_size);
+
+/*
+ * Encodes a single fragment of a message into a v3 frame, for transports that need to send
+ * each frame separately.
+ *
+ * Returns the number of bytes written to the target buffer, or a negative value if an
+ * error occurs.
+ */
+int mgpu_packet_framing_v3_encode_fragment(const uint8_t *payload,
+                                           size_t payload_size,
+                                           uint8_t flags,
+                                           uint8_t sequence,
+                                           uint8_t *target_buffer,
+                                           size_t buffer_size);
+
+/*
+ * Takes a buffer containing bytes and attempts to decode the first v3 frame it finds
+ * ending with a zero byte value. If the frame is valid, its fragment (flags, sequence and
+ * payload, without the CRC) is placed in the decode buffer with its size in
+ * `decoded_byte_count`. Pass the fragment to a frame reassembler to get whole messages.
+ *
+ * Like v2 packets, frames can be decoded in place by passing the input buffer as the decode
+ * buffer, as long as the whole frame including its zero byte is in the input buffer.
+ */
+void mgpu_packet_framing_v3_decode(const uint8_t *input_buffer,
+                                   size_t input_buffer_size,
+                                   uint8_t *decode_buffer,
+                                   size_t decode_buffer_size,
+                                   size_t *decoded_byte_count,
+                                   size_t *input_bytes_processed);
+
+/*
+ * Joins the fragments of v3 frames back into whole messages.
+ */
+typedef struct Mgpu_FrameReassembler Mgpu_FrameReassembler;
+
+/*
+ * Creates a reassembler that can hold messages of up to `max_message_size` bytes. The
+ * message buffer is allocated from slow ram, since it's only touched once per fragment.
+ */
+Mgpu_FrameReassembler *mgpu_frame_reassembler_new(const Mgpu_Allocator *allocator, size_t max_message_size);
+
+/*
+ * Frees the reassembler and its message buffer.
+ */
+void mgpu_frame_reassembler_free(Mgpu_FrameReassembler *reassembler);
+
+/*
+ * Drops any partially received message.
+ */
+void mgpu_frame_reassembler_reset(Mgpu_FrameReassembler *reassembler);
+
+/*
+ * Adds a decoded fragment to the message being reassembled. Returns true once the fragment
+ * completes a message, with `message` and `message_size` describing it. The message is only
+ * valid until the next fragment is added, and messages sent as a single fragment point
+ * directly into the passed in fragment rather than being copied.
+ *
+ * Returns false if more fragments are needed, or if the fragment was out of order, in which
+ * case the partial message is dropped and the last message is set.
+ */
+bool mgpu_frame_reassembler_add(Mgpu_FrameReassembler *reassembler,
+                                const uint8_t *fragment,
+                                size_t fragment_size,
+                                const uint8_t **message,
+                                size_t *message_size);
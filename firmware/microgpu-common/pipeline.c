@@ -0,0 +1,246 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "messages.h"
+#include "operations/execution/fences.h"
+#include "operations/operation_execution.h"
+#include "operations/operation_queue.h"
+#include "pipeline.h"
+
+struct Mgpu_Pipeline {
+    const Mgpu_Allocator *allocator;
+    Mgpu_OperationQueue *queue;
+    void (*waitFn)(uint32_t attempt);
+    atomic_bool isStopped;
+    uint32_t executeWaitAttempts; // Only touched by the execute stage
+
+    atomic_uint_fast32_t operationsReceived;
+    atomic_uint_fast32_t operationsExecuted;
+    atomic_uint_fast32_t receiveWaits;
+    atomic_uint_fast32_t executeWaits;
+    atomic_uint_fast32_t operationsDropped;
+
+    /*
+     * Errors on the receive stage are written here instead of the shared message buffer. Each one
+     * is copied into `receiveError`, to be published once every operation queued before it has
+     * executed.
+     */
+    char receiveMessage[MESSAGE_MAX_LEN + 1];
+    char receiveError[MESSAGE_MAX_LEN + 1];
+    uint32_t operationsQueued; // Only touched by the receive stage
+    uint32_t receiveErrorQueuedCount;
+    atomic_bool hasReceiveError;
+};
+
+static void wait(Mgpu_Pipeline *pipeline, uint32_t attempt) {
+    if (pipeline->waitFn != NULL) {
+        pipeline->waitFn(attempt);
+    }
+}
+
+Mgpu_Pipeline *mgpu_pipeline_new(const Mgpu_Allocator *allocator, const Mgpu_PipelineOptions *options) {
+    mgpu_alloc_assert(allocator);
+    assert(options != NULL);
+
+    Mgpu_Pipeline *pipeline = allocator->FastMemAllocateFn(sizeof(Mgpu_Pipeline));
+    if (pipeline == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate pipeline", MESSAGE_MAX_LEN);
+
+        return NULL;
+    }
+
+    pipeline->allocator = allocator;
+    pipeline->waitFn = options->waitFn;
+    pipeline->executeWaitAttempts = 0;
+    atomic_init(&pipeline->isStopped, false);
+    atomic_init(&pipeline->operationsReceived, 0);
+    atomic_init(&pipeline->operationsExecuted, 0);
+    atomic_init(&pipeline->receiveWaits, 0);
+    atomic_init(&pipeline->executeWaits, 0);
+    atomic_init(&pipeline->operationsDropped, 0);
+    pipeline->receiveMessage[0] = '\0';
+    pipeline->receiveError[0] = '\0';
+    pipeline->operationsQueued = 0;
+    pipeline->receiveErrorQueuedCount = 0;
+    atomic_init(&pipeline->hasReceiveError, false);
+
+    pipeline->queue = mgpu_operation_queue_new(allocator, options->operationCapacity, options->payloadArenaSize);
+    if (pipeline->queue == NULL) {
+        mgpu_pipeline_free(pipeline);
+        return NULL;
+    }
+
+    return pipeline;
+}
+
+void mgpu_pipeline_free(Mgpu_Pipeline *pipeline) {
+    if (pipeline != NULL) {
+        mgpu_operation_queue_free(pipeline->queue);
+        pipeline->allocator->FastMemFreeFn(pipeline);
+    }
+}
+
+/*
+ * Hands the receive stage's error off to the execute stage, waiting for it to publish the last one
+ * first so none are lost.
+ */
+static void queue_receive_error(Mgpu_Pipeline *pipeline) {
+    if (pipeline->receiveMessage[0] == '\0') {
+        return;
+    }
+
+    uint32_t attempt = 0;
+    while (atomic_load_explicit(&pipeline->hasReceiveError, memory_order_acquire)) {
+        if (atomic_load_explicit(&pipeline->isStopped, memory_order_relaxed)) {
+            return;
+        }
+
+        if (attempt == 0) {
+            atomic_fetch_add_explicit(&pipeline->receiveWaits, 1, memory_order_relaxed);
+        }
+
+        wait(pipeline, attempt);
+        attempt++;
+    }
+
+    memcpy(pipeline->receiveError, pipeline->receiveMessage, sizeof(pipeline->receiveError));
+    pipeline->receiveErrorQueuedCount = pipeline->operationsQueued;
+    atomic_store_explicit(&pipeline->hasReceiveError, true, memory_order_release);
+}
+
+/*
+ * Publishes the receive stage's error as the last message, once the execute stage has caught up
+ * to where it happened.
+ */
+static void publish_receive_error(Mgpu_Pipeline *pipeline) {
+    if (!atomic_load_explicit(&pipeline->hasReceiveError, memory_order_acquire)) {
+        return;
+    }
+
+    uint32_t executed = atomic_load_explicit(&pipeline->operationsExecuted, memory_order_relaxed);
+    if (executed != pipeline->receiveErrorQueuedCount) {
+        return;
+    }
+
+    char *msg = mgpu_message_get_pointer();
+    assert(msg != NULL);
+    memcpy(msg, pipeline->receiveError, MESSAGE_MAX_LEN + 1);
+    atomic_store_explicit(&pipeline->hasReceiveError, false, memory_order_release);
+}
+
+static bool receive_next(Mgpu_Pipeline *pipeline, Mgpu_Databus *databus) {
+    Mgpu_Operation operation;
+    if (!mgpu_databus_get_next_operation(databus, &operation)) {
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&pipeline->operationsReceived, 1, memory_order_relaxed);
+
+    if (operation.type == Mgpu_Operation_QueryFence) {
+        // Only reports what's already completed, so it's answered now instead of after every
+        // queued operation has executed.
+        mgpu_exec_fence_respond(databus, operation.requestId);
+        return true;
+    }
+
+    uint32_t attempt = 0;
+    while (!atomic_load_explicit(&pipeline->isStopped, memory_order_relaxed)) {
+        switch (mgpu_operation_queue_try_push(pipeline->queue, &operation)) {
+            case Mgpu_OperationQueue_Pushed:
+                pipeline->operationsQueued++;
+                return true;
+
+            case Mgpu_OperationQueue_Full:
+                if (attempt == 0) {
+                    atomic_fetch_add_explicit(&pipeline->receiveWaits, 1, memory_order_relaxed);
+                }
+
+                wait(pipeline, attempt);
+                attempt++;
+                break;
+
+            case Mgpu_OperationQueue_TooLarge: {
+                char *msg = mgpu_message_get_pointer();
+                assert(msg != NULL);
+                snprintf(msg,
+                         MESSAGE_MAX_LEN,
+                         "Operation of type %u was too large to be queued for execution",
+                         operation.type);
+
+                atomic_fetch_add_explicit(&pipeline->operationsDropped, 1, memory_order_relaxed);
+                return false;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool mgpu_pipeline_receive_next(Mgpu_Pipeline *pipeline, Mgpu_Databus *databus) {
+    assert(pipeline != NULL);
+    assert(databus != NULL);
+
+    // Everything reporting an error while receiving writes to the pipeline's buffer, since the
+    // shared one belongs to the execute stage
+    mgpu_message_use_thread_buffer(pipeline->receiveMessage);
+    pipeline->receiveMessage[0] = '\0';
+
+    bool received = receive_next(pipeline, databus);
+    if (!received) {
+        queue_receive_error(pipeline);
+    }
+
+    return received;
+}
+
+bool mgpu_pipeline_execute_next(Mgpu_Pipeline *pipeline,
+                                Mgpu_Display *display,
+                                Mgpu_Databus *databus,
+                                bool *resetFlag,
+                                Mgpu_TextureManager *textureManager) {
+    assert(pipeline != NULL);
+
+    // Fences are completed here, since fence queries are answered by the receive stage
+    mgpu_exec_fences_update(display);
+
+    // Checked after peeking, so an error received before the operation is always seen first
+    Mgpu_Operation *operation = mgpu_operation_queue_peek(pipeline->queue);
+    publish_receive_error(pipeline);
+    if (operation == NULL) {
+        if (pipeline->executeWaitAttempts == 0) {
+            atomic_fetch_add_explicit(&pipeline->executeWaits, 1, memory_order_relaxed);
+        }
+
+        wait(pipeline, pipeline->executeWaitAttempts);
+        pipeline->executeWaitAttempts++;
+
+        return false;
+    }
+
+    pipeline->executeWaitAttempts = 0;
+
+    mgpu_execute_operation(operation, display, databus, resetFlag, textureManager);
+    mgpu_operation_queue_pop(pipeline->queue);
+    atomic_fetch_add_explicit(&pipeline->operationsExecuted, 1, memory_order_relaxed);
+
+    return true;
+}
+
+void mgpu_pipeline_stop(Mgpu_Pipeline *pipeline) {
+    assert(pipeline != NULL);
+    atomic_store_explicit(&pipeline->isStopped, true, memory_order_relaxed);
+}
+
+void mgpu_pipeline_get_stats(Mgpu_Pipeline *pipeline, Mgpu_PipelineStats *stats) {
+    assert(pipeline != NULL);
+    assert(stats != NULL);
+
+    stats->operationsReceived = atomic_load_explicit(&pipeline->operationsReceived, memory_order_relaxed);
+    stats->operationsExecuted = atomic_load_explicit(&pipeline->operationsExecuted, memory_order_relaxed);
+    stats->receiveWaits = atomic_load_explicit(&pipeline->receiveWaits, memory_order_relaxed);
+    stats->executeWaits = atomic_load_explicit(&pipeline->executeWaits, memory_order_relaxed);
+    stats->operationsDropped = atomic_load_explicit(&pipeline->operationsDropped, memory_order_relaxed);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "alloc.h"
+#include "databus.h"
+#include "display.h"
+#include "texture_manager.h"
+
+/*
+ * An optional way of running the microgpu, where receiving and decoding operations happens in
+ * one stage while executing them happens in another. Each stage is expected to run on its own
+ * thread, so the time spent waiting on the databus and decoding packets can overlap with the time
+ * spent rasterizing.
+ *
+ * The stages are connected by a lock-free single producer/single consumer operation queue, so
+ * exactly one thread may call `mgpu_pipeline_receive_next()` and exactly one thread may call
+ * `mgpu_pipeline_execute_next()`.
+ */
+typedef struct Mgpu_Pipeline Mgpu_Pipeline;
+
+typedef struct {
+    /*
+     * How many decoded operations can be waiting to be executed. Must be a power of two.
+     */
+    uint16_t operationCapacity;
+
+    /*
+     * How many bytes to reserve for holding operation data (batch contents, texture pixels,
+     * etc...) until the operation has been executed. Must be at least as large as the
+     * largest operation the databus can receive.
+     */
+    size_t payloadArenaSize;
+
+    /*
+     * Called when a stage can't make progress because it's waiting on the other stage. The
+     * number of consecutive times the stage has waited is passed in, so implementations can
+     * yield at first and back off to sleeping. If NULL, the stages will busy-wait.
+     */
+    void (*waitFn)(uint32_t attempt);
+} Mgpu_PipelineOptions;
+
+typedef struct {
+    uint32_t operationsReceived;
+    uint32_t operationsExecuted;
+
+    /*
+     * How many times the receive stage had a decoded operation but had to wait for the execute
+     * stage to make room for it.
+     */
+    uint32_t receiveWaits;
+
+    /*
+     * How many times the execute stage was ready for an operation, but none had been received yet.
+     */
+    uint32_t executeWaits;
+
+    /*
+     * Operations that were received but were too large to be held until execution.
+     */
+    uint32_t operationsDropped;
+} Mgpu_PipelineStats;
+
+/*
+ * Creates a new pipeline
+ */
+Mgpu_Pipeline *mgpu_pipeline_new(const Mgpu_Allocator *allocator, const Mgpu_PipelineOptions *options);
+
+/*
+ * Frees the pipeline and all memory it allocated. Neither stage may be running when it's freed.
+ */
+void mgpu_pipeline_free(Mgpu_Pipeline *pipeline);
+
+/*
+ * Receive stage. Blocks until the databus provides the next operation, then waits until there's
+ * room to hand it off to the execute stage. Returns false if no operation could be received, or
+ * if it was given up on due to the pipeline being stopped.
+ *
+ * Fence queries aren't handed off, but are answered right away with the last fence the execute
+ * stage saw complete. The databus must allow responses to be sent from both stages.
+ *
+ * Messages reported while receiving, such as deserialization errors, go to a buffer kept by the
+ * pipeline, which is what `mgpu_message_get_pointer()` returns on the receive stage's thread.
+ * When receiving fails the execute stage publishes its message as the last message, once every
+ * operation received before it has executed.
+ */
+bool mgpu_pipeline_receive_next(Mgpu_Pipeline *pipeline, Mgpu_Databus *databus);
+
+/*
+ * Execute stage. Executes the oldest received operation, if one is available. If none are
+ * available then the pipeline's wait function is invoked and false is returned.
+ */
+bool mgpu_pipeline_execute_next(Mgpu_Pipeline *pipeline,
+                                Mgpu_Display *display,
+                                Mgpu_Databus *databus,
+                                bool *resetFlag,
+                                Mgpu_TextureManager *textureManager);
+
+/*
+ * Signals both stages to stop waiting on each other, so the threads running them can exit.
+ */
+void mgpu_pipeline_stop(Mgpu_Pipeline *pipeline);
+
+/*
+ * Gets a snapshot of how the stages have been interacting.
+ */
+void mgpu_pipeline_get_stats(Mgpu_Pipeline *pipeline, Mgpu_PipelineStats *stats);
@@ -1,9 +1,10 @@
 #include <assert.h>
+#include <string.h>
 #include "response_serializer.h"
 
 int serialize_status(Mgpu_StatusResponse *status, uint8_t buffer[], size_t bufferSize) {
     assert(status != NULL);
-    size_t requiredSize = 15;
+    size_t requiredSize = 16;
 
     if (bufferSize < requiredSize) {
         return MGPU_ERROR_BUFFER_TOO_SMALL;
@@ -24,6 +25,7 @@ int serialize_status(Mgpu_StatusResponse *status, uint8_t buffer[], size_t buffe
     buffer[12] = status->opByteLimit & 0xFF;
     buffer[13] = status->apiVersionId >> 8;
     buffer[14] = status->apiVersionId & 0xFF;
+    buffer[15] = status->maxFramingVersion;
 
     return (int) requiredSize;
 }
@@ -52,11 +54,108 @@ int serialize_last_message(Mgpu_LastMessageResponse *lastMessage, uint8_t buffer
     return bufferIndex;
 }
 
-int mgpu_serialize_response(Mgpu_Response *response, uint8_t buffer[], size_t bufferSize) {
-    assert(response != NULL);
-    assert(buffer != NULL);
-    assert(bufferSize > 1);
+static void write_uint32(uint8_t buffer[], uint32_t value) {
+    buffer[0] = value >> 24;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+}
+
+int serialize_texture_usage(Mgpu_TextureUsageResponse *usage, uint8_t buffer[], size_t bufferSize) {
+    assert(usage != NULL);
+    size_t requiredSize = 22 + sizeof(usage->evictedIds);
+
+    if (bufferSize < requiredSize) {
+        return MGPU_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    buffer[0] = Mgpu_Response_TextureUsage;
+    write_uint32(buffer + 1, usage->fastBytesUsed);
+    write_uint32(buffer + 5, usage->fastBudget);
+    write_uint32(buffer + 9, usage->slowBytesUsed);
+    write_uint32(buffer + 13, usage->slowBudget);
+    buffer[17] = usage->textureCount;
+    write_uint32(buffer + 18, usage->evictionCount);
+    memcpy(buffer + 22, usage->evictedIds, sizeof(usage->evictedIds));
+
+    return (int) requiredSize;
+}
+
+int serialize_framing(Mgpu_FramingResponse *framing, uint8_t buffer[], size_t bufferSize) {
+    assert(framing != NULL);
+    size_t requiredSize = 6;
+
+    if (bufferSize < requiredSize) {
+        return MGPU_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    buffer[0] = Mgpu_Response_Framing;
+    buffer[1] = framing->version;
+    buffer[2] = framing->maxFrameSize >> 8;
+    buffer[3] = framing->maxFrameSize & 0xFF;
+    buffer[4] = framing->maxMessageSize >> 8;
+    buffer[5] = framing->maxMessageSize & 0xFF;
+
+    return (int) requiredSize;
+}
+
+int serialize_fence(Mgpu_FenceResponse *fence, uint8_t buffer[], size_t bufferSize) {
+    assert(fence != NULL);
+    size_t requiredSize = 5;
+
+    if (bufferSize < requiredSize) {
+        return MGPU_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    buffer[0] = Mgpu_Response_Fence;
+    write_uint32(buffer + 1, fence->lastCompletedValue);
+
+    return (int) requiredSize;
+}
+
+int serialize_credits(Mgpu_CreditsResponse *credits, uint8_t buffer[], size_t bufferSize) {
+    assert(credits != NULL);
+    size_t requiredSize = 5;
+
+    if (bufferSize < requiredSize) {
+        return MGPU_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    buffer[0] = Mgpu_Response_Credits;
+    write_uint32(buffer + 1, credits->byteLimit);
+
+    return (int) requiredSize;
+}
+
+int serialize_stats(Mgpu_StatsResponse *stats, uint8_t buffer[], size_t bufferSize) {
+    assert(stats != NULL);
+    assert(stats->entryCount == 0 || stats->entries != NULL);
+    size_t requiredSize = MGPU_STATS_RESPONSE_HEADER_SIZE + (size_t) stats->entryCount * MGPU_STATS_RESPONSE_ENTRY_SIZE;
+
+    if (bufferSize < requiredSize) {
+        return MGPU_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    buffer[0] = Mgpu_Response_Stats;
+    buffer[1] = stats->nextType;
+    buffer[2] = stats->entryCount;
 
+    uint8_t *entryBytes = buffer + MGPU_STATS_RESPONSE_HEADER_SIZE;
+    for (uint8_t index = 0; index < stats->entryCount; index++) {
+        const Mgpu_StatsEntry *entry = &stats->entries[index];
+        entryBytes[0] = entry->operationType;
+        write_uint32(entryBytes + 1, entry->executions);
+        write_uint32(entryBytes + 5, entry->totalMicroseconds);
+        write_uint32(entryBytes + 9, entry->maxMicroseconds);
+        write_uint32(entryBytes + 13, entry->pixelsTouched);
+        write_uint32(entryBytes + 17, entry->bytesDecoded);
+        entryBytes += MGPU_STATS_RESPONSE_ENTRY_SIZE;
+    }
+
+    return (int) requiredSize;
+}
+
+static int serialize_untagged_response(Mgpu_Response *response, uint8_t buffer[], size_t bufferSize) {
     switch (response->type) {
         case Mgpu_Response_Status:
             return serialize_status(&response->status, buffer, bufferSize);
@@ -64,7 +163,48 @@ int mgpu_serialize_response(Mgpu_Response *response, uint8_t buffer[], size_t bu
         case Mgpu_Response_LastMessage:
             return serialize_last_message(&response->lastMessage, buffer, bufferSize);
 
+        case Mgpu_Response_TextureUsage:
+            return serialize_texture_usage(&response->textureUsage, buffer, bufferSize);
+
+        case Mgpu_Response_Framing:
+            return serialize_framing(&response->framing, buffer, bufferSize);
+
+        case Mgpu_Response_Fence:
+            return serialize_fence(&response->fence, buffer, bufferSize);
+
+        case Mgpu_Response_Credits:
+            return serialize_credits(&response->credits, buffer, bufferSize);
+
+        case Mgpu_Response_Stats:
+            return serialize_stats(&response->stats, buffer, bufferSize);
+
         default:
             return MGPU_ERROR_UNKNOWN_RESPONSE_TYPE;
     }
 }
+
+int mgpu_serialize_response(Mgpu_Response *response, uint8_t buffer[], size_t bufferSize) {
+    assert(response != NULL);
+    assert(buffer != NULL);
+    assert(bufferSize > 1);
+
+    if (response->requestId == 0) {
+        return serialize_untagged_response(response, buffer, bufferSize);
+    }
+
+    if (bufferSize < 4) {
+        return MGPU_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    // Serialized two bytes in, so the type byte ends up where the low byte of the id goes
+    int bytesWritten = serialize_untagged_response(response, buffer + 2, bufferSize - 2);
+    if (bytesWritten < 0) {
+        return bytesWritten;
+    }
+
+    buffer[0] = buffer[2] | MGPU_RESPONSE_TAGGED_FLAG;
+    buffer[1] = response->requestId >> 8;
+    buffer[2] = response->requestId & 0xFF;
+
+    return bytesWritten + 2;
+}
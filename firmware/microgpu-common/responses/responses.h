@@ -10,8 +10,19 @@
 typedef enum {
     Mgpu_Response_Status = 1,
     Mgpu_Response_LastMessage,
+    Mgpu_Response_TextureUsage,
+    Mgpu_Response_Framing,
+    Mgpu_Response_Fence,
+    Mgpu_Response_Credits,
+    Mgpu_Response_Stats,
 } Mgpu_ResponseType;
 
+/*
+ * Set on the type byte of a serialized response when it's tagged with a request id. The
+ * request id follows as a 16 bit value, and then the rest of the response as usual.
+ */
+#define MGPU_RESPONSE_TAGGED_FLAG 0x80
+
 /*
  * A status response declares the current operating state of the
  * microgpu system.
@@ -26,6 +37,9 @@ typedef struct {
 
     /* Identifies the version of the GPU's API */
     uint16_t apiVersionId;
+
+    /* The newest packet framing version the databus can be switched to */
+    uint8_t maxFramingVersion;
 } Mgpu_StatusResponse;
 
 /*
@@ -38,13 +52,103 @@ typedef struct {
     char *message;
 } Mgpu_LastMessageResponse;
 
+/*
+ * Reports how many bytes of fast and slow ram textures are using, along with the budget
+ * each pool is limited to (zero if unlimited).
+ */
+typedef struct {
+    uint32_t fastBytesUsed, fastBudget, slowBytesUsed, slowBudget;
+    uint8_t textureCount;
+    uint32_t evictionCount;
+
+    /*
+     * Bitmap of texture ids evicted since the previous texture usage response, with bit
+     * `id % 8` of byte `id / 8` set for each evicted id.
+     */
+    uint8_t evictedIds[32];
+} Mgpu_TextureUsageResponse;
+
+/*
+ * Describes the packet framing the databus switched to after a negotiation request, and
+ * the limits that come with it.
+ */
+typedef struct {
+    uint8_t version;
+
+    /* The largest encoded frame the gpu accepts, including the trailing zero byte */
+    uint16_t maxFrameSize;
+
+    /* The largest operation the gpu can reassemble out of fragments */
+    uint16_t maxMessageSize;
+} Mgpu_FramingResponse;
+
+/*
+ * Reports the value of the most recently completed fence, or zero if none have completed yet.
+ */
+typedef struct {
+    uint32_t lastCompletedValue;
+} Mgpu_FenceResponse;
+
+/*
+ * Sent by databuses on their own once credits are enabled, to let the client know how much it
+ * can send without overrunning what the gpu can buffer. The limit is the total number of bytes
+ * the client may have sent since the enable credits operation, and wraps around.
+ */
+typedef struct {
+    uint32_t byteLimit;
+} Mgpu_CreditsResponse;
+
+/*
+ * Most operation types a single stats response reports on. Fewer are sent when that many wouldn't
+ * fit in a message the databus can send, such as the 11 that fit with version 2 framing.
+ */
+#define MGPU_STATS_RESPONSE_MAX_ENTRIES 16
+
+/*
+ * Bytes an untagged stats response takes up before its entries, and bytes each entry takes up
+ */
+#define MGPU_STATS_RESPONSE_HEADER_SIZE 3
+#define MGPU_STATS_RESPONSE_ENTRY_SIZE 21
+
+/*
+ * Counters for a single type of operation since they were last reset
+ */
+typedef struct {
+    uint8_t operationType;
+    uint32_t executions, totalMicroseconds, maxMicroseconds, pixelsTouched, bytesDecoded;
+} Mgpu_StatsEntry;
+
+/*
+ * Reports the counters of operation types that have been executed since they were last reset,
+ * in order of operation type.
+ */
+typedef struct {
+    /*
+     * Operation type to request next to get the rest of the counters, or zero if every type with
+     * counters was included.
+     */
+    uint8_t nextType;
+
+    uint8_t entryCount;
+    const Mgpu_StatsEntry *entries;
+} Mgpu_StatsResponse;
+
 /*
  * The composed response to send over the databus.
  */
 typedef struct {
     Mgpu_ResponseType type;
+
+    /* The request id of the operation being responded to, or zero to send the response untagged */
+    uint16_t requestId;
+
     union {
         Mgpu_StatusResponse status;
         Mgpu_LastMessageResponse lastMessage;
+        Mgpu_TextureUsageResponse textureUsage;
+        Mgpu_FramingResponse framing;
+        Mgpu_FenceResponse fence;
+        Mgpu_CreditsResponse credits;
+        Mgpu_StatsResponse stats;
     };
 } Mgpu_Response;
@@ -0,0 +1,280 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "messages.h"
+#include "operations/execution/drawing/draw_operation.h"
+#include "operations/operation_deserializer.h"
+#include "retained_frame.h"
+
+#define NO_LIST (-1)
+
+typedef struct {
+    Mgpu_Operation operation;
+    Mgpu_DrawBounds bounds;
+} RecordedOperation;
+
+typedef struct {
+    RecordedOperation *operations;
+    uint16_t count;
+    uint8_t *payloadArena;
+    size_t payloadArenaUsed;
+    uint16_t frameHeight;
+} DisplayList;
+
+struct Mgpu_RetainedFrame {
+    const Mgpu_Allocator *allocator;
+    void (*waitFn)(uint32_t attempt);
+    uint16_t operationCapacity;
+    size_t payloadArenaSize;
+    DisplayList lists[2];
+
+    // Only touched by the thread executing operations
+    int recordingIndex;
+    bool recordingNeedsReset;
+
+    // Only touched by the thread rendering strips
+    int renderingIndex;
+
+    // Latest list to be presented, and the list the display is currently rendering from
+    atomic_int presentedIndex;
+    atomic_int displayedIndex;
+};
+
+static void wait(Mgpu_RetainedFrame *frame, uint32_t attempt) {
+    if (frame->waitFn != NULL) {
+        frame->waitFn(attempt);
+    }
+}
+
+static void drop_operation(Mgpu_Operation *operation, const char *reason) {
+    char *msg = mgpu_message_get_pointer();
+    assert(msg != NULL);
+    snprintf(msg, MESSAGE_MAX_LEN, "Operation of type %u dropped: %s", operation->type, reason);
+}
+
+/*
+ * Makes sure the recording list isn't still being displayed before it's written to
+ */
+static DisplayList *get_recording_list(Mgpu_RetainedFrame *frame) {
+    DisplayList *list = &frame->lists[frame->recordingIndex];
+    if (frame->recordingNeedsReset) {
+        uint32_t attempt = 0;
+        while (atomic_load_explicit(&frame->displayedIndex, memory_order_acquire) == frame->recordingIndex) {
+            wait(frame, attempt);
+            attempt++;
+        }
+
+        list->count = 0;
+        list->payloadArenaUsed = 0;
+        frame->recordingNeedsReset = false;
+    }
+
+    return list;
+}
+
+static void present(Mgpu_RetainedFrame *frame, Mgpu_TextureManager *textureManager) {
+    DisplayList *list = get_recording_list(frame);
+    Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
+    list->frameHeight = frameBuffer != NULL ? frameBuffer->height : 0;
+
+    atomic_store_explicit(&frame->presentedIndex, frame->recordingIndex, memory_order_release);
+    frame->recordingIndex = frame->recordingIndex == 0 ? 1 : 0;
+    frame->recordingNeedsReset = true;
+}
+
+static bool record(Mgpu_RetainedFrame *frame, Mgpu_Operation *operation, Mgpu_DrawBounds *bounds) {
+    DisplayList *list = get_recording_list(frame);
+    if (list->count >= frame->operationCapacity) {
+        return false;
+    }
+
+    RecordedOperation *recorded = &list->operations[list->count];
+    recorded->operation = *operation;
+    recorded->bounds = *bounds;
+
+    const uint8_t **payloadField;
+    size_t payloadSize = mgpu_operation_get_payload(&recorded->operation, &payloadField);
+    if (payloadSize > 0) {
+        if (list->payloadArenaUsed + payloadSize > frame->payloadArenaSize) {
+            return false;
+        }
+
+        memcpy(list->payloadArena + list->payloadArenaUsed, *payloadField, payloadSize);
+        *payloadField = list->payloadArena + list->payloadArenaUsed;
+        list->payloadArenaUsed += payloadSize;
+    }
+
+    list->count++;
+    return true;
+}
+
+static bool submit(void *context, Mgpu_Operation *operation, Mgpu_TextureManager *textureManager) {
+    Mgpu_RetainedFrame *frame = context;
+
+    if (operation->type == Mgpu_Operation_PresentFramebuffer) {
+        // The display still needs to be told to render, so let the present execute normally
+        present(frame, textureManager);
+        return false;
+    }
+
+    uint8_t targetTextureId;
+    Mgpu_DrawBounds bounds;
+    if (!mgpu_draw_operation_get_bounds(operation, textureManager, &targetTextureId, &bounds)) {
+        // Not a drawing operation, or not a valid one. Either way it won't touch the framebuffer.
+        return false;
+    }
+
+    if (mgpu_draw_operation_reads_texture(operation, 0)) {
+        drop_operation(operation, "the framebuffer can't be read from when rendering in strips");
+        return true;
+    }
+
+    if (targetTextureId != 0) {
+        return false;
+    }
+
+    if (bounds.left < bounds.right && bounds.top < bounds.bottom && !record(frame, operation, &bounds)) {
+        drop_operation(operation, "the frame's display list is full");
+    }
+
+    return true;
+}
+
+static void flush(void *context, Mgpu_TextureManager *textureManager) {
+    // Nothing to do, as frames are only rendered once the display asks for them
+}
+
+Mgpu_RetainedFrame *mgpu_retained_frame_new(const Mgpu_Allocator *allocator,
+                                            const Mgpu_RetainedFrameOptions *options) {
+    mgpu_alloc_assert(allocator);
+    assert(options != NULL);
+    assert(options->operationCapacity > 0);
+
+    Mgpu_RetainedFrame *frame = allocator->FastMemAllocateFn(sizeof(Mgpu_RetainedFrame));
+    if (frame == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate retained frame", MESSAGE_MAX_LEN);
+
+        return NULL;
+    }
+
+    memset(frame, 0, sizeof(Mgpu_RetainedFrame));
+    frame->allocator = allocator;
+    frame->waitFn = options->waitFn;
+    frame->operationCapacity = options->operationCapacity;
+    frame->payloadArenaSize = options->payloadArenaSize;
+    frame->recordingIndex = 0;
+    frame->renderingIndex = NO_LIST;
+    atomic_init(&frame->presentedIndex, NO_LIST);
+    atomic_init(&frame->displayedIndex, NO_LIST);
+
+    for (int x = 0; x < 2; x++) {
+        DisplayList *list = &frame->lists[x];
+        list->operations = allocator->FastMemAllocateFn(sizeof(RecordedOperation) * options->operationCapacity);
+        if (options->payloadArenaSize > 0) {
+            list->payloadArena = allocator->FastMemAllocateFn(options->payloadArenaSize);
+        }
+
+        if (list->operations == NULL || (options->payloadArenaSize > 0 && list->payloadArena == NULL)) {
+            char *msg = mgpu_message_get_pointer();
+            assert(msg != NULL);
+            strncpy(msg, "Failed to allocate retained frame display lists", MESSAGE_MAX_LEN);
+
+            mgpu_retained_frame_free(frame);
+            return NULL;
+        }
+    }
+
+    return frame;
+}
+
+void mgpu_retained_frame_free(Mgpu_RetainedFrame *frame) {
+    if (frame != NULL) {
+        for (int x = 0; x < 2; x++) {
+            if (frame->lists[x].operations != NULL) {
+                frame->allocator->FastMemFreeFn(frame->lists[x].operations);
+            }
+
+            if (frame->lists[x].payloadArena != NULL) {
+                frame->allocator->FastMemFreeFn(frame->lists[x].payloadArena);
+            }
+        }
+
+        frame->allocator->FastMemFreeFn(frame);
+    }
+}
+
+void mgpu_retained_frame_get_dispatcher(Mgpu_RetainedFrame *frame, Mgpu_DrawDispatcher *dispatcher) {
+    assert(frame != NULL);
+    assert(dispatcher != NULL);
+
+    dispatcher->context = frame;
+    dispatcher->submitFn = submit;
+    dispatcher->flushFn = flush;
+}
+
+void mgpu_retained_frame_render_strip(Mgpu_RetainedFrame *frame,
+                                      Mgpu_TextureManager *textureManager,
+                                      Mgpu_Color *pixels,
+                                      uint16_t width,
+                                      uint16_t firstLine,
+                                      uint16_t lineCount) {
+    assert(frame != NULL);
+    assert(textureManager != NULL);
+    assert(pixels != NULL);
+
+    if (firstLine == 0) {
+        // Start of a new frame, so pick up whatever was presented last. Once the display list
+        // in use is published, the previous one is free to be recorded into again.
+        frame->renderingIndex = atomic_load_explicit(&frame->presentedIndex, memory_order_acquire);
+        atomic_store_explicit(&frame->displayedIndex, frame->renderingIndex, memory_order_release);
+        mgpu_texture_manager_begin_read_pass(textureManager);
+    }
+
+    DisplayList *list = frame->renderingIndex != NO_LIST ? &frame->lists[frame->renderingIndex] : NULL;
+    uint16_t frameHeight = list != NULL ? list->frameHeight : firstLine + lineCount;
+    if (firstLine >= frameHeight) {
+        return;
+    }
+
+    Mgpu_DrawRegion region = {
+            .pixels = pixels,
+            .stride = width,
+            .originX = 0,
+            .originY = firstLine,
+            .clip = {
+                    .left = 0,
+                    .top = firstLine,
+                    .right = width,
+                    .bottom = min(firstLine + lineCount, frameHeight),
+            },
+    };
+
+    Mgpu_Color black = mgpu_color_from_rgb888(0, 0, 0);
+    memset(pixels, black, sizeof(Mgpu_Color) * width * (region.clip.bottom - firstLine));
+    if (list == NULL) {
+        return;
+    }
+
+    for (int x = 0; x < list->count; x++) {
+        RecordedOperation *recorded = &list->operations[x];
+        if (!mgpu_draw_bounds_intersect(&recorded->bounds, &region.clip)) {
+            continue;
+        }
+
+        if (recorded->operation.type == Mgpu_Operation_DrawTexture) {
+            // The textures being drawn from may have been redefined since the operation was
+            // recorded, so make sure it's still safe to read from them.
+            uint8_t targetTextureId;
+            Mgpu_DrawBounds bounds;
+            if (!mgpu_draw_operation_get_bounds(&recorded->operation, textureManager, &targetTextureId, &bounds)) {
+                continue;
+            }
+        }
+
+        mgpu_draw_operation_in_region(&recorded->operation, textureManager, &region);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "alloc.h"
+#include "colors/color.h"
+#include "operations/operation_execution.h"
+#include "texture_manager.h"
+
+/*
+ * Renders frames without a framebuffer. Drawing operations that target the framebuffer are kept
+ * as a display list, and once the frame is presented the display renders it on demand a strip of
+ * lines at a time, directly into its own line or bounce buffers. Texture 0 is expected to be
+ * defined with `MGPU_TEXTURE_NO_PIXELS`, so only its dimensions are tracked.
+ *
+ * Two display lists are kept, so the next frame can be recorded while the presented one is still
+ * being displayed. Recording the next frame only starts once the display has begun rendering the
+ * newly presented frame.
+ *
+ * The retained frame is hooked into operation execution as a draw dispatcher. Operations that
+ * would need to read framebuffer pixels (such as drawing from texture 0) can't be supported and
+ * are dropped with a message, as are framebuffer draws once the display list is full.
+ *
+ * Textures drawn from are read when each strip is rendered, not when the operation is received.
+ * Changing a texture's pixels therefore affects every frame still being displayed that draws it.
+ */
+typedef struct Mgpu_RetainedFrame Mgpu_RetainedFrame;
+
+typedef struct {
+    /*
+     * How many drawing operations each frame's display list can hold
+     */
+    uint16_t operationCapacity;
+
+    /*
+     * How many bytes each display list reserves for copies of operation data (such as
+     * characters to draw).
+     */
+    size_t payloadArenaSize;
+
+    /*
+     * Called while waiting for the display to start rendering a presented frame. The number of
+     * consecutive waits is passed in, so implementations can yield at first and back off to
+     * sleeping. If NULL, waiting will busy-wait.
+     */
+    void (*waitFn)(uint32_t attempt);
+} Mgpu_RetainedFrameOptions;
+
+/*
+ * Creates a new retained frame
+ */
+Mgpu_RetainedFrame *mgpu_retained_frame_new(const Mgpu_Allocator *allocator,
+                                            const Mgpu_RetainedFrameOptions *options);
+
+/*
+ * Frees the retained frame and all memory it allocated. It must no longer be the active draw
+ * dispatcher, and no display may be rendering from it.
+ */
+void mgpu_retained_frame_free(Mgpu_RetainedFrame *frame);
+
+/*
+ * Gets the dispatcher that records operations into this retained frame, to be passed to
+ * `mgpu_execute_set_draw_dispatcher()`.
+ */
+void mgpu_retained_frame_get_dispatcher(Mgpu_RetainedFrame *frame, Mgpu_DrawDispatcher *dispatcher);
+
+/*
+ * Renders lines of the most recently presented frame into `pixels`, which must hold `width`
+ * pixels for each line. Lines past the bottom of texture 0 are left untouched. Lines no
+ * operation draws to are black.
+ *
+ * Rendering line zero marks the start of a new frame, and is when a newly presented frame is
+ * picked up. It also starts a read pass of the texture manager, so textures retired before then
+ * can be freed. Only one thread may render strips, but it doesn't need to be the thread executing
+ * operations.
+ */
+void mgpu_retained_frame_render_strip(Mgpu_RetainedFrame *frame,
+                                      Mgpu_TextureManager *textureManager,
+                                      Mgpu_Color *pixels,
+                                      uint16_t width,
+                                      uint16_t firstLine,
+                                      uint16_t lineCount);
@@ -0,0 +1,415 @@
+#include <assert.h>
+#include <string.h>
+#include "messages.h"
+#include "texture_arena.h"
+
+#define ALIGNMENT 8
+#define ALIGN_UP(x) (((x) + ALIGNMENT - 1) & ~((size_t) ALIGNMENT - 1))
+
+// Slab pages hold this many bytes of slots, no matter the slot size
+#define SLAB_PAGE_PAYLOAD 4096
+#define SLAB_CLASS_COUNT 5
+#define MAX_SLOTS_PER_PAGE 64
+
+static const uint16_t slabSlotSizes[SLAB_CLASS_COUNT] = {64, 128, 256, 512, 1024};
+
+typedef enum {
+    Block_Free,
+    Block_Allocation,
+    Block_Slab,
+} BlockKind;
+
+/*
+ * Every block in the arena starts with this header, with blocks laid out back to back. The
+ * previous block's size is kept so neighbors on both sides can be found when merging free blocks.
+ */
+typedef struct {
+    uint32_t size;
+    uint32_t previousSize;
+    uint8_t kind;
+    void **owner;
+} BlockHeader;
+
+typedef struct {
+    uint16_t slotSize;
+    uint16_t slotCount;
+    uint16_t usedCount;
+    uint64_t usedSlots;
+    void **owners[MAX_SLOTS_PER_PAGE];
+} SlabHeader;
+
+#define HEADER_SIZE ALIGN_UP(sizeof(BlockHeader))
+#define SLAB_HEADER_SIZE ALIGN_UP(sizeof(SlabHeader))
+#define SLAB_BLOCK_SIZE (HEADER_SIZE + SLAB_HEADER_SIZE + SLAB_PAGE_PAYLOAD)
+#define MIN_BLOCK_SIZE (HEADER_SIZE + ALIGNMENT)
+
+struct Mgpu_TextureArena {
+    const Mgpu_Allocator *allocator;
+    bool useSlowRam;
+    uint8_t *memory;
+    size_t size;
+
+    uint32_t allocations;
+    uint32_t failedAllocations;
+    uint32_t compactions;
+    size_t bytesRelocated;
+};
+
+static uint8_t *payload(BlockHeader *block) {
+    return (uint8_t *) block + HEADER_SIZE;
+}
+
+static SlabHeader *slab_header(BlockHeader *block) {
+    return (SlabHeader *) payload(block);
+}
+
+static uint8_t *slab_slot(BlockHeader *block, int index) {
+    SlabHeader *slab = slab_header(block);
+    return payload(block) + SLAB_HEADER_SIZE + (index * slab->slotSize);
+}
+
+static BlockHeader *next_block(Mgpu_TextureArena *arena, BlockHeader *block) {
+    uint8_t *next = (uint8_t *) block + block->size;
+    return next < arena->memory + arena->size ? (BlockHeader *) next : NULL;
+}
+
+static BlockHeader *previous_block(BlockHeader *block) {
+    return block->previousSize > 0 ? (BlockHeader *) ((uint8_t *) block - block->previousSize) : NULL;
+}
+
+static void set_block_size(Mgpu_TextureArena *arena, BlockHeader *block, uint32_t size) {
+    block->size = size;
+
+    BlockHeader *next = next_block(arena, block);
+    if (next != NULL) {
+        next->previousSize = size;
+    }
+}
+
+static BlockHeader *find_block(Mgpu_TextureArena *arena, const void *memory) {
+    for (BlockHeader *block = (BlockHeader *) arena->memory; block != NULL; block = next_block(arena, block)) {
+        if ((const uint8_t *) memory < (uint8_t *) block + block->size) {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+static BlockHeader *allocate_block(Mgpu_TextureArena *arena, size_t size, BlockKind kind) {
+    for (BlockHeader *block = (BlockHeader *) arena->memory; block != NULL; block = next_block(arena, block)) {
+        if (block->kind != Block_Free || block->size < size) {
+            continue;
+        }
+
+        if (block->size - size >= MIN_BLOCK_SIZE) {
+            // Split off the rest as its own free block
+            uint32_t remaining = block->size - size;
+            set_block_size(arena, block, size);
+
+            BlockHeader *rest = next_block(arena, block);
+            rest->kind = Block_Free;
+            rest->owner = NULL;
+            rest->previousSize = size;
+            set_block_size(arena, rest, remaining);
+        }
+
+        block->kind = kind;
+        block->owner = NULL;
+        return block;
+    }
+
+    return NULL;
+}
+
+static void release_block(Mgpu_TextureArena *arena, BlockHeader *block) {
+    block->kind = Block_Free;
+    block->owner = NULL;
+
+    BlockHeader *next = next_block(arena, block);
+    if (next != NULL && next->kind == Block_Free) {
+        set_block_size(arena, block, block->size + next->size);
+    }
+
+    BlockHeader *previous = previous_block(block);
+    if (previous != NULL && previous->kind == Block_Free) {
+        set_block_size(arena, previous, previous->size + block->size);
+    }
+}
+
+static int slab_class_for(size_t size) {
+    for (int x = 0; x < SLAB_CLASS_COUNT; x++) {
+        if (size <= slabSlotSizes[x]) {
+            return x;
+        }
+    }
+
+    return -1;
+}
+
+static void *allocate_slot(Mgpu_TextureArena *arena, uint16_t slotSize, void **owner) {
+    BlockHeader *page = NULL;
+    for (BlockHeader *block = (BlockHeader *) arena->memory; block != NULL; block = next_block(arena, block)) {
+        if (block->kind == Block_Slab &&
+            slab_header(block)->slotSize == slotSize &&
+            slab_header(block)->usedCount < slab_header(block)->slotCount) {
+            page = block;
+            break;
+        }
+    }
+
+    if (page == NULL) {
+        page = allocate_block(arena, SLAB_BLOCK_SIZE, Block_Slab);
+        if (page == NULL) {
+            return NULL;
+        }
+
+        SlabHeader *slab = slab_header(page);
+        memset(slab, 0, sizeof(SlabHeader));
+        slab->slotSize = slotSize;
+        slab->slotCount = SLAB_PAGE_PAYLOAD / slotSize;
+    }
+
+    SlabHeader *slab = slab_header(page);
+    for (int x = 0; x < slab->slotCount; x++) {
+        uint64_t bit = (uint64_t) 1 << x;
+        if ((slab->usedSlots & bit) == 0) {
+            slab->usedSlots |= bit;
+            slab->usedCount++;
+            slab->owners[x] = owner;
+
+            return slab_slot(page, x);
+        }
+    }
+
+    assert(false && "Slab page had a free slot count but no free slot");
+    return NULL;
+}
+
+static int slot_index(BlockHeader *page, const void *memory) {
+    SlabHeader *slab = slab_header(page);
+    int index = (int) (((const uint8_t *) memory - slab_slot(page, 0)) / slab->slotSize);
+    assert(index >= 0 && index < slab->slotCount);
+    assert(slab_slot(page, index) == memory);
+
+    return index;
+}
+
+/*
+ * Points everything referring to allocations inside the block at where they are now.
+ */
+static void update_owners(BlockHeader *block) {
+    if (block->kind == Block_Allocation) {
+        *block->owner = payload(block);
+    } else if (block->kind == Block_Slab) {
+        SlabHeader *slab = slab_header(block);
+        for (int x = 0; x < slab->slotCount; x++) {
+            if ((slab->usedSlots & ((uint64_t) 1 << x)) != 0) {
+                *slab->owners[x] = slab_slot(block, x);
+            }
+        }
+    }
+}
+
+Mgpu_TextureArena *mgpu_texture_arena_new(const Mgpu_Allocator *allocator, bool useSlowRam, size_t size) {
+    mgpu_alloc_assert(allocator);
+
+    size = size & ~((size_t) ALIGNMENT - 1);
+    assert(size >= MIN_BLOCK_SIZE);
+    assert(size <= UINT32_MAX);
+
+    Mgpu_TextureArena *arena = allocator->FastMemAllocateFn(sizeof(Mgpu_TextureArena));
+    if (arena == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate texture arena", MESSAGE_MAX_LEN);
+
+        return NULL;
+    }
+
+    memset(arena, 0, sizeof(Mgpu_TextureArena));
+    arena->allocator = allocator;
+    arena->useSlowRam = useSlowRam;
+    arena->size = size;
+    arena->memory = useSlowRam
+                    ? allocator->SlowMemAllocateFn(size)
+                    : allocator->FastMemAllocateFn(size);
+
+    if (arena->memory == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate texture arena memory", MESSAGE_MAX_LEN);
+
+        mgpu_texture_arena_free(arena);
+        return NULL;
+    }
+
+    BlockHeader *block = (BlockHeader *) arena->memory;
+    block->size = size;
+    block->previousSize = 0;
+    block->kind = Block_Free;
+    block->owner = NULL;
+
+    return arena;
+}
+
+void mgpu_texture_arena_free(Mgpu_TextureArena *arena) {
+    if (arena != NULL) {
+        if (arena->memory != NULL) {
+            if (arena->useSlowRam) {
+                arena->allocator->SlowMemFreeFn(arena->memory);
+            } else {
+                arena->allocator->FastMemFreeFn(arena->memory);
+            }
+        }
+
+        arena->allocator->FastMemFreeFn(arena);
+    }
+}
+
+void *mgpu_texture_arena_allocate(Mgpu_TextureArena *arena, size_t size, void **owner) {
+    assert(arena != NULL);
+    assert(owner != NULL);
+
+    void *memory = NULL;
+    int slabClass = slab_class_for(size);
+    if (slabClass >= 0) {
+        memory = allocate_slot(arena, slabSlotSizes[slabClass], owner);
+    } else if (size <= arena->size) {
+        BlockHeader *block = allocate_block(arena, ALIGN_UP(HEADER_SIZE + size), Block_Allocation);
+        if (block != NULL) {
+            block->owner = owner;
+            memory = payload(block);
+        }
+    }
+
+    if (memory != NULL) {
+        arena->allocations++;
+    } else {
+        arena->failedAllocations++;
+    }
+
+    return memory;
+}
+
+void mgpu_texture_arena_release(Mgpu_TextureArena *arena, void *memory) {
+    assert(arena != NULL);
+    assert(mgpu_texture_arena_contains(arena, memory));
+
+    BlockHeader *block = find_block(arena, memory);
+    assert(block != NULL);
+
+    if (block->kind == Block_Allocation) {
+        assert(payload(block) == memory);
+        release_block(arena, block);
+    } else {
+        assert(block->kind == Block_Slab);
+        SlabHeader *slab = slab_header(block);
+        int index = slot_index(block, memory);
+
+        slab->usedSlots &= ~((uint64_t) 1 << index);
+        slab->owners[index] = NULL;
+        slab->usedCount--;
+        if (slab->usedCount == 0) {
+            release_block(arena, block);
+        }
+    }
+}
+
+void mgpu_texture_arena_set_owner(Mgpu_TextureArena *arena, void *memory, void **owner) {
+    assert(arena != NULL);
+    assert(owner != NULL);
+
+    BlockHeader *block = find_block(arena, memory);
+    assert(block != NULL);
+
+    if (block->kind == Block_Allocation) {
+        block->owner = owner;
+    } else {
+        assert(block->kind == Block_Slab);
+        slab_header(block)->owners[slot_index(block, memory)] = owner;
+    }
+}
+
+bool mgpu_texture_arena_contains(Mgpu_TextureArena *arena, const void *memory) {
+    assert(arena != NULL);
+
+    const uint8_t *address = memory;
+    return address >= arena->memory && address < arena->memory + arena->size;
+}
+
+void mgpu_texture_arena_compact(Mgpu_TextureArena *arena) {
+    assert(arena != NULL);
+
+    uint8_t *cursor = arena->memory;
+    uint32_t previousSize = 0;
+    BlockHeader *block = (BlockHeader *) arena->memory;
+    while (block != NULL) {
+        // Moving a block only ever overwrites itself and free space before it, so the next
+        // block is still intact after the move.
+        BlockHeader *next = next_block(arena, block);
+        if (block->kind != Block_Free) {
+            uint32_t size = block->size;
+            if ((uint8_t *) block != cursor) {
+                memmove(cursor, block, size);
+                arena->bytesRelocated += size;
+                update_owners((BlockHeader *) cursor);
+            }
+
+            ((BlockHeader *) cursor)->previousSize = previousSize;
+            previousSize = size;
+            cursor += size;
+        }
+
+        block = next;
+    }
+
+    if (cursor < arena->memory + arena->size) {
+        BlockHeader *free = (BlockHeader *) cursor;
+        free->size = (uint32_t) (arena->memory + arena->size - cursor);
+        free->previousSize = previousSize;
+        free->kind = Block_Free;
+        free->owner = NULL;
+    }
+
+    arena->compactions++;
+}
+
+void mgpu_texture_arena_get_stats(Mgpu_TextureArena *arena, Mgpu_TextureArenaStats *stats) {
+    assert(arena != NULL);
+    assert(stats != NULL);
+
+    memset(stats, 0, sizeof(Mgpu_TextureArenaStats));
+    stats->totalBytes = arena->size;
+    stats->allocations = arena->allocations;
+    stats->failedAllocations = arena->failedAllocations;
+    stats->compactions = arena->compactions;
+    stats->bytesRelocated = arena->bytesRelocated;
+
+    for (BlockHeader *block = (BlockHeader *) arena->memory; block != NULL; block = next_block(arena, block)) {
+        switch (block->kind) {
+            case Block_Free: {
+                size_t available = block->size - HEADER_SIZE;
+                stats->freeBytes += block->size;
+                stats->freeBlockCount++;
+                if (available > stats->largestFreeBlock) {
+                    stats->largestFreeBlock = available;
+                }
+
+                break;
+            }
+
+            case Block_Allocation:
+                stats->usedBytes += block->size - HEADER_SIZE;
+                break;
+
+            case Block_Slab: {
+                SlabHeader *slab = slab_header(block);
+                stats->slabPageCount++;
+                stats->usedBytes += slab->usedCount * slab->slotSize;
+                stats->freeSlabSlots += slab->slotCount - slab->usedCount;
+                break;
+            }
+        }
+    }
+}
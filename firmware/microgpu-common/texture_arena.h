@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "alloc.h"
+
+/*
+ * A single large block of memory that texture allocations are carved out of, instead of each
+ * texture being its own heap allocation. Constantly defining and undefining textures of
+ * different sizes fragments a heap until large textures can no longer be defined, and the arena
+ * keeps that fragmentation contained and recoverable:
+ *
+ * - Small allocations come from size-class slabs. Each slab is a page of equally sized slots,
+ *   so small sprites coming and going never splits up the free space larger textures need.
+ * - Larger allocations use first-fit with free neighbors merged back together on release.
+ * - Compaction slides every allocation towards the start of the arena, leaving all free space
+ *   as one block at the end.
+ *
+ * Since compaction moves allocations, each allocation records the pointer that refers to it
+ * (its owner), which is updated whenever it's relocated. Nothing else may hold onto a pointer
+ * to arena memory across a compaction.
+ */
+typedef struct Mgpu_TextureArena Mgpu_TextureArena;
+
+typedef struct {
+    size_t totalBytes;
+
+    /*
+     * Bytes handed out to allocations, including rounding up to their slab slot size
+     */
+    size_t usedBytes;
+
+    /*
+     * Bytes not part of any allocation or slab page
+     */
+    size_t freeBytes;
+
+    /*
+     * The largest allocation that can be made without compacting first
+     */
+    size_t largestFreeBlock;
+
+    uint32_t freeBlockCount;
+    uint32_t slabPageCount;
+    uint32_t freeSlabSlots;
+
+    uint32_t allocations;
+    uint32_t failedAllocations;
+    uint32_t compactions;
+    size_t bytesRelocated;
+} Mgpu_TextureArenaStats;
+
+/*
+ * Creates a new arena with `size` bytes of space, reserved from the slow ram pool if
+ * `useSlowRam` is set and the fast ram pool otherwise.
+ */
+Mgpu_TextureArena *mgpu_texture_arena_new(const Mgpu_Allocator *allocator, bool useSlowRam, size_t size);
+
+/*
+ * Frees the arena and all allocations made from it.
+ */
+void mgpu_texture_arena_free(Mgpu_TextureArena *arena);
+
+/*
+ * Allocates `size` bytes from the arena. `owner` is where the caller keeps the returned pointer,
+ * and is updated if the allocation is relocated. Returns NULL if there's no room.
+ */
+void *mgpu_texture_arena_allocate(Mgpu_TextureArena *arena, size_t size, void **owner);
+
+/*
+ * Returns an allocation's memory to the arena.
+ */
+void mgpu_texture_arena_release(Mgpu_TextureArena *arena, void *memory);
+
+/*
+ * Changes where the pointer to an allocation is kept.
+ */
+void mgpu_texture_arena_set_owner(Mgpu_TextureArena *arena, void *memory, void **owner);
+
+/*
+ * Returns true if the memory was allocated from this arena.
+ */
+bool mgpu_texture_arena_contains(Mgpu_TextureArena *arena, const void *memory);
+
+/*
+ * Moves all allocations to the start of the arena, so all free space is in one block.
+ */
+void mgpu_texture_arena_compact(Mgpu_TextureArena *arena);
+
+/*
+ * Gets a snapshot of the arena's usage and fragmentation.
+ */
+void mgpu_texture_arena_get_stats(Mgpu_TextureArena *arena, Mgpu_TextureArenaStats *stats);
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,24 +7,418 @@
 #include "messages.h"
 #include "texture_manager.h"
 
+#define RETIRED_CAPACITY 16
+
+/*
+ * Memory of a texture or font that's no longer defined, but that another thread may still be reading
+ */
+typedef struct {
+    void *memory;
+    size_t size;
+    bool allocatedInSlowRam;
+    bool allocatedInArena;
+
+    /*
+     * The read pass that was in progress when the memory was retired
+     */
+    unsigned int readPass;
+} Mgpu_RetiredMemory;
+
 struct Mgpu_TextureManager {
     const Mgpu_Allocator *allocator;
     Mgpu_Texture **textures;
+    Mgpu_SubTexture *subTextures;
+    Mgpu_UploadedFont *fonts[NUM_UPLOADED_FONTS];
+    Mgpu_TextureArena *fastArena;
+    Mgpu_TextureArena *slowArena;
+    bool compactWhenFull;
+    uint32_t arenaFallbacks;
+    size_t fastBudget, slowBudget;
+    size_t fastBytesUsed, slowBytesUsed;
+    uint32_t useCounter;
+    uint32_t evictionCount;
+    uint8_t evictedIds[MGPU_TEXTURE_ID_BITMAP_SIZE];
+    bool deferFrees;
+    void (*waitFn)(uint32_t attempt);
+    atomic_uint readPasses;
+    Mgpu_RetiredMemory retired[RETIRED_CAPACITY];
+    uint8_t retiredCount;
 };
 
-void free_texture(Mgpu_Texture *texture, const Mgpu_Allocator *allocator) {
+static Mgpu_TextureArena *get_arena(Mgpu_TextureManager *textureManager, bool slowRam) {
+    return slowRam ? textureManager->slowArena : textureManager->fastArena;
+}
+
+static size_t get_texture_size(Mgpu_Texture *texture) {
+    size_t pixelCount = texture->hasPixels ? texture->width * texture->height : 0;
+    return sizeof(Mgpu_Texture) + pixelCount * sizeof(Mgpu_Color);
+}
+
+static size_t *get_bytes_used(Mgpu_TextureManager *textureManager, bool slowRam) {
+    return slowRam ? &textureManager->slowBytesUsed : &textureManager->fastBytesUsed;
+}
+
+static bool fits_in_budget(Mgpu_TextureManager *textureManager, bool slowRam, size_t size) {
+    size_t budget = slowRam ? textureManager->slowBudget : textureManager->fastBudget;
+    return budget == 0 || *get_bytes_used(textureManager, slowRam) + size <= budget;
+}
+
+static void release_memory(Mgpu_TextureManager *textureManager,
+                           void *memory,
+                           size_t size,
+                           bool slowRam,
+                           bool inArena) {
+    *get_bytes_used(textureManager, slowRam) -= size;
+
+    if (inArena) {
+        mgpu_texture_arena_release(get_arena(textureManager, slowRam), memory);
+    } else if (slowRam) {
+        textureManager->allocator->SlowMemFreeFn(memory);
+    } else {
+        textureManager->allocator->FastMemFreeFn(memory);
+    }
+}
+
+void free_texture(Mgpu_Texture *texture, Mgpu_TextureManager *textureManager) {
     assert(texture != NULL);
-    mgpu_alloc_assert(allocator);
+    assert(textureManager != NULL);
+
+    release_memory(textureManager,
+                   texture,
+                   get_texture_size(texture),
+                   texture->allocatedInSlowRam,
+                   texture->allocatedInArena);
+}
+
+/*
+ * Frees retired memory the reader has moved past. If `waitForReader` is set and some of it is
+ * still in use, then this waits for the reader to start another pass so all of it can be freed.
+ * Returns true if any memory was freed.
+ */
+static bool reclaim_retired_memory(Mgpu_TextureManager *textureManager, bool waitForReader) {
+    if (textureManager->retiredCount == 0) {
+        return false;
+    }
+
+    unsigned int readPass = atomic_load_explicit(&textureManager->readPasses, memory_order_acquire);
+    if (waitForReader) {
+        bool inUse = false;
+        for (int x = 0; x < RETIRED_CAPACITY; x++) {
+            Mgpu_RetiredMemory *retired = &textureManager->retired[x];
+            inUse = inUse || (retired->memory != NULL && retired->readPass == readPass);
+        }
+
+        for (uint32_t attempt = 0; inUse; attempt++) {
+            textureManager->waitFn(attempt);
+            inUse = atomic_load_explicit(&textureManager->readPasses, memory_order_acquire) == readPass;
+        }
+
+        readPass = atomic_load_explicit(&textureManager->readPasses, memory_order_acquire);
+    }
 
-    if (texture->allocatedInSlowRam) {
-        allocator->SlowMemFreeFn(texture);
+    bool anyFreed = false;
+    for (int x = 0; x < RETIRED_CAPACITY; x++) {
+        Mgpu_RetiredMemory *retired = &textureManager->retired[x];
+        if (retired->memory != NULL && retired->readPass != readPass) {
+            release_memory(textureManager,
+                           retired->memory,
+                           retired->size,
+                           retired->allocatedInSlowRam,
+                           retired->allocatedInArena);
+
+            retired->memory = NULL;
+            textureManager->retiredCount--;
+            anyFreed = true;
+        }
+    }
+
+    return anyFreed;
+}
+
+/*
+ * Frees memory that's no longer referenced by the texture manager. When frees are deferred the
+ * memory is kept, and still counts against its budget, until the reader has moved past it.
+ */
+static void retire_memory(Mgpu_TextureManager *textureManager,
+                          void *memory,
+                          size_t size,
+                          bool slowRam,
+                          bool inArena) {
+    if (!textureManager->deferFrees) {
+        release_memory(textureManager, memory, size, slowRam, inArena);
+        return;
+    }
+
+    reclaim_retired_memory(textureManager, false);
+    if (textureManager->retiredCount == RETIRED_CAPACITY) {
+        reclaim_retired_memory(textureManager, true);
+    }
+
+    int index = 0;
+    while (textureManager->retired[index].memory != NULL) {
+        index++;
+    }
+
+    // Whatever pass the reader is in now may have looked the memory up before it was unreferenced
+    atomic_thread_fence(memory_order_seq_cst);
+
+    Mgpu_RetiredMemory *retired = &textureManager->retired[index];
+    retired->memory = memory;
+    retired->size = size;
+    retired->allocatedInSlowRam = slowRam;
+    retired->allocatedInArena = inArena;
+    retired->readPass = atomic_load_explicit(&textureManager->readPasses, memory_order_relaxed);
+    textureManager->retiredCount++;
+
+    if (inArena) {
+        mgpu_texture_arena_set_owner(get_arena(textureManager, slowRam), memory, &retired->memory);
+    }
+}
+
+static void retire_texture(Mgpu_Texture *texture, Mgpu_TextureManager *textureManager) {
+    assert(texture != NULL);
+
+    retire_memory(textureManager,
+                  texture,
+                  get_texture_size(texture),
+                  texture->allocatedInSlowRam,
+                  texture->allocatedInArena);
+}
+
+static void retire_font(Mgpu_TextureManager *textureManager, uint8_t index) {
+    Mgpu_UploadedFont *font = textureManager->fonts[index];
+    if (font == NULL) {
+        return;
+    }
+
+    textureManager->fonts[index] = NULL;
+    retire_memory(textureManager, font, font->allocatedSize, font->allocatedInSlowRam, false);
+}
+
+static bool get_font_index(uint8_t id, uint8_t *index) {
+    if (id < MGPU_UPLOADED_FONT_FIRST_ID || id - MGPU_UPLOADED_FONT_FIRST_ID >= NUM_UPLOADED_FONTS) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining font id %u failed as uploaded fonts use ids %u to %u",
+                 id,
+                 MGPU_UPLOADED_FONT_FIRST_ID,
+                 MGPU_UPLOADED_FONT_FIRST_ID + NUM_UPLOADED_FONTS - 1);
+
+        return false;
+    }
+
+    *index = id - MGPU_UPLOADED_FONT_FIRST_ID;
+    return true;
+}
+
+/*
+ * Allocates a blank font of the type in an empty font slot, with room for its glyph tables and
+ * data. Returns NULL if the font doesn't fit.
+ */
+static Mgpu_UploadedFont *allocate_font(Mgpu_TextureManager *textureManager,
+                                        uint8_t index,
+                                        Mgpu_UploadedFontType type,
+                                        uint8_t characterCount,
+                                        uint32_t dataSize) {
+    assert(textureManager->fonts[index] == NULL);
+
+    // Offsets come first so they're aligned, followed by the advances or widths and then the data
+    size_t glyphSize = sizeof(uint32_t) + (type == MGPU_UPLOADED_FONT_OUTLINE ? sizeof(uint16_t) : sizeof(uint8_t));
+    size_t size = sizeof(Mgpu_UploadedFont) + (characterCount * glyphSize) + dataSize;
+    bool allocatedInSlowRam = false;
+    Mgpu_UploadedFont *font = NULL;
+    do {
+        if (fits_in_budget(textureManager, false, size)) {
+            font = textureManager->allocator->FastMemAllocateFn(size);
+            allocatedInSlowRam = false;
+        }
+
+        if (font == NULL && fits_in_budget(textureManager, true, size)) {
+            font = textureManager->allocator->SlowMemAllocateFn(size);
+            allocatedInSlowRam = true;
+        }
+    } while (font == NULL && reclaim_retired_memory(textureManager, true));
+
+    if (font == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining font id %u failed: could not allocate font space",
+                 index + MGPU_UPLOADED_FONT_FIRST_ID);
+
+        return NULL;
+    }
+
+    memset(font, 0, size);
+    font->type = type;
+    font->characterCount = characterCount;
+    font->dataSize = dataSize;
+    font->allocatedSize = size;
+    font->allocatedInSlowRam = allocatedInSlowRam;
+    font->glyphOffsets = (uint32_t *) (font + 1);
+
+    uint8_t *glyphTable = (uint8_t *) (font->glyphOffsets + characterCount);
+    if (type == MGPU_UPLOADED_FONT_OUTLINE) {
+        font->glyphAdvances = (uint16_t *) glyphTable;
+        font->data = (uint8_t *) (font->glyphAdvances + characterCount);
     } else {
-        allocator->FastMemFreeFn(texture);
+        font->glyphWidths = glyphTable;
+        font->data = font->glyphWidths + characterCount;
+    }
+
+    *get_bytes_used(textureManager, allocatedInSlowRam) += size;
+    textureManager->fonts[index] = font;
+
+    return font;
+}
+
+/*
+ * Tries to fit a relocatable texture into one of the arenas, following the same fast then slow
+ * ram preference as individually allocated textures.
+ */
+static Mgpu_Texture *allocate_in_arena(Mgpu_TextureManager *textureManager,
+                                       Mgpu_TextureDefinition *info,
+                                       size_t size,
+                                       bool *allocatedInSlowRam) {
+    bool useSlowRamOnly = (info->flags & MGPU_TEXTURE_USE_SLOW_RAM) == MGPU_TEXTURE_USE_SLOW_RAM;
+    void **owner = (void **) &textureManager->textures[info->id];
+    if (textureManager->fastArena == NULL && textureManager->slowArena == NULL) {
+        return NULL;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        for (int pool = useSlowRamOnly ? 1 : 0; pool < 2; pool++) {
+            Mgpu_TextureArena *arena = get_arena(textureManager, pool == 1);
+            if (arena == NULL || !fits_in_budget(textureManager, pool == 1, size)) {
+                continue;
+            }
+
+            if (attempt > 0) {
+                mgpu_texture_arena_compact(arena);
+            }
+
+            Mgpu_Texture *texture = mgpu_texture_arena_allocate(arena, size, owner);
+            if (texture != NULL) {
+                *allocatedInSlowRam = pool == 1;
+                return texture;
+            }
+        }
+
+        if (!textureManager->compactWhenFull) {
+            break;
+        }
+    }
+
+    textureManager->arenaFallbacks++;
+    return NULL;
+}
+
+/*
+ * Allocates space for a texture, from an arena if it's relocatable and otherwise from the fast
+ * or slow ram allocator. Pools that don't have room left in their budget are skipped.
+ */
+static Mgpu_Texture *allocate_texture(Mgpu_TextureManager *textureManager,
+                                      Mgpu_TextureDefinition *info,
+                                      size_t size,
+                                      bool *allocatedInSlowRam,
+                                      bool *allocatedInArena) {
+    Mgpu_Texture *texture = NULL;
+    *allocatedInArena = false;
+    if ((info->flags & MGPU_TEXTURE_RELOCATABLE) == MGPU_TEXTURE_RELOCATABLE) {
+        texture = allocate_in_arena(textureManager, info, size, allocatedInSlowRam);
+        *allocatedInArena = texture != NULL;
+    }
+
+    if (texture == NULL &&
+        (info->flags & MGPU_TEXTURE_USE_SLOW_RAM) != MGPU_TEXTURE_USE_SLOW_RAM &&
+        fits_in_budget(textureManager, false, size)) {
+        texture = textureManager->allocator->FastMemAllocateFn(size);
+        *allocatedInSlowRam = false;
+    }
+
+    if (texture == NULL && fits_in_budget(textureManager, true, size)) {
+        texture = textureManager->allocator->SlowMemAllocateFn(size);
+        *allocatedInSlowRam = true;
+    }
+
+    return texture;
+}
+
+/*
+ * Returns true if evicting cacheable textures from a pool could make room for a texture. When the
+ * pool's budget is what's in the way, the texture has to fit in it once they're all evicted.
+ * Otherwise evicting only helps if it frees up at least as many bytes as the texture needs.
+ */
+static bool can_evict_for(Mgpu_TextureManager *textureManager, bool slowRam, size_t size) {
+    size_t evictableBytes = 0;
+    for (int x = 0; x < NUM_TEXTURES; x++) {
+        Mgpu_Texture *texture = textureManager->textures[x];
+        if (texture != NULL && texture->isCacheable && texture->allocatedInSlowRam == slowRam) {
+            evictableBytes += get_texture_size(texture);
+        }
+    }
+
+    if (evictableBytes == 0) {
+        return false;
     }
+
+    size_t budget = slowRam ? textureManager->slowBudget : textureManager->fastBudget;
+    size_t bytesUsed = *get_bytes_used(textureManager, slowRam);
+    if (budget > 0 && bytesUsed + size > budget) {
+        return bytesUsed - evictableBytes + size <= budget;
+    }
+
+    return evictableBytes >= size;
 }
 
-Mgpu_TextureManager *mgpu_texture_manager_new(const Mgpu_Allocator *allocator) {
+/*
+ * Retires the cacheable texture that was drawn from the longest time ago, out of the pools
+ * evicting from could make room in. Returns false if there was nothing to evict.
+ */
+static bool evict_least_recently_used(Mgpu_TextureManager *textureManager, bool fromFastRam, bool fromSlowRam) {
+    int oldestId = -1;
+    uint32_t oldestAge = 0;
+    for (int x = 0; x < NUM_TEXTURES; x++) {
+        Mgpu_Texture *texture = textureManager->textures[x];
+        if (texture == NULL || !texture->isCacheable) {
+            continue;
+        }
+
+        if (!(texture->allocatedInSlowRam ? fromSlowRam : fromFastRam)) {
+            continue;
+        }
+
+        // Ages are relative to the counter so they stay ordered when it wraps around
+        uint32_t age = textureManager->useCounter - texture->lastUsed;
+        if (oldestId < 0 || age > oldestAge) {
+            oldestId = x;
+            oldestAge = age;
+        }
+    }
+
+    if (oldestId < 0) {
+        return false;
+    }
+
+    // The strip renderer may still be drawing the evicted texture, so it's retired like any other
+    retire_texture(textureManager->textures[oldestId], textureManager);
+    textureManager->textures[oldestId] = NULL;
+    textureManager->evictedIds[oldestId / 8] |= 1 << (oldestId % 8);
+    textureManager->evictionCount++;
+
+    return true;
+}
+
+Mgpu_TextureManager *mgpu_texture_manager_new(const Mgpu_Allocator *allocator,
+                                              const Mgpu_TextureManagerOptions *options) {
     mgpu_alloc_assert(allocator);
+    assert(options != NULL);
+    assert(!options->deferFrees || options->waitFn != NULL);
 
     Mgpu_TextureManager *manager = allocator->FastMemAllocateFn(sizeof(Mgpu_TextureManager));
     if (manager == NULL) {
@@ -35,6 +430,25 @@ Mgpu_TextureManager *mgpu_texture_manager_new(const Mgpu_Allocator *allocator) {
         return NULL;
     }
 
+    manager->allocator = allocator;
+    manager->subTextures = NULL;
+    memset(manager->fonts, 0, sizeof(manager->fonts));
+    manager->fastArena = NULL;
+    manager->slowArena = NULL;
+    manager->compactWhenFull = options->compactWhenFull;
+    manager->arenaFallbacks = 0;
+    manager->fastBudget = options->fastBudget;
+    manager->slowBudget = options->slowBudget;
+    manager->fastBytesUsed = 0;
+    manager->slowBytesUsed = 0;
+    manager->useCounter = 0;
+    manager->evictionCount = 0;
+    memset(manager->evictedIds, 0, sizeof(manager->evictedIds));
+    manager->deferFrees = options->deferFrees;
+    manager->waitFn = options->waitFn;
+    atomic_init(&manager->readPasses, 0);
+    memset(manager->retired, 0, sizeof(manager->retired));
+    manager->retiredCount = 0;
     manager->textures = allocator->FastMemAllocateFn(sizeof(Mgpu_Texture *) * NUM_TEXTURES);
     if (manager->textures == NULL) {
         char *message = mgpu_message_get_pointer();
@@ -46,9 +460,37 @@ Mgpu_TextureManager *mgpu_texture_manager_new(const Mgpu_Allocator *allocator) {
         return NULL;
     }
 
-    manager->allocator = allocator;
     memset(manager->textures, 0, sizeof(Mgpu_Texture *) * NUM_TEXTURES);
 
+    manager->subTextures = allocator->FastMemAllocateFn(sizeof(Mgpu_SubTexture) * NUM_SUB_TEXTURES);
+    if (manager->subTextures == NULL) {
+        char *message = mgpu_message_get_pointer();
+        assert(message != NULL);
+
+        strncpy(message, "Failed to allocate sub-texture array", MESSAGE_MAX_LEN);
+        mgpu_texture_manager_free(manager);
+
+        return NULL;
+    }
+
+    memset(manager->subTextures, 0, sizeof(Mgpu_SubTexture) * NUM_SUB_TEXTURES);
+
+    if (options->fastArenaSize > 0) {
+        manager->fastArena = mgpu_texture_arena_new(allocator, false, options->fastArenaSize);
+        if (manager->fastArena == NULL) {
+            mgpu_texture_manager_free(manager);
+            return NULL;
+        }
+    }
+
+    if (options->slowArenaSize > 0) {
+        manager->slowArena = mgpu_texture_arena_new(allocator, true, options->slowArenaSize);
+        if (manager->slowArena == NULL) {
+            mgpu_texture_manager_free(manager);
+            return NULL;
+        }
+    }
+
     return manager;
 }
 
@@ -57,7 +499,7 @@ void mgpu_texture_manager_free(Mgpu_TextureManager *textureManager) {
         if (textureManager->textures != NULL) {
             for (int x = 0; x < NUM_TEXTURES; x++) {
                 if (textureManager->textures[x] != NULL) {
-                    free_texture(textureManager->textures[x], textureManager->allocator);
+                    free_texture(textureManager->textures[x], textureManager);
                     textureManager->textures[x] = NULL;
                 }
             }
@@ -66,6 +508,23 @@ void mgpu_texture_manager_free(Mgpu_TextureManager *textureManager) {
             textureManager->textures = NULL;
         }
 
+        // Nothing can be reading from the texture manager once it's being freed
+        textureManager->deferFrees = false;
+        for (int x = 0; x < NUM_UPLOADED_FONTS; x++) {
+            retire_font(textureManager, x);
+        }
+
+        atomic_fetch_add_explicit(&textureManager->readPasses, 1, memory_order_acq_rel);
+        reclaim_retired_memory(textureManager, false);
+
+        if (textureManager->subTextures != NULL) {
+            textureManager->allocator->FastMemFreeFn(textureManager->subTextures);
+            textureManager->subTextures = NULL;
+        }
+
+        mgpu_texture_arena_free(textureManager->fastArena);
+        mgpu_texture_arena_free(textureManager->slowArena);
+
         textureManager->allocator->FastMemFreeFn(textureManager);
     }
 }
@@ -88,10 +547,15 @@ bool mgpu_texture_define(Mgpu_TextureManager *textureManager, Mgpu_TextureDefini
         return false;
     }
 
+    reclaim_retired_memory(textureManager, false);
+
+    // Once a texture is defined again the caller knows what it holds, evicted or not
+    textureManager->evictedIds[info->id / 8] &= ~(1 << (info->id % 8));
+
     Mgpu_Texture *texture = textureManager->textures[info->id];
     if (texture != NULL) {
         // Texture is being redefined
-        free_texture(texture, textureManager->allocator);
+        retire_texture(texture, textureManager);
         textureManager->textures[info->id] = NULL;
         texture = NULL;
     }
@@ -101,17 +565,29 @@ bool mgpu_texture_define(Mgpu_TextureManager *textureManager, Mgpu_TextureDefini
 
     size_t pixelCount = width * height;
     if (pixelCount > 0) {
-        bool allocatedInSlowRam;
-        if ((info->flags & MGPU_TEXTURE_USE_SLOW_RAM) != MGPU_TEXTURE_USE_SLOW_RAM) {
-            texture = textureManager->allocator->FastMemAllocateFn(
-                    sizeof(Mgpu_Texture) + pixelCount * sizeof(Mgpu_Color));
-            allocatedInSlowRam = false;
-        }
+        bool hasPixels = (info->flags & MGPU_TEXTURE_NO_PIXELS) != MGPU_TEXTURE_NO_PIXELS;
+        size_t pixelBytes = hasPixels ? pixelCount * sizeof(Mgpu_Color) : 0;
+        size_t size = sizeof(Mgpu_Texture) + pixelBytes;
+        bool useSlowRamOnly = (info->flags & MGPU_TEXTURE_USE_SLOW_RAM) == MGPU_TEXTURE_USE_SLOW_RAM;
+        bool canEvictSlow = can_evict_for(textureManager, true, size);
+        bool canEvictFast = !useSlowRamOnly && can_evict_for(textureManager, false, size);
+
+        bool allocatedInSlowRam = false;
+        bool allocatedInArena = false;
+        while (true) {
+            texture = allocate_texture(textureManager, info, size, &allocatedInSlowRam, &allocatedInArena);
+            if (texture != NULL) {
+                break;
+            }
 
-        if (texture == NULL) {
-            texture = textureManager->allocator->SlowMemAllocateFn(
-                    sizeof(Mgpu_Texture) + pixelCount * sizeof(Mgpu_Color));
-            allocatedInSlowRam = true;
+            // Memory that's only waiting on the reader is freed before anything is evicted
+            if (reclaim_retired_memory(textureManager, true)) {
+                continue;
+            }
+
+            if (!evict_least_recently_used(textureManager, canEvictFast, canEvictSlow)) {
+                break;
+            }
         }
 
         if (texture == NULL) {
@@ -130,9 +606,14 @@ bool mgpu_texture_define(Mgpu_TextureManager *textureManager, Mgpu_TextureDefini
         texture->pixelsWritten = 0;
         texture->scale = scale;
         texture->allocatedInSlowRam = allocatedInSlowRam;
+        texture->allocatedInArena = allocatedInArena;
+        texture->hasPixels = hasPixels;
+        texture->isCacheable = (info->flags & MGPU_TEXTURE_CACHEABLE) == MGPU_TEXTURE_CACHEABLE;
+        texture->lastUsed = ++textureManager->useCounter;
+        *get_bytes_used(textureManager, allocatedInSlowRam) += size;
 
         Mgpu_Color color = mgpu_color_from_rgb888(0, 0, 0);
-        memset(texture->pixels, color, width * height * sizeof(Mgpu_Color));
+        memset(texture->pixels, color, pixelBytes);
         textureManager->textures[info->id] = texture;
     }
 
@@ -157,6 +638,177 @@ Mgpu_Texture *mgpu_texture_get(Mgpu_TextureManager *textureManager, uint8_t id)
     return textureManager->textures[id];
 }
 
+bool mgpu_texture_define_sub(Mgpu_TextureManager *textureManager, uint16_t subTextureId, const Mgpu_SubTexture *info) {
+    assert(textureManager != NULL);
+    assert(info != NULL);
+
+    if (subTextureId >= NUM_SUB_TEXTURES) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+
+        snprintf(msg,
+                 MESSAGE_MAX_LEN,
+                 "Defining sub-texture id %u failed as id larger than set count of %u",
+                 subTextureId, NUM_SUB_TEXTURES);
+
+        return false;
+    }
+
+    Mgpu_SubTexture *subTexture = &textureManager->subTextures[subTextureId];
+    if (info->width == 0 || info->height == 0) {
+        memset(subTexture, 0, sizeof(Mgpu_SubTexture));
+    } else {
+        *subTexture = *info;
+    }
+
+    return true;
+}
+
+const Mgpu_SubTexture *mgpu_texture_get_sub(Mgpu_TextureManager *textureManager, uint16_t subTextureId) {
+    assert(textureManager != NULL);
+
+    if (subTextureId >= NUM_SUB_TEXTURES || textureManager->subTextures[subTextureId].width == 0) {
+        return NULL;
+    }
+
+    return &textureManager->subTextures[subTextureId];
+}
+
+bool mgpu_texture_define_font(Mgpu_TextureManager *textureManager, const Mgpu_FontDefinition *info) {
+    assert(textureManager != NULL);
+    assert(info != NULL);
+
+    uint8_t index;
+    if (!get_font_index(info->id, &index)) {
+        return false;
+    }
+
+    reclaim_retired_memory(textureManager, false);
+    retire_font(textureManager, index);
+    if (info->characterCount == 0) {
+        return true;
+    }
+
+    Mgpu_UploadedFont *font = allocate_font(textureManager, index, MGPU_UPLOADED_FONT_BITMAP, info->characterCount, info->bitmapSize);
+    if (font == NULL) {
+        return false;
+    }
+
+    assert(info->glyphs != NULL);
+
+    font->height = info->height;
+    font->firstCharacter = info->firstCharacter;
+    for (int x = 0; x < info->characterCount; x++) {
+        const uint8_t *glyph = info->glyphs + (x * 3);
+        font->glyphWidths[x] = glyph[0];
+        font->glyphOffsets[x] = ((uint16_t) glyph[1] << 8) | glyph[2];
+        font->maxWidth = max(font->maxWidth, glyph[0]);
+    }
+
+    return true;
+}
+
+bool mgpu_texture_define_outline_font(Mgpu_TextureManager *textureManager, const Mgpu_OutlineFontDefinition *info) {
+    assert(textureManager != NULL);
+    assert(info != NULL);
+
+    uint8_t index;
+    if (!get_font_index(info->id, &index)) {
+        return false;
+    }
+
+    reclaim_retired_memory(textureManager, false);
+    retire_font(textureManager, index);
+    if (info->characterCount == 0) {
+        return true;
+    }
+
+    Mgpu_UploadedFont *font = allocate_font(textureManager, index, MGPU_UPLOADED_FONT_OUTLINE, info->characterCount, info->outlineSize);
+    if (font == NULL) {
+        return false;
+    }
+
+    assert(info->glyphs != NULL);
+
+    font->firstCharacter = info->firstCharacter;
+    font->unitsPerEm = info->unitsPerEm;
+    font->ascent = info->ascent;
+    font->descent = info->descent;
+    for (int x = 0; x < info->characterCount; x++) {
+        const uint8_t *glyph = info->glyphs + (x * 4);
+        font->glyphAdvances[x] = ((uint16_t) glyph[0] << 8) | glyph[1];
+        font->glyphOffsets[x] = ((uint16_t) glyph[2] << 8) | glyph[3];
+    }
+
+    return true;
+}
+
+Mgpu_UploadedFont *mgpu_texture_define_coverage_font(Mgpu_TextureManager *textureManager,
+                                                     const Mgpu_CoverageFontDefinition *info) {
+    assert(textureManager != NULL);
+    assert(info != NULL);
+    assert(info->glyphWidths != NULL || info->characterCount == 0);
+
+    uint32_t dataSize = 0;
+    for (int x = 0; x < info->characterCount; x++) {
+        dataSize += (uint32_t) info->glyphWidths[x] * info->height;
+    }
+
+    uint8_t index;
+    if (!get_font_index(info->id, &index)) {
+        return NULL;
+    }
+
+    reclaim_retired_memory(textureManager, false);
+    retire_font(textureManager, index);
+    if (info->characterCount == 0) {
+        return NULL;
+    }
+
+    Mgpu_UploadedFont *font = allocate_font(textureManager, index, MGPU_UPLOADED_FONT_COVERAGE, info->characterCount, dataSize);
+    if (font == NULL) {
+        return NULL;
+    }
+
+    font->height = info->height;
+    font->firstCharacter = info->firstCharacter;
+    font->dataBytesWritten = dataSize;
+
+    uint32_t offset = 0;
+    for (int x = 0; x < info->characterCount; x++) {
+        font->glyphWidths[x] = info->glyphWidths[x];
+        font->glyphOffsets[x] = offset;
+        font->maxWidth = max(font->maxWidth, info->glyphWidths[x]);
+        offset += (uint32_t) info->glyphWidths[x] * info->height;
+    }
+
+    return font;
+}
+
+Mgpu_UploadedFont *mgpu_texture_get_font(Mgpu_TextureManager *textureManager, uint8_t id) {
+    assert(textureManager != NULL);
+
+    if (id < MGPU_UPLOADED_FONT_FIRST_ID || id - MGPU_UPLOADED_FONT_FIRST_ID >= NUM_UPLOADED_FONTS) {
+        return NULL;
+    }
+
+    return textureManager->fonts[id - MGPU_UPLOADED_FONT_FIRST_ID];
+}
+
+void mgpu_texture_manager_begin_read_pass(Mgpu_TextureManager *textureManager) {
+    assert(textureManager != NULL);
+
+    atomic_fetch_add_explicit(&textureManager->readPasses, 1, memory_order_acq_rel);
+}
+
+void mgpu_texture_mark_used(Mgpu_TextureManager *textureManager, uint8_t id) {
+    assert(textureManager != NULL);
+
+    if (id < NUM_TEXTURES && textureManager->textures[id] != NULL) {
+        textureManager->textures[id]->lastUsed = ++textureManager->useCounter;
+    }
+}
+
 void mgpu_texture_swap(Mgpu_TextureManager *textureManager, uint8_t firstId, uint8_t secondId) {
     assert(textureManager != NULL);
     assert(textureManager->textures[firstId] != NULL);
@@ -166,4 +818,68 @@ void mgpu_texture_swap(Mgpu_TextureManager *textureManager, uint8_t firstId, uin
     textureManager->textures[firstId] = textureManager->textures[secondId];
     textureManager->textures[secondId] = temp;
 
+    // Arena textures need to know which id they are now kept under, in case they are relocated
+    for (int x = 0; x < 2; x++) {
+        uint8_t id = x == 0 ? firstId : secondId;
+        Mgpu_Texture *texture = textureManager->textures[id];
+        if (texture->allocatedInArena) {
+            mgpu_texture_arena_set_owner(get_arena(textureManager, texture->allocatedInSlowRam),
+                                         texture,
+                                         (void **) &textureManager->textures[id]);
+        }
+    }
+}
+
+void mgpu_texture_manager_compact(Mgpu_TextureManager *textureManager) {
+    assert(textureManager != NULL);
+
+    if (textureManager->fastArena != NULL) {
+        mgpu_texture_arena_compact(textureManager->fastArena);
+    }
+
+    if (textureManager->slowArena != NULL) {
+        mgpu_texture_arena_compact(textureManager->slowArena);
+    }
+}
+
+void mgpu_texture_manager_get_stats(Mgpu_TextureManager *textureManager, Mgpu_TextureManagerStats *stats) {
+    assert(textureManager != NULL);
+    assert(stats != NULL);
+
+    memset(stats, 0, sizeof(Mgpu_TextureManagerStats));
+    stats->arenaFallbacks = textureManager->arenaFallbacks;
+
+    if (textureManager->fastArena != NULL) {
+        mgpu_texture_arena_get_stats(textureManager->fastArena, &stats->fastArena);
+    }
+
+    if (textureManager->slowArena != NULL) {
+        mgpu_texture_arena_get_stats(textureManager->slowArena, &stats->slowArena);
+    }
+}
+
+void mgpu_texture_manager_get_usage(Mgpu_TextureManager *textureManager, Mgpu_TextureUsage *usage) {
+    assert(textureManager != NULL);
+    assert(usage != NULL);
+
+    usage->fastBytesUsed = textureManager->fastBytesUsed;
+    usage->fastBudget = textureManager->fastBudget;
+    usage->slowBytesUsed = textureManager->slowBytesUsed;
+    usage->slowBudget = textureManager->slowBudget;
+    usage->evictionCount = textureManager->evictionCount;
+    usage->textureCount = 0;
+    for (int x = 0; x < NUM_TEXTURES; x++) {
+        if (textureManager->textures[x] != NULL) {
+            usage->textureCount++;
+        }
+    }
+}
+
+void mgpu_texture_manager_take_evicted_ids(Mgpu_TextureManager *textureManager,
+                                           uint8_t evictedIds[MGPU_TEXTURE_ID_BITMAP_SIZE]) {
+    assert(textureManager != NULL);
+    assert(evictedIds != NULL);
+
+    memcpy(evictedIds, textureManager->evictedIds, MGPU_TEXTURE_ID_BITMAP_SIZE);
+    memset(textureManager->evictedIds, 0, MGPU_TEXTURE_ID_BITMAP_SIZE);
 }
@@ -4,15 +4,49 @@
 #include <stdbool.h>
 #include "alloc.h"
 #include "microgpu-common/colors/color.h"
+#include "texture_arena.h"
 
 #define NUM_TEXTURES 255
 
+/*
+ * Number of bytes needed for a bitmap with a bit for every texture id
+ */
+#define MGPU_TEXTURE_ID_BITMAP_SIZE 32
+
+#define NUM_SUB_TEXTURES 512
+
+/*
+ * Fonts uploaded by clients use ids from here up, so they never share an id with a built-in font
+ */
+#define MGPU_UPLOADED_FONT_FIRST_ID 16
+#define NUM_UPLOADED_FONTS 16
+
 typedef enum {
     /*
      * If set, then the texture should be allocated via the slow ram allocator. Otherwise, the texture should be
      * allocated in fast ram. If the fast ram allocation fails, it will attempt the slow ram.
      */
     MGPU_TEXTURE_USE_SLOW_RAM = 1 << 0,
+
+    /*
+     * If set, then no pixels are allocated for the texture and only its dimensions are tracked.
+     * Used for the frame buffer when frames are rendered in strips instead of into a frame buffer.
+     */
+    MGPU_TEXTURE_NO_PIXELS = 1 << 1,
+
+    /*
+     * If set, then the texture may be placed in the texture arena of the ram it's allocated in,
+     * and moved around when the arena is compacted. Only textures nothing keeps a pointer to
+     * outside of the texture manager should be relocatable.
+     */
+    MGPU_TEXTURE_RELOCATABLE = 1 << 2,
+
+    /*
+     * If set, then the texture may be evicted when memory is needed for another texture. The
+     * least recently drawn cacheable textures are evicted first, and evicted ids are recorded
+     * until they are taken by `mgpu_texture_manager_take_evicted_ids()`.
+     */
+    MGPU_TEXTURE_CACHEABLE = 1 << 3,
 } Mgpu_TextureDefinitionFlags;
 
 typedef struct {
@@ -33,17 +67,206 @@ typedef struct {
     uint8_t scale;
     size_t pixelsWritten;
     bool allocatedInSlowRam;
+    bool allocatedInArena;
+    bool isCacheable;
+
+    /*
+     * When the texture was last drawn from, relative to other textures. Used to pick which
+     * cacheable texture to evict first.
+     */
+    uint32_t lastUsed;
+
+    /*
+     * False if the texture was defined with `MGPU_TEXTURE_NO_PIXELS`, and thus `pixels` can't
+     * be read from or written to.
+     */
+    bool hasPixels;
     Mgpu_Color pixels[];
 } Mgpu_Texture;
 
+/*
+ * A named rectangle inside of another texture, such as a single sprite inside of an atlas.
+ * The rectangle is checked against the texture each time it's drawn, so sub-textures stay
+ * registered while the texture they're in is undefined, evicted or redefined.
+ */
+typedef struct {
+    uint8_t textureId;
+    uint16_t x, y, width, height;
+} Mgpu_SubTexture;
+
+typedef struct {
+    uint8_t id;
+    uint8_t height;
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+    uint16_t bitmapSize;
+
+    /*
+     * Three bytes for each character: how many pixels wide its glyph is, then the big endian
+     * offset of the bitmap byte the glyph's rows start at.
+     */
+    const uint8_t *glyphs;
+} Mgpu_FontDefinition;
+
+typedef struct {
+    uint8_t id;
+
+    /*
+     * Size of the em square in font units, which is what's scaled to a coverage font's pixel size
+     */
+    uint16_t unitsPerEm;
+
+    /*
+     * How many font units lines extend above and below the baseline
+     */
+    uint16_t ascent, descent;
+
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+    uint16_t outlineSize;
+
+    /*
+     * Four bytes for each character: how many font units it advances, then the offset of the
+     * outline byte its contours start at, both as big endian values.
+     */
+    const uint8_t *glyphs;
+} Mgpu_OutlineFontDefinition;
+
+typedef struct {
+    uint8_t id;
+    uint8_t height;
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+
+    /*
+     * How many pixels wide each character's glyph is
+     */
+    const uint8_t *glyphWidths;
+} Mgpu_CoverageFontDefinition;
+
+typedef enum {
+    /*
+     * Glyphs are one bit per pixel, with the data appended by the client
+     */
+    MGPU_UPLOADED_FONT_BITMAP = 0,
+
+    /*
+     * Glyphs are quadratic contours in font units, with the data appended by the client. Outline
+     * fonts aren't drawn directly, but are rasterized into coverage fonts at a pixel size.
+     */
+    MGPU_UPLOADED_FONT_OUTLINE = 1,
+
+    /*
+     * Glyphs are a byte per pixel of how much of the pixel the glyph covers, from 0 to 255
+     */
+    MGPU_UPLOADED_FONT_COVERAGE = 2,
+} Mgpu_UploadedFontType;
+
+/*
+ * A font defined by a client. Its data starts out blank, and is filled in by appending bytes to it
+ * or, for coverage fonts, by rasterizing glyphs into it.
+ */
+typedef struct {
+    Mgpu_UploadedFontType type;
+    uint8_t firstCharacter;
+    uint8_t characterCount;
+
+    /*
+     * Height of every glyph in pixels, and the width of the widest one. Not used by outline fonts.
+     */
+    uint8_t height;
+    uint8_t maxWidth;
+
+    /*
+     * Only used by outline fonts, in font units
+     */
+    uint16_t unitsPerEm, ascent, descent;
+
+    uint32_t dataSize;
+    uint32_t dataBytesWritten;
+    size_t allocatedSize;
+    bool allocatedInSlowRam;
+
+    /*
+     * How many pixels wide each glyph of a bitmap or coverage font is
+     */
+    uint8_t *glyphWidths;
+
+    /*
+     * How many font units each glyph of an outline font advances
+     */
+    uint16_t *glyphAdvances;
+
+    /*
+     * The byte of the data each glyph starts at
+     */
+    uint32_t *glyphOffsets;
+
+    uint8_t *data;
+} Mgpu_UploadedFont;
+
 typedef struct Mgpu_TextureManager Mgpu_TextureManager;
 
+typedef struct {
+    /*
+     * Bytes of fast and slow ram to reserve up front for relocatable textures. Zero means
+     * relocatable textures are allocated individually, like any other texture.
+     */
+    size_t fastArenaSize;
+    size_t slowArenaSize;
+
+    /*
+     * If set, then when a relocatable texture doesn't fit in an arena it's compacted and the
+     * allocation is tried again. Compaction moves textures, so it must not be enabled if
+     * textures may be read from another thread while operations are being executed.
+     */
+    bool compactWhenFull;
+
+    /*
+     * The most bytes textures may take up in fast and slow ram, including the framebuffer if it
+     * was defined in that ram. Zero means a pool is only limited by how much can be allocated.
+     */
+    size_t fastBudget;
+    size_t slowBudget;
+
+    /*
+     * If set, then memory of undefined, redefined and evicted textures and fonts isn't freed
+     * until the thread reading them has started another read pass, since it may still be drawing
+     * from it. Defining a texture or font waits on the reader through `waitFn` when its memory is
+     * held up by retired ones, so the reader must keep starting passes while operations execute.
+     */
+    bool deferFrees;
+    void (*waitFn)(uint32_t attempt);
+} Mgpu_TextureManagerOptions;
+
+typedef struct {
+    size_t fastBytesUsed, fastBudget;
+    size_t slowBytesUsed, slowBudget;
+    uint8_t textureCount;
+
+    /*
+     * How many textures have been evicted since the texture manager was created
+     */
+    uint32_t evictionCount;
+} Mgpu_TextureUsage;
+
+typedef struct {
+    Mgpu_TextureArenaStats fastArena;
+    Mgpu_TextureArenaStats slowArena;
+
+    /*
+     * Relocatable textures that didn't fit in an arena, and were allocated individually instead
+     */
+    uint32_t arenaFallbacks;
+} Mgpu_TextureManagerStats;
+
 /*
  * Creates a new texture manager instance. The allocator provided will not only be
  * used to allocate the texture manager itself, but also all textures that get
  * defined.
  */
-Mgpu_TextureManager *mgpu_texture_manager_new(const Mgpu_Allocator *allocator);
+Mgpu_TextureManager *mgpu_texture_manager_new(const Mgpu_Allocator *allocator,
+                                              const Mgpu_TextureManagerOptions *options);
 
 /*
  * Uninitializes and frees memory used by the texture manager. It gets freed
@@ -66,7 +289,84 @@ bool mgpu_texture_define(Mgpu_TextureManager *textureManager, Mgpu_TextureDefini
  */
 Mgpu_Texture *mgpu_texture_get(Mgpu_TextureManager *textureManager, uint8_t id);
 
+/*
+ * Registers a sub-texture under the specified id, replacing any sub-texture previously registered
+ * with it. If the width or height are zero, then the sub-texture id is cleared.
+ *
+ * Returns false if the sub-texture id is out of range.
+ */
+bool mgpu_texture_define_sub(Mgpu_TextureManager *textureManager, uint16_t subTextureId, const Mgpu_SubTexture *info);
+
+/*
+ * Retrieves the sub-texture registered with the specified id, or NULL if none is.
+ */
+const Mgpu_SubTexture *mgpu_texture_get_sub(Mgpu_TextureManager *textureManager, uint16_t subTextureId);
+
+/*
+ * Defines a font under the specified id, replacing any font previously defined with it. Fonts are
+ * allocated from fast ram when they fit, and count against the same budgets as textures. If the
+ * character count is zero, then the font id is cleared. Every glyph must fit inside the bitmap.
+ *
+ * Returns false if the font could not be defined for any reason.
+ */
+bool mgpu_texture_define_font(Mgpu_TextureManager *textureManager, const Mgpu_FontDefinition *info);
+
+/*
+ * Defines an outline font under the specified id, the same way as a bitmap font is defined. Every
+ * glyph's offset must be inside the outline data.
+ */
+bool mgpu_texture_define_outline_font(Mgpu_TextureManager *textureManager, const Mgpu_OutlineFontDefinition *info);
+
+/*
+ * Defines a coverage font under the specified id, replacing any font previously defined with it.
+ * Glyphs are laid out one after another with a byte per pixel, and start out with no coverage
+ * for the caller to rasterize into. Returns NULL if the font could not be defined.
+ */
+Mgpu_UploadedFont *mgpu_texture_define_coverage_font(Mgpu_TextureManager *textureManager,
+                                                     const Mgpu_CoverageFontDefinition *info);
+
+/*
+ * Retrieves the font defined with the specified id, or NULL if none is.
+ */
+Mgpu_UploadedFont *mgpu_texture_get_font(Mgpu_TextureManager *textureManager, uint8_t id);
+
+/*
+ * Marks the start of another pass over textures and fonts by a thread other than the one
+ * executing operations, such as a display rendering strips. Textures and fonts retired before
+ * this are no longer being read by it once this is called.
+ */
+void mgpu_texture_manager_begin_read_pass(Mgpu_TextureManager *textureManager);
+
+/*
+ * Records that the texture is being drawn from, making it the last cacheable texture to be evicted.
+ */
+void mgpu_texture_mark_used(Mgpu_TextureManager *textureManager, uint8_t id);
+
 /*
  * Swaps two textures so their ids are reversed.
  */
 void mgpu_texture_swap(Mgpu_TextureManager *textureManager, uint8_t firstId, uint8_t secondId);
+
+/*
+ * Compacts both texture arenas, so all of their free space is in one block. The ids of
+ * relocated textures stay the same, but pointers to them retrieved earlier are no longer valid.
+ */
+void mgpu_texture_manager_compact(Mgpu_TextureManager *textureManager);
+
+/*
+ * Gets a snapshot of how texture memory is being used. Stats for an arena that isn't being used
+ * are all zero.
+ */
+void mgpu_texture_manager_get_stats(Mgpu_TextureManager *textureManager, Mgpu_TextureManagerStats *stats);
+
+/*
+ * Gets how many bytes of each pool textures are taking up, and what they are limited to.
+ */
+void mgpu_texture_manager_get_usage(Mgpu_TextureManager *textureManager, Mgpu_TextureUsage *usage);
+
+/*
+ * Copies a bitmap of texture ids that were evicted and haven't been redefined since, with bit
+ * `id % 8` of byte `id / 8` set for each one, then clears the recorded evictions.
+ */
+void mgpu_texture_manager_take_evicted_ids(Mgpu_TextureManager *textureManager,
+                                           uint8_t evictedIds[MGPU_TEXTURE_ID_BITMAP_SIZE]);
@@ -0,0 +1,347 @@
+#include <assert.h>
+#include <string.h>
+#include "common.h"
+#include "messages.h"
+#include "operations/execution/drawing/draw_operation.h"
+#include "operations/operation_deserializer.h"
+#include "tile_binner.h"
+
+#define NO_ENTRY UINT16_MAX
+
+typedef struct {
+    uint16_t operationIndex;
+    uint16_t next;
+} BinEntry;
+
+typedef struct {
+    uint16_t first, last;
+} Bin;
+
+struct Mgpu_TileBinner {
+    const Mgpu_Allocator *allocator;
+    uint8_t tileSize;
+
+    Mgpu_Operation *operations;
+    uint16_t operationCapacity, operationCount;
+
+    BinEntry *entries;
+    uint16_t entryCapacity, entryCount;
+
+    uint8_t *payloadArena;
+    size_t payloadArenaSize, payloadArenaUsed;
+
+    // Sized for the framebuffer the bins were last set up for
+    Bin *bins;
+    uint16_t tileColumns, tileRows;
+    uint16_t frameBufferWidth, frameBufferHeight;
+
+    Mgpu_Color *tileBuffer;
+
+    // Presenting clears the framebuffer, so until something else draws to it tiles can start
+    // out cleared instead of being read from the framebuffer.
+    bool presentRequested;
+    bool frameBufferIsClear;
+
+    Mgpu_TileBinnerStats stats;
+};
+
+static void clear_bins(Mgpu_TileBinner *binner) {
+    for (int x = 0; x < binner->tileColumns * binner->tileRows; x++) {
+        binner->bins[x].first = NO_ENTRY;
+        binner->bins[x].last = NO_ENTRY;
+    }
+
+    binner->operationCount = 0;
+    binner->entryCount = 0;
+    binner->payloadArenaUsed = 0;
+}
+
+/*
+ * Makes sure there's a bin for each tile of the framebuffer. Returns false if bins could not
+ * be allocated.
+ */
+static bool prepare_bins(Mgpu_TileBinner *binner, Mgpu_Texture *frameBuffer) {
+    if (binner->bins != NULL &&
+        binner->frameBufferWidth == frameBuffer->width &&
+        binner->frameBufferHeight == frameBuffer->height) {
+        return true;
+    }
+
+    // Bins only change size when the framebuffer does, which can't happen with operations recorded
+    assert(binner->operationCount == 0);
+
+    if (binner->bins != NULL) {
+        binner->allocator->FastMemFreeFn(binner->bins);
+    }
+
+    binner->tileColumns = (frameBuffer->width + binner->tileSize - 1) / binner->tileSize;
+    binner->tileRows = (frameBuffer->height + binner->tileSize - 1) / binner->tileSize;
+    binner->bins = binner->allocator->FastMemAllocateFn(sizeof(Bin) * binner->tileColumns * binner->tileRows);
+    if (binner->bins == NULL) {
+        binner->tileColumns = binner->tileRows = 0;
+        return false;
+    }
+
+    binner->frameBufferWidth = frameBuffer->width;
+    binner->frameBufferHeight = frameBuffer->height;
+    binner->frameBufferIsClear = false;
+    clear_bins(binner);
+
+    return true;
+}
+
+static void render_tile(Mgpu_TileBinner *binner,
+                        Mgpu_TextureManager *textureManager,
+                        Mgpu_Texture *frameBuffer,
+                        uint16_t column,
+                        uint16_t row) {
+    uint16_t startX = column * binner->tileSize;
+    uint16_t startY = row * binner->tileSize;
+    uint16_t width = min(binner->tileSize, frameBuffer->width - startX);
+    uint16_t height = min(binner->tileSize, frameBuffer->height - startY);
+
+    Mgpu_DrawRegion region = {
+            .pixels = binner->tileBuffer,
+            .stride = binner->tileSize,
+            .originX = startX,
+            .originY = startY,
+            .clip = {
+                    .left = startX,
+                    .top = startY,
+                    .right = startX + width,
+                    .bottom = startY + height,
+            },
+    };
+
+    Mgpu_Color *frameBufferStart = frameBuffer->pixels + (startY * frameBuffer->width) + startX;
+    if (binner->frameBufferIsClear) {
+        Mgpu_Color color = mgpu_color_from_rgb888(0, 0, 0);
+        memset(binner->tileBuffer, color, sizeof(Mgpu_Color) * binner->tileSize * height);
+    } else {
+        for (int y = 0; y < height; y++) {
+            memcpy(binner->tileBuffer + (y * binner->tileSize),
+                   frameBufferStart + (y * frameBuffer->width),
+                   sizeof(Mgpu_Color) * width);
+        }
+    }
+
+    Bin *bin = &binner->bins[(row * binner->tileColumns) + column];
+    for (uint16_t index = bin->first; index != NO_ENTRY; index = binner->entries[index].next) {
+        Mgpu_Operation *operation = &binner->operations[binner->entries[index].operationIndex];
+        mgpu_draw_operation_in_region(operation, textureManager, &region);
+    }
+
+    for (int y = 0; y < height; y++) {
+        memcpy(frameBufferStart + (y * frameBuffer->width),
+               binner->tileBuffer + (y * binner->tileSize),
+               sizeof(Mgpu_Color) * width);
+    }
+}
+
+static void flush(void *context, Mgpu_TextureManager *textureManager) {
+    Mgpu_TileBinner *binner = context;
+
+    if (binner->operationCount > 0) {
+        Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
+        assert(frameBuffer != NULL);
+
+        for (uint16_t row = 0; row < binner->tileRows; row++) {
+            for (uint16_t column = 0; column < binner->tileColumns; column++) {
+                if (binner->bins[(row * binner->tileColumns) + column].first == NO_ENTRY) {
+                    binner->stats.tilesSkipped++;
+                } else {
+                    render_tile(binner, textureManager, frameBuffer, column, row);
+                    binner->stats.tilesRendered++;
+                }
+            }
+        }
+
+        clear_bins(binner);
+        if (!binner->presentRequested) {
+            binner->stats.earlyFlushes++;
+        }
+    }
+
+    // Whatever is executed after a flush may draw to the framebuffer, unless it's a present
+    binner->frameBufferIsClear = binner->presentRequested;
+    binner->presentRequested = false;
+}
+
+/*
+ * Copies the operation into the binner, so it stays valid until the frame is presented. Returns
+ * NULL if there's no room for it.
+ */
+static Mgpu_Operation *record_operation(Mgpu_TileBinner *binner, Mgpu_Operation *operation) {
+    if (binner->operationCount >= binner->operationCapacity) {
+        return NULL;
+    }
+
+    Mgpu_Operation *copy = &binner->operations[binner->operationCount];
+    *copy = *operation;
+
+    const uint8_t **payloadField;
+    size_t payloadSize = mgpu_operation_get_payload(copy, &payloadField);
+    if (payloadSize > 0) {
+        if (binner->payloadArenaUsed + payloadSize > binner->payloadArenaSize) {
+            return NULL;
+        }
+
+        memcpy(binner->payloadArena + binner->payloadArenaUsed, *payloadField, payloadSize);
+        *payloadField = binner->payloadArena + binner->payloadArenaUsed;
+        binner->payloadArenaUsed += payloadSize;
+    }
+
+    binner->operationCount++;
+    return copy;
+}
+
+static bool submit(void *context, Mgpu_Operation *operation, Mgpu_TextureManager *textureManager) {
+    Mgpu_TileBinner *binner = context;
+
+    if (operation->type == Mgpu_Operation_PresentFramebuffer) {
+        // Recorded operations are rasterized by the flush that comes before the present
+        binner->presentRequested = true;
+        return false;
+    }
+
+    uint8_t targetTextureId;
+    Mgpu_DrawBounds bounds;
+    if (!mgpu_draw_operation_get_bounds(operation, textureManager, &targetTextureId, &bounds) ||
+        targetTextureId != 0 ||
+        mgpu_draw_operation_reads_texture(operation, 0)) {
+        // Only operations that draw to the framebuffer can be deferred, and only if they don't
+        // depend on framebuffer pixels that haven't been drawn yet.
+        return false;
+    }
+
+    if (bounds.left >= bounds.right || bounds.top >= bounds.bottom) {
+        // Won't draw anything
+        return true;
+    }
+
+    Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
+    if (!prepare_bins(binner, frameBuffer)) {
+        return false;
+    }
+
+    uint16_t firstColumn = bounds.left / binner->tileSize;
+    uint16_t lastColumn = (bounds.right - 1) / binner->tileSize;
+    uint16_t firstRow = bounds.top / binner->tileSize;
+    uint16_t lastRow = (bounds.bottom - 1) / binner->tileSize;
+    size_t entriesNeeded = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+    if (binner->entryCount + entriesNeeded > binner->entryCapacity) {
+        return false;
+    }
+
+    if (record_operation(binner, operation) == NULL) {
+        return false;
+    }
+
+    for (uint16_t row = firstRow; row <= lastRow; row++) {
+        for (uint16_t column = firstColumn; column <= lastColumn; column++) {
+            uint16_t entryIndex = binner->entryCount++;
+            binner->entries[entryIndex].operationIndex = binner->operationCount - 1;
+            binner->entries[entryIndex].next = NO_ENTRY;
+
+            // Appending keeps each bin's operations in the order they were submitted
+            Bin *bin = &binner->bins[(row * binner->tileColumns) + column];
+            if (bin->last == NO_ENTRY) {
+                bin->first = entryIndex;
+            } else {
+                binner->entries[bin->last].next = entryIndex;
+            }
+
+            bin->last = entryIndex;
+        }
+    }
+
+    return true;
+}
+
+Mgpu_TileBinner *mgpu_tile_binner_new(const Mgpu_Allocator *allocator, const Mgpu_TileBinnerOptions *options) {
+    mgpu_alloc_assert(allocator);
+    assert(options != NULL);
+    assert(options->tileSize > 0);
+    assert(options->operationCapacity > 0);
+    assert(options->binEntryCapacity > 0 && options->binEntryCapacity < NO_ENTRY);
+
+    Mgpu_TileBinner *binner = allocator->FastMemAllocateFn(sizeof(Mgpu_TileBinner));
+    if (binner == NULL) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate tile binner", MESSAGE_MAX_LEN);
+
+        return NULL;
+    }
+
+    memset(binner, 0, sizeof(Mgpu_TileBinner));
+    binner->allocator = allocator;
+    binner->tileSize = options->tileSize;
+    binner->operationCapacity = options->operationCapacity;
+    binner->entryCapacity = options->binEntryCapacity;
+    binner->payloadArenaSize = options->payloadArenaSize;
+
+    binner->operations = allocator->FastMemAllocateFn(sizeof(Mgpu_Operation) * options->operationCapacity);
+    binner->entries = allocator->FastMemAllocateFn(sizeof(BinEntry) * options->binEntryCapacity);
+    binner->tileBuffer = allocator->FastMemAllocateFn(sizeof(Mgpu_Color) * options->tileSize * options->tileSize);
+    if (options->payloadArenaSize > 0) {
+        binner->payloadArena = allocator->FastMemAllocateFn(options->payloadArenaSize);
+    }
+
+    if (binner->operations == NULL ||
+        binner->entries == NULL ||
+        binner->tileBuffer == NULL ||
+        (options->payloadArenaSize > 0 && binner->payloadArena == NULL)) {
+        char *msg = mgpu_message_get_pointer();
+        assert(msg != NULL);
+        strncpy(msg, "Failed to allocate tile binner buffers", MESSAGE_MAX_LEN);
+
+        mgpu_tile_binner_free(binner);
+        return NULL;
+    }
+
+    return binner;
+}
+
+void mgpu_tile_binner_free(Mgpu_TileBinner *binner) {
+    if (binner != NULL) {
+        const Mgpu_Allocator *allocator = binner->allocator;
+        if (binner->operations != NULL) {
+            allocator->FastMemFreeFn(binner->operations);
+        }
+
+        if (binner->entries != NULL) {
+            allocator->FastMemFreeFn(binner->entries);
+        }
+
+        if (binner->payloadArena != NULL) {
+            allocator->FastMemFreeFn(binner->payloadArena);
+        }
+
+        if (binner->bins != NULL) {
+            allocator->FastMemFreeFn(binner->bins);
+        }
+
+        if (binner->tileBuffer != NULL) {
+            allocator->FastMemFreeFn(binner->tileBuffer);
+        }
+
+        allocator->FastMemFreeFn(binner);
+    }
+}
+
+void mgpu_tile_binner_get_dispatcher(Mgpu_TileBinner *binner, Mgpu_DrawDispatcher *dispatcher) {
+    assert(binner != NULL);
+    assert(dispatcher != NULL);
+
+    dispatcher->context = binner;
+    dispatcher->submitFn = submit;
+    dispatcher->flushFn = flush;
+}
+
+void mgpu_tile_binner_get_stats(Mgpu_TileBinner *binner, Mgpu_TileBinnerStats *stats) {
+    assert(binner != NULL);
+    assert(stats != NULL);
+
+    *stats = binner->stats;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "alloc.h"
+#include "operations/operation_execution.h"
+#include "texture_manager.h"
+
+/*
+ * Defers drawing to the framebuffer until the frame is presented. Drawing operations are
+ * recorded and sorted into bins for each square tile of the framebuffer they overlap. When the
+ * frame is presented each tile with any operations in its bin is rasterized into a small fast
+ * ram buffer, and then written to the framebuffer once.
+ *
+ * This means overlapping operations no longer each read and write the same framebuffer pixels,
+ * which matters when the framebuffer is in slow ram (such as PSRAM). Tiles that no operations
+ * touched are skipped entirely.
+ *
+ * The binner is hooked into operation execution as a draw dispatcher. Any operation that it
+ * can't defer (drawing to other textures, defining textures, etc...) causes all recorded
+ * operations to be rasterized first, so operations always appear to have been executed in order.
+ * The same happens if the binner runs out of room to record operations.
+ */
+typedef struct Mgpu_TileBinner Mgpu_TileBinner;
+
+typedef struct {
+    /*
+     * Width and height of each tile, in pixels
+     */
+    uint8_t tileSize;
+
+    /*
+     * How many drawing operations can be recorded before they have to be rasterized.
+     */
+    uint16_t operationCapacity;
+
+    /*
+     * How many tile bin entries can be recorded before they have to be rasterized. Each recorded
+     * operation takes one entry for every tile it overlaps.
+     */
+    uint16_t binEntryCapacity;
+
+    /*
+     * How many bytes are reserved for copies of recorded operation data (such as characters to
+     * draw).
+     */
+    size_t payloadArenaSize;
+} Mgpu_TileBinnerOptions;
+
+typedef struct {
+    uint32_t tilesRendered;
+    uint32_t tilesSkipped;
+
+    /*
+     * How many times recorded operations had to be rasterized before the frame was presented,
+     * either due to an operation that couldn't be deferred or due to running out of space.
+     */
+    uint32_t earlyFlushes;
+} Mgpu_TileBinnerStats;
+
+/*
+ * Creates a new tile binner
+ */
+Mgpu_TileBinner *mgpu_tile_binner_new(const Mgpu_Allocator *allocator, const Mgpu_TileBinnerOptions *options);
+
+/*
+ * Frees the tile binner and all memory it allocated. It must no longer be the active draw
+ * dispatcher.
+ */
+void mgpu_tile_binner_free(Mgpu_TileBinner *binner);
+
+/*
+ * Gets the dispatcher that routes operations through this binner, to be passed to
+ * `mgpu_execute_set_draw_dispatcher()`.
+ */
+void mgpu_tile_binner_get_dispatcher(Mgpu_TileBinner *binner, Mgpu_DrawDispatcher *dispatcher);
+
+/*
+ * Gets how many tiles have been rendered and skipped since the binner was created.
+ */
+void mgpu_tile_binner_get_stats(Mgpu_TileBinner *binner, Mgpu_TileBinnerStats *stats);
@@ -21,6 +21,7 @@ int64_t prevOperationStartedAt;
 bool hasResponse;
 bool hasFinished = false;
 Mgpu_Response lastSeenResponse;
+Mgpu_StatsEntry lastSeenStatsEntries[MGPU_STATS_RESPONSE_MAX_ENTRIES];
 OperationInfo operations[OP_COUNT];
 uint8_t *testTexturePixels;
 size_t lastFreeHeapSize, lastFreeStackSize;
@@ -295,6 +296,31 @@ void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response)
         case Mgpu_Response_LastMessage:
             lastSeenResponse.lastMessage = response->lastMessage;
             break;
+
+        case Mgpu_Response_TextureUsage:
+            lastSeenResponse.textureUsage = response->textureUsage;
+            break;
+
+        case Mgpu_Response_Framing:
+            lastSeenResponse.framing = response->framing;
+            break;
+
+        case Mgpu_Response_Fence:
+            lastSeenResponse.fence = response->fence;
+            break;
+
+        case Mgpu_Response_Credits:
+            lastSeenResponse.credits = response->credits;
+            break;
+
+        case Mgpu_Response_Stats:
+            // Entries only live as long as the response, so they're copied to be looked at later
+            lastSeenResponse.stats = response->stats;
+            lastSeenResponse.stats.entries = lastSeenStatsEntries;
+            for (uint8_t index = 0; index < response->stats.entryCount; index++) {
+                lastSeenStatsEntries[index] = response->stats.entries[index];
+            }
+            break;
     }
 }
 
@@ -304,6 +330,25 @@ uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus) {
     return 0;
 }
 
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+
+    return 2;
+}
+
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId) {
+    assert(databus != NULL);
+
+    // Operations are generated in memory, so there's no framing to switch
+    Mgpu_Response response = {
+            .type = Mgpu_Response_Framing,
+            .requestId = requestId,
+            .framing = {.version = 2, .maxFrameSize = 0, .maxMessageSize = 0},
+    };
+
+    mgpu_databus_send_response(databus, &response);
+}
+
 void init_databus_options(Mgpu_DatabusOptions *options) {
     ESP_LOGI(LOG_TAG, "Initializing benchmarking databus");
 }
@@ -6,6 +6,7 @@
 #include <driver/gpio.h>
 #include "microgpu-common/colors/color.h"
 #include "microgpu-common/display.h"
+#include "microgpu-common/retained_frame.h"
 #include "../common.h"
 #include "i80_display.h"
 
@@ -115,6 +116,20 @@ void init_i80_bus(const Mgpu_DisplayOptions *options, esp_lcd_panel_io_handle_t
     ESP_ERROR_CHECK(esp_lcd_new_panel_io_i80(bus, &ioConfig, io_handle));
 }
 
+static bool on_color_transfer_done(esp_lcd_panel_io_handle_t ioHandle,
+                                   esp_lcd_panel_io_event_data_t *eventData,
+                                   void *context) {
+    Mgpu_Display *display = context;
+    atomic_fetch_add_explicit(&display->transfersDone, 1, memory_order_release);
+
+    return false;
+}
+
+static void queue_lines(Mgpu_Display *display, int firstLine, int endLine, uint16_t *buffer) {
+    display->transfersQueued++;
+    esp_lcd_panel_draw_bitmap(display->panel, 0, firstLine, display->pixelWidth, endLine, buffer);
+}
+
 void log_display_options(const Mgpu_DisplayOptions *options) {
     ESP_LOGI(LOG_TAG, "Microgpu i80 LCD display options:");
     ESP_LOGI(LOG_TAG, "Display resolution: %u x %u", options->pixelWidth, options->pixelHeight);
@@ -152,6 +167,16 @@ Mgpu_Display *mgpu_display_new(const Mgpu_Allocator *allocator, const Mgpu_Displ
     display->pixelWidth = options->pixelWidth;
     display->pixelHeight = options->pixelHeight;
     display->linesPerBuffer = (int) calc_buffer_line_height(options);
+    display->retainedFrame = NULL;
+    display->transfersQueued = 0;
+    atomic_init(&display->transfersDone, 0);
+    display->framesRendered = 0;
+
+    const esp_lcd_panel_io_callbacks_t callbacks = {
+            .on_color_trans_done = on_color_transfer_done,
+    };
+
+    ESP_ERROR_CHECK(esp_lcd_panel_io_register_event_callbacks(ioHandle, &callbacks, display));
 
     size_t bufferBytes = options->pixelWidth * display->linesPerBuffer * sizeof(Mgpu_Color);
     display->buffer1 = heap_caps_malloc(bufferBytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
@@ -175,13 +200,26 @@ void mgpu_display_get_dimensions(Mgpu_Display *display, uint16_t *width, uint16_
     *height = display->pixelHeight;
 }
 
-void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureManager) {
-    assert(display != NULL);
-    assert(textureManager != NULL);
+void render_strips(Mgpu_Display *display, Mgpu_TextureManager *textureManager, Mgpu_Texture *frameBuffer) {
+    assert(frameBuffer->scale == 1 && "Only a scale factor of 1 is supported when rendering in strips");
 
-    Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
-    assert(frameBuffer != NULL);
+    // Render each strip directly into the transfer buffers, so no frame buffer is needed at all
+    uint16_t *currentBuffer = display->buffer2;
+    for (int firstLine = 0; firstLine < frameBuffer->height; firstLine += display->linesPerBuffer) {
+        mgpu_retained_frame_render_strip(display->retainedFrame,
+                                         textureManager,
+                                         currentBuffer,
+                                         display->pixelWidth,
+                                         firstLine,
+                                         display->linesPerBuffer);
+
+        queue_lines(display, firstLine, firstLine + display->linesPerBuffer, currentBuffer);
 
+        currentBuffer = currentBuffer == display->buffer2 ? display->buffer1 : display->buffer2;
+    }
+}
+
+void render_frame_buffer(Mgpu_Display *display, Mgpu_Texture *frameBuffer) {
     uint16_t *currentBuffer = display->buffer2;
     uint16_t *destPixel = currentBuffer;
     uint16_t *sourcePixel = frameBuffer->pixels;
@@ -203,12 +241,7 @@ void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureMana
 
             displayRowCount++;
             if (displayRowCount % display->linesPerBuffer == 0) {
-                esp_lcd_panel_draw_bitmap(display->panel,
-                                          0,
-                                          displayRowCount - display->linesPerBuffer,
-                                          display->pixelWidth,
-                                          displayRowCount,
-                                          currentBuffer);
+                queue_lines(display, displayRowCount - display->linesPerBuffer, displayRowCount, currentBuffer);
 
                 currentBuffer = currentBuffer == display->buffer2 ? display->buffer1 : display->buffer2;
                 destPixel = currentBuffer;
@@ -217,6 +250,55 @@ void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureMana
     }
 }
 
+void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureManager) {
+    assert(display != NULL);
+    assert(textureManager != NULL);
+
+    Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
+    assert(frameBuffer != NULL);
+
+    if (display->retainedFrame != NULL) {
+        render_strips(display, textureManager, frameBuffer);
+    } else {
+        render_frame_buffer(display, frameBuffer);
+    }
+
+    display->frameEndTransfers[display->framesRendered % I80_FRAME_END_HISTORY] = display->transfersQueued;
+    display->framesRendered++;
+}
+
+void mgpu_display_get_frame_counts(Mgpu_Display *display, uint32_t *framesRendered, uint32_t *framesPresented) {
+    assert(display != NULL);
+    assert(framesRendered != NULL);
+    assert(framesPresented != NULL);
+
+    uint32_t transfersDone = atomic_load_explicit(&display->transfersDone, memory_order_acquire);
+
+    // Walk back from the newest frame until one has had all of its transfers complete. The
+    // transfer queue is much shorter than a frame, so only the last couple of frames can
+    // still be in flight.
+    uint32_t presented = display->framesRendered;
+    while (display->framesRendered - presented < I80_FRAME_END_HISTORY && presented > 0) {
+        uint32_t frameEnd = display->frameEndTransfers[(presented - 1) % I80_FRAME_END_HISTORY];
+        if ((int32_t) (transfersDone - frameEnd) >= 0) {
+            break;
+        }
+
+        presented--;
+    }
+
+    *framesRendered = display->framesRendered;
+    *framesPresented = presented;
+}
+
+void mgpu_display_set_retained_frame(Mgpu_Display *display,
+                                     Mgpu_RetainedFrame *retainedFrame,
+                                     Mgpu_TextureManager *textureManager) {
+    assert(display != NULL);
+
+    display->retainedFrame = retainedFrame;
+}
+
 void init_display_options(Mgpu_DisplayOptions *displayOptions) {
     assert(displayOptions != NULL);
 
@@ -4,8 +4,12 @@
  * The i80 display allows using an intel 8080 parallel interfaced LCD (such as the ili9341).
  */
 
+#include <stdatomic.h>
 #include <esp_lcd_types.h>
 
+// How many of the most recently rendered frames to remember the last transfer of
+#define I80_FRAME_END_HISTORY 4
+
 /*
  * Structure containing which gpio pins are used for control actions
  */
@@ -36,6 +40,16 @@ struct Mgpu_Display {
     uint16_t *buffer1;
     uint16_t *buffer2;
     int linesPerBuffer;
+    Mgpu_RetainedFrame *retainedFrame;
+
+    /*
+     * Pixel transfers are queued up for DMA, so a frame is only presented once the last transfer
+     * queued for it is done. Transfers complete in the order they were queued.
+     */
+    uint32_t transfersQueued;
+    atomic_uint_least32_t transfersDone;
+    uint32_t framesRendered;
+    uint32_t frameEndTransfers[I80_FRAME_END_HISTORY];
 };
 
 void init_display_options(Mgpu_DisplayOptions *displayOptions);
@@ -1,4 +1,7 @@
+#include <stdatomic.h>
 #include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <esp_lcd_panel_rgb.h>
 #include <esp_log.h>
 #include <esp_lcd_panel_ops.h>
@@ -9,14 +12,94 @@
 #include "rgb_lcd_display.h"
 #include "common.h"
 
+// Each bounce buffer holds this many lines, and strips are rendered at the same height
+#define BOUNCE_BUFFER_LINES 8
+
+// How many strips can be rendered ahead of the one being sent to the panel
+#define STRIP_RING_SIZE 4
+
+#define STRIP_FREE (-1)
+
 static Mgpu_Texture *renderingFramebuffer = NULL;
 static uint8_t swapTextureId = 0;
 
+// The panel is refreshed continuously, so a rendered frame counts as presented once the panel
+// has made a full pass over it. That's known when the pass after it starts.
+static atomic_uint_least32_t framesRendered;
+static atomic_uint_least32_t framesPresented;
+static uint32_t frameBeingScanned = 0;
+
+// When rendering from a retained frame, a render task fills a ring of strips ahead of the panel
+// and the bounce buffer callback copies them out. Each slot holds the first line of the strip
+// rendered into it, or STRIP_FREE once it has been copied and can be rendered into again.
+static Mgpu_RetainedFrame *stripFrame = NULL;
+static Mgpu_TextureManager *stripTextureManager = NULL;
+static Mgpu_Color *stripRing = NULL;
+static atomic_int stripSlotLines[STRIP_RING_SIZE];
+static TaskHandle_t stripRenderTask = NULL;
+static uint16_t stripWidth, stripHeight;
+
+static bool on_bounce_buffer_empty_from_strips(void *bounceBuffer, int nextPixelIndex, int bufferByteLength) {
+    int line = nextPixelIndex / stripWidth;
+    int slot = (line / BOUNCE_BUFFER_LINES) % STRIP_RING_SIZE;
+    int slotLine = atomic_load_explicit(&stripSlotLines[slot], memory_order_acquire);
+
+    if (slotLine == line) {
+        memcpy(bounceBuffer, stripRing + (slot * stripWidth * BOUNCE_BUFFER_LINES), bufferByteLength);
+    } else {
+        // The render task fell behind, so show black rather than stall the panel
+        memset(bounceBuffer, 0, bufferByteLength);
+    }
+
+    // Either way the slot can't be used for this line anymore, so let the render task reuse it
+    if (slotLine != STRIP_FREE) {
+        atomic_store_explicit(&stripSlotLines[slot], STRIP_FREE, memory_order_release);
+    }
+
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(stripRenderTask, &higherPriorityTaskWoken);
+
+    return higherPriorityTaskWoken == pdTRUE;
+}
+
+static void strip_render_task(void *param) {
+    int firstLine = 0;
+    while (true) {
+        int slot = (firstLine / BOUNCE_BUFFER_LINES) % STRIP_RING_SIZE;
+        while (atomic_load_explicit(&stripSlotLines[slot], memory_order_acquire) != STRIP_FREE) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        mgpu_retained_frame_render_strip(stripFrame,
+                                         stripTextureManager,
+                                         stripRing + (slot * stripWidth * BOUNCE_BUFFER_LINES),
+                                         stripWidth,
+                                         firstLine,
+                                         BOUNCE_BUFFER_LINES);
+
+        atomic_store_explicit(&stripSlotLines[slot], firstLine, memory_order_release);
+
+        firstLine += BOUNCE_BUFFER_LINES;
+        if (firstLine >= stripHeight) {
+            firstLine = 0;
+        }
+    }
+}
+
 static bool on_bounce_buffer_empty(esp_lcd_panel_handle_t handle,
                             void *bounceBuffer,
                             int nextPixelIndex,
                             int bufferByteLength,
                             void *context) {
+    if (nextPixelIndex == 0) {
+        atomic_store_explicit(&framesPresented, frameBeingScanned, memory_order_release);
+        frameBeingScanned = atomic_load_explicit(&framesRendered, memory_order_acquire);
+    }
+
+    if (stripFrame != NULL) {
+        return on_bounce_buffer_empty_from_strips(bounceBuffer, nextPixelIndex, bufferByteLength);
+    }
+
     if (renderingFramebuffer == NULL) {
         // We don't have a texture to draw yet, so zero out the buffer
         memset(bounceBuffer, 0, bufferByteLength);
@@ -89,7 +172,7 @@ void init_lcd(const Mgpu_DisplayOptions *options, esp_lcd_panel_handle_t *handle
             .data_width = 16,
             .psram_trans_align = 64,
             .num_fbs = 0,
-            .bounce_buffer_size_px = 8 * options->pixelWidth,
+            .bounce_buffer_size_px = BOUNCE_BUFFER_LINES * options->pixelWidth,
             .clk_src = LCD_CLK_SRC_DEFAULT,
             .disp_gpio_num = -1,
             .pclk_gpio_num = options->controlPins.pixelClock,
@@ -163,6 +246,9 @@ Mgpu_Display *mgpu_display_new(const Mgpu_Allocator *allocator, const Mgpu_Displ
     display->panel = panel;
     display->pixelWidth = options->pixelWidth;
     display->pixelHeight = options->pixelHeight;
+    display->retainedFrame = NULL;
+    atomic_store(&framesRendered, 0);
+    atomic_store(&framesPresented, 0);
 
     return display;
 }
@@ -189,6 +275,12 @@ void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureMana
     assert(display != NULL);
     assert(textureManager != NULL);
 
+    if (display->retainedFrame != NULL) {
+        // The render task picks up the newly presented frame when it starts rendering from line 0
+        atomic_fetch_add_explicit(&framesRendered, 1, memory_order_release);
+        return;
+    }
+
     Mgpu_Texture *framebufferToPresent = mgpu_texture_get(textureManager, 0);
     assert(framebufferToPresent != NULL);
     assert(framebufferToPresent->scale == 1 && "Only a scale factor of 1 is supported");
@@ -235,6 +327,59 @@ void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureMana
 
     mgpu_texture_swap(textureManager, 0, swapTextureId);
     renderingFramebuffer = mgpu_texture_get(textureManager, swapTextureId);
+    atomic_fetch_add_explicit(&framesRendered, 1, memory_order_release);
+}
+
+void mgpu_display_get_frame_counts(Mgpu_Display *display, uint32_t *rendered, uint32_t *presented) {
+    assert(display != NULL);
+    assert(rendered != NULL);
+    assert(presented != NULL);
+
+    *rendered = atomic_load_explicit(&framesRendered, memory_order_acquire);
+    *presented = atomic_load_explicit(&framesPresented, memory_order_acquire);
+}
+
+void mgpu_display_set_retained_frame(Mgpu_Display *display,
+                                     Mgpu_RetainedFrame *retainedFrame,
+                                     Mgpu_TextureManager *textureManager) {
+    assert(display != NULL);
+    assert(retainedFrame != NULL && "Switching back to a frame buffer isn't supported by the RGB display");
+    assert(textureManager != NULL);
+    assert(display->pixelHeight % BOUNCE_BUFFER_LINES == 0);
+
+    if (stripRenderTask != NULL) {
+        assert(stripFrame == retainedFrame && "Only one retained frame can be rendered");
+        return;
+    }
+
+    // Strips are rendered into internal ram, so they can be copied into the bounce buffers quickly
+    size_t ringBytes = sizeof(Mgpu_Color) * display->pixelWidth * BOUNCE_BUFFER_LINES * STRIP_RING_SIZE;
+    stripRing = display->allocator->FastMemAllocateFn(ringBytes);
+    assert(stripRing != NULL && "Strip ring could not be allocated");
+
+    for (int x = 0; x < STRIP_RING_SIZE; x++) {
+        atomic_init(&stripSlotLines[x], STRIP_FREE);
+    }
+
+    stripWidth = display->pixelWidth;
+    stripHeight = display->pixelHeight;
+    stripTextureManager = textureManager;
+    display->retainedFrame = retainedFrame;
+
+    // Render on the core not executing operations, at a higher priority so strips are ready in time
+    BaseType_t core = (xPortGetCoreID() + 1) % portNUM_PROCESSORS;
+    BaseType_t result = xTaskCreatePinnedToCore(strip_render_task,
+                                                "mgpu_strips",
+                                                4096,
+                                                NULL,
+                                                uxTaskPriorityGet(NULL) + 1,
+                                                &stripRenderTask,
+                                                core);
+
+    assert(result == pdPASS && "Strip render task could not be started");
+
+    // Only hand the retained frame to the bounce buffer callback once everything it uses is set up
+    stripFrame = retainedFrame;
 }
 
 void init_display_options(Mgpu_DisplayOptions *displayOptions) {
@@ -1,6 +1,7 @@
 #pragma once
 #include <esp_lcd_types.h>
 #include "microgpu-common/alloc.h"
+#include "microgpu-common/retained_frame.h"
 #include "microgpu-common/texture_manager.h"
 
 typedef struct {
@@ -24,6 +25,7 @@ struct Mgpu_Display {
     uint16_t pixelWidth, pixelHeight;
     uint8_t swapTextureId;
     Mgpu_Texture *activeRenderingFrameBuffer;
+    Mgpu_RetainedFrame *retainedFrame;
 };
 
 void init_display_options(Mgpu_DisplayOptions *options);
@@ -5,6 +5,7 @@
 
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "microgpu-common/operations/execution//drawing/triangle.h"
 #include "microgpu-common/messages.h"
 #include "microgpu-common/alloc.h"
@@ -12,6 +13,7 @@
 #include "microgpu-common/display.h"
 #include "microgpu-common/fonts/fonts.h"
 #include "microgpu-common/operations/operation_execution.h"
+#include "microgpu-common/operations/operation_stats.h"
 #include "common.h"
 
 #if defined(CONFIG_MICROGPU_DATABUS_SPI)
@@ -30,6 +32,22 @@
 #error "No display defined"
 #endif
 
+#if CONFIG_MICROGPU_RASTER_WORKERS > 0
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "microgpu-common/band_rasterizer.h"
+#endif
+
+#if defined(CONFIG_MICROGPU_TILE_BINNING)
+#include "microgpu-common/tile_binner.h"
+#endif
+
+#if defined(CONFIG_MICROGPU_STRIP_RENDERING)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "microgpu-common/retained_frame.h"
+#endif
+
 Mgpu_Display *display;
 Mgpu_DisplayOptions displayOptions;
 Mgpu_Databus *databus;
@@ -37,10 +55,27 @@ Mgpu_DatabusOptions databusOptions;
 Mgpu_TextureManager *textureManager;
 bool resetRequested;
 
+#if CONFIG_MICROGPU_RASTER_WORKERS > 0
+Mgpu_BandRasterizer *bandRasterizer;
+uint8_t rasterWorkerIndexes[CONFIG_MICROGPU_RASTER_WORKERS];
+#endif
+
+#if defined(CONFIG_MICROGPU_TILE_BINNING)
+Mgpu_TileBinner *tileBinner;
+#endif
+
+#if defined(CONFIG_MICROGPU_STRIP_RENDERING)
+Mgpu_RetainedFrame *retainedFrame;
+
+void retained_frame_wait(uint32_t attempt);
+#endif
+
 void *alloc_internal_ram(size_t size);
 
 void *alloc_spi_ram(size_t size);
 
+uint32_t get_microseconds(void);
+
 static const Mgpu_Allocator standardAllocator = {
         .FastMemAllocateFn = alloc_internal_ram,
         .FastMemFreeFn = free,
@@ -65,12 +100,29 @@ bool setup(void) {
         return false;
     }
 
-    textureManager = mgpu_texture_manager_new(&standardAllocator);
+    Mgpu_TextureManagerOptions textureManagerOptions = {
+            .fastArenaSize = 0, // Textures defined by operations are always put in slow ram
+            .slowArenaSize = CONFIG_MICROGPU_TEXTURE_ARENA_KB * 1024,
+#if defined(CONFIG_MICROGPU_STRIP_RENDERING) && defined(CONFIG_MICROGPU_DISPLAY_16BIT_RGB_LCD)
+            // Strips are rendered on another task while operations execute, so textures can't be moved
+            // and their memory can't be freed until that task has moved on to its next frame
+            .compactWhenFull = false,
+            .deferFrees = true,
+            .waitFn = retained_frame_wait,
+#else
+            .compactWhenFull = true,
+#endif
+            .slowBudget = CONFIG_MICROGPU_TEXTURE_BUDGET_KB * 1024,
+    };
+
+    textureManager = mgpu_texture_manager_new(&standardAllocator, &textureManagerOptions);
     if (textureManager == NULL) {
         ESP_LOGE(LOG_TAG, "Texture manager could not be created");
         return false;
     }
 
+    mgpu_operation_stats_set_clock(get_microseconds);
+
     return true;
 }
 
@@ -84,7 +136,11 @@ bool define_display_framebuffer(uint8_t scale) {
             .height = height,
             .id = 0,
             .transparentColor = mgpu_color_from_rgb888(0, 0, 0),
+#if defined(CONFIG_MICROGPU_STRIP_RENDERING)
+            .flags = MGPU_TEXTURE_NO_PIXELS, // frames are rendered in strips
+#else
             .flags = 0, // allocate in fast ram
+#endif
     };
 
     if (!mgpu_texture_define(textureManager, &frameBufferSpecs, scale)) {
@@ -95,6 +151,24 @@ bool define_display_framebuffer(uint8_t scale) {
     return true;
 }
 
+void draw_boot_text(char *text, uint16_t y) {
+    // Drawn as an operation, so the text goes through the same path as any other framebuffer drawing
+    Mgpu_Operation operation = {
+            .type = Mgpu_Operation_DrawChars,
+            .drawChars = {
+                    .fontId = Mgpu_Font_Font8x12,
+                    .textureId = 0,
+                    .color = mgpu_color_from_rgb888(255, 255, 255),
+                    .startX = 10,
+                    .startY = y,
+                    .numCharacters = strlen(text),
+                    .characters = (const uint8_t *) text,
+            },
+    };
+
+    mgpu_execute_operation(&operation, display, databus, &resetRequested, textureManager);
+}
+
 bool show_boot_screen(void) {
     if (!define_display_framebuffer(1)) {
         return false;
@@ -105,18 +179,16 @@ bool show_boot_screen(void) {
     snprintf(versionString, sizeof(versionString), "Firmware version: %s", MGPU_VERSION);
     sniprintf(apiString, sizeof(apiString), "API version: %u", MGPU_API_VERSION);
 
-    Mgpu_Color white = mgpu_color_from_rgb888(255, 255, 255);
-    mgpu_font_draw(textureManager, Mgpu_Font_Font8x12, 0, "Microgpu", white, 10, 10);
-    mgpu_font_draw(textureManager, Mgpu_Font_Font8x12, 0, versionString, white, 10, 25);
-    mgpu_font_draw(textureManager, Mgpu_Font_Font8x12, 0, apiString, white, 10, 40);
+    draw_boot_text("Microgpu", 10);
+    draw_boot_text(versionString, 25);
+    draw_boot_text(apiString, 40);
 
     uint16_t width, height;
     mgpu_display_get_dimensions(display, &width, &height);
+    draw_boot_text("Waiting for Initialization...", height - 25);
 
-    uint16_t startY = height - 25;
-    mgpu_font_draw(textureManager, Mgpu_Font_Font8x12, 0, "Waiting for Initialization...", white, 10, startY);
-
-    mgpu_display_render(display, textureManager);
+    Mgpu_Operation present = {.type = Mgpu_Operation_PresentFramebuffer};
+    mgpu_execute_operation(&present, display, databus, &resetRequested, textureManager);
 
     // Now that the boot screen is rendered, we can free the frame buffer we were currently using, as we won't
     // write to it or render it again. This is also a small hack to keep the get status operation as returning
@@ -169,6 +241,123 @@ bool wait_for_initialization(void) {
     return true;
 }
 
+#if CONFIG_MICROGPU_RASTER_WORKERS > 0
+void band_rasterizer_wait(uint32_t attempt) {
+    // Stay responsive while a frame is being drawn, but let lower priority tasks (such as the
+    // idle task feeding the watchdog) run when there's nothing to do for a while.
+    if (attempt < 1000) {
+        taskYIELD();
+    } else {
+        vTaskDelay(1);
+    }
+}
+
+void band_rasterizer_task(void *param) {
+    uint8_t workerIndex = *(uint8_t *) param;
+    while (true) {
+        mgpu_band_rasterizer_work(bandRasterizer, workerIndex);
+    }
+}
+
+bool start_band_rasterizer(void) {
+    Mgpu_BandRasterizerOptions options = {
+            .workerCount = CONFIG_MICROGPU_RASTER_WORKERS,
+            .operationCapacity = 128,
+            .payloadArenaSize = 2048,
+            .waitFn = band_rasterizer_wait,
+    };
+
+    bandRasterizer = mgpu_band_rasterizer_new(&standardAllocator, &options);
+    if (bandRasterizer == NULL) {
+        ESP_LOGE(LOG_TAG, "Band rasterizer could not be created");
+        return false;
+    }
+
+    BaseType_t mainCore = xPortGetCoreID();
+    for (int x = 0; x < CONFIG_MICROGPU_RASTER_WORKERS; x++) {
+        rasterWorkerIndexes[x] = x;
+        BaseType_t core = (mainCore + 1 + x) % portNUM_PROCESSORS;
+        BaseType_t result = xTaskCreatePinnedToCore(band_rasterizer_task,
+                                                    "mgpu_raster",
+                                                    4096,
+                                                    &rasterWorkerIndexes[x],
+                                                    uxTaskPriorityGet(NULL),
+                                                    NULL,
+                                                    core);
+
+        if (result != pdPASS) {
+            ESP_LOGE(LOG_TAG, "Band rasterizer worker %u could not be started", x);
+            return false;
+        }
+    }
+
+    Mgpu_DrawDispatcher dispatcher;
+    mgpu_band_rasterizer_get_dispatcher(bandRasterizer, &dispatcher);
+    mgpu_execute_set_draw_dispatcher(&dispatcher);
+
+    ESP_LOGI(LOG_TAG, "Rasterizing with %u framebuffer bands", CONFIG_MICROGPU_RASTER_WORKERS);
+    return true;
+}
+#endif
+
+#if defined(CONFIG_MICROGPU_TILE_BINNING)
+bool start_tile_binner(void) {
+    Mgpu_TileBinnerOptions options = {
+            .tileSize = 32,
+            .operationCapacity = 256,
+            .binEntryCapacity = 2048,
+            .payloadArenaSize = 2048,
+    };
+
+    tileBinner = mgpu_tile_binner_new(&standardAllocator, &options);
+    if (tileBinner == NULL) {
+        ESP_LOGE(LOG_TAG, "Tile binner could not be created");
+        return false;
+    }
+
+    Mgpu_DrawDispatcher dispatcher;
+    mgpu_tile_binner_get_dispatcher(tileBinner, &dispatcher);
+    mgpu_execute_set_draw_dispatcher(&dispatcher);
+
+    ESP_LOGI(LOG_TAG, "Rasterizing framebuffer tiles on present");
+    return true;
+}
+#endif
+
+#if defined(CONFIG_MICROGPU_STRIP_RENDERING)
+void retained_frame_wait(uint32_t attempt) {
+    // Waiting on the display to start showing the last presented frame, or to move past retired
+    // textures, can take a whole refresh, so back off to sleeping quickly.
+    if (attempt < 100) {
+        taskYIELD();
+    } else {
+        vTaskDelay(1);
+    }
+}
+
+bool start_strip_rendering(void) {
+    Mgpu_RetainedFrameOptions options = {
+            .operationCapacity = 512,
+            .payloadArenaSize = 2048,
+            .waitFn = retained_frame_wait,
+    };
+
+    retainedFrame = mgpu_retained_frame_new(&standardAllocator, &options);
+    if (retainedFrame == NULL) {
+        ESP_LOGE(LOG_TAG, "Retained frame could not be created");
+        return false;
+    }
+
+    Mgpu_DrawDispatcher dispatcher;
+    mgpu_retained_frame_get_dispatcher(retainedFrame, &dispatcher);
+    mgpu_execute_set_draw_dispatcher(&dispatcher);
+    mgpu_display_set_retained_frame(display, retainedFrame, textureManager);
+
+    ESP_LOGI(LOG_TAG, "Rendering frames in strips without a framebuffer");
+    return true;
+}
+#endif
+
 void app_main(void) {
     ESP_LOGI(LOG_TAG, "Starting Microgpu");
     ESP_LOGI(LOG_TAG, "Version: %s", MGPU_VERSION);
@@ -177,11 +366,33 @@ void app_main(void) {
         return;
     }
 
+#if defined(CONFIG_MICROGPU_STRIP_RENDERING)
+    // Started before the boot screen, so no framebuffer is ever allocated
+    if (!start_strip_rendering()) {
+        ESP_LOGE(LOG_TAG, "Strip rendering could not be started, exiting");
+        return;
+    }
+#endif
+
     if (!wait_for_initialization()) {
         ESP_LOGE(LOG_TAG, "No initialization occurred, exiting");
         return;
     }
 
+#if CONFIG_MICROGPU_RASTER_WORKERS > 0
+    if (!start_band_rasterizer()) {
+        ESP_LOGE(LOG_TAG, "Band rasterization could not be started, exiting");
+        return;
+    }
+#endif
+
+#if defined(CONFIG_MICROGPU_TILE_BINNING)
+    if (!start_tile_binner()) {
+        ESP_LOGE(LOG_TAG, "Tile binning could not be started, exiting");
+        return;
+    }
+#endif
+
     Mgpu_Operation operation;
     while (1) {
         if (resetRequested) {
@@ -201,6 +412,10 @@ void app_main(void) {
     }
 }
 
+uint32_t get_microseconds(void) {
+    return (uint32_t) esp_timer_get_time();
+}
+
 void *alloc_internal_ram(size_t size) {
     return heap_caps_malloc(size, MALLOC_CAP_32BIT);
 }
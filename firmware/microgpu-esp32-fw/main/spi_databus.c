@@ -11,9 +11,25 @@
 #include "common.h"
 
 #define SPI_BUFFER_SIZE (1024)
-#define PACKET_BUFFER_SIZE (255)
+
+// Each v3 frame has to fit in a single transaction, so this also holds any decoded frame
+#define PACKET_BUFFER_SIZE SPI_BUFFER_SIZE
+
+// Bytes from every queued transaction can be waiting to be decoded at once
+#define RECEIVE_BUFFER_SIZE (SPI_BUFFER_SIZE * (SPI_QUEUED_TRANSACTIONS + 1))
+
+/*
+ * The handshake line is only high while at least this many transactions are queued. The
+ * controller waits for it before every transaction, and needing two means there's still one
+ * queued even if the controller starts its next transaction before the one it just finished has
+ * been queued again. This makes the handshake the databus' credit: the controller never sends
+ * more than the gpu has room to receive.
+ */
+#define HANDSHAKE_MIN_QUEUED_TRANSACTIONS 2
 
 int handshakePin;
+static int queuedTransactionCount = 0;
+static portMUX_TYPE handshakeLock = portMUX_INITIALIZER_UNLOCKED;
 
 void log_options(Mgpu_DatabusOptions *options) {
     ESP_LOGI(LOG_TAG, "SPI databus options:");
@@ -25,12 +41,65 @@ void log_options(Mgpu_DatabusOptions *options) {
     ESP_LOGI(LOG_TAG, "SPI host: %u", options->spiHost);
 }
 
-void spi_ready_callback(spi_slave_transaction_t *transaction) {
-    gpio_set_level(handshakePin, 1);
+void spi_transaction_done_callback(spi_slave_transaction_t *transaction) {
+    portENTER_CRITICAL_ISR(&handshakeLock);
+    queuedTransactionCount--;
+    gpio_set_level(handshakePin, queuedTransactionCount >= HANDSHAKE_MIN_QUEUED_TRANSACTIONS);
+    portEXIT_CRITICAL_ISR(&handshakeLock);
 }
 
-void spi_unready_callback(spi_slave_transaction_t *transaction) {
-    gpio_set_level(handshakePin, 0);
+/*
+ * Queues the slot's transaction behind all the others. Whatever is in its send buffer goes out
+ * when the controller reaches it.
+ */
+static void queue_slot(Mgpu_Databus *databus, Mgpu_SpiTransactionSlot *slot) {
+    memset(&slot->transaction, 0, sizeof(slot->transaction));
+    slot->transaction.length = SPI_BUFFER_SIZE * 8;
+    slot->transaction.rx_buffer = slot->receiveBuffer;
+    slot->transaction.tx_buffer = slot->sendBuffer;
+
+    ESP_ERROR_CHECK(spi_slave_queue_trans(databus->spiHost, &slot->transaction, portMAX_DELAY));
+
+    // Only counted once it's queued, so the controller is never told there's room that isn't there yet
+    portENTER_CRITICAL(&handshakeLock);
+    queuedTransactionCount++;
+    gpio_set_level(handshakePin, queuedTransactionCount >= HANDSHAKE_MIN_QUEUED_TRANSACTIONS);
+    portEXIT_CRITICAL(&handshakeLock);
+}
+
+/*
+ * Waits for the controller to finish the oldest queued transaction and keeps whatever it sent
+ * for decoding. The slot is handed back with an empty send buffer, and must be queued again.
+ */
+static Mgpu_SpiTransactionSlot *take_oldest_slot(Mgpu_Databus *databus) {
+    Mgpu_SpiTransactionSlot *slot = &databus->slots[databus->oldestSlot];
+    databus->oldestSlot = (databus->oldestSlot + 1) % SPI_QUEUED_TRANSACTIONS;
+
+    spi_slave_transaction_t *finished;
+    ESP_ERROR_CHECK(spi_slave_get_trans_result(databus->spiHost, &finished, portMAX_DELAY));
+    assert(finished == &slot->transaction);
+
+    // Transactions the controller only used to read responses are all zeros, so only the first
+    // zero after the last packet is kept as its delimiter.
+    size_t length = min(finished->length / 8, finished->trans_len / 8);
+    size_t keptLength = length;
+    while (keptLength > 0 && slot->receiveBuffer[keptLength - 1] == 0) {
+        keptLength--;
+    }
+
+    if (keptLength > 0 && keptLength < length) {
+        keptLength++;
+    }
+
+    if (databus->receiveBufferBytesRemaining + keptLength > RECEIVE_BUFFER_SIZE) {
+        ESP_LOGW(LOG_TAG, "Dropping %zu bytes from SPI transaction, no room left to decode them", keptLength);
+    } else {
+        memcpy(databus->receiveBuffer + databus->receiveBufferBytesRemaining, slot->receiveBuffer, keptLength);
+        databus->receiveBufferBytesRemaining += keptLength;
+    }
+
+    memset(slot->sendBuffer, 0, SPI_BUFFER_SIZE);
+    return slot;
 }
 
 Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocator *allocator) {
@@ -51,10 +120,9 @@ Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocato
     spi_slave_interface_config_t slaveConfig = {
             .mode = 0,
             .spics_io_num = options->csPin,
-            .queue_size = 3,
+            .queue_size = SPI_QUEUED_TRANSACTIONS,
             .flags = 0,
-            .post_setup_cb = spi_ready_callback,
-            .post_trans_cb = spi_unready_callback,
+            .post_trans_cb = spi_transaction_done_callback,
     };
 
     gpio_config_t handshakeConfig = {
@@ -65,6 +133,8 @@ Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocato
     };
 
     gpio_config(&handshakeConfig);
+    gpio_set_level(handshakePin, 0);
+    queuedTransactionCount = 0;
 
     //Enable pull-ups on SPI lines, so we don't detect rogue pulses when no master is connected.
     gpio_set_pull_mode(options->copiPin, GPIO_PULLUP_ONLY);
@@ -76,19 +146,45 @@ Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocato
     Mgpu_Databus *databus = allocator->FastMemAllocateFn(sizeof(Mgpu_Databus));
     databus->allocator = allocator;
     databus->spiHost = options->spiHost;
-    databus->receiveBuffer = heap_caps_malloc(SPI_BUFFER_SIZE, MALLOC_CAP_DMA);
-    databus->sendBuffer = heap_caps_malloc(SPI_BUFFER_SIZE, MALLOC_CAP_DMA);
+    databus->receiveBuffer = allocator->FastMemAllocateFn(RECEIVE_BUFFER_SIZE);
+    databus->sendBuffer = allocator->FastMemAllocateFn(SPI_BUFFER_SIZE);
     databus->encodeDecodeBuffer = allocator->FastMemAllocateFn(PACKET_BUFFER_SIZE);
     databus->receiveBufferBytesRemaining = 0;
+    databus->framingVersion = MGPU_FRAMING_VERSION_2;
+    databus->reassembler = mgpu_frame_reassembler_new(allocator, MGPU_FRAMING_V3_MAX_MSG_SIZE);
+    if (databus->reassembler == NULL) {
+        ESP_LOGW(LOG_TAG, "Large operations will not be supported: %s", mgpu_message_get_pointer());
+    }
+
+    // Every slot stays queued from here on, except while its results are being taken
+    databus->oldestSlot = 0;
+    for (int x = 0; x < SPI_QUEUED_TRANSACTIONS; x++) {
+        Mgpu_SpiTransactionSlot *slot = &databus->slots[x];
+        slot->receiveBuffer = heap_caps_malloc(SPI_BUFFER_SIZE, MALLOC_CAP_DMA);
+        slot->sendBuffer = heap_caps_malloc(SPI_BUFFER_SIZE, MALLOC_CAP_DMA);
+        assert(slot->receiveBuffer != NULL && slot->sendBuffer != NULL);
+        memset(slot->sendBuffer, 0, SPI_BUFFER_SIZE);
+        queue_slot(databus, slot);
+    }
 
     return databus;
 }
 
 void mgpu_databus_free(Mgpu_Databus *databus) {
     if (databus) {
+        // Drops the queued transactions, so nothing is still pointing to the slot buffers
+        spi_slave_free(databus->spiHost);
+        gpio_set_level(handshakePin, 0);
+
+        for (int x = 0; x < SPI_QUEUED_TRANSACTIONS; x++) {
+            free(databus->slots[x].receiveBuffer);
+            free(databus->slots[x].sendBuffer);
+        }
+
+        mgpu_frame_reassembler_free(databus->reassembler);
         databus->allocator->FastMemFreeFn(databus->encodeDecodeBuffer);
-        free(databus->receiveBuffer);
-        free(databus->sendBuffer);
+        databus->allocator->FastMemFreeFn(databus->receiveBuffer);
+        databus->allocator->FastMemFreeFn(databus->sendBuffer);
         databus->allocator->FastMemFreeFn(databus);
     }
 }
@@ -97,35 +193,32 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
     assert(databus != NULL);
     assert(operation != NULL);
 
-    spi_slave_transaction_t transaction;
-    memset(&transaction, 0, sizeof(transaction));
     if (databus->receiveBufferBytesRemaining == 0) {
-        memset(databus->receiveBuffer, 0, SPI_BUFFER_SIZE);
-        memset(databus->sendBuffer, 0, SPI_BUFFER_SIZE);
-
-        // Set up the SPI transaction
-        transaction.length = SPI_BUFFER_SIZE * 8;
-        transaction.rx_buffer = databus->receiveBuffer;
-        transaction.tx_buffer = databus->sendBuffer;
+        Mgpu_SpiTransactionSlot *slot = take_oldest_slot(databus);
+        queue_slot(databus, slot);
 
-        esp_err_t result = spi_slave_transmit(databus->spiHost, &transaction, portMAX_DELAY);
-        if (result != ESP_OK) {
-            ESP_LOGE(LOG_TAG, "SPI receive failed: %s", esp_err_to_name(result));
+        if (databus->receiveBufferBytesRemaining == 0) {
             return false;
         }
-
-        size_t length = min(transaction.length / 8, transaction.trans_len / 8);
-        assert(length <= SPI_BUFFER_SIZE);
-        databus->receiveBufferBytesRemaining = length;
     }
 
     size_t inputBytesProcessed = 0, decodedBytes = 0;
-    mgpu_packet_framing_decode(databus->receiveBuffer,
-                               databus->receiveBufferBytesRemaining,
-                               databus->encodeDecodeBuffer,
-                               PACKET_BUFFER_SIZE,
-                               &decodedBytes,
-                               &inputBytesProcessed);
+    bool isVersion3 = databus->framingVersion == MGPU_FRAMING_VERSION_3;
+    if (isVersion3) {
+        mgpu_packet_framing_v3_decode(databus->receiveBuffer,
+                                      databus->receiveBufferBytesRemaining,
+                                      databus->encodeDecodeBuffer,
+                                      PACKET_BUFFER_SIZE,
+                                      &decodedBytes,
+                                      &inputBytesProcessed);
+    } else {
+        mgpu_packet_framing_decode(databus->receiveBuffer,
+                                   databus->receiveBufferBytesRemaining,
+                                   databus->encodeDecodeBuffer,
+                                   PACKET_BUFFER_SIZE,
+                                   &decodedBytes,
+                                   &inputBytesProcessed);
+    }
 
     if (inputBytesProcessed == 0) {
         // We didn't get a complete packet, so discard the rest of the buffer
@@ -152,13 +245,69 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
         memmove(databus->receiveBuffer, databus->receiveBuffer + inputBytesProcessed, bytesToShift);
     }
 
-    return mgpu_operation_deserialize(databus->encodeDecodeBuffer, decodedBytes, operation);
+    if (!isVersion3 || decodedBytes == 0) {
+        return mgpu_operation_deserialize(databus->encodeDecodeBuffer, decodedBytes, operation);
+    }
+
+    // Operations larger than a transaction arrive as fragments, which are held until the last one
+    const uint8_t *message;
+    size_t messageSize;
+    if (!mgpu_frame_reassembler_add(databus->reassembler,
+                                    databus->encodeDecodeBuffer,
+                                    decodedBytes,
+                                    &message,
+                                    &messageSize)) {
+        return false;
+    }
+
+    return mgpu_operation_deserialize(message, messageSize, operation);
 }
 
-void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response) {
-    assert(databus != NULL);
-    assert(response != NULL);
+/*
+ * Sends the send buffer with the next transaction that gets queued. The controller still has to
+ * clock out the transactions already queued ahead of it before it receives the response, and
+ * any operations it sends in the meantime are kept for decoding.
+ */
+static void transmit_send_buffer(Mgpu_Databus *databus) {
+    Mgpu_SpiTransactionSlot *slot = take_oldest_slot(databus);
+    memcpy(slot->sendBuffer, databus->sendBuffer, SPI_BUFFER_SIZE);
+    queue_slot(databus, slot);
+}
+
+/*
+ * Sends the serialized response in the encode buffer as v3 frames, one transaction per frame.
+ */
+static void send_fragmented_response(Mgpu_Databus *databus, size_t byteCount) {
+    size_t maxPayload = mgpu_packet_framing_v3_max_payload(SPI_BUFFER_SIZE);
+    size_t offset = 0;
+    uint8_t sequence = 0;
+    while (offset < byteCount) {
+        size_t payloadSize = min(byteCount - offset, maxPayload);
+        uint8_t flags = offset == 0 ? MGPU_FRAMING_V3_FLAG_FIRST : 0;
+        if (offset + payloadSize == byteCount) {
+            flags |= MGPU_FRAMING_V3_FLAG_FINAL;
+        }
 
+        memset(databus->sendBuffer, 0, SPI_BUFFER_SIZE);
+        int bytesEncoded = mgpu_packet_framing_v3_encode_fragment(databus->encodeDecodeBuffer + offset,
+                                                                  payloadSize,
+                                                                  flags,
+                                                                  sequence,
+                                                                  databus->sendBuffer,
+                                                                  SPI_BUFFER_SIZE);
+
+        if (bytesEncoded <= 0) {
+            ESP_LOGE(LOG_TAG, "Encoding response fragment failed with error: %d", bytesEncoded);
+            return;
+        }
+
+        transmit_send_buffer(databus);
+        offset += payloadSize;
+        sequence++;
+    }
+}
+
+static void send_response(Mgpu_Databus *databus, Mgpu_Response *response, uint8_t framingVersion) {
     memset(databus->sendBuffer, 0, SPI_BUFFER_SIZE);
     int byteCount = mgpu_serialize_response(response, databus->encodeDecodeBuffer, PACKET_BUFFER_SIZE);
     if (byteCount <= 0) {
@@ -177,6 +326,11 @@ void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response)
         }
     }
 
+    if (framingVersion == MGPU_FRAMING_VERSION_3) {
+        send_fragmented_response(databus, byteCount);
+        return;
+    }
+
     int bytesEncoded = mgpu_packet_framing_encode(databus->encodeDecodeBuffer, byteCount, databus->sendBuffer, SPI_BUFFER_SIZE);
     if (bytesEncoded <= 0) {
         switch (bytesEncoded) {
@@ -194,25 +348,51 @@ void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response)
         }
     }
 
-    spi_slave_transaction_t transaction;
-    memset(&transaction, 0, sizeof(transaction));
-    memset(databus->receiveBuffer, 0, SPI_BUFFER_SIZE);
+    transmit_send_buffer(databus);
+}
 
-    // Set up the SPI transaction
-    transaction.length = SPI_BUFFER_SIZE * 8;
-    transaction.rx_buffer = databus->receiveBuffer;
-    transaction.tx_buffer = databus->sendBuffer;
+void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response) {
+    assert(databus != NULL);
+    assert(response != NULL);
 
-    esp_err_t spiResult = spi_slave_transmit(databus->spiHost, &transaction, portMAX_DELAY);
-    if (spiResult != ESP_OK) {
-        ESP_LOGE(LOG_TAG, "SPI send failed: %s", esp_err_to_name(spiResult));
-    }
+    send_response(databus, response, databus->framingVersion);
 }
 
 uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus) {
     assert(databus != NULL);
 
-    return SPI_BUFFER_SIZE;
+    if (databus->framingVersion == MGPU_FRAMING_VERSION_3) {
+        return MGPU_FRAMING_V3_MAX_MSG_SIZE;
+    }
+
+    return MGPU_FRAMING_MAX_MSG_SIZE;
+}
+
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+
+    return databus->reassembler != NULL ? MGPU_FRAMING_VERSION_3 : MGPU_FRAMING_VERSION_2;
+}
+
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId) {
+    assert(databus != NULL);
+
+    uint8_t previousVersion = databus->framingVersion;
+    Mgpu_Response response = {.type = Mgpu_Response_Framing, .requestId = requestId};
+    if (requestedVersion >= MGPU_FRAMING_VERSION_3 && databus->reassembler != NULL) {
+        response.framing.version = MGPU_FRAMING_VERSION_3;
+        response.framing.maxFrameSize = SPI_BUFFER_SIZE;
+        response.framing.maxMessageSize = MGPU_FRAMING_V3_MAX_MSG_SIZE;
+        mgpu_frame_reassembler_reset(databus->reassembler);
+    } else {
+        response.framing.version = MGPU_FRAMING_VERSION_2;
+        response.framing.maxFrameSize = MGPU_FRAMING_MAX_MSG_SIZE + 4;
+        response.framing.maxMessageSize = MGPU_FRAMING_MAX_MSG_SIZE;
+    }
+
+    databus->framingVersion = response.framing.version;
+    send_response(databus, &response, previousVersion);
+    ESP_LOGI(LOG_TAG, "Switched from framing version %u to %u", previousVersion, response.framing.version);
 }
 
 void init_databus_options(Mgpu_DatabusOptions *options) {
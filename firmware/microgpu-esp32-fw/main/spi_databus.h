@@ -1,7 +1,23 @@
 #pragma once
 
+#include <driver/spi_slave.h>
 #include <hal/spi_types.h>
 #include "microgpu-common/alloc.h"
+#include "microgpu-common/packet_framing.h"
+
+/*
+ * How many transactions are kept queued with the SPI driver, so the controller can clock the
+ * next one while operations from the last one are still being executed.
+ */
+#define SPI_QUEUED_TRANSACTIONS 3
+
+/*
+ * A transaction along with the DMA buffers it receives into and sends from
+ */
+typedef struct {
+    spi_slave_transaction_t transaction;
+    uint8_t *receiveBuffer, *sendBuffer;
+} Mgpu_SpiTransactionSlot;
 
 struct Mgpu_DatabusOptions {
     int copiPin, cipoPin, sclkPin, csPin, handshakePin;
@@ -11,8 +27,27 @@ struct Mgpu_DatabusOptions {
 struct Mgpu_Databus {
     const Mgpu_Allocator *allocator;
     spi_host_device_t spiHost;
-    uint8_t *receiveBuffer, *sendBuffer, *encodeDecodeBuffer;
+
+    /*
+     * Every transaction is queued in slot order, so the oldest slot is always the next one the
+     * controller will finish.
+     */
+    Mgpu_SpiTransactionSlot slots[SPI_QUEUED_TRANSACTIONS];
+    uint8_t oldestSlot;
+
+    /*
+     * Bytes received from finished transactions that haven't been decoded yet
+     */
+    uint8_t *receiveBuffer;
     size_t receiveBufferBytesRemaining;
+    uint8_t *sendBuffer, *encodeDecodeBuffer;
+    uint8_t framingVersion;
+
+    /*
+     * Joins operations sent across multiple SPI transactions. NULL if there wasn't enough
+     * memory for it, in which case only the original framing is supported.
+     */
+    Mgpu_FrameReassembler *reassembler;
 };
 
 void init_databus_options(Mgpu_DatabusOptions *options);
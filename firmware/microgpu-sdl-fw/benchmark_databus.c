@@ -0,0 +1,269 @@
+#include <assert.h>
+#include <string.h>
+#include <SDL.h>
+#include "microgpu-common/fonts/fonts.h"
+#include "microgpu-common/operations/operation_deserializer.h"
+#include "microgpu-common/packet_framing.h"
+#include "benchmark_databus.h"
+
+// Replays a fixed frame of operations over and over, as framed packets, so the full receive,
+// decode, and execution cost of every operation is paid each frame. Comparing the frame times
+// of the pipelined and sequential modes shows how much of the receive side is being overlapped
+// with rasterization.
+
+#define STREAM_CAPACITY (128 * 1024)
+#define TEXTURE_ID 5
+#define TEXTURE_SIZE 64
+#define PIXELS_PER_APPEND 100
+#define RECTANGLES_PER_FRAME 200
+#define TRIANGLES_PER_FRAME 60
+#define TEXTURE_DRAWS_PER_FRAME 40
+#define TEXT_LINES_PER_FRAME 10
+#define BATCHES_PER_FRAME 10
+#define RECTANGLES_PER_BATCH 10
+
+static uint32_t randomState;
+
+static uint16_t next_random(uint16_t max) {
+    randomState = randomState * 1103515245 + 12345;
+    return (uint16_t) ((randomState >> 16) % max);
+}
+
+static void write_u16(uint8_t *bytes, uint16_t value) {
+    bytes[0] = value >> 8;
+    bytes[1] = value & 0xFF;
+}
+
+static void append_packet(Mgpu_Databus *databus, const uint8_t *bytes, size_t size) {
+    int written = mgpu_packet_framing_encode(bytes,
+                                             size,
+                                             databus->stream + databus->streamSize,
+                                             STREAM_CAPACITY - databus->streamSize);
+
+    assert(written > 0);
+    databus->streamSize += written;
+}
+
+static size_t make_rectangle(uint8_t *bytes) {
+    bytes[0] = Mgpu_Operation_DrawRectangle;
+    bytes[1] = 0;
+    write_u16(bytes + 2, next_random(1000));
+    write_u16(bytes + 4, next_random(750));
+    write_u16(bytes + 6, 10 + next_random(100));
+    write_u16(bytes + 8, 10 + next_random(100));
+    write_u16(bytes + 10, next_random(0xFFFF));
+
+    return 12;
+}
+
+static void build_stream(Mgpu_Databus *databus) {
+    uint8_t bytes[MGPU_FRAMING_MAX_MSG_SIZE];
+    randomState = 12345;
+
+    bytes[0] = Mgpu_Operation_Initialize;
+    bytes[1] = 1;
+    append_packet(databus, bytes, 2);
+
+    bytes[0] = Mgpu_Operation_DefineTexture;
+    bytes[1] = TEXTURE_ID;
+    write_u16(bytes + 2, TEXTURE_SIZE);
+    write_u16(bytes + 4, TEXTURE_SIZE);
+    write_u16(bytes + 6, mgpu_color_from_rgb888(255, 255, 255));
+    append_packet(databus, bytes, 8);
+
+    for (int pixelsLeft = TEXTURE_SIZE * TEXTURE_SIZE; pixelsLeft > 0; pixelsLeft -= PIXELS_PER_APPEND) {
+        uint16_t pixelCount = pixelsLeft < PIXELS_PER_APPEND ? pixelsLeft : PIXELS_PER_APPEND;
+        bytes[0] = Mgpu_Operation_AppendTexturePixels;
+        bytes[1] = TEXTURE_ID;
+        write_u16(bytes + 2, pixelCount);
+        for (int x = 0; x < pixelCount; x++) {
+            write_u16(bytes + 4 + (x * 2), next_random(0xFFFF));
+        }
+
+        append_packet(databus, bytes, 4 + pixelCount * 2);
+    }
+
+    databus->frameStartPosition = databus->streamSize;
+
+    for (int x = 0; x < RECTANGLES_PER_FRAME; x++) {
+        append_packet(databus, bytes, make_rectangle(bytes));
+    }
+
+    for (int x = 0; x < TRIANGLES_PER_FRAME; x++) {
+        uint16_t baseX = next_random(900), baseY = next_random(650);
+        bytes[0] = Mgpu_Operation_DrawTriangle;
+        bytes[1] = 0;
+        write_u16(bytes + 2, baseX + next_random(100));
+        write_u16(bytes + 4, baseY);
+        write_u16(bytes + 6, baseX);
+        write_u16(bytes + 8, baseY + 20 + next_random(80));
+        write_u16(bytes + 10, baseX + 20 + next_random(100));
+        write_u16(bytes + 12, baseY + 20 + next_random(80));
+        write_u16(bytes + 14, next_random(0xFFFF));
+        append_packet(databus, bytes, 16);
+    }
+
+    for (int x = 0; x < TEXTURE_DRAWS_PER_FRAME; x++) {
+        bytes[0] = Mgpu_Operation_DrawTexture;
+        bytes[1] = TEXTURE_ID;
+        bytes[2] = 0;
+        write_u16(bytes + 3, 0);
+        write_u16(bytes + 5, 0);
+        write_u16(bytes + 7, TEXTURE_SIZE);
+        write_u16(bytes + 9, TEXTURE_SIZE);
+        write_u16(bytes + 11, next_random(1000));
+        write_u16(bytes + 13, next_random(750));
+        bytes[15] = 0;
+        append_packet(databus, bytes, 16);
+    }
+
+    const char text[] = "Microgpu pipeline benchmark 0123456789";
+    for (int x = 0; x < TEXT_LINES_PER_FRAME; x++) {
+        bytes[0] = Mgpu_Operation_DrawChars;
+        bytes[1] = Mgpu_Font_Font12x16;
+        bytes[2] = 0;
+        write_u16(bytes + 3, mgpu_color_from_rgb888(255, 255, 255));
+        write_u16(bytes + 5, next_random(500));
+        write_u16(bytes + 7, next_random(740));
+        bytes[9] = sizeof(text) - 1;
+        memcpy(bytes + 10, text, sizeof(text) - 1);
+        append_packet(databus, bytes, 10 + sizeof(text) - 1);
+    }
+
+    for (int x = 0; x < BATCHES_PER_FRAME; x++) {
+        size_t size = 3;
+        for (int y = 0; y < RECTANGLES_PER_BATCH; y++) {
+            size_t innerSize = make_rectangle(bytes + size + 2);
+            write_u16(bytes + size, innerSize);
+            size += innerSize + 2;
+        }
+
+        bytes[0] = Mgpu_Operation_Batch;
+        write_u16(bytes + 1, size - 3);
+        append_packet(databus, bytes, size);
+    }
+
+    bytes[0] = Mgpu_Operation_PresentFramebuffer;
+    append_packet(databus, bytes, 1);
+}
+
+static void report_frame_finished(Mgpu_Databus *databus) {
+    databus->framesSinceReport++;
+    if (databus->framesSinceReport < databus->framesPerReport) {
+        return;
+    }
+
+    uint64_t now = SDL_GetPerformanceCounter();
+    double seconds = (double) (now - databus->reportStartedAt) / (double) SDL_GetPerformanceFrequency();
+    SDL_Log("Benchmark: %u frames in %.3f seconds (%.2f ms per frame, %.1f fps)\n",
+            databus->framesSinceReport,
+            seconds,
+            seconds * 1000 / databus->framesSinceReport,
+            databus->framesSinceReport / seconds);
+
+    databus->framesSinceReport = 0;
+    databus->reportStartedAt = now;
+}
+
+Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocator *allocator) {
+    assert(options != NULL);
+    mgpu_alloc_assert(allocator);
+
+    Mgpu_Databus *databus = allocator->FastMemAllocateFn(sizeof(Mgpu_Databus));
+    if (databus == NULL) {
+        return NULL;
+    }
+
+    memset(databus, 0, sizeof(Mgpu_Databus));
+    databus->allocator = allocator;
+    databus->linkBytesPerSecond = options->linkBytesPerSecond;
+    databus->framesPerReport = options->framesPerReport > 0 ? options->framesPerReport : 100;
+    databus->stream = allocator->SlowMemAllocateFn(STREAM_CAPACITY);
+    if (databus->stream == NULL) {
+        mgpu_databus_free(databus);
+        return NULL;
+    }
+
+    build_stream(databus);
+    SDL_Log("Benchmark stream built: %zu bytes per frame, link speed %u bytes/sec\n",
+            databus->streamSize - databus->frameStartPosition,
+            databus->linkBytesPerSecond);
+
+    return databus;
+}
+
+void mgpu_databus_free(Mgpu_Databus *databus) {
+    if (databus != NULL) {
+        if (databus->stream != NULL) {
+            databus->allocator->SlowMemFreeFn(databus->stream);
+        }
+
+        databus->allocator->FastMemFreeFn(databus);
+    }
+}
+
+bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *operation) {
+    assert(databus != NULL);
+    assert(operation != NULL);
+
+    if (databus->streamPosition >= databus->streamSize) {
+        databus->streamPosition = databus->frameStartPosition;
+    }
+
+    if (databus->reportStartedAt == 0) {
+        databus->reportStartedAt = SDL_GetPerformanceCounter();
+    }
+
+    size_t decodedByteCount, inputBytesProcessed;
+    mgpu_packet_framing_decode(databus->stream + databus->streamPosition,
+                               databus->streamSize - databus->streamPosition,
+                               databus->decodeBuffer,
+                               sizeof(databus->decodeBuffer),
+                               &decodedByteCount,
+                               &inputBytesProcessed);
+
+    assert(inputBytesProcessed > 0);
+    databus->streamPosition += inputBytesProcessed;
+
+    if (databus->linkBytesPerSecond > 0) {
+        // Simulate a link that only starts transferring once the gpu asks for the next packet,
+        // like an SPI slave transaction does.
+        uint64_t frequency = SDL_GetPerformanceFrequency();
+        uint64_t transferTicks = (inputBytesProcessed * frequency) / databus->linkBytesPerSecond;
+        uint64_t availableAt = SDL_GetPerformanceCounter() + transferTicks;
+        while (SDL_GetPerformanceCounter() < availableAt) {
+            // Yield instead of sleeping, as sleep granularity is far coarser than a packet's
+            // transfer time, but don't hog the cpu the way real link hardware wouldn't.
+            SDL_Delay(0);
+        }
+    }
+
+    if (decodedByteCount == 0 ||
+        !mgpu_operation_deserialize(databus->decodeBuffer, decodedByteCount, operation)) {
+        return false;
+    }
+
+    if (operation->type == Mgpu_Operation_PresentFramebuffer) {
+        report_frame_finished(databus);
+    }
+
+    return true;
+}
+
+void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response) {
+    // The benchmark never asks for responses
+}
+
+uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+    return MGPU_FRAMING_MAX_MSG_SIZE;
+}
+
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+    return MGPU_FRAMING_VERSION_2;
+}
+
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId) {
+    // The benchmark never asks for responses
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include "microgpu-common/databus.h"
+
+struct Mgpu_DatabusOptions {
+    /*
+     * Simulated speed of the link the packets arrive over. Each packet is held back until it
+     * would have been fully received at this rate. Zero means packets are available immediately.
+     */
+    uint32_t linkBytesPerSecond;
+
+    /*
+     * How many frames to render between each timing report
+     */
+    uint16_t framesPerReport;
+};
+
+struct Mgpu_Databus {
+    const Mgpu_Allocator *allocator;
+    uint8_t *stream;
+    size_t streamSize, streamPosition, frameStartPosition;
+    uint32_t linkBytesPerSecond;
+    uint16_t framesPerReport, framesSinceReport;
+    uint64_t reportStartedAt;
+    uint8_t decodeBuffer[256];
+};
@@ -0,0 +1,357 @@
+#define SDL_MAIN_HANDLED
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "microgpu-common/alloc.h"
+#include "microgpu-common/messages.h"
+#include "microgpu-common/packet_framing.h"
+
+// Measures how fast messages can be framed and unframed, and checks the framing against a set
+// of known good vectors. The same vectors are used by the C# driver's tests, so both sides
+// are held to byte for byte identical frames.
+//
+// Usage:
+//   microgpu_sdl_framing_benchmark [vectors file]
+//   microgpu_sdl_framing_benchmark --write-vectors <vectors file>
+
+#define MAX_MESSAGE_SIZE 65535
+#define MAX_ENCODED_SIZE (MAX_MESSAGE_SIZE * 2)
+#define BYTES_PER_SCENARIO (64 * 1024 * 1024)
+#define V3_FRAME_SIZE 1024
+
+typedef enum {
+    PATTERN_FEW_ZEROS,
+    PATTERN_SPARSE_ZEROS,
+    PATTERN_ALL_ZEROS,
+    PATTERN_NO_ZEROS,
+} Pattern;
+
+static const char *patternNames[] = {"few zeros", "every 8th byte zero", "all zeros", "no zeros"};
+
+typedef struct {
+    uint8_t version;
+    size_t messageSize;
+    Pattern pattern;
+} Scenario;
+
+static const Scenario scenarios[] = {
+        {.version = 2, .messageSize = MGPU_FRAMING_MAX_MSG_SIZE, .pattern = PATTERN_FEW_ZEROS},
+        {.version = 2, .messageSize = MGPU_FRAMING_MAX_MSG_SIZE, .pattern = PATTERN_SPARSE_ZEROS},
+        {.version = 2, .messageSize = MGPU_FRAMING_MAX_MSG_SIZE, .pattern = PATTERN_ALL_ZEROS},
+        {.version = 2, .messageSize = 16, .pattern = PATTERN_FEW_ZEROS},
+        {.version = 3, .messageSize = MAX_MESSAGE_SIZE, .pattern = PATTERN_FEW_ZEROS},
+        {.version = 3, .messageSize = MAX_MESSAGE_SIZE, .pattern = PATTERN_SPARSE_ZEROS},
+        {.version = 3, .messageSize = MAX_MESSAGE_SIZE, .pattern = PATTERN_ALL_ZEROS},
+};
+
+static uint8_t message[MAX_MESSAGE_SIZE];
+static uint8_t encoded[MAX_ENCODED_SIZE];
+static uint8_t decoded[MAX_MESSAGE_SIZE];
+static uint8_t expected[MAX_ENCODED_SIZE];
+
+static uint32_t randomState;
+
+static uint32_t next_random(uint32_t max) {
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 8) % max;
+}
+
+static void fill_message(uint8_t *buffer, size_t size, Pattern pattern) {
+    for (size_t x = 0; x < size; x++) {
+        switch (pattern) {
+            case PATTERN_FEW_ZEROS:
+                buffer[x] = next_random(256);
+                break;
+
+            case PATTERN_SPARSE_ZEROS:
+                buffer[x] = x % 8 == 7 ? 0 : 1 + next_random(255);
+                break;
+
+            case PATTERN_ALL_ZEROS:
+                buffer[x] = 0;
+                break;
+
+            case PATTERN_NO_ZEROS:
+                buffer[x] = 1 + next_random(255);
+                break;
+        }
+    }
+}
+
+static void *allocate(size_t size) {
+    return malloc(size);
+}
+
+static const Mgpu_Allocator allocator = {
+        .FastMemAllocateFn = allocate,
+        .FastMemFreeFn = free,
+        .SlowMemAllocateFn = allocate,
+        .SlowMemFreeFn = free,
+};
+
+static int encode(uint8_t version, size_t frameSize, const uint8_t *msg, size_t size, uint8_t *target, size_t targetSize) {
+    if (version == MGPU_FRAMING_VERSION_2) {
+        return mgpu_packet_framing_encode(msg, size, target, targetSize);
+    }
+
+    return mgpu_packet_framing_v3_encode(msg, size, frameSize, target, targetSize);
+}
+
+/*
+ * Decodes every frame in the buffer, returning the size of the last message completed or -1
+ * if any frame failed to decode.
+ */
+static int decode(uint8_t version, Mgpu_FrameReassembler *reassembler, const uint8_t *frames, size_t size) {
+    int messageSize = -1;
+    size_t offset = 0;
+    while (offset < size) {
+        size_t decodedCount, processed;
+        if (version == MGPU_FRAMING_VERSION_2) {
+            mgpu_packet_framing_decode(frames + offset, size - offset, decoded, sizeof(decoded), &decodedCount, &processed);
+            if (decodedCount == 0) {
+                return -1;
+            }
+
+            messageSize = (int) decodedCount;
+        } else {
+            mgpu_packet_framing_v3_decode(frames + offset, size - offset, decoded, sizeof(decoded), &decodedCount, &processed);
+            if (decodedCount == 0) {
+                return -1;
+            }
+
+            const uint8_t *reassembled;
+            size_t reassembledSize;
+            if (mgpu_frame_reassembler_add(reassembler, decoded, decodedCount, &reassembled, &reassembledSize)) {
+                // Unfragmented frames come back pointing into `decoded` just past the header, so the
+                // ranges overlap
+                if (reassembled != decoded) {
+                    memmove(decoded, reassembled, reassembledSize);
+                }
+
+                messageSize = (int) reassembledSize;
+            }
+        }
+
+        offset += processed;
+    }
+
+    return messageSize;
+}
+
+static void write_hex(FILE *file, const uint8_t *bytes, size_t size) {
+    fputc(' ', file);
+    for (size_t x = 0; x < size; x++) {
+        fprintf(file, "%02X", bytes[x]);
+    }
+}
+
+static bool read_hex(FILE *file, uint8_t *bytes, size_t capacity, size_t *size) {
+    *size = 0;
+    int c;
+    while ((c = fgetc(file)) == ' ') {}
+
+    char digits[3] = {0};
+    while (c != EOF && c != ' ' && c != '\n') {
+        int next = fgetc(file);
+        if (next == EOF || *size >= capacity) {
+            return false;
+        }
+
+        digits[0] = (char) c;
+        digits[1] = (char) next;
+        bytes[(*size)++] = (uint8_t) strtoul(digits, NULL, 16);
+        c = fgetc(file);
+    }
+
+    if (c != EOF) {
+        ungetc(c, file);
+    }
+
+    return true;
+}
+
+static void write_vector(FILE *file, uint8_t version, size_t frameSize, const uint8_t *msg, size_t size) {
+    int encodedSize = encode(version, frameSize, msg, size, encoded, sizeof(encoded));
+    if (encodedSize <= 0) {
+        SDL_Log("Failed to encode %zu byte v%u vector: %d\n", size, version, encodedSize);
+        return;
+    }
+
+    if (version == MGPU_FRAMING_VERSION_2) {
+        fprintf(file, "v2");
+    } else {
+        fprintf(file, "v3 %zu", frameSize);
+    }
+
+    write_hex(file, msg, size);
+    write_hex(file, encoded, encodedSize);
+    fputc('\n', file);
+}
+
+static int write_vectors(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        SDL_Log("Failed to open %s for writing\n", path);
+        return 1;
+    }
+
+    fprintf(file, "# Packet framing vectors, generated by microgpu_sdl_framing_benchmark --write-vectors\n");
+    fprintf(file, "# v2 <message> <packet>\n");
+    fprintf(file, "# v3 <max frame size> <message> <frames>\n");
+
+    randomState = 12345;
+
+    // Checksums with zero bytes in them
+    static const uint8_t checksumEdges[][2] = {{0x00, 0x00}, {0x01, 0x00}, {0x80, 0x80}, {0xFF, 0x01}};
+    for (int x = 0; x < sizeof(checksumEdges) / sizeof(checksumEdges[0]); x++) {
+        write_vector(file, MGPU_FRAMING_VERSION_2, 0, checksumEdges[x], 2);
+    }
+
+    static const size_t v2Sizes[] = {1, 2, 3, 8, 9, 64, 249, 250};
+    for (int pattern = PATTERN_FEW_ZEROS; pattern <= PATTERN_NO_ZEROS; pattern++) {
+        for (int x = 0; x < sizeof(v2Sizes) / sizeof(v2Sizes[0]); x++) {
+            fill_message(message, v2Sizes[x], pattern);
+            write_vector(file, MGPU_FRAMING_VERSION_2, 0, message, v2Sizes[x]);
+        }
+    }
+
+    // Sizes around the longest COBS run and the fragment boundaries
+    static const size_t v3FrameSizes[] = {16, 300};
+    static const size_t v3Sizes[] = {1, 253, 254, 255, 600};
+    for (int pattern = PATTERN_FEW_ZEROS; pattern <= PATTERN_NO_ZEROS; pattern++) {
+        for (int f = 0; f < sizeof(v3FrameSizes) / sizeof(v3FrameSizes[0]); f++) {
+            for (int x = 0; x < sizeof(v3Sizes) / sizeof(v3Sizes[0]); x++) {
+                fill_message(message, v3Sizes[x], pattern);
+                write_vector(file, MGPU_FRAMING_VERSION_3, v3FrameSizes[f], message, v3Sizes[x]);
+            }
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static int check_vectors(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        SDL_Log("Failed to open %s\n", path);
+        return 1;
+    }
+
+    Mgpu_FrameReassembler *reassembler = mgpu_frame_reassembler_new(&allocator, MAX_MESSAGE_SIZE);
+    if (reassembler == NULL) {
+        SDL_Log("Failed to create frame reassembler: %s\n", mgpu_message_get_pointer());
+        fclose(file);
+        return 1;
+    }
+
+    int line = 0, checked = 0, failed = 0;
+    char prefix[3];
+    while (fscanf(file, "%2s", prefix) == 1) {
+        line++;
+        if (prefix[0] == '#') {
+            int c;
+            while ((c = fgetc(file)) != '\n' && c != EOF) {}
+            continue;
+        }
+
+        uint8_t version = prefix[1] == '3' ? MGPU_FRAMING_VERSION_3 : MGPU_FRAMING_VERSION_2;
+        size_t frameSize = 0, messageSize, expectedSize;
+        if ((version == MGPU_FRAMING_VERSION_3 && fscanf(file, "%zu", &frameSize) != 1) ||
+            !read_hex(file, message, sizeof(message), &messageSize) ||
+            !read_hex(file, expected, sizeof(expected), &expectedSize)) {
+            SDL_Log("Line %d: malformed vector\n", line);
+            failed++;
+            break;
+        }
+
+        checked++;
+        int encodedSize = encode(version, frameSize, message, messageSize, encoded, sizeof(encoded));
+        if (encodedSize != expectedSize || memcmp(encoded, expected, expectedSize) != 0) {
+            SDL_Log("Line %d: encoding did not match the expected frames\n", line);
+            failed++;
+            continue;
+        }
+
+        mgpu_frame_reassembler_reset(reassembler);
+        int decodedSize = decode(version, reassembler, expected, expectedSize);
+        if (decodedSize != messageSize || memcmp(decoded, message, messageSize) != 0) {
+            SDL_Log("Line %d: decoding did not return the original message: %s\n", line, mgpu_message_get_pointer());
+            failed++;
+        }
+    }
+
+    SDL_Log("%d of %d framing vectors matched\n", checked - failed, checked);
+
+    mgpu_frame_reassembler_free(reassembler);
+    fclose(file);
+    return failed > 0 ? 1 : 0;
+}
+
+static void run_scenario(const Scenario *scenario, Mgpu_FrameReassembler *reassembler) {
+    randomState = 12345;
+    fill_message(message, scenario->messageSize, scenario->pattern);
+
+    int encodedSize = 0;
+    int iterations = BYTES_PER_SCENARIO / (int) scenario->messageSize;
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (int x = 0; x < iterations; x++) {
+        encodedSize = encode(scenario->version, V3_FRAME_SIZE, message, scenario->messageSize, encoded, sizeof(encoded));
+    }
+
+    uint64_t encodeTicks = SDL_GetPerformanceCounter() - start;
+
+    int decodedSize = 0;
+    start = SDL_GetPerformanceCounter();
+    for (int x = 0; x < iterations; x++) {
+        decodedSize = decode(scenario->version, reassembler, encoded, encodedSize);
+    }
+
+    uint64_t decodeTicks = SDL_GetPerformanceCounter() - start;
+
+    if (encodedSize <= 0 || decodedSize != scenario->messageSize) {
+        SDL_Log("v%u %zu byte messages with %s: round trip failed: %s\n",
+                scenario->version,
+                scenario->messageSize,
+                patternNames[scenario->pattern],
+                mgpu_message_get_pointer());
+
+        return;
+    }
+
+    double megabytes = (double) iterations * scenario->messageSize / (1024 * 1024);
+    double frequency = (double) SDL_GetPerformanceFrequency();
+    SDL_Log("v%u %zu byte messages with %s: encode %.1f MB/s, decode %.1f MB/s\n",
+            scenario->version,
+            scenario->messageSize,
+            patternNames[scenario->pattern],
+            megabytes * frequency / (double) encodeTicks,
+            megabytes * frequency / (double) decodeTicks);
+}
+
+int main(int argc, char *args[]) {
+    if (argc == 3 && strcmp(args[1], "--write-vectors") == 0) {
+        return write_vectors(args[2]);
+    }
+
+    if (argc == 2 && check_vectors(args[1]) != 0) {
+        return 1;
+    }
+
+    Mgpu_FrameReassembler *reassembler = mgpu_frame_reassembler_new(&allocator, MAX_MESSAGE_SIZE);
+    if (reassembler == NULL) {
+        SDL_Log("Failed to create frame reassembler: %s\n", mgpu_message_get_pointer());
+        return 1;
+    }
+
+    for (int x = 0; x < sizeof(scenarios) / sizeof(scenarios[0]); x++) {
+        run_scenario(&scenarios[x], reassembler);
+    }
+
+    mgpu_frame_reassembler_free(reassembler);
+    return 0;
+}
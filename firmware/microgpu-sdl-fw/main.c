@@ -2,11 +2,18 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL.h>
 #include "microgpu-common/alloc.h"
+#include "microgpu-common/band_rasterizer.h"
 #include "microgpu-common/messages.h"
 #include "microgpu-common/operations/operations.h"
 #include "microgpu-common/operations/operation_execution.h"
+#include "microgpu-common/operations/operation_stats.h"
+#include "microgpu-common/pipeline.h"
+#include "microgpu-common/retained_frame.h"
+#include "microgpu-common/tile_binner.h"
 #include "sdl_display.h"
 #include "microgpu-common/packet_framing.h"
 
@@ -18,6 +25,14 @@
 
 #include "tcp_databus.h"
 
+#elif defined(DATABUS_BENCHMARK)
+
+#include "benchmark_databus.h"
+
+#elif defined(DATABUS_SHM)
+
+#include "shm_databus.h"
+
 #endif
 
 #define FPS 60
@@ -31,19 +46,47 @@ static const Mgpu_Allocator basicAllocator = {
 };
 
 bool isRunning, resetRequested;
+bool usePipeline = true;
+Mgpu_Pipeline *pipeline;
+uint8_t rasterWorkerCount = 0;
+Mgpu_BandRasterizer *bandRasterizer;
+SDL_Thread *rasterWorkerThreads[UINT8_MAX];
+uint8_t rasterWorkerIndexes[UINT8_MAX];
+bool useTileBinning = false;
+Mgpu_TileBinner *tileBinner;
+bool useStripRendering = false;
+Mgpu_RetainedFrame *retainedFrame;
 Mgpu_Display *display;
 Mgpu_Databus *databus;
 uint16_t width, height;
 Mgpu_TextureManager *textureManager;
+size_t textureBudget = 0;
 Mgpu_DatabusOptions dataBusOptions;
+#ifdef DATABUS_SHM
+const char *shmPath = SHM_DATABUS_DEFAULT_PATH;
+#endif
 Mgpu_DisplayOptions displayOptions = {
         .width = 1024,
         .height = 768,
 };
 
+uint32_t get_microseconds(void) {
+    uint64_t ticksPerMicrosecond = SDL_GetPerformanceFrequency() / 1000000;
+    if (ticksPerMicrosecond == 0) {
+        return SDL_GetTicks() * 1000;
+    }
+
+    return (uint32_t) (SDL_GetPerformanceCounter() / ticksPerMicrosecond);
+}
+
 bool setup(void) {
-#ifdef DATABUS_TCP
+#if defined(DATABUS_TCP)
     dataBusOptions.port = 9123;
+#elif defined(DATABUS_BENCHMARK)
+    dataBusOptions.linkBytesPerSecond = 2 * 1024 * 1024;
+    dataBusOptions.framesPerReport = 100;
+#elif defined(DATABUS_SHM)
+    dataBusOptions.path = shmPath;
 #endif
 
     databus = mgpu_databus_new(&dataBusOptions, &basicAllocator);
@@ -58,12 +101,21 @@ bool setup(void) {
         return false;
     }
 
-    textureManager = mgpu_texture_manager_new(&basicAllocator);
+    Mgpu_TextureManagerOptions textureManagerOptions = {
+            .fastArenaSize = 0,
+            .slowArenaSize = 8 * 1024 * 1024,
+            .compactWhenFull = true,
+            .slowBudget = textureBudget,
+    };
+
+    textureManager = mgpu_texture_manager_new(&basicAllocator, &textureManagerOptions);
     if (textureManager == NULL) {
         fprintf(stderr, "Failed to initialize texture manager\n");
         return false;
     }
 
+    mgpu_operation_stats_set_clock(get_microseconds);
+
     return true;
 }
 
@@ -84,6 +136,38 @@ void handleResponse(Mgpu_Response *response) {
             SDL_Log("GetLastMessage response received: %s", response->lastMessage.message);
             break;
 
+        case Mgpu_Response_TextureUsage:
+            SDL_Log("Texture usage: %u of %u slow bytes, %u textures, %u evictions\n",
+                    response->textureUsage.slowBytesUsed,
+                    response->textureUsage.slowBudget,
+                    response->textureUsage.textureCount,
+                    response->textureUsage.evictionCount);
+            break;
+
+        case Mgpu_Response_Framing:
+            SDL_Log("Framing: version %u, %u byte frames, %u byte operations\n",
+                    response->framing.version,
+                    response->framing.maxFrameSize,
+                    response->framing.maxMessageSize);
+            break;
+
+        case Mgpu_Response_Fence:
+            SDL_Log("Last completed fence: %u\n", response->fence.lastCompletedValue);
+            break;
+
+        case Mgpu_Response_Stats:
+            for (uint8_t index = 0; index < response->stats.entryCount; index++) {
+                const Mgpu_StatsEntry *entry = &response->stats.entries[index];
+                SDL_Log("Operation %u: %u executions, %u total us, %u max us, %u pixels, %u bytes\n",
+                        entry->operationType,
+                        entry->executions,
+                        entry->totalMicroseconds,
+                        entry->maxMicroseconds,
+                        entry->pixelsTouched,
+                        entry->bytesDecoded);
+            }
+            break;
+
         default:
             break;
     }
@@ -112,6 +196,195 @@ int databus_loop(void *data) {
     return 0;
 }
 
+void pipeline_wait(uint32_t attempt) {
+    // Yield for short waits, but back off to sleeping so an idle stage doesn't spin a core
+    SDL_Delay(attempt < 1000 ? 0 : 1);
+}
+
+int pipeline_receive_loop(void *data) {
+    while (isRunning) {
+        if (!mgpu_pipeline_receive_next(pipeline, databus)) {
+            // The receive stage reports errors to the pipeline's own message buffer
+            char *receiveMessage = mgpu_message_get_pointer();
+            if (receiveMessage != NULL && strlen(receiveMessage) > 0) {
+                SDL_Log("Message from receiving: %s\n", receiveMessage);
+            }
+#ifdef DATABUS_TCP
+            SDL_Log("Failed to deserialize data\n");
+#endif
+        }
+    }
+
+    return 0;
+}
+
+int pipeline_execute_loop(void *data) {
+    while (isRunning) {
+        if (mgpu_pipeline_execute_next(pipeline, display, databus, &resetRequested, textureManager)) {
+            char *currentMessage = mgpu_message_get_pointer();
+            if (currentMessage != NULL && strlen(currentMessage) > 0) {
+                SDL_Log("Message from operation: %s\n", currentMessage);
+            }
+        }
+    }
+
+    return 0;
+}
+
+bool start_pipeline(SDL_Thread **receiveThread, SDL_Thread **executeThread) {
+    Mgpu_PipelineOptions options = {
+            .operationCapacity = 256,
+            .payloadArenaSize = 128 * 1024, // Room for more than one of the largest operations
+            .waitFn = pipeline_wait,
+    };
+
+    pipeline = mgpu_pipeline_new(&basicAllocator, &options);
+    if (pipeline == NULL) {
+        SDL_Log("Failed to create pipeline: %s\n", mgpu_message_get_pointer());
+        return false;
+    }
+
+    *executeThread = SDL_CreateThread(pipeline_execute_loop, "Execute Loop", NULL);
+    *receiveThread = SDL_CreateThread(pipeline_receive_loop, "Receive Loop", NULL);
+
+    return true;
+}
+
+void stop_pipeline(SDL_Thread *receiveThread, SDL_Thread *executeThread) {
+    mgpu_pipeline_stop(pipeline);
+
+    SDL_Log("Waiting for pipeline to close\n");
+    SDL_WaitThread(executeThread, NULL);
+    SDL_WaitThread(receiveThread, NULL);
+
+    Mgpu_PipelineStats stats;
+    mgpu_pipeline_get_stats(pipeline, &stats);
+    SDL_Log("Pipeline: %u operations received, %u executed, %u dropped\n",
+            stats.operationsReceived,
+            stats.operationsExecuted,
+            stats.operationsDropped);
+    SDL_Log("Pipeline: receive stage waited on execution %u times, execute stage waited on receiving %u times\n",
+            stats.receiveWaits,
+            stats.executeWaits);
+
+    mgpu_pipeline_free(pipeline);
+    pipeline = NULL;
+
+    mgpu_databus_free(databus);
+    databus = NULL;
+}
+
+int raster_worker_loop(void *data) {
+    uint8_t workerIndex = *(uint8_t *) data;
+    while (isRunning) {
+        mgpu_band_rasterizer_work(bandRasterizer, workerIndex);
+    }
+
+    return 0;
+}
+
+bool start_band_rasterizer(void) {
+    Mgpu_BandRasterizerOptions options = {
+            .workerCount = rasterWorkerCount,
+            .operationCapacity = 256,
+            .payloadArenaSize = 16 * 1024,
+            .waitFn = pipeline_wait,
+    };
+
+    bandRasterizer = mgpu_band_rasterizer_new(&basicAllocator, &options);
+    if (bandRasterizer == NULL) {
+        SDL_Log("Failed to create band rasterizer: %s\n", mgpu_message_get_pointer());
+        return false;
+    }
+
+    for (int x = 0; x < rasterWorkerCount; x++) {
+        rasterWorkerIndexes[x] = x;
+        rasterWorkerThreads[x] = SDL_CreateThread(raster_worker_loop, "Raster Worker", &rasterWorkerIndexes[x]);
+    }
+
+    Mgpu_DrawDispatcher dispatcher;
+    mgpu_band_rasterizer_get_dispatcher(bandRasterizer, &dispatcher);
+    mgpu_execute_set_draw_dispatcher(&dispatcher);
+
+    return true;
+}
+
+void stop_band_rasterizer(void) {
+    // Operation execution has stopped, so nothing else can be submitted
+    mgpu_band_rasterizer_stop(bandRasterizer);
+
+    SDL_Log("Waiting for raster workers to close\n");
+    for (int x = 0; x < rasterWorkerCount; x++) {
+        SDL_WaitThread(rasterWorkerThreads[x], NULL);
+    }
+
+    mgpu_execute_set_draw_dispatcher(NULL);
+    mgpu_band_rasterizer_free(bandRasterizer);
+    bandRasterizer = NULL;
+}
+
+bool start_tile_binner(void) {
+    Mgpu_TileBinnerOptions options = {
+            .tileSize = 32,
+            .operationCapacity = 2048,
+            .binEntryCapacity = 16384,
+            .payloadArenaSize = 16 * 1024,
+    };
+
+    tileBinner = mgpu_tile_binner_new(&basicAllocator, &options);
+    if (tileBinner == NULL) {
+        SDL_Log("Failed to create tile binner: %s\n", mgpu_message_get_pointer());
+        return false;
+    }
+
+    Mgpu_DrawDispatcher dispatcher;
+    mgpu_tile_binner_get_dispatcher(tileBinner, &dispatcher);
+    mgpu_execute_set_draw_dispatcher(&dispatcher);
+
+    return true;
+}
+
+void stop_tile_binner(void) {
+    Mgpu_TileBinnerStats stats;
+    mgpu_tile_binner_get_stats(tileBinner, &stats);
+    SDL_Log("Tile binner: %u tiles rendered, %u tiles skipped, %u early flushes\n",
+            stats.tilesRendered,
+            stats.tilesSkipped,
+            stats.earlyFlushes);
+
+    mgpu_execute_set_draw_dispatcher(NULL);
+    mgpu_tile_binner_free(tileBinner);
+    tileBinner = NULL;
+}
+
+bool start_strip_rendering(void) {
+    Mgpu_RetainedFrameOptions options = {
+            .operationCapacity = 2048,
+            .payloadArenaSize = 16 * 1024,
+            .waitFn = pipeline_wait,
+    };
+
+    retainedFrame = mgpu_retained_frame_new(&basicAllocator, &options);
+    if (retainedFrame == NULL) {
+        SDL_Log("Failed to create retained frame: %s\n", mgpu_message_get_pointer());
+        return false;
+    }
+
+    Mgpu_DrawDispatcher dispatcher;
+    mgpu_retained_frame_get_dispatcher(retainedFrame, &dispatcher);
+    mgpu_execute_set_draw_dispatcher(&dispatcher);
+    mgpu_display_set_retained_frame(display, retainedFrame, textureManager);
+
+    return true;
+}
+
+void stop_strip_rendering(void) {
+    mgpu_execute_set_draw_dispatcher(NULL);
+    mgpu_display_set_retained_frame(display, NULL, textureManager);
+    mgpu_retained_frame_free(retainedFrame);
+    retainedFrame = NULL;
+}
+
 void wait_for_init_op() {
     SDL_Log("Waiting for initialization operation\n");
     Mgpu_Operation operation;
@@ -143,6 +416,7 @@ void wait_for_init_op() {
             .height = height,
             .id = 0,
             .transparentColor = mgpu_color_from_rgb888(0, 0, 0),
+            .flags = useStripRendering ? MGPU_TEXTURE_NO_PIXELS : 0,
     };
 
     if (!mgpu_texture_define(textureManager, &frameBufferSpecs, operation.initialize.frameBufferScale)) {
@@ -186,12 +460,28 @@ void sdl_poll_events() {
 
 void start_sdl_system(void) {
     SDL_Thread *databusThread = NULL;
+    SDL_Thread *receiveThread = NULL;
+    SDL_Thread *executeThread = NULL;
 
     SDL_Log("Starting SDL system\n");
     isRunning = setup();
     if (isRunning) {
         wait_for_init_op();
-        databusThread = SDL_CreateThread(databus_loop, "Databus Loop", NULL);
+        if (rasterWorkerCount > 0) {
+            isRunning = start_band_rasterizer();
+        } else if (useTileBinning) {
+            isRunning = start_tile_binner();
+        } else if (useStripRendering) {
+            isRunning = start_strip_rendering();
+        }
+    }
+
+    if (isRunning) {
+        if (usePipeline) {
+            isRunning = start_pipeline(&receiveThread, &executeThread);
+        } else {
+            databusThread = SDL_CreateThread(databus_loop, "Databus Loop", NULL);
+        }
     }
 
     uint32_t previousFrameTime = 0;
@@ -210,11 +500,41 @@ void start_sdl_system(void) {
         sdl_poll_events();
     }
 
-    SDL_Log("Waiting for databus to close\n");
-    SDL_WaitThread(databusThread, NULL);
+    if (pipeline != NULL) {
+        stop_pipeline(receiveThread, executeThread);
+    } else {
+        SDL_Log("Waiting for databus to close\n");
+        SDL_WaitThread(databusThread, NULL);
+    }
+
+    if (bandRasterizer != NULL) {
+        stop_band_rasterizer();
+    }
+
+    if (tileBinner != NULL) {
+        stop_tile_binner();
+    }
+
+    if (retainedFrame != NULL) {
+        stop_strip_rendering();
+    }
 
     SDL_Log("Finishing tear down\n");
 
+    Mgpu_TextureManagerStats textureStats;
+    mgpu_texture_manager_get_stats(textureManager, &textureStats);
+    SDL_Log("Texture arena: %zu of %zu bytes used, %zu free in %u blocks (largest %zu)\n",
+            textureStats.slowArena.usedBytes,
+            textureStats.slowArena.totalBytes,
+            textureStats.slowArena.freeBytes,
+            textureStats.slowArena.freeBlockCount,
+            textureStats.slowArena.largestFreeBlock);
+    SDL_Log("Texture arena: %u allocations, %u failed, %u compactions, %u textures allocated outside the arena\n",
+            textureStats.slowArena.allocations,
+            textureStats.slowArena.failedAllocations,
+            textureStats.slowArena.compactions,
+            textureStats.arenaFallbacks);
+
     mgpu_texture_manager_free(textureManager);
     textureManager = NULL;
 
@@ -225,6 +545,47 @@ void start_sdl_system(void) {
 int main(int argc, char *args[]) {
     SDL_Log("Color size: %llu\n", sizeof(Mgpu_Color));
 
+    for (int x = 1; x < argc; x++) {
+        if (strcmp(args[x], "--sequential") == 0) {
+            // Receive and execute operations on the same thread, one after another
+            usePipeline = false;
+        } else if (strcmp(args[x], "--raster-workers") == 0 && x + 1 < argc) {
+            // Split framebuffer drawing into horizontal bands, each drawn on its own thread
+            int count = atoi(args[x + 1]);
+            rasterWorkerCount = count < 0 ? 0 : count > UINT8_MAX ? UINT8_MAX : count;
+            x++;
+        } else if (strcmp(args[x], "--tile-binning") == 0) {
+            // Defer framebuffer drawing until present, then draw it one tile at a time
+            useTileBinning = true;
+        } else if (strcmp(args[x], "--strip-rendering") == 0) {
+            // Don't keep a frame buffer, and instead render each frame in strips as it's displayed
+            useStripRendering = true;
+        } else if (strcmp(args[x], "--texture-budget-kb") == 0 && x + 1 < argc) {
+            // Limit how much memory textures can use, evicting cacheable textures when it runs out
+            int kilobytes = atoi(args[x + 1]);
+            textureBudget = kilobytes < 0 ? 0 : (size_t) kilobytes * 1024;
+            x++;
+#ifdef DATABUS_SHM
+        } else if (strcmp(args[x], "--shm-path") == 0 && x + 1 < argc) {
+            // File the shared memory databus is mapped from, which clients need to open as well
+            shmPath = args[x + 1];
+            x++;
+#endif
+        }
+    }
+
+    SDL_Log("Operations will be %s\n", usePipeline ? "pipelined" : "received and executed sequentially");
+    if (rasterWorkerCount > 0) {
+        SDL_Log("Framebuffer will be rasterized in %u bands\n", rasterWorkerCount);
+    } else if (useTileBinning) {
+        SDL_Log("Framebuffer will be rasterized in tiles when presented\n");
+    } else if (useStripRendering) {
+        SDL_Log("Frames will be rendered in strips without a framebuffer\n");
+    }
+
+    // Bands and tiles both draw into the framebuffer, so strip rendering can't be combined with them
+    useStripRendering = useStripRendering && rasterWorkerCount == 0 && !useTileBinning;
+
     while (true) {
         resetRequested = false;
         start_sdl_system();
@@ -1,45 +1,72 @@
 #include <assert.h>
 #include <SDL.h>
 #include "sdl_display.h"
+#include "microgpu-common/common.h"
 #include "microgpu-common/display.h"
 
+// Number of lines rendered at a time when rendering from a retained frame
+#define STRIP_HEIGHT 16
+
+uint32_t *transfer_line(Mgpu_Display *display, Mgpu_Color *line, uint16_t width, uint8_t scale, uint32_t *target) {
+    uint16_t colPadding = display->width - (width * scale);
+
+    for (int rowScale = 0; rowScale < scale; rowScale++) {
+        // Each scaled row duplicates the same line.
+        // A memcopy() is probably faster, but the point of sdl implementation isn't speed.
+        Mgpu_Color *source = line;
+        for (int col = 0; col < width; col++) {
+            for (int colScale = 0; colScale < scale; colScale++) {
+                uint8_t red, green, blue;
+                mgpu_color_get_rgb888(*source, &red, &green, &blue);
+                uint32_t color = ((uint32_t) red << 16) | ((uint32_t) green << 8) | blue;
+                *target = color;
+                target++;
+            }
+            source++;
+        }
+
+        // Add any padding to make sure non-exact scaling doesn't cause
+        // pixel shifting / starts next pixel on the correct row.
+        for (int col = 0; col < colPadding; col++) {
+            *target = 0; // black
+            target++;
+        }
+    }
+
+    return target;
+}
+
 void transfer_framebuffer(Mgpu_Display *display, Mgpu_TextureManager *textureManager) {
     Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
     assert(frameBuffer != NULL);
     assert(frameBuffer->width != 0);
     assert(frameBuffer->height != 0);
 
-    Mgpu_Color *source = frameBuffer->pixels;
     uint32_t *target = display->pixelBuffer;
-    uint16_t colPadding = display->width - (frameBuffer->width * frameBuffer->scale);
     uint16_t rowPadding = display->height - (frameBuffer->height * frameBuffer->scale);
 
-    for (int row = 0; row < frameBuffer->height; row++) {
-        for (int rowScale = 0; rowScale < frameBuffer->scale; rowScale++) {
-            if (rowScale > 0) {
-                // Reset back to the start of the line to duplicate the previous line.
-                // A memcopy() is probably faster, but the point of sdl implementation isn't speed.
-                source -= frameBuffer->width;
-            }
-
-            for (int col = 0; col < frameBuffer->width; col++) {
-                for (int colScale = 0; colScale < frameBuffer->scale; colScale++) {
-                    uint8_t red, green, blue;
-                    mgpu_color_get_rgb888(*source, &red, &green, &blue);
-                    uint32_t color = ((uint32_t) red << 16) | ((uint32_t) green << 8) | blue;
-                    *target = color;
-                    target++;
-                }
-                source++;
-            }
-
-            // Add any padding to make sure non-exact scaling doesn't cause
-            // pixel shifting / starts next pixel on the correct row.
-            for (int col = 0; col < colPadding; col++) {
-                *target = 0; // black
-                target++;
+    if (display->retainedFrame != NULL) {
+        // Render the frame a strip at a time, the same way a display without room for a
+        // full frame buffer would.
+        for (int firstLine = 0; firstLine < frameBuffer->height; firstLine += STRIP_HEIGHT) {
+            uint16_t lineCount = min(STRIP_HEIGHT, frameBuffer->height - firstLine);
+            mgpu_retained_frame_render_strip(display->retainedFrame,
+                                             textureManager,
+                                             display->stripBuffer,
+                                             frameBuffer->width,
+                                             firstLine,
+                                             lineCount);
+
+            for (int row = 0; row < lineCount; row++) {
+                Mgpu_Color *line = display->stripBuffer + (row * frameBuffer->width);
+                target = transfer_line(display, line, frameBuffer->width, frameBuffer->scale, target);
             }
         }
+    } else {
+        for (int row = 0; row < frameBuffer->height; row++) {
+            Mgpu_Color *line = frameBuffer->pixels + (row * frameBuffer->width);
+            target = transfer_line(display, line, frameBuffer->width, frameBuffer->scale, target);
+        }
     }
 
     // Add row padding
@@ -63,6 +90,9 @@ Mgpu_Display *mgpu_display_new(const Mgpu_Allocator *allocator, const Mgpu_Displ
 
     display->width = options->width;
     display->height = options->height;
+    display->retainedFrame = NULL;
+    display->stripBuffer = NULL;
+    display->framesRendered = 0;
 
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
         fprintf(stderr, "Error initializing SDL: %s.\n", SDL_GetError());
@@ -125,6 +155,8 @@ void mgpu_display_free(Mgpu_Display *display) {
         SDL_DestroyWindow(display->window);
         display->allocator->FastMemFreeFn(display->pixelBuffer);
         display->pixelBuffer = NULL;
+        display->allocator->FastMemFreeFn(display->stripBuffer);
+        display->stripBuffer = NULL;
         display->allocator->FastMemFreeFn(display);
     }
 }
@@ -153,4 +185,29 @@ void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureMana
 
     SDL_RenderCopy(display->renderer, display->texture, NULL, NULL);
     SDL_RenderPresent(display->renderer);
+    display->framesRendered++;
+}
+
+void mgpu_display_set_retained_frame(Mgpu_Display *display,
+                                     Mgpu_RetainedFrame *retainedFrame,
+                                     Mgpu_TextureManager *textureManager) {
+    assert(display != NULL);
+
+    if (retainedFrame != NULL && display->stripBuffer == NULL) {
+        // The frame buffer is never wider than the display, so this covers any scale
+        display->stripBuffer = display->allocator->FastMemAllocateFn(sizeof(Mgpu_Color) * display->width * STRIP_HEIGHT);
+        assert(display->stripBuffer != NULL);
+    }
+
+    display->retainedFrame = retainedFrame;
+}
+
+void mgpu_display_get_frame_counts(Mgpu_Display *display, uint32_t *framesRendered, uint32_t *framesPresented) {
+    assert(display != NULL);
+    assert(framesRendered != NULL);
+    assert(framesPresented != NULL);
+
+    // Frames are on screen by the time rendering returns
+    *framesRendered = display->framesRendered;
+    *framesPresented = display->framesRendered;
 }
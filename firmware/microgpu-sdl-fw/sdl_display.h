@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <SDL.h>
 #include "microgpu-common/alloc.h"
+#include "microgpu-common/retained_frame.h"
 
 struct Mgpu_Display {
     uint16_t width, height;
@@ -11,6 +12,9 @@ struct Mgpu_Display {
     SDL_Window *window;
     SDL_Renderer *renderer;
     const Mgpu_Allocator *allocator;
+    Mgpu_RetainedFrame *retainedFrame;
+    Mgpu_Color *stripBuffer;
+    uint32_t framesRendered;
 };
 
 struct Mgpu_DisplayOptions {
@@ -0,0 +1,317 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <SDL.h>
+#include "microgpu-common/databus.h"
+#include "microgpu-common/operations/operation_deserializer.h"
+#include "microgpu-common/responses/response_serializer.h"
+#include "microgpu-common/packet_framing.h"
+#include "shm_databus.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#define HEADER_SIZE 4096
+#define OPERATION_RING_SIZE (1024 * 1024)
+#define RESPONSE_RING_SIZE (64 * 1024)
+#define RESPONSE_BUFFER_SIZE 1024
+
+// How many times a ring is checked before going to sleep until it changes
+#define SPINS_BEFORE_SLEEPING 1000
+
+// How long to wait for an operation before giving up, so the caller gets a chance to stop
+#define OPERATION_WAIT_MS 100
+
+// How long to wait for the client to make room for a response before dropping it
+#define RESPONSE_WAIT_MS 1000
+
+static uint32_t entrySize(uint32_t length) {
+    return sizeof(uint32_t) + ((length + 3) & ~(uint32_t) 3);
+}
+
+/*
+ * Sleeps until the value no longer matches what was last seen, or for about a millisecond. The
+ * sleeping flag is set for the duration so the other side knows it needs to wake us.
+ */
+static void sleepUntilChanged(_Atomic uint32_t *value, uint32_t seen, Mgpu_ShmCounter *sleeping) {
+    atomic_store(&sleeping->value, 1);
+    if (atomic_load(value) == seen) {
+#ifdef __linux__
+        // Not a private futex, since the other side is a different process
+        struct timespec timeout = {.tv_sec = 0, .tv_nsec = 1000000};
+        syscall(SYS_futex, value, FUTEX_WAIT, seen, &timeout, NULL, 0);
+#else
+        SDL_Delay(1);
+#endif
+    }
+
+    atomic_store(&sleeping->value, 0);
+}
+
+static void wakeSleeper(_Atomic uint32_t *value, Mgpu_ShmCounter *sleeping) {
+    if (atomic_load(&sleeping->value) != 0) {
+#ifdef __linux__
+        syscall(SYS_futex, value, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+    }
+}
+
+/*
+ * Hands the entry of the last operation back to the client, now that nothing points into it.
+ */
+static void releasePendingOperation(Mgpu_Databus *databus) {
+    if (databus->pendingEntrySize > 0) {
+        atomic_fetch_add_explicit(&databus->header->operationTail.value,
+                                  databus->pendingEntrySize,
+                                  memory_order_release);
+
+        databus->pendingEntrySize = 0;
+    }
+}
+
+/*
+ * A client connects by incrementing the connect request, and then waits for it to be
+ * acknowledged before using the rings. Anything the previous client left behind is discarded.
+ */
+static void acceptConnection(Mgpu_Databus *databus) {
+    Mgpu_ShmHeader *header = databus->header;
+    uint32_t request = atomic_load(&header->connectRequest.value);
+    if (request == atomic_load(&header->connectAcknowledgement.value)) {
+        return;
+    }
+
+    atomic_store(&header->operationHead.value, 0);
+    atomic_store(&header->operationTail.value, 0);
+    atomic_store(&header->responseHead.value, 0);
+    atomic_store(&header->responseTail.value, 0);
+    databus->pendingEntrySize = 0;
+
+    atomic_store(&header->connectAcknowledgement.value, request);
+    SDL_Log("Client connection accepted.\n");
+}
+
+static bool isHeaderValid(Mgpu_ShmHeader *header) {
+    return atomic_load(&header->magic) == SHM_DATABUS_MAGIC &&
+           header->layoutVersion == SHM_DATABUS_LAYOUT_VERSION &&
+           header->operationRingSize == OPERATION_RING_SIZE &&
+           header->responseRingSize == RESPONSE_RING_SIZE;
+}
+
+Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocator *allocator) {
+    assert(options != NULL);
+    mgpu_alloc_assert(allocator);
+
+    Mgpu_Databus *databus = allocator->FastMemAllocateFn(sizeof(Mgpu_Databus));
+    if (databus == NULL) {
+        return NULL;
+    }
+
+    databus->allocator = allocator;
+    databus->memory = NULL;
+    databus->memorySize = HEADER_SIZE + OPERATION_RING_SIZE + RESPONSE_RING_SIZE;
+    databus->pendingEntrySize = 0;
+    databus->sendLock = SDL_CreateMutex();
+    if (databus->sendLock == NULL) {
+        mgpu_databus_free(databus);
+        return NULL;
+    }
+
+    const char *path = options->path != NULL ? options->path : SHM_DATABUS_DEFAULT_PATH;
+    int file = open(path, O_RDWR | O_CREAT, 0666);
+    if (file < 0) {
+        fprintf(stderr, "Failed to open shared memory file %s\n", path);
+        mgpu_databus_free(databus);
+        return NULL;
+    }
+
+    void *memory = MAP_FAILED;
+    if (ftruncate(file, (off_t) databus->memorySize) == 0) {
+        memory = mmap(NULL, databus->memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+
+    close(file);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "Failed to map shared memory file %s\n", path);
+        mgpu_databus_free(databus);
+        return NULL;
+    }
+
+    databus->memory = memory;
+    databus->header = memory;
+    databus->operationRing = databus->memory + HEADER_SIZE;
+    databus->responseRing = databus->operationRing + OPERATION_RING_SIZE;
+
+    // A file left by an earlier databus, such as before a reset, is reused as is so a client
+    // that's still attached doesn't have to reconnect.
+    Mgpu_ShmHeader *header = databus->header;
+    if (!isHeaderValid(header)) {
+        atomic_store(&header->magic, 0);
+        memset(databus->memory + sizeof(header->magic), 0, databus->memorySize - sizeof(header->magic));
+        header->layoutVersion = SHM_DATABUS_LAYOUT_VERSION;
+        header->operationRingSize = OPERATION_RING_SIZE;
+        header->responseRingSize = RESPONSE_RING_SIZE;
+        atomic_store(&header->magic, SHM_DATABUS_MAGIC);
+    }
+
+    SDL_Log("Sharing databus memory through %s\n", path);
+
+    return databus;
+}
+
+void mgpu_databus_free(Mgpu_Databus *databus) {
+    if (databus != NULL) {
+        if (databus->memory != NULL) {
+            // Released so the operation that caused the databus to be freed, like a reset,
+            // isn't read again by the next databus using the same file.
+            releasePendingOperation(databus);
+            munmap(databus->memory, databus->memorySize);
+        }
+
+        if (databus->sendLock != NULL) {
+            SDL_DestroyMutex(databus->sendLock);
+        }
+
+        databus->allocator->FastMemFreeFn(databus);
+    }
+}
+
+bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *operation) {
+    assert(databus != NULL);
+    assert(operation != NULL);
+
+    memset(operation, 0, sizeof(Mgpu_Operation));
+    releasePendingOperation(databus);
+
+    Mgpu_ShmHeader *header = databus->header;
+    uint32_t startTicks = SDL_GetTicks();
+    uint32_t spins = 0;
+    while (true) {
+        acceptConnection(databus);
+
+        uint32_t head = atomic_load_explicit(&header->operationHead.value, memory_order_acquire);
+        uint32_t tail = atomic_load_explicit(&header->operationTail.value, memory_order_relaxed);
+        if (head == tail) {
+            if (spins < SPINS_BEFORE_SLEEPING) {
+                spins++;
+            } else if (SDL_GetTicks() - startTicks >= OPERATION_WAIT_MS) {
+                return false;
+            } else {
+                sleepUntilChanged(&header->operationHead.value, head, &header->gpuSleeping);
+            }
+
+            continue;
+        }
+
+        uint32_t offset = tail & (OPERATION_RING_SIZE - 1);
+        uint32_t length;
+        memcpy(&length, databus->operationRing + offset, sizeof(length));
+        if (length == SHM_DATABUS_WRAP_MARKER) {
+            atomic_store_explicit(&header->operationTail.value,
+                                  tail + OPERATION_RING_SIZE - offset,
+                                  memory_order_release);
+            continue;
+        }
+
+        uint32_t queuedBytes = head - tail;
+        if (length > UINT16_MAX ||
+            entrySize(length) > queuedBytes ||
+            entrySize(length) > OPERATION_RING_SIZE - offset) {
+            // The client wrote something that isn't an entry, so there's nothing left to trust
+            fprintf(stderr, "Dropping %u bytes of invalid shared memory operations\n", queuedBytes);
+            atomic_store_explicit(&header->operationTail.value, head, memory_order_release);
+            return false;
+        }
+
+        // Deserialized right where the client wrote it, so the entry isn't released until the
+        // next operation is requested.
+        databus->pendingEntrySize = entrySize(length);
+        return mgpu_operation_deserialize(databus->operationRing + offset + sizeof(length), length, operation);
+    }
+}
+
+static void writeResponse(Mgpu_Databus *databus, const uint8_t *message, uint32_t length) {
+    Mgpu_ShmHeader *header = databus->header;
+    uint32_t head = atomic_load_explicit(&header->responseHead.value, memory_order_relaxed);
+    uint32_t offset = head & (RESPONSE_RING_SIZE - 1);
+    uint32_t bytesUntilEnd = RESPONSE_RING_SIZE - offset;
+    uint32_t requiredBytes = entrySize(length) + (bytesUntilEnd < entrySize(length) ? bytesUntilEnd : 0);
+
+    uint32_t startTicks = SDL_GetTicks();
+    uint32_t spins = 0;
+    while (true) {
+        uint32_t tail = atomic_load_explicit(&header->responseTail.value, memory_order_acquire);
+        if (RESPONSE_RING_SIZE - (head - tail) >= requiredBytes) {
+            break;
+        }
+
+        if (spins < SPINS_BEFORE_SLEEPING) {
+            spins++;
+        } else if (SDL_GetTicks() - startTicks >= RESPONSE_WAIT_MS) {
+            SDL_Log("Dropping response of type %u, since the client isn't reading responses", message[0]);
+            return;
+        } else {
+            sleepUntilChanged(&header->responseTail.value, tail, &header->gpuSleeping);
+        }
+    }
+
+    if (bytesUntilEnd < entrySize(length)) {
+        uint32_t marker = SHM_DATABUS_WRAP_MARKER;
+        memcpy(databus->responseRing + offset, &marker, sizeof(marker));
+        head += bytesUntilEnd;
+        offset = 0;
+    }
+
+    memcpy(databus->responseRing + offset, &length, sizeof(length));
+    memcpy(databus->responseRing + offset + sizeof(length), message, length);
+    // Sequentially consistent, so the client either sees the new head or has already marked
+    // itself as sleeping by the time the flag is checked
+    atomic_store(&header->responseHead.value, head + entrySize(length));
+    wakeSleeper(&header->responseHead.value, &header->clientSleeping);
+}
+
+void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response) {
+    assert(databus != NULL);
+    assert(response != NULL);
+
+    uint8_t messageBuffer[RESPONSE_BUFFER_SIZE] = {0};
+    int messageBytesWritten = mgpu_serialize_response(response, messageBuffer, sizeof(messageBuffer));
+    if (messageBytesWritten < 0) {
+        fprintf(stderr, "Failed to serialize response: %u\n", messageBytesWritten);
+        return;
+    }
+
+    SDL_LockMutex(databus->sendLock);
+    writeResponse(databus, messageBuffer, messageBytesWritten);
+    SDL_UnlockMutex(databus->sendLock);
+}
+
+uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+    return UINT16_MAX;
+}
+
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+    return MGPU_FRAMING_VERSION_2;
+}
+
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId) {
+    assert(databus != NULL);
+
+    // Operations are written straight into memory, so there's no framing to switch
+    Mgpu_Response response = {
+            .type = Mgpu_Response_Framing,
+            .requestId = requestId,
+            .framing = {.version = MGPU_FRAMING_VERSION_2, .maxFrameSize = 0, .maxMessageSize = UINT16_MAX},
+    };
+
+    mgpu_databus_send_response(databus, &response);
+}
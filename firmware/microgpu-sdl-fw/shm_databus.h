@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "microgpu-common/alloc.h"
+#include "microgpu-common/databus.h"
+
+/*
+ * Databus for clients running on the same machine, which exchange operations and responses
+ * through a memory mapped file instead of a socket. Operations are written by the client
+ * directly into a ring in the file and deserialized from where they landed, so there's no
+ * packet framing or checksums involved.
+ *
+ * The file is laid out as a 4KB header followed by the ring of operations going to the gpu and
+ * then the ring of responses going to the client. Every value in the header is a 32 bit little
+ * endian integer. Values written by different sides sit on their own 64 byte cache line:
+ *
+ *   0    magic (SHM_DATABUS_MAGIC, written last once the file is ready)
+ *   4    layout version (SHM_DATABUS_LAYOUT_VERSION)
+ *   8    size of the operation ring
+ *   12   size of the response ring
+ *   64   connect request, incremented by a client when it connects
+ *   128  connect acknowledgement, set to the connect request once the rings have been reset
+ *   192  operation ring head, advanced by the client
+ *   256  operation ring tail, advanced by the gpu
+ *   320  response ring head, advanced by the gpu
+ *   384  response ring tail, advanced by the client
+ *   448  set while the gpu is sleeping until the operation ring head changes
+ *   512  set while the client is sleeping until the response ring head changes
+ *
+ * Heads and tails are running byte counts that wrap at 32 bits, and ring sizes are powers of
+ * two. Each entry in a ring is a 32 bit length followed by that many bytes, padded to a multiple
+ * of 4 bytes. Entries never wrap around the end of a ring. If one doesn't fit before the end,
+ * the writer puts a length of SHM_DATABUS_WRAP_MARKER there and starts over at the beginning.
+ *
+ * After advancing a head, the writer wakes the other side if it's sleeping. On Linux that's a
+ * futex wake on the head, but sleepers also wake up on their own every millisecond, so writers
+ * that can't issue futex calls still work.
+ */
+
+#define SHM_DATABUS_MAGIC 0x4853474D // "MGSH"
+#define SHM_DATABUS_LAYOUT_VERSION 1
+#define SHM_DATABUS_WRAP_MARKER 0xFFFFFFFF
+
+#ifdef __linux__
+#define SHM_DATABUS_DEFAULT_PATH "/dev/shm/microgpu"
+#else
+#define SHM_DATABUS_DEFAULT_PATH "/tmp/microgpu"
+#endif
+
+typedef struct {
+    _Atomic uint32_t value;
+    uint8_t padding[60];
+} Mgpu_ShmCounter;
+
+typedef struct {
+    _Atomic uint32_t magic;
+    uint32_t layoutVersion;
+    uint32_t operationRingSize;
+    uint32_t responseRingSize;
+    uint8_t padding[48];
+
+    Mgpu_ShmCounter connectRequest;
+    Mgpu_ShmCounter connectAcknowledgement;
+    Mgpu_ShmCounter operationHead;
+    Mgpu_ShmCounter operationTail;
+    Mgpu_ShmCounter responseHead;
+    Mgpu_ShmCounter responseTail;
+    Mgpu_ShmCounter gpuSleeping;
+    Mgpu_ShmCounter clientSleeping;
+} Mgpu_ShmHeader;
+
+struct Mgpu_DatabusOptions {
+    /*
+     * Path of the file to share with clients. It's created if it doesn't exist.
+     */
+    const char *path;
+};
+
+struct Mgpu_Databus {
+    const Mgpu_Allocator *allocator;
+    uint8_t *memory;
+    size_t memorySize;
+    Mgpu_ShmHeader *header;
+    uint8_t *operationRing, *responseRing;
+
+    /*
+     * Size of the entry the last operation was read from. It's only released back to the client
+     * when the next operation is requested, since the operation points into it.
+     */
+    uint32_t pendingEntrySize;
+
+    /*
+     * Responses are sent by the execution thread, while fence queries are answered by the receive thread
+     */
+    SDL_mutex *sendLock;
+};
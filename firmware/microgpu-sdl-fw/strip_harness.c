@@ -0,0 +1,237 @@
+#define SDL_MAIN_HANDLED
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "microgpu-common/alloc.h"
+#include "microgpu-common/common.h"
+#include "microgpu-common/display.h"
+#include "microgpu-common/messages.h"
+#include "microgpu-common/operations/operation_execution.h"
+#include "microgpu-common/retained_frame.h"
+#include "benchmark_databus.h"
+
+// Validates strip rendering against full framebuffer rendering. The benchmark's frames are
+// replayed once into a full framebuffer and once through a retained frame rendered in strips,
+// and every presented frame is compared pixel by pixel. No window is opened; this harness
+// supplies its own display that captures each presented frame.
+
+#define DISPLAY_WIDTH 1024
+#define DISPLAY_HEIGHT 768
+#define FRAMES_PER_RUN 3
+
+typedef struct {
+    uint8_t scale;
+
+    // Zero renders into a full framebuffer
+    uint16_t stripHeight;
+} Scenario;
+
+static const Scenario scenarios[] = {
+        {.scale = 1, .stripHeight = 1},
+        {.scale = 1, .stripHeight = 7},
+        {.scale = 1, .stripHeight = 16},
+        {.scale = 1, .stripHeight = DISPLAY_HEIGHT},
+        {.scale = 2, .stripHeight = 5},
+        {.scale = 2, .stripHeight = 16},
+};
+
+static const Mgpu_Allocator basicAllocator = {
+        .FastMemAllocateFn = malloc,
+        .FastMemFreeFn = free,
+        .SlowMemAllocateFn = malloc,
+        .SlowMemFreeFn = free,
+};
+
+struct Mgpu_Display {
+    Mgpu_RetainedFrame *retainedFrame;
+    uint16_t stripHeight;
+    Mgpu_Color *frames;
+    uint16_t framesCaptured;
+};
+
+Mgpu_Display *mgpu_display_new(const Mgpu_Allocator *allocator, const Mgpu_DisplayOptions *options) {
+    // The harness display is set up directly by each run
+    return NULL;
+}
+
+void mgpu_display_free(Mgpu_Display *display) {
+}
+
+void mgpu_display_get_dimensions(Mgpu_Display *display, uint16_t *width, uint16_t *height) {
+    *width = DISPLAY_WIDTH;
+    *height = DISPLAY_HEIGHT;
+}
+
+void mgpu_display_render(Mgpu_Display *display, Mgpu_TextureManager *textureManager) {
+    Mgpu_Texture *frameBuffer = mgpu_texture_get(textureManager, 0);
+    size_t pixelCount = frameBuffer->width * frameBuffer->height;
+    Mgpu_Color *capture = display->frames + (display->framesCaptured * pixelCount);
+
+    if (display->retainedFrame != NULL) {
+        for (int firstLine = 0; firstLine < frameBuffer->height; firstLine += display->stripHeight) {
+            uint16_t lineCount = min(display->stripHeight, frameBuffer->height - firstLine);
+            mgpu_retained_frame_render_strip(display->retainedFrame,
+                                             textureManager,
+                                             capture + (firstLine * frameBuffer->width),
+                                             frameBuffer->width,
+                                             firstLine,
+                                             lineCount);
+        }
+    } else {
+        memcpy(capture, frameBuffer->pixels, sizeof(Mgpu_Color) * pixelCount);
+    }
+
+    display->framesCaptured++;
+}
+
+void mgpu_display_set_retained_frame(Mgpu_Display *display,
+                                     Mgpu_RetainedFrame *retainedFrame,
+                                     Mgpu_TextureManager *textureManager) {
+    display->retainedFrame = retainedFrame;
+}
+
+void mgpu_display_get_frame_counts(Mgpu_Display *display, uint32_t *framesRendered, uint32_t *framesPresented) {
+    *framesRendered = display->framesCaptured;
+    *framesPresented = display->framesCaptured;
+}
+
+static bool run_frames(const Scenario *scenario, Mgpu_Color *frames) {
+    Mgpu_DatabusOptions databusOptions = {
+            .linkBytesPerSecond = 0,
+            .framesPerReport = FRAMES_PER_RUN,
+    };
+
+    Mgpu_Databus *databus = mgpu_databus_new(&databusOptions, &basicAllocator);
+    Mgpu_TextureManagerOptions textureManagerOptions = {0};
+    Mgpu_TextureManager *textureManager = mgpu_texture_manager_new(&basicAllocator, &textureManagerOptions);
+    if (databus == NULL || textureManager == NULL) {
+        SDL_Log("Failed to set up run: %s\n", mgpu_message_get_pointer());
+        return false;
+    }
+
+    Mgpu_Display display = {
+            .stripHeight = scenario->stripHeight,
+            .frames = frames,
+    };
+
+    // Make sure pixels left over from an earlier run can't hide pixels strips never wrote
+    memset(frames, 0xA5, sizeof(Mgpu_Color) * DISPLAY_WIDTH * DISPLAY_HEIGHT * FRAMES_PER_RUN);
+
+    Mgpu_Operation operation;
+    while (!mgpu_databus_get_next_operation(databus, &operation) ||
+           operation.type != Mgpu_Operation_Initialize) {
+    }
+
+    Mgpu_TextureDefinition frameBufferSpecs = {
+            .width = DISPLAY_WIDTH,
+            .height = DISPLAY_HEIGHT,
+            .id = 0,
+            .transparentColor = mgpu_color_from_rgb888(0, 0, 0),
+            .flags = scenario->stripHeight > 0 ? MGPU_TEXTURE_NO_PIXELS : 0,
+    };
+
+    mgpu_texture_define(textureManager, &frameBufferSpecs, scenario->scale);
+
+    Mgpu_RetainedFrame *retainedFrame = NULL;
+    if (scenario->stripHeight > 0) {
+        Mgpu_RetainedFrameOptions options = {
+                .operationCapacity = 1024,
+                .payloadArenaSize = 4 * 1024,
+        };
+
+        retainedFrame = mgpu_retained_frame_new(&basicAllocator, &options);
+        if (retainedFrame == NULL) {
+            SDL_Log("Failed to create retained frame: %s\n", mgpu_message_get_pointer());
+            return false;
+        }
+
+        Mgpu_DrawDispatcher dispatcher;
+        mgpu_retained_frame_get_dispatcher(retainedFrame, &dispatcher);
+        mgpu_execute_set_draw_dispatcher(&dispatcher);
+        mgpu_display_set_retained_frame(&display, retainedFrame, textureManager);
+    }
+
+    bool success = true;
+    bool resetRequested = false;
+    while (display.framesCaptured < FRAMES_PER_RUN) {
+        if (!mgpu_databus_get_next_operation(databus, &operation)) {
+            continue;
+        }
+
+        mgpu_execute_operation(&operation, &display, databus, &resetRequested, textureManager);
+
+        char *message = mgpu_message_get_pointer();
+        if (scenario->stripHeight > 0 && strlen(message) > 0) {
+            SDL_Log("Message from operation: %s\n", message);
+            success = false;
+        }
+    }
+
+    mgpu_execute_set_draw_dispatcher(NULL);
+    mgpu_retained_frame_free(retainedFrame);
+    mgpu_texture_manager_free(textureManager);
+    mgpu_databus_free(databus);
+
+    return success;
+}
+
+static bool compare_frames(const Scenario *scenario, Mgpu_Color *expected, Mgpu_Color *actual) {
+    uint16_t width = DISPLAY_WIDTH / scenario->scale;
+    uint16_t height = DISPLAY_HEIGHT / scenario->scale;
+    size_t pixelCount = width * height;
+
+    for (int frame = 0; frame < FRAMES_PER_RUN; frame++) {
+        for (size_t x = 0; x < pixelCount; x++) {
+            size_t index = (frame * pixelCount) + x;
+            if (expected[index] != actual[index]) {
+                SDL_Log("Frame %u differs at (%zu, %zu): expected 0x%04x but strips rendered 0x%04x\n",
+                        frame,
+                        x % width,
+                        x / width,
+                        expected[index],
+                        actual[index]);
+
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *args[]) {
+    size_t framesSize = sizeof(Mgpu_Color) * DISPLAY_WIDTH * DISPLAY_HEIGHT * FRAMES_PER_RUN;
+    Mgpu_Color *expected = malloc(framesSize);
+    Mgpu_Color *actual = malloc(framesSize);
+    if (expected == NULL || actual == NULL) {
+        SDL_Log("Failed to allocate frame captures\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (int x = 0; x < sizeof(scenarios) / sizeof(scenarios[0]); x++) {
+        const Scenario *scenario = &scenarios[x];
+        Scenario fullFrameBuffer = {.scale = scenario->scale, .stripHeight = 0};
+
+        bool passed = run_frames(&fullFrameBuffer, expected) &&
+                      run_frames(scenario, actual) &&
+                      compare_frames(scenario, expected, actual);
+
+        SDL_Log("Scale %u with %u line strips: %s\n",
+                scenario->scale,
+                scenario->stripHeight,
+                passed ? "matched" : "FAILED");
+
+        if (!passed) {
+            failures++;
+        }
+    }
+
+    free(expected);
+    free(actual);
+
+    return failures > 0 ? 1 : 0;
+}
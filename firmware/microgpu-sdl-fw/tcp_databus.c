@@ -12,10 +12,22 @@
 #define INVALID_SOCKET -1
 #endif
 
-#define BYTE_QUEUE_MAX_SIZE 20000
-uint8_t *globalByteQueue;
-size_t globalByteQueueSize; // How many bytes we've pushed into the byte queue
-uint8_t operationBytes[1024];
+// Largest v3 frame accepted from clients, which is enough for most operations to fit in one frame
+#define TCP_MAX_FRAME_SIZE 65535
+#define RESPONSE_BUFFER_SIZE 1024
+
+// Received bytes are written straight into a power of two sized ring and decoded where they
+// land. The first RING_MIRROR_SIZE bytes of the ring are mirrored right after its end, so a
+// frame that wraps around the end of the ring can still be decoded as one contiguous block.
+#define RING_SIZE (256 * 1024)
+#define RING_MASK (RING_SIZE - 1)
+#define RING_MIRROR_SIZE TCP_MAX_FRAME_SIZE
+
+// How far the credit limit has to move before the client is told about it, so every consumed
+// frame doesn't cause a credit response to be sent.
+#define CREDIT_UPDATE_THRESHOLD (RING_SIZE / 8)
+
+static void sendFramedResponse(Mgpu_Databus *databus, Mgpu_Response *response, int framingVersion);
 
 int initSockets(void) {
 #ifdef _WIN32
@@ -76,71 +88,177 @@ bool readBytes(Mgpu_Databus *databus, char *buffer, size_t bufferSize, int *byte
     return true;
 }
 
-void readPacketFromQueue(Mgpu_Operation *operation, bool *hadFullPacket, bool *operationDeserializeResult) {
-    *hadFullPacket = false;
-    *operationDeserializeResult = false;
+void resetRing(Mgpu_Databus *databus) {
+    databus->ringHead = 0;
+    databus->ringTail = 0;
+    databus->ringScanned = 0;
+}
 
-    size_t decodedByteCount, inputBytesProcessed;
-    mgpu_packet_framing_decode(globalByteQueue,
-                               globalByteQueueSize,
-                               (uint8_t *)&operationBytes,
-                               sizeof(operationBytes),
-                               &decodedByteCount,
-                               &inputBytesProcessed);
-
-    if (inputBytesProcessed == 0) {
-        // Could not find a complete packet
-        if (globalByteQueueSize >= BYTE_QUEUE_MAX_SIZE) {
-            // We have a full queue but no valid packet.
-            fprintf(stderr, "TCP queue was full but not one valid packet could be found. Most likely corrupted data");
-            globalByteQueueSize = 0;
+/*
+ * Receives as many bytes as fit between the ring's head and either its end or its tail,
+ * whichever comes first.
+ *
+ * Bytes are only received when there's no complete frame left to decode, and anything longer
+ * than a frame is dropped, so there's always room for more. When operations aren't being
+ * taken off the databus fast enough, no more bytes are received and TCP's flow control makes
+ * the client wait.
+ */
+bool receiveIntoRing(Mgpu_Databus *databus) {
+    size_t offset = databus->ringHead & RING_MASK;
+    size_t freeBytes = RING_SIZE - (databus->ringHead - databus->ringTail);
+    size_t bytesUntilEnd = RING_SIZE - offset;
+    assert(freeBytes > 0);
+
+    int bytesRead;
+    if (!readBytes(databus,
+                   (char *) databus->ring + offset,
+                   freeBytes < bytesUntilEnd ? freeBytes : bytesUntilEnd,
+                   &bytesRead)) {
+        return false;
+    }
+
+    if (offset < RING_MIRROR_SIZE) {
+        size_t mirroredBytes = RING_MIRROR_SIZE - offset;
+        if (mirroredBytes > (size_t) bytesRead) {
+            mirroredBytes = bytesRead;
         }
 
-        return;
+        memcpy(databus->ring + RING_SIZE + offset, databus->ring + offset, mirroredBytes);
     }
 
-    size_t bytesToShift = globalByteQueueSize - inputBytesProcessed;
-    if (bytesToShift > 0) {
-        memmove(globalByteQueue, globalByteQueue + inputBytesProcessed, bytesToShift);
+    databus->ringHead += bytesRead;
+    return true;
+}
+
+/*
+ * Takes the next complete frame, including its zero delimiter, off of the ring. Returns NULL if
+ * more bytes need to be received first. The frame stays valid until more bytes are received.
+ */
+uint8_t *takeFrameFromRing(Mgpu_Databus *databus, size_t *frameSize) {
+    size_t offset = databus->ringTail & RING_MASK;
+    size_t queuedBytes = databus->ringHead - databus->ringTail;
+    size_t contiguousBytes = RING_SIZE - offset + RING_MIRROR_SIZE;
+    if (queuedBytes < contiguousBytes) {
+        contiguousBytes = queuedBytes;
+    }
+
+    uint8_t *start = databus->ring + offset;
+    uint8_t *zero = memchr(start + databus->ringScanned, 0, contiguousBytes - databus->ringScanned);
+    if (zero == NULL) {
+        databus->ringScanned = contiguousBytes;
+        if (contiguousBytes >= RING_MIRROR_SIZE) {
+            // Longer than any valid frame, so most likely corrupted data
+            fprintf(stderr, "Dropping %zu received bytes that did not contain a valid frame\n", contiguousBytes);
+            databus->ringTail += contiguousBytes;
+            databus->ringScanned = 0;
+        }
+
+        return NULL;
+    }
+
+    *frameSize = zero - start + 1;
+    databus->ringTail += *frameSize;
+    databus->ringScanned = 0;
+
+    return start;
+}
+
+/*
+ * Attempts to read the next operation from the ring. Returns true if a frame was consumed,
+ * which includes frames that were only a fragment of a larger operation.
+ */
+bool readPacketFromQueue(Mgpu_Databus *databus,
+                         Mgpu_Operation *operation,
+                         bool *hadFullPacket,
+                         bool *operationDeserializeResult) {
+    *hadFullPacket = false;
+    *operationDeserializeResult = false;
+
+    size_t frameSize;
+    uint8_t *frame = takeFrameFromRing(databus, &frameSize);
+    if (frame == NULL) {
+        return false;
+    }
+
+    bool isVersion3 = SDL_AtomicGet(&databus->framingVersion) == MGPU_FRAMING_VERSION_3;
+    size_t decodedByteCount, inputBytesProcessed;
+    if (isVersion3) {
+        mgpu_packet_framing_v3_decode(frame, frameSize, frame, frameSize, &decodedByteCount, &inputBytesProcessed);
+    } else {
+        mgpu_packet_framing_decode(frame, frameSize, frame, frameSize, &decodedByteCount, &inputBytesProcessed);
     }
 
-    *hadFullPacket = true;
-    globalByteQueueSize = bytesToShift;
     if (decodedByteCount == 0) {
         // decoding failed
+        *hadFullPacket = true;
+        return true;
+    }
+
+    if (!isVersion3) {
+        *hadFullPacket = true;
+        *operationDeserializeResult = mgpu_operation_deserialize(frame, decodedByteCount, operation);
+        return true;
+    }
+
+    const uint8_t *message;
+    size_t messageSize;
+    if (mgpu_frame_reassembler_add(databus->reassembler, frame, decodedByteCount, &message, &messageSize)) {
+        *hadFullPacket = true;
+        *operationDeserializeResult = mgpu_operation_deserialize(message, messageSize, operation);
+    }
+
+    return true;
+}
+
+/*
+ * Lets the client know it can send more, if enough of the ring has been consumed since it was
+ * last told. The ring never holds more than its size, so the client can have sent everything
+ * consumed so far plus a full ring.
+ */
+void advertiseCredits(Mgpu_Databus *databus, bool force) {
+    if (!databus->creditsEnabled) {
+        return;
+    }
+
+    uint32_t limit = (uint32_t) (databus->ringTail - databus->creditStart + RING_SIZE);
+    if (!force && limit - databus->advertisedCreditLimit < CREDIT_UPDATE_THRESHOLD) {
         return;
     }
 
-    *operationDeserializeResult = mgpu_operation_deserialize(operationBytes, decodedByteCount, operation);
+    Mgpu_Response response = {.type = Mgpu_Response_Credits, .credits = {.byteLimit = limit}};
+    sendFramedResponse(databus, &response, SDL_AtomicGet(&databus->framingVersion));
+    databus->advertisedCreditLimit = limit;
 }
 
 bool readOperation(Mgpu_Databus *databus, Mgpu_Operation *operation) {
-    char buffer[1024];
-
     while (true) {
         bool hasFullPacket, operationDeserializationResult;
-        readPacketFromQueue(operation, &hasFullPacket, &operationDeserializationResult);
+        bool consumedBytes = readPacketFromQueue(databus, operation, &hasFullPacket, &operationDeserializationResult);
+        if (consumedBytes) {
+            advertiseCredits(databus, false);
+        }
+
+        if (hasFullPacket && operationDeserializationResult && operation->type == Mgpu_Operation_EnableCredits) {
+            // Counted from the end of the frame this operation came in, which the tail now points to
+            databus->creditsEnabled = true;
+            databus->creditStart = databus->ringTail;
+            advertiseCredits(databus, true);
+        }
 
         if (hasFullPacket) {
             return operationDeserializationResult;
         }
 
+        if (consumedBytes) {
+            // Only a fragment of a larger operation, so the rest may already be queued
+            continue;
+        }
+
         // We didn't have a full packet, so we need more bytes
-        int bytesRead;
-        if (!readBytes(databus, buffer, sizeof(buffer), &bytesRead)) {
+        if (!receiveIntoRing(databus)) {
             // Reading the connection failed
             return false;
         }
-
-        if (globalByteQueueSize + bytesRead > BYTE_QUEUE_MAX_SIZE) {
-            SDL_LogError(0, "Queue grew too large\n");
-            exit(2);
-        }
-
-        for (int x = 0; x < bytesRead; x++) {
-            globalByteQueue[globalByteQueueSize + x] = buffer[x];
-        }
-        globalByteQueueSize += bytesRead;
     }
 }
 
@@ -156,10 +274,17 @@ Mgpu_Databus *mgpu_databus_new(Mgpu_DatabusOptions *options, const Mgpu_Allocato
     databus->allocator = allocator;
     databus->serverSocket = INVALID_SOCKET;
     databus->clientSocket = INVALID_SOCKET;
-
-    // Initialize the packet if it's not already allocated
-    if (globalByteQueue == NULL) {
-        globalByteQueue = allocator->FastMemAllocateFn(sizeof(uint8_t) * BYTE_QUEUE_MAX_SIZE);
+    databus->sendLock = NULL;
+    databus->creditsEnabled = false;
+    SDL_AtomicSet(&databus->framingVersion, MGPU_FRAMING_VERSION_2);
+    resetRing(databus);
+    databus->ring = allocator->FastMemAllocateFn(RING_SIZE + RING_MIRROR_SIZE);
+    databus->reassembler = mgpu_frame_reassembler_new(allocator, MGPU_FRAMING_V3_MAX_MSG_SIZE);
+    databus->sendLock = SDL_CreateMutex();
+    if (databus->ring == NULL || databus->reassembler == NULL || databus->sendLock == NULL) {
+        fprintf(stderr, "Failed to allocate receive buffers\n");
+        mgpu_databus_free(databus);
+        return NULL;
     }
 
     // create the socket
@@ -199,6 +324,15 @@ void mgpu_databus_free(Mgpu_Databus *databus) {
         closeSocket(databus->clientSocket);
         closeSocket(databus->serverSocket);
         quitSocketHandling();
+        mgpu_frame_reassembler_free(databus->reassembler);
+        if (databus->sendLock != NULL) {
+            SDL_DestroyMutex(databus->sendLock);
+        }
+
+        if (databus->ring != NULL) {
+            databus->allocator->FastMemFreeFn(databus->ring);
+        }
+
         databus->allocator->FastMemFreeFn(databus);
     }
 }
@@ -206,7 +340,6 @@ void mgpu_databus_free(Mgpu_Databus *databus) {
 bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *operation) {
     assert(databus != NULL);
     assert(operation != NULL);
-    assert(globalByteQueue != NULL);
 
     memset(operation, 0, sizeof(Mgpu_Operation));
     if (isInvalidSocket(databus->clientSocket)) {
@@ -220,39 +353,89 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
             return false;
         }
 
-        // Clear the byte queue
-        globalByteQueueSize = 0;
+        // Clear the ring, and start the new client off with the original framing and no credits
+        resetRing(databus);
+        SDL_AtomicSet(&databus->framingVersion, MGPU_FRAMING_VERSION_2);
+        mgpu_frame_reassembler_reset(databus->reassembler);
+        databus->creditsEnabled = false;
     }
 
     return readOperation(databus, operation);
 }
 
-void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response) {
-    assert(databus != NULL);
-    assert(response != NULL);
-
-    uint8_t messageBuffer[1024] = {0};
+static void sendFramedResponse(Mgpu_Databus *databus, Mgpu_Response *response, int framingVersion) {
+    uint8_t messageBuffer[RESPONSE_BUFFER_SIZE] = {0};
     int messageBytesWritten = mgpu_serialize_response(response, messageBuffer, sizeof(messageBuffer));
     if (messageBytesWritten < 0) {
         fprintf(stderr, "Failed to serialize response: %u\n", messageBytesWritten);
         return;
     }
 
-    uint8_t outputBuffer[255] = {0};
-    int outputBytesWritten = mgpu_packet_framing_encode(messageBuffer,
+    // Extra room for the byte stuffing and framing overhead
+    uint8_t outputBuffer[RESPONSE_BUFFER_SIZE + 64] = {0};
+    int outputBytesWritten;
+    if (framingVersion == MGPU_FRAMING_VERSION_3) {
+        outputBytesWritten = mgpu_packet_framing_v3_encode(messageBuffer,
+                                                           messageBytesWritten,
+                                                           sizeof(outputBuffer),
+                                                           outputBuffer,
+                                                           sizeof(outputBuffer));
+    } else {
+        outputBytesWritten = mgpu_packet_framing_encode(messageBuffer,
                                                         messageBytesWritten,
                                                         outputBuffer,
                                                         sizeof(outputBuffer));
+    }
 
     if (outputBytesWritten >= 0) {
+        SDL_LockMutex(databus->sendLock);
         send(databus->clientSocket, (char *) outputBuffer, outputBytesWritten, 0);
+        SDL_UnlockMutex(databus->sendLock);
     } else {
-        SDL_Log("Failed to send response of type %u with error code %u", response->type, outputBytesWritten);
+        SDL_Log("Failed to send response of type %u with error code %d", response->type, outputBytesWritten);
     }
 }
 
+void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response) {
+    assert(databus != NULL);
+    assert(response != NULL);
+
+    sendFramedResponse(databus, response, SDL_AtomicGet(&databus->framingVersion));
+}
+
 uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus) {
     assert(databus != NULL);
-    return 1024;
+
+    if (SDL_AtomicGet(&databus->framingVersion) == MGPU_FRAMING_VERSION_3) {
+        return MGPU_FRAMING_V3_MAX_MSG_SIZE;
+    }
+
+    return MGPU_FRAMING_MAX_MSG_SIZE;
 }
 
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+    return MGPU_FRAMING_VERSION_3;
+}
+
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId) {
+    assert(databus != NULL);
+
+    Mgpu_Response response = {.type = Mgpu_Response_Framing, .requestId = requestId};
+    if (requestedVersion >= MGPU_FRAMING_VERSION_3) {
+        response.framing.version = MGPU_FRAMING_VERSION_3;
+        response.framing.maxFrameSize = TCP_MAX_FRAME_SIZE;
+        response.framing.maxMessageSize = MGPU_FRAMING_V3_MAX_MSG_SIZE;
+    } else {
+        response.framing.version = MGPU_FRAMING_VERSION_2;
+        response.framing.maxFrameSize = MGPU_FRAMING_MAX_MSG_SIZE + 4;
+        response.framing.maxMessageSize = MGPU_FRAMING_MAX_MSG_SIZE;
+    }
+
+    // Switched before responding, since the client can send its next operation in the new
+    // framing as soon as it has the response, and the receive thread may decode it right away.
+    int previousVersion = SDL_AtomicSet(&databus->framingVersion, response.framing.version);
+    sendFramedResponse(databus, &response, previousVersion);
+
+    SDL_Log("Switched from framing version %d to %u\n", previousVersion, response.framing.version);
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <SDL.h>
 #include "microgpu-common/alloc.h"
+#include "microgpu-common/packet_framing.h"
 
 #ifdef _WIN32
 
@@ -27,4 +29,38 @@ struct Mgpu_DatabusOptions {
 struct Mgpu_Databus {
     const Mgpu_Allocator *allocator;
     SOCKET serverSocket, clientSocket;
+
+    /*
+     * Ring of received bytes that frames are decoded out of in place. The head and tail are
+     * running totals of bytes received and consumed, and are only masked down to an index into
+     * the ring when accessing it.
+     */
+    uint8_t *ring;
+    size_t ringHead, ringTail;
+
+    /*
+     * How many bytes past the tail are known not to contain the end of a frame, so they aren't
+     * searched again when more bytes arrive.
+     */
+    size_t ringScanned;
+
+    /*
+     * The framing version in use, which is switched by the execution thread when a client
+     * negotiates while the receive thread may be decoding.
+     */
+    SDL_atomic_t framingVersion;
+    Mgpu_FrameReassembler *reassembler;
+
+    /*
+     * Responses are sent by the execution thread, while credits are sent by the receive thread
+     */
+    SDL_mutex *sendLock;
+
+    /*
+     * Once the client enables credits, it's told how many bytes it may send in total (counted
+     * from right after the enable credits operation) without overrunning the ring.
+     */
+    bool creditsEnabled;
+    size_t creditStart;
+    uint32_t advertisedCreditLimit;
 };
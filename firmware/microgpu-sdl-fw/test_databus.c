@@ -10,6 +10,7 @@
 
 bool hasResponse;
 Mgpu_Response lastSeenResponse;
+Mgpu_StatsEntry lastSeenStatsEntries[MGPU_STATS_RESPONSE_MAX_ENTRIES];
 uint16_t operationCount;
 char testString[] = "Hello world!";
 
@@ -212,6 +213,7 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
             operation->drawChars.startY = 300;
             operation->drawChars.numCharacters = strlen(testString);
             operation->drawChars.characters = (const uint8_t*) testString;
+            operation->drawChars.hasBackground = false;
 
             operationCount++;
             return true;
@@ -225,6 +227,7 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
             operation->drawChars.startY = 300;
             operation->drawChars.numCharacters = strlen(testString);
             operation->drawChars.characters = (const uint8_t*) testString;
+            operation->drawChars.hasBackground = false;
 
             operationCount++;
             return true;
@@ -238,6 +241,7 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
             operation->drawChars.startY = 760;
             operation->drawChars.numCharacters = strlen(testString);
             operation->drawChars.characters = (const uint8_t*) testString;
+            operation->drawChars.hasBackground = false;
 
             operationCount++;
             return true;
@@ -251,6 +255,7 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
             operation->drawChars.startY = 320;
             operation->drawChars.numCharacters = strlen(testString);
             operation->drawChars.characters = (const uint8_t*) testString;
+            operation->drawChars.hasBackground = false;
 
             operationCount++;
             return true;
@@ -260,6 +265,15 @@ bool mgpu_databus_get_next_operation(Mgpu_Databus *databus, Mgpu_Operation *oper
             operationCount++;
             return true;
 
+        case 19:
+            // An id in the custom range that nothing registered. The custom fields hold junk, like
+            // a union left over from another operation, and must not be queued as its payload.
+            operation->type = MGPU_CUSTOM_OPERATION_FIRST_ID + 1;
+            operation->custom.bytes = (const uint8_t *) 1;
+            operation->custom.size = UINT16_MAX;
+            operationCount++;
+            return true;
+
         case RESET_OPERATION_ID:
             operation->type = Mgpu_Operation_Reset;
             operationCount++;
@@ -285,6 +299,31 @@ void mgpu_databus_send_response(Mgpu_Databus *databus, Mgpu_Response *response)
         case Mgpu_Response_LastMessage:
             lastSeenResponse.lastMessage = response->lastMessage;
             break;
+
+        case Mgpu_Response_TextureUsage:
+            lastSeenResponse.textureUsage = response->textureUsage;
+            break;
+
+        case Mgpu_Response_Framing:
+            lastSeenResponse.framing = response->framing;
+            break;
+
+        case Mgpu_Response_Fence:
+            lastSeenResponse.fence = response->fence;
+            break;
+
+        case Mgpu_Response_Credits:
+            lastSeenResponse.credits = response->credits;
+            break;
+
+        case Mgpu_Response_Stats:
+            // Entries only live as long as the response, so they're copied to be looked at later
+            lastSeenResponse.stats = response->stats;
+            lastSeenResponse.stats.entries = lastSeenStatsEntries;
+            for (uint8_t index = 0; index < response->stats.entryCount; index++) {
+                lastSeenStatsEntries[index] = response->stats.entries[index];
+            }
+            break;
     }
 }
 
@@ -306,3 +345,21 @@ uint16_t mgpu_databus_get_max_size(Mgpu_Databus *databus) {
     assert(databus != NULL);
     return 984;
 }
+
+uint8_t mgpu_databus_get_max_framing_version(Mgpu_Databus *databus) {
+    assert(databus != NULL);
+    return 2;
+}
+
+void mgpu_databus_negotiate_framing(Mgpu_Databus *databus, uint8_t requestedVersion, uint16_t requestId) {
+    assert(databus != NULL);
+
+    // Operations are generated in memory, so there's no framing to switch
+    Mgpu_Response response = {
+            .type = Mgpu_Response_Framing,
+            .requestId = requestId,
+            .framing = {.version = 2, .maxFrameSize = 0, .maxMessageSize = mgpu_databus_get_max_size(databus)},
+    };
+
+    mgpu_databus_send_response(databus, &response);
+}
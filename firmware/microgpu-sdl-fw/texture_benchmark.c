@@ -0,0 +1,235 @@
+#define SDL_MAIN_HANDLED
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "microgpu-common/alloc.h"
+#include "microgpu-common/messages.h"
+#include "microgpu-common/operations/execution/textures.h"
+#include "microgpu-common/texture_manager.h"
+
+// Compares how often texture definitions fail, and how long they take, with and without texture
+// arenas. Textures are constantly defined and undefined the way Glade2d does with sprites, and
+// all memory comes from a fixed size simulated heap, since the host's heap would never run out.
+
+#define HEAP_SIZE (1024 * 1024)
+#define MAX_HEAP_ALLOCATIONS 1024
+#define ITERATIONS 200000
+#define TARGET_LIVE_BYTES (HEAP_SIZE * 8 / 10)
+#define MAX_TEXTURE_ID 200
+
+typedef struct {
+    size_t offset, size;
+} HeapAllocation;
+
+typedef struct {
+    const char *name;
+    size_t arenaSize;
+    bool compactWhenFull;
+} Scenario;
+
+static const Scenario scenarios[] = {
+        {.name = "individual allocations", .arenaSize = 0, .compactWhenFull = false},
+        {.name = "arena without compaction", .arenaSize = HEAP_SIZE * 9 / 10, .compactWhenFull = false},
+        {.name = "arena with compaction", .arenaSize = HEAP_SIZE * 9 / 10, .compactWhenFull = true},
+};
+
+// A first-fit heap over a fixed block of memory, standing in for the device's heap
+static uint8_t *heap;
+static HeapAllocation heapAllocations[MAX_HEAP_ALLOCATIONS];
+static int heapAllocationCount;
+
+static uint32_t randomState;
+
+static uint32_t next_random(uint32_t max) {
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 8) % max;
+}
+
+static void *heap_allocate(size_t size) {
+    size = (size + 7) & ~(size_t) 7;
+    if (heapAllocationCount >= MAX_HEAP_ALLOCATIONS) {
+        return NULL;
+    }
+
+    size_t gapStart = 0;
+    for (int x = 0; x <= heapAllocationCount; x++) {
+        size_t gapEnd = x < heapAllocationCount ? heapAllocations[x].offset : HEAP_SIZE;
+        if (gapEnd - gapStart >= size) {
+            memmove(&heapAllocations[x + 1], &heapAllocations[x], sizeof(HeapAllocation) * (heapAllocationCount - x));
+            heapAllocations[x].offset = gapStart;
+            heapAllocations[x].size = size;
+            heapAllocationCount++;
+
+            return heap + gapStart;
+        }
+
+        if (x < heapAllocationCount) {
+            gapStart = heapAllocations[x].offset + heapAllocations[x].size;
+        }
+    }
+
+    return NULL;
+}
+
+static void heap_free(void *memory) {
+    if (memory == NULL) {
+        return;
+    }
+
+    size_t offset = (uint8_t *) memory - heap;
+    for (int x = 0; x < heapAllocationCount; x++) {
+        if (heapAllocations[x].offset == offset) {
+            memmove(&heapAllocations[x], &heapAllocations[x + 1], sizeof(HeapAllocation) * (heapAllocationCount - x - 1));
+            heapAllocationCount--;
+            return;
+        }
+    }
+}
+
+static void get_heap_stats(size_t *freeBytes, size_t *largestFreeBlock) {
+    *freeBytes = 0;
+    *largestFreeBlock = 0;
+
+    size_t gapStart = 0;
+    for (int x = 0; x <= heapAllocationCount; x++) {
+        size_t gapEnd = x < heapAllocationCount ? heapAllocations[x].offset : HEAP_SIZE;
+        size_t gap = gapEnd - gapStart;
+        *freeBytes += gap;
+        if (gap > *largestFreeBlock) {
+            *largestFreeBlock = gap;
+        }
+
+        if (x < heapAllocationCount) {
+            gapStart = heapAllocations[x].offset + heapAllocations[x].size;
+        }
+    }
+}
+
+static const Mgpu_Allocator heapAllocator = {
+        .FastMemAllocateFn = heap_allocate,
+        .FastMemFreeFn = heap_free,
+        .SlowMemAllocateFn = heap_allocate,
+        .SlowMemFreeFn = heap_free,
+};
+
+static void pick_texture_size(uint16_t *width, uint16_t *height) {
+    uint32_t kind = next_random(100);
+    if (kind < 80) {
+        // Sprites and sub-textures
+        *width = 8 + next_random(25);
+        *height = 8 + next_random(25);
+    } else if (kind < 95) {
+        *width = 32 + next_random(65);
+        *height = 32 + next_random(65);
+    } else {
+        // Backgrounds and tile maps
+        *width = 128 + next_random(193);
+        *height = 128 + next_random(113);
+    }
+}
+
+static void run_scenario(const Scenario *scenario) {
+    heapAllocationCount = 0;
+    randomState = 12345;
+
+    Mgpu_TextureManagerOptions options = {
+            .slowArenaSize = scenario->arenaSize,
+            .compactWhenFull = scenario->compactWhenFull,
+    };
+
+    Mgpu_TextureManager *textureManager = mgpu_texture_manager_new(&heapAllocator, &options);
+    if (textureManager == NULL) {
+        SDL_Log("%s: failed to create texture manager: %s\n", scenario->name, mgpu_message_get_pointer());
+        return;
+    }
+
+    size_t liveBytes = 0;
+    size_t textureBytes[MAX_TEXTURE_ID + 1] = {0};
+    uint32_t defines = 0, failures = 0, largeDefines = 0, largeFailures = 0;
+    uint64_t defineTicks = 0;
+
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+        uint8_t id = 1 + next_random(MAX_TEXTURE_ID);
+        Mgpu_DefineTextureOperation operation = {.textureId = id};
+
+        bool undefine = textureBytes[id] > 0 && (liveBytes > TARGET_LIVE_BYTES || next_random(4) == 0);
+        if (!undefine) {
+            pick_texture_size(&operation.width, &operation.height);
+        }
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        mgpu_exec_texture_define(textureManager, &operation);
+        uint64_t ticks = SDL_GetPerformanceCounter() - start;
+
+        liveBytes -= textureBytes[id];
+        textureBytes[id] = 0;
+        if (undefine) {
+            continue;
+        }
+
+        bool isLarge = operation.width >= 128;
+        size_t bytes = operation.width * operation.height * sizeof(Mgpu_Color);
+        defines++;
+        largeDefines += isLarge ? 1 : 0;
+        defineTicks += ticks;
+
+        if (mgpu_texture_get(textureManager, id) == NULL) {
+            failures++;
+            largeFailures += isLarge ? 1 : 0;
+        } else {
+            textureBytes[id] = bytes;
+            liveBytes += bytes;
+        }
+    }
+
+    double defineMicroseconds = (double) defineTicks * 1000000 / SDL_GetPerformanceFrequency() / defines;
+    SDL_Log("%s: %u defines, %u failed (%.2f%%), %u of %u large defines failed, %.2f us per define\n",
+            scenario->name,
+            defines,
+            failures,
+            100.0 * failures / defines,
+            largeFailures,
+            largeDefines,
+            defineMicroseconds);
+
+    size_t heapFree, heapLargest;
+    get_heap_stats(&heapFree, &heapLargest);
+    SDL_Log("%s: heap has %zu bytes free, largest free block %zu\n", scenario->name, heapFree, heapLargest);
+
+    if (scenario->arenaSize > 0) {
+        Mgpu_TextureManagerStats stats;
+        mgpu_texture_manager_get_stats(textureManager, &stats);
+        SDL_Log("%s: arena has %zu bytes free in %u blocks (largest %zu), %u slab pages with %u free slots\n",
+                scenario->name,
+                stats.slowArena.freeBytes,
+                stats.slowArena.freeBlockCount,
+                stats.slowArena.largestFreeBlock,
+                stats.slowArena.slabPageCount,
+                stats.slowArena.freeSlabSlots);
+        SDL_Log("%s: %u compactions relocated %zu bytes, %u textures fell back to the heap\n",
+                scenario->name,
+                stats.slowArena.compactions,
+                stats.slowArena.bytesRelocated,
+                stats.arenaFallbacks);
+    }
+
+    mgpu_texture_manager_free(textureManager);
+}
+
+int main(int argc, char *args[]) {
+    heap = malloc(HEAP_SIZE);
+    if (heap == NULL) {
+        SDL_Log("Failed to allocate simulated heap\n");
+        return 1;
+    }
+
+    for (int x = 0; x < sizeof(scenarios) / sizeof(scenarios[0]); x++) {
+        run_scenario(&scenarios[x]);
+    }
+
+    free(heap);
+    return 0;
+}